@@ -1,23 +1,126 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 #include <pybind11/operators.h>
+#include <pybind11/numpy.h>
 #include <memory>
+#include <cstring>
 
 // Core
 #include "physics_core/vec3.h"
+#include "physics_core/quat.h"
+#include "physics_core/cpu_dispatch.h"
 
 // C++ Layer
 #include "volleybot_physics/scene.h"
+#include "volleybot_physics/batch_scene.h"
+#include "volleybot_physics/task_scheduler.h"
 #include "volleybot_physics/material.h"
 #include "volleybot_physics/primitive.h"
 #include "volleybot_physics/composite_object.h"
 #include "volleybot_physics/joint.h"
+#include "volleybot_physics/mesh_asset.h"
+#include "volleybot_physics/mjcf_model.h"
 
 // Concrete Primitives
 #include "volleybot_physics/primitive.h"
 
 namespace py = pybind11;
 
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+static_assert(sizeof(Vec3) == 3 * sizeof(float), "Vec3 arrays are exposed as float arrays");
+static_assert(sizeof(Quat) == 4 * sizeof(float), "Quat arrays are exposed as float arrays");
+
+// Number of floats per element of a state array
+template <typename T>
+constexpr size_t float_width() { return sizeof(T) / sizeof(float); }
+
+/**
+ * A writable NumPy array that shares memory with one of the engine's state arrays.
+ * 'owner' is the Python scene object; the view keeps it alive.
+ * @param shape Leading dimensions; the element's floats (3 for Vec3, 4 for Quat) are appended unless 1.
+ */
+template <typename T>
+static py::array_t<float> state_view(std::vector<T>& values, std::vector<size_t> shape, py::handle owner) {
+    if (float_width<T>() > 1) {
+        shape.push_back(float_width<T>());
+    }
+    return py::array_t<float>(shape, reinterpret_cast<float*>(values.data()), owner);
+}
+
+// Copies an array of matching size into one of the engine's state arrays
+template <typename T>
+static void copy_into_state(std::vector<T>& values, const FloatArray& source, const char* name) {
+    size_t expected = values.size() * float_width<T>();
+    if ((size_t)source.size() != expected) {
+        throw py::value_error(std::string(name) + " expects " + std::to_string(expected) + " values, got " +
+                              std::to_string(source.size()));
+    }
+    std::memcpy(values.data(), source.data(), expected * sizeof(float));
+}
+
+// Shape of a per-body array of a batch: (worlds, bodies per world)
+static std::vector<size_t> world_major_shape(const BatchScene& batch, size_t per_world) {
+    return {(size_t)batch.get_num_worlds(), per_world};
+}
+
+// Views of all state of a scene, as returned by step_n
+static py::dict scene_state(py::object self) {
+    Scene& scene = self.cast<Scene&>();
+    BodyStore& store = scene.get_body_store();
+    auto& joint_speeds = const_cast<std::vector<float>&>(scene.get_joint_speeds());
+    py::dict state;
+    state["positions"] = state_view(store.positions, {store.size()}, self);
+    state["velocities"] = state_view(store.velocities, {store.size()}, self);
+    state["angular_velocities"] = state_view(store.angular_velocities, {store.size()}, self);
+    state["orientations"] = state_view(store.orientations, {store.size()}, self);
+    state["joint_speeds"] = state_view(joint_speeds, {joint_speeds.size()}, self);
+    return state;
+}
+
+static py::dict batch_state(py::object self) {
+    BatchScene& batch = self.cast<BatchScene&>();
+    BodyStore& store = batch.get_body_store();
+    std::vector<size_t> shape = world_major_shape(batch, batch.get_bodies_per_world());
+    auto& joint_speeds = const_cast<std::vector<float>&>(batch.get_joint_speeds());
+    py::dict state;
+    state["positions"] = state_view(store.positions, shape, self);
+    state["velocities"] = state_view(store.velocities, shape, self);
+    state["angular_velocities"] = state_view(store.angular_velocities, shape, self);
+    state["orientations"] = state_view(store.orientations, shape, self);
+    state["joint_speeds"] = state_view(joint_speeds, world_major_shape(batch, batch.get_action_size()), self);
+    return state;
+}
+
+/**
+ * Checks the actions passed to BatchScene.step and returns a pointer to them, or nullptr for None.
+ * 'storage' holds the converted array while the pointer is in use.
+ */
+static const float* batch_actions(const BatchScene& batch, const py::object& actions, FloatArray& storage) {
+    if (actions.is_none()) {
+        return nullptr;
+    }
+    storage = actions.cast<FloatArray>();
+    size_t expected = (size_t)batch.get_num_worlds() * batch.get_action_size();
+    if ((size_t)storage.size() != expected) {
+        throw py::value_error("expected " + std::to_string(expected) + " actions (num_worlds * action_size)");
+    }
+    return storage.data();
+}
+
+static py::bytes snapshot_bytes(const std::vector<uint8_t>& snapshot) {
+    return py::bytes(reinterpret_cast<const char*>(snapshot.data()), snapshot.size());
+}
+
+// The bytes of a snapshot passed back in as bytes, bytearray or any other contiguous buffer
+static py::buffer_info snapshot_buffer(const py::buffer& data) {
+    py::buffer_info info = data.request();
+    if (info.ndim > 1 || (info.ndim == 1 && info.strides[0] != info.itemsize)) {
+        throw py::value_error("snapshots must be passed as a contiguous buffer, e.g. bytes");
+    }
+    return info;
+}
+
 PYBIND11_MODULE(volleybot_physics, m) {
     m.doc() = "Python bindings for the VolleyBot physics engine";
 
@@ -47,7 +150,22 @@ PYBIND11_MODULE(volleybot_physics, m) {
         .def("get_position", &Primitive::get_position)
         .def("get_velocity", &Primitive::get_velocity)
         .def("get_angular_velocity", &Primitive::get_angular_velocity)
-        .def("set_position", &Primitive::set_position, py::arg("pos"));
+        .def("set_position", &Primitive::set_position, py::arg("pos"))
+        .def("get_orientation", [](const Primitive& primitive) {
+                Quat q = primitive.get_orientation();
+                return py::make_tuple(q.x, q.y, q.z, q.w);
+             }, "Orientation as an (x, y, z, w) unit quaternion.")
+        .def("set_orientation", [](Primitive& primitive, const Vec3& axis, float angle_rad) {
+                Quat q;
+                quat_from_axis_angle(axis, angle_rad, &q);
+                primitive.set_orientation(q);
+             }, py::arg("axis"), py::arg("angle_rad"), "Set the orientation as a rotation of angle_rad about axis.")
+        .def("get_body_index", &Primitive::get_body_index, "Row of this body in its scene's state arrays (get_positions() etc.).")
+        .def("set_bullet", &Primitive::set_bullet, py::arg("bullet"),
+             "Sweep this sphere along its motion every step, so it cannot pass through thin bodies at large dt.")
+        .def("is_bullet", &Primitive::is_bullet)
+        .def("is_sleeping", &Primitive::is_sleeping)
+        .def("wake_up", &Primitive::wake_up, "Wake this body and the island it sleeps with.");
 
     py::class_<Box, Primitive, std::shared_ptr<Box>>(m, "Box")
         .def(py::init<const Vec3&, std::shared_ptr<Material>>(), 
@@ -61,6 +179,91 @@ PYBIND11_MODULE(volleybot_physics, m) {
         .def("set_position", &Sphere::set_position, py::arg("pos"))
         .def("set_velocity", &Sphere::set_velocity, py::arg("vel"));
 
+    py::class_<Cylinder, Primitive, std::shared_ptr<Cylinder>>(m, "Cylinder")
+        .def(py::init<float, float, int, std::shared_ptr<Material>>(),
+             py::arg("height"), py::arg("radius"), py::arg("sides"), py::arg("material"))
+        .def("set_velocity", &Cylinder::set_velocity, py::arg("vel"))
+        .def("set_angular_velocity", &Cylinder::set_angular_velocity, py::arg("ang_vel"));
+
+    py::class_<Capsule, Primitive, std::shared_ptr<Capsule>>(m, "Capsule")
+        .def(py::init<float, float, std::shared_ptr<Material>>(),
+             py::arg("height"), py::arg("radius"), py::arg("material"),
+             "A capsule along its local Y axis; height is the distance between its cap centers.")
+        .def("set_velocity", &Capsule::set_velocity, py::arg("vel"))
+        .def("set_angular_velocity", &Capsule::set_angular_velocity, py::arg("ang_vel"));
+
+    py::class_<MeshAsset, std::shared_ptr<MeshAsset>>(m, "MeshAsset")
+        .def_static("build", &MeshAsset::build, py::arg("vertices"), py::arg("indices"),
+                    "Builds the BVH and hull of a mesh, three indices per triangle.")
+        .def_static("load_obj", &MeshAsset::load_obj, py::arg("path"), "Reads an .obj file. Returns None if it cannot be read.")
+        .def_static("load_stl", &MeshAsset::load_stl, py::arg("path"),
+                    "Reads a binary or ASCII .stl file, welding duplicate corners. Returns None if it cannot be read.")
+        .def_static("load_cooked", &MeshAsset::load_cooked, py::arg("path"),
+                    "Maps a cooked mesh file read-only, shared with every scene and process that loads it. "
+                    "Returns None if it is not a cooked mesh of this version.")
+        .def_static("cook", &MeshAsset::cook, py::arg("source_path"), py::arg("cooked_path"),
+                    "Loads a mesh source file (.obj or .stl) and writes it as a cooked mesh file.")
+        .def("write_cooked", &MeshAsset::write_cooked, py::arg("path"))
+        .def("get_vertices", [](const MeshAsset& asset) {
+                return std::vector<Vec3>(asset.get_vertices(), asset.get_vertices() + asset.get_vertex_count());
+             })
+        .def("get_indices", [](const MeshAsset& asset) {
+                return std::vector<unsigned int>(asset.get_indices(), asset.get_indices() + 3 * asset.get_triangle_count());
+             })
+        .def("get_normals", [](const MeshAsset& asset) {
+                return std::vector<Vec3>(asset.get_normals(), asset.get_normals() + asset.get_vertex_count());
+             })
+        .def("get_hull_points", [](const MeshAsset& asset) {
+                return std::vector<Vec3>(asset.get_hull_points(), asset.get_hull_points() + asset.get_hull_point_count());
+             })
+        .def("get_hull_indices", [](const MeshAsset& asset) {
+                return std::vector<unsigned int>(asset.get_hull_indices(), asset.get_hull_indices() + 3 * asset.get_hull_triangle_count());
+             })
+        .def("get_volume", [](const MeshAsset& asset) { return asset.get_mass_properties().volume; })
+        .def("get_hull_volume", [](const MeshAsset& asset) { return asset.get_hull_mass_properties().volume; })
+        .def("get_center_of_mass", [](const MeshAsset& asset) { return asset.get_mass_properties().center_of_mass; })
+        .def("get_inertia", [](const MeshAsset& asset) {
+                const Mat4& inertia = asset.get_mass_properties().inertia;
+                std::vector<std::vector<float>> rows(3, std::vector<float>(3));
+                for (int i = 0; i < 3; ++i) {
+                    for (int j = 0; j < 3; ++j) rows[i][j] = inertia.m[j][i];
+                }
+                return rows;
+             }, "The 3x3 inertia tensor about the center of mass at unit density.")
+        .def("is_closed", &MeshAsset::is_closed)
+        .def("is_mapped", &MeshAsset::is_mapped);
+
+    py::class_<ConvexHull, Primitive, std::shared_ptr<ConvexHull>>(m, "ConvexHull")
+        .def(py::init<const std::vector<Vec3>&, std::shared_ptr<Material>>(),
+             py::arg("points"), py::arg("material"),
+             "The convex hull of points in the local frame, collided through GJK/EPA. The points are reduced to the hull's corners.")
+        .def(py::init<const MeshAsset&, std::shared_ptr<Material>>(), py::arg("asset"), py::arg("material"),
+             "The convex hull of a mesh asset, e.g. a robot part loaded from an .stl file.")
+        .def("get_vertices", &ConvexHull::get_vertices)
+        .def("set_velocity", &ConvexHull::set_velocity, py::arg("vel"))
+        .def("set_angular_velocity", &ConvexHull::set_angular_velocity, py::arg("ang_vel"));
+
+    py::class_<TriangleMesh, Primitive, std::shared_ptr<TriangleMesh>>(m, "TriangleMesh")
+        .def(py::init<std::vector<Vec3>, std::vector<unsigned int>, std::shared_ptr<Material>>(),
+             py::arg("vertices"), py::arg("indices"), py::arg("material"),
+             "Static triangle geometry, three indices per triangle. The triangles are reordered for the mesh's BVH.")
+        .def(py::init<std::shared_ptr<MeshAsset>, std::shared_ptr<Material>>(), py::arg("asset"), py::arg("material"),
+             "A mesh sharing the geometry of a MeshAsset.")
+        .def("get_asset", &TriangleMesh::get_asset)
+        .def("get_vertices", [](const TriangleMesh& mesh) {
+                const MeshAsset& asset = *mesh.get_asset();
+                return std::vector<Vec3>(asset.get_vertices(), asset.get_vertices() + asset.get_vertex_count());
+             })
+        .def("get_indices", [](const TriangleMesh& mesh) {
+                const MeshAsset& asset = *mesh.get_asset();
+                return std::vector<unsigned int>(asset.get_indices(), asset.get_indices() + 3 * asset.get_triangle_count());
+             });
+
+    py::class_<Plane, Primitive, std::shared_ptr<Plane>>(m, "Plane")
+        .def(py::init<std::shared_ptr<Material>>(), py::arg("material"),
+             "A static ground plane through its position, facing its local +Y axis.")
+        .def("get_normal", &Plane::get_normal);
+
     // --- Joints ---
     py::class_<Joint, std::shared_ptr<Joint>>(m, "Joint"); // Base class
 
@@ -80,9 +283,256 @@ PYBIND11_MODULE(volleybot_physics, m) {
         .def("get_revolute_joint", &CompositeObject::get_revolute_joint, py::arg("joint_id"), py::return_value_policy::reference, "Get a specific revolute joint by its ID.");
 
     // --- Scene ---
+    py::enum_<BroadphaseType>(m, "BroadphaseType")
+        .value("SWEEP_AND_PRUNE", BroadphaseType::SWEEP_AND_PRUNE)
+        .value("AABB_TREE", BroadphaseType::AABB_TREE)
+        .value("SPATIAL_HASH", BroadphaseType::SPATIAL_HASH);
+
+    py::class_<SleepSettings>(m, "SleepSettings")
+        .def(py::init<>())
+        .def_readwrite("linear_speed", &SleepSettings::linear_speed)
+        .def_readwrite("angular_speed", &SleepSettings::angular_speed)
+        .def_readwrite("time", &SleepSettings::time, "Seconds an island must stay slow before it sleeps; 0 turns sleeping off.");
+
     py::class_<Scene>(m, "Scene")
         .def(py::init<>())
-        .def("step", &Scene::step, py::arg("dt"), "Advance the simulation by one time step")
+        // Long-running calls release the GIL so other Python threads keep going. A scene must not be
+        // stepped from two threads at once.
+        .def("step", &Scene::step, py::arg("dt"), py::call_guard<py::gil_scoped_release>(),
+             "Advance the simulation by one time step")
+        .def("step_n", [](py::object self, float dt, int n, int frame_skip) {
+                Scene& scene = self.cast<Scene&>();
+                {
+                    py::gil_scoped_release release;
+                    scene.step_n(dt, n, frame_skip);
+                }
+                return scene_state(self);
+             }, py::arg("dt"), py::arg("n"), py::arg("frame_skip") = 1,
+             "Advance n * frame_skip time steps in one call. Returns a dict of views of the final state "
+             "(positions, velocities, angular_velocities, orientations, joint_speeds).")
+        .def("set_broadphase_type", &Scene::set_broadphase_type, py::arg("type"), "Select the broadphase collision culling algorithm.")
+        .def("get_broadphase_type", &Scene::get_broadphase_type, "Get the broadphase collision culling algorithm in use.")
+        .def("set_solver_iterations", &Scene::set_solver_iterations, py::arg("iterations"), "Set the number of constraint solver iterations per step.")
+        .def("get_solver_iterations", &Scene::get_solver_iterations, "Get the number of constraint solver iterations per step.")
+        .def("set_contact_slop", &Scene::set_contact_slop, py::arg("slop"),
+             "Set how deep resting contacts may stay before position correction pushes them apart.")
+        .def("get_contact_slop", &Scene::get_contact_slop, "Get how deep resting contacts may stay before position correction.")
+        .def("set_sleep_settings", &Scene::set_sleep_settings, py::arg("settings"),
+             "Set when resting islands fall asleep. Turning sleeping off wakes every body.")
+        .def("get_sleep_settings", &Scene::get_sleep_settings)
         .def("add_composite_object", &Scene::add_composite_object, py::arg("object"), "Adds a composite object to the scene.")
-        .def("add_primitive", &Scene::add_primitive, py::arg("primitive"), "Adds a single primitive to the scene.");
+        .def("add_primitive", &Scene::add_primitive, py::arg("primitive"), "Adds a single primitive to the scene.")
+        .def("load_obj_as_primitive", &Scene::load_obj_as_primitive, py::arg("filepath"), py::arg("material"),
+             "Loads an .obj file as a TriangleMesh and adds it to the scene. Returns None if it cannot be read.")
+        .def("load_stl_as_primitive", &Scene::load_stl_as_primitive, py::arg("filepath"), py::arg("material"),
+             "Loads a binary or ASCII .stl file as a TriangleMesh and adds it to the scene. Returns None if it cannot be read.")
+        .def("load_cooked_mesh_as_primitive", &Scene::load_cooked_mesh_as_primitive, py::arg("filepath"), py::arg("material"),
+             "Maps a cooked mesh file as a TriangleMesh and adds it to the scene. Returns None if it cannot be loaded.")
+        // Zero-copy views of the body state, one row per body (see Primitive.get_body_index). Writes go straight
+        // into the simulation but do not wake sleeping bodies; call Primitive.wake_up for those. Adding bodies
+        // invalidates earlier views.
+        .def("get_positions", [](py::object self) {
+                BodyStore& store = self.cast<Scene&>().get_body_store();
+                return state_view(store.positions, {store.size()}, self);
+             }, "Positions of all bodies as a writable (bodies, 3) view.")
+        .def("get_velocities", [](py::object self) {
+                BodyStore& store = self.cast<Scene&>().get_body_store();
+                return state_view(store.velocities, {store.size()}, self);
+             }, "Linear velocities of all bodies as a writable (bodies, 3) view.")
+        .def("get_angular_velocities", [](py::object self) {
+                BodyStore& store = self.cast<Scene&>().get_body_store();
+                return state_view(store.angular_velocities, {store.size()}, self);
+             }, "Angular velocities of all bodies as a writable (bodies, 3) view.")
+        .def("get_orientations", [](py::object self) {
+                BodyStore& store = self.cast<Scene&>().get_body_store();
+                return state_view(store.orientations, {store.size()}, self);
+             }, "Orientations of all bodies as a writable (bodies, 4) view of (x, y, z, w) quaternions.")
+        .def("get_joint_speeds", [](py::object self) {
+                auto& speeds = const_cast<std::vector<float>&>(self.cast<Scene&>().get_joint_speeds());
+                return state_view(speeds, {speeds.size()}, self);
+             }, "Relative speed of each revolute joint at the end of the last step, as a (joints,) view.")
+        .def("set_positions", [](Scene& scene, const FloatArray& values) {
+                copy_into_state(scene.get_body_store().positions, values, "set_positions");
+             }, py::arg("positions"), "Overwrite the positions of all bodies from a (bodies, 3) array.")
+        .def("set_velocities", [](Scene& scene, const FloatArray& values) {
+                copy_into_state(scene.get_body_store().velocities, values, "set_velocities");
+             }, py::arg("velocities"), "Overwrite the linear velocities of all bodies from a (bodies, 3) array.")
+        .def("set_angular_velocities", [](Scene& scene, const FloatArray& values) {
+                copy_into_state(scene.get_body_store().angular_velocities, values, "set_angular_velocities");
+             }, py::arg("angular_velocities"), "Overwrite the angular velocities of all bodies from a (bodies, 3) array.")
+        .def("set_orientations", [](Scene& scene, const FloatArray& values) {
+                copy_into_state(scene.get_body_store().orientations, values, "set_orientations");
+             }, py::arg("orientations"), "Overwrite the orientations of all bodies from a (bodies, 4) array of unit quaternions.")
+        .def("set_motor_speeds", [](Scene& scene, const FloatArray& speeds) {
+                if ((size_t)speeds.size() != scene.get_revolute_joints().size()) {
+                    throw py::value_error("set_motor_speeds expects one speed per revolute joint");
+                }
+                scene.set_motor_speeds(speeds.data());
+             }, py::arg("speeds"), "Set the motor target speed of every revolute joint.")
+        .def("snapshot", [](const Scene& scene) {
+                std::vector<uint8_t> snapshot;
+                scene.save_snapshot(snapshot);
+                return snapshot_bytes(snapshot);
+             }, "Save the bodies, joint motor targets and contact cache as bytes, for restore().")
+        .def("restore", [](Scene& scene, const py::buffer& data) {
+                py::buffer_info info = snapshot_buffer(data);
+                if (!scene.restore_snapshot(static_cast<const uint8_t*>(info.ptr), (size_t)(info.size * info.itemsize))) {
+                    throw py::value_error("restore expects a snapshot of a scene with the same bodies and joints");
+                }
+             }, py::arg("snapshot"), "Restore a state saved by snapshot() on this scene or an identically built one.");
+
+    py::class_<BatchScene>(m, "BatchScene")
+        .def(py::init<const Scene&, int>(), py::arg("template_scene"), py::arg("num_worlds"),
+             py::call_guard<py::gil_scoped_release>(),
+             "Builds num_worlds independent copies of the template scene.")
+        .def("step", [](BatchScene& batch, py::object actions, float dt) {
+                FloatArray storage;
+                const float* data = batch_actions(batch, actions, storage);
+                py::gil_scoped_release release;
+                batch.step(data, dt);
+             }, py::arg("actions"), py::arg("dt"),
+             "Advance all worlds by one time step. actions holds one motor speed per revolute joint per world, or None.")
+        .def("step_n", [](py::object self, py::object actions, float dt, int n, int frame_skip) {
+                BatchScene& batch = self.cast<BatchScene&>();
+                FloatArray storage;
+                const float* data = batch_actions(batch, actions, storage);
+                {
+                    py::gil_scoped_release release;
+                    batch.step_n(data, dt, n, frame_skip);
+                }
+                return batch_state(self);
+             }, py::arg("actions"), py::arg("dt"), py::arg("n"), py::arg("frame_skip") = 1,
+             "Apply the actions, then advance all worlds n * frame_skip time steps in one call. Returns a dict of "
+             "views of the final state (positions, velocities, angular_velocities, orientations, joint_speeds).")
+        .def("reset", &BatchScene::reset, py::call_guard<py::gil_scoped_release>(), "Put every world back into its initial state.")
+        .def("reset_world", &BatchScene::reset_world, py::arg("world"), py::call_guard<py::gil_scoped_release>(),
+             "Put one world back into its initial state.")
+        .def_property_readonly("num_worlds", &BatchScene::get_num_worlds)
+        .def_property_readonly("bodies_per_world", &BatchScene::get_bodies_per_world)
+        .def_property_readonly("action_size", &BatchScene::get_action_size)
+        // Zero-copy views of the world-major state. They stay valid for the lifetime of the batch.
+        .def("get_positions", [](py::object self) {
+                auto& batch = self.cast<BatchScene&>();
+                return state_view(batch.get_body_store().positions, world_major_shape(batch, batch.get_bodies_per_world()), self);
+             }, "Positions of all bodies as a writable (num_worlds, bodies_per_world, 3) view.")
+        .def("get_velocities", [](py::object self) {
+                auto& batch = self.cast<BatchScene&>();
+                return state_view(batch.get_body_store().velocities, world_major_shape(batch, batch.get_bodies_per_world()), self);
+             }, "Linear velocities of all bodies as a writable (num_worlds, bodies_per_world, 3) view.")
+        .def("get_angular_velocities", [](py::object self) {
+                auto& batch = self.cast<BatchScene&>();
+                return state_view(batch.get_body_store().angular_velocities, world_major_shape(batch, batch.get_bodies_per_world()), self);
+             }, "Angular velocities of all bodies as a writable (num_worlds, bodies_per_world, 3) view.")
+        .def("get_orientations", [](py::object self) {
+                auto& batch = self.cast<BatchScene&>();
+                return state_view(batch.get_body_store().orientations, world_major_shape(batch, batch.get_bodies_per_world()), self);
+             }, "Orientations of all bodies as a writable (num_worlds, bodies_per_world, 4) view of (x, y, z, w) quaternions.")
+        .def("get_joint_speeds", [](py::object self) {
+                auto& batch = self.cast<BatchScene&>();
+                auto& speeds = const_cast<std::vector<float>&>(batch.get_joint_speeds());
+                return state_view(speeds, world_major_shape(batch, batch.get_action_size()), self);
+             }, "Relative speed of each motorized joint at the end of the last step, as a (num_worlds, action_size) view.")
+        .def("set_positions", [](BatchScene& batch, const FloatArray& values) {
+                copy_into_state(batch.get_body_store().positions, values, "set_positions");
+             }, py::arg("positions"), "Overwrite the positions of all bodies from a (num_worlds, bodies_per_world, 3) array.")
+        .def("set_velocities", [](BatchScene& batch, const FloatArray& values) {
+                copy_into_state(batch.get_body_store().velocities, values, "set_velocities");
+             }, py::arg("velocities"), "Overwrite the linear velocities of all bodies from a (num_worlds, bodies_per_world, 3) array.")
+        .def("set_angular_velocities", [](BatchScene& batch, const FloatArray& values) {
+                copy_into_state(batch.get_body_store().angular_velocities, values, "set_angular_velocities");
+             }, py::arg("angular_velocities"), "Overwrite the angular velocities of all bodies from a (num_worlds, bodies_per_world, 3) array.")
+        .def("set_orientations", [](BatchScene& batch, const FloatArray& values) {
+                copy_into_state(batch.get_body_store().orientations, values, "set_orientations");
+             }, py::arg("orientations"), "Overwrite the orientations of all bodies from a (num_worlds, bodies_per_world, 4) array of unit quaternions.")
+        .def("set_motor_speeds", [](BatchScene& batch, const FloatArray& speeds) {
+                if ((size_t)speeds.size() != (size_t)batch.get_num_worlds() * batch.get_action_size()) {
+                    throw py::value_error("set_motor_speeds expects (num_worlds, action_size) speeds");
+                }
+                batch.set_motor_speeds(speeds.data());
+             }, py::arg("speeds"), "Set the motor target speeds of every world, like the actions of step().")
+        .def("snapshot_world", [](const BatchScene& batch, int world) {
+                if (world < 0 || world >= batch.get_num_worlds()) {
+                    throw py::index_error("world index out of range");
+                }
+                std::vector<uint8_t> snapshot;
+                batch.save_world_snapshot(world, snapshot);
+                return snapshot_bytes(snapshot);
+             }, py::arg("world"), "Save one world's bodies, joint motor targets and contact cache as bytes.")
+        .def("restore_world", [](BatchScene& batch, int world, const py::buffer& data) {
+                if (world < 0 || world >= batch.get_num_worlds()) {
+                    throw py::index_error("world index out of range");
+                }
+                py::buffer_info info = snapshot_buffer(data);
+                if (!batch.restore_world_snapshot(world, static_cast<const uint8_t*>(info.ptr), (size_t)(info.size * info.itemsize))) {
+                    throw py::value_error("restore_world expects a snapshot of a world or scene built like the template");
+                }
+             }, py::arg("world"), py::arg("snapshot"),
+             "Restore a snapshot from snapshot_world() or Scene.snapshot() into one world.")
+        .def("copy_world", [](BatchScene& batch, int src, int dst) {
+                if (!batch.copy_world(src, dst)) {
+                    throw py::index_error("world index out of range");
+                }
+             }, py::arg("src"), py::arg("dst"), "Overwrite world dst with the current state of world src.");
+
+    // --- MJCF import ---
+    py::class_<MjcfActuator>(m, "MjcfActuator")
+        .def_readonly("name", &MjcfActuator::name)
+        .def_readonly("joint_index", &MjcfActuator::joint_index, "Index of the driven joint in the scene's revolute joints.")
+        .def_readonly("gear", &MjcfActuator::gear)
+        .def_readonly("ctrl_limited", &MjcfActuator::ctrl_limited)
+        .def_readonly("ctrl_min", &MjcfActuator::ctrl_min)
+        .def_readonly("ctrl_max", &MjcfActuator::ctrl_max);
+
+    py::class_<MjcfModel, std::shared_ptr<MjcfModel>>(m, "MjcfModel")
+        .def_static("load", &MjcfModel::load, py::arg("path"), py::arg("scene"),
+                    "Reads a MuJoCo XML file into the scene. Returns None if it cannot be read.")
+        .def("find_body", &MjcfModel::find_body, py::arg("name"), "The object a body became, or None for unknown or static bodies.")
+        .def("find_geom", &MjcfModel::find_geom, py::arg("name"), "The primitive a geom became, or None.")
+        .def("find_joint", &MjcfModel::find_joint, py::arg("name"), "Index of a hinge joint in the scene's revolute joints, or -1.")
+        .def("find_actuator", &MjcfModel::find_actuator, py::arg("name"), "Index of an actuator, or -1.")
+        .def("get_actuators", &MjcfModel::get_actuators)
+        .def("get_camera_names", &MjcfModel::get_camera_names)
+        .def("get_timestep", &MjcfModel::get_timestep, "The file's simulation time step.")
+        .def("apply_controls", [](const MjcfModel& model, Scene& scene, const FloatArray& controls) {
+                if ((size_t)controls.size() != model.get_actuators().size()) {
+                    throw py::value_error("apply_controls expects one control per actuator");
+                }
+                model.apply_controls(scene, controls.data());
+             }, py::arg("scene"), py::arg("controls"), "Set the actuated joints' motor targets from one control per actuator.")
+        .def("controls_to_motor_speeds", [](const MjcfModel& model, const FloatArray& controls, const FloatArray& speeds) {
+                if ((size_t)controls.size() != model.get_actuators().size()) {
+                    throw py::value_error("controls_to_motor_speeds expects one control per actuator");
+                }
+                for (const auto& actuator : model.get_actuators()) {
+                    if ((size_t)actuator.joint_index >= (size_t)speeds.size()) {
+                        throw py::value_error("controls_to_motor_speeds expects one speed per revolute joint");
+                    }
+                }
+                FloatArray result(speeds.size());
+                std::memcpy(result.mutable_data(), speeds.data(), speeds.size() * sizeof(float));
+                model.controls_to_motor_speeds(controls.data(), result.mutable_data());
+                return result;
+             }, py::arg("controls"), py::arg("speeds"),
+             "Returns a copy of speeds, one per revolute joint, with the actuated joints' targets set from one control "
+             "per actuator, e.g. to build one world's BatchScene actions.");
+
+    // --- Threading ---
+    m.def("set_num_threads", &TaskScheduler::configure_global, py::arg("num_threads"), py::arg("pin_threads") = false,
+          py::call_guard<py::gil_scoped_release>(),
+          "Set the threads the engine steps with, counting the calling thread (0 = VOLLEYBOT_NUM_THREADS or all cores). "
+          "pin_threads pins each worker to one core. Call while no scene is stepping.");
+    m.def("get_num_threads", []() { return TaskScheduler::global().get_thread_count(); },
+          "Get the threads the engine steps with.");
+
+    // --- CPU dispatch ---
+    py::enum_<SimdLevel>(m, "SimdLevel")
+        .value("SCALAR", SIMD_LEVEL_SCALAR)
+        .value("SSE4", SIMD_LEVEL_SSE4)
+        .value("AVX2", SIMD_LEVEL_AVX2)
+        .value("AVX512", SIMD_LEVEL_AVX512);
+
+    m.def("get_simd_level", &simd_get_level, "Get the instruction set the physics kernels currently use.");
+    m.def("set_simd_level", &simd_set_level, py::arg("level"),
+          "Force the physics kernels to an instruction set, clamped to what the CPU supports. Returns the level in use.");
+    m.def("detect_simd_level", &simd_detect_level, "Get the best instruction set this CPU supports.");
 }
@@ -2,7 +2,10 @@
 #define COLLISION_H
 
 #include "vec3.h"
+#include "quat.h"
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -15,8 +18,175 @@ typedef struct {
     float depth;    // The amount of overlap/penetration
 } CollisionInfo;
 
+// Defines an Axis-Aligned Bounding Box
+typedef struct {
+    Vec3 min;
+    Vec3 max;
+} AABB;
+
+#define MAX_MANIFOLD_POINTS 4
+
+// One point of a contact manifold
+typedef struct {
+    Vec3 point;           // World space, midway between the two surfaces
+    float depth;          // Penetration at this point
+    uint32_t feature_id;  // Identifies the pair of features that made the point, stable while they stay in contact
+} ManifoldPoint;
+
+// The contact points of a shape pair, all sharing one normal
+typedef struct {
+    Vec3 normal;          // Unit length, pointing from A to B
+    int point_count;
+    ManifoldPoint points[MAX_MANIFOLD_POINTS];
+} ContactManifold;
+
 CollisionInfo test_sphere_vs_sphere(Vec3 pos_a, float radius_a, Vec3 pos_b, float radius_b);
-CollisionInfo test_sphere_vs_box(Vec3 sphere_pos, float sphere_radius, Vec3 box_pos, Vec3 box_extents);
+// The box is oriented by box_rot, with box_extents as its half extents along its local axes
+CollisionInfo test_sphere_vs_box(Vec3 sphere_pos, float sphere_radius, Vec3 box_pos, Quat box_rot, Vec3 box_extents);
+
+/**
+ * Separating axis test of two oriented boxes. On overlap, fills the manifold with
+ * up to MAX_MANIFOLD_POINTS points: the incident face clipped against the reference
+ * face for face contact, or the closest points of the two edges for edge contact.
+ * Face contact also keeps the points a little apart, with a negative depth, for the solver to
+ * stop before they touch.
+ * @param extents_a, extents_b Half extents along each box's local axes.
+ * @return True if the boxes overlap.
+ */
+bool test_box_vs_box(Vec3 pos_a, Quat rot_a, Vec3 extents_a, Vec3 pos_b, Quat rot_b, Vec3 extents_b,
+                     ContactManifold* manifold);
+
+/**
+ * Tests of the round shapes, each filling a manifold whose normal points from the first
+ * shape to the second, and returning true on overlap. Capsules and cylinders are centered
+ * on their position with their axis along their local Y: a capsule is everything within
+ * its radius of the segment from -half_height to half_height, and a cylinder spans
+ * half_height to either side of its center. Planes are solid below the surface through
+ * plane_pos that faces along the unit plane_normal.
+ */
+bool test_sphere_vs_capsule(Vec3 sphere_pos, float sphere_radius, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                            float cap_half_height, ContactManifold* manifold);
+bool test_sphere_vs_cylinder(Vec3 sphere_pos, float sphere_radius, Vec3 cyl_pos, Quat cyl_rot, float cyl_radius,
+                             float cyl_half_height, ContactManifold* manifold);
+bool test_sphere_vs_plane(Vec3 sphere_pos, float sphere_radius, Vec3 plane_pos, Vec3 plane_normal, ContactManifold* manifold);
+bool test_box_vs_capsule(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                         float cap_half_height, ContactManifold* manifold);
+// Separating axis test on the box's faces, the cylinder's axis and the box's edges crossed with it, with the cylinder's rim
+// points inside the box and the box's corners inside the cylinder as contacts. Edge contacts without either go through GJK/EPA.
+bool test_box_vs_cylinder(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 cyl_pos, Quat cyl_rot, float cyl_radius,
+                          float cyl_half_height, ContactManifold* manifold);
+bool test_box_vs_plane(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 plane_pos, Vec3 plane_normal,
+                       ContactManifold* manifold);
+bool test_cylinder_vs_capsule(Vec3 cyl_pos, Quat cyl_rot, float cyl_radius, float cyl_half_height, Vec3 cap_pos,
+                              Quat cap_rot, float cap_radius, float cap_half_height, ContactManifold* manifold);
+bool test_cylinder_vs_plane(Vec3 cyl_pos, Quat cyl_rot, float cyl_radius, float cyl_half_height, Vec3 plane_pos,
+                            Vec3 plane_normal, ContactManifold* manifold);
+bool test_capsule_vs_capsule(Vec3 pos_a, Quat rot_a, float radius_a, float half_height_a, Vec3 pos_b, Quat rot_b,
+                             float radius_b, float half_height_b, ContactManifold* manifold);
+bool test_capsule_vs_plane(Vec3 cap_pos, Quat cap_rot, float cap_radius, float cap_half_height, Vec3 plane_pos,
+                           Vec3 plane_normal, ContactManifold* manifold);
+// The hull's points are in its local frame. Up to four of the points below the plane become contacts.
+bool test_convex_hull_vs_plane(Vec3 hull_pos, Quat hull_rot, const Vec3* vertices, size_t vertex_count, Vec3 plane_pos,
+                               Vec3 plane_normal, ContactManifold* manifold);
+
+// Where a moving sphere first touches a shape
+typedef struct {
+    float toi;    // Fraction of the motion covered before the contact, in [0, 1]
+    Vec3 normal;  // Unit surface normal at the contact, pointing from the shape to the sphere
+    Vec3 point;   // Contact point on the shape's surface
+} SweepHit;
+
+/**
+ * Continuous tests of a sphere of 'radius' moving from 'start' to 'start + motion' against a
+ * shape that holds still, with the shapes laid out as in the tests above. They find the first
+ * contact however far the sphere moves, so a fast sphere cannot pass through a thin shape.
+ * A sphere that already overlaps the shape at 'start', or that moves away from it, does not hit.
+ * @return True on a hit, with 'hit' filled in.
+ */
+bool sweep_sphere_vs_sphere(Vec3 start, Vec3 motion, float radius, Vec3 other_pos, float other_radius, SweepHit* hit);
+bool sweep_sphere_vs_box(Vec3 start, Vec3 motion, float radius, Vec3 box_pos, Quat box_rot, Vec3 box_extents,
+                         SweepHit* hit);
+bool sweep_sphere_vs_capsule(Vec3 start, Vec3 motion, float radius, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                             float cap_half_height, SweepHit* hit);
+bool sweep_sphere_vs_cylinder(Vec3 start, Vec3 motion, float radius, Vec3 cyl_pos, Quat cyl_rot, float cyl_radius,
+                              float cyl_half_height, SweepHit* hit);
+bool sweep_sphere_vs_plane(Vec3 start, Vec3 motion, float radius, Vec3 plane_pos, Vec3 plane_normal, SweepHit* hit);
+
+/**
+ * A node of a mesh's bounding volume hierarchy. Nodes are stored depth first, so the
+ * first child of an inner node is the node after it; 'offset' holds the second one.
+ */
+typedef struct {
+    AABB bounds;      // In the mesh's frame
+    uint32_t offset;  // Leaf: first triangle; inner node: index of the second child
+    uint32_t count;   // Triangles of a leaf, 0 for inner nodes
+} BvhNode;
+
+// A triangle mesh with its BVH, in the mesh's local frame. Nothing is owned: the arrays live with the mesh.
+typedef struct {
+    const Vec3* vertices;
+    const unsigned int* indices;  // Three per triangle, in the order mesh_bvh_build left them
+    size_t triangle_count;
+    const BvhNode* nodes;         // Root first
+    size_t node_count;
+} MeshShape;
+
+// Nodes a BVH over 'triangle_count' triangles can need
+size_t mesh_bvh_max_nodes(size_t triangle_count);
+/**
+ * Builds a BVH over a mesh's triangles, reordering their indices so each leaf's triangles
+ * are contiguous. Leaves hold a few triangles each.
+ * @param nodes Room for mesh_bvh_max_nodes(triangle_count) nodes.
+ * @return The number of nodes used.
+ */
+size_t mesh_bvh_build(const Vec3* vertices, unsigned int* indices, size_t triangle_count, BvhNode* nodes);
+/**
+ * Checks a BVH that was not built here, e.g. read from a file: that every inner node's children
+ * follow it within the nodes, no deeper than the queries walk, and every leaf's triangles are the mesh's.
+ * The triangles' vertex indices are not checked.
+ */
+bool mesh_bvh_is_valid(const MeshShape* mesh);
+
+/**
+ * Tests of shapes against a static triangle mesh, walking its BVH down to the triangles near
+ * the shape. Triangles are two-sided: a shape is pushed back out on the side its center is.
+ * Contacts against differently facing triangles keep the deepest one's side, like the round
+ * shape tests. The manifold normal points from the shape to the mesh.
+ */
+bool test_sphere_vs_mesh(Vec3 sphere_pos, float sphere_radius, Vec3 mesh_pos, Quat mesh_rot, const MeshShape* mesh,
+                         ContactManifold* manifold);
+bool test_box_vs_mesh(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 mesh_pos, Quat mesh_rot, const MeshShape* mesh,
+                      ContactManifold* manifold);
+bool test_cylinder_vs_mesh(Vec3 cyl_pos, Quat cyl_rot, float cyl_radius, float cyl_half_height, Vec3 mesh_pos,
+                           Quat mesh_rot, const MeshShape* mesh, ContactManifold* manifold);
+// The hull's points are in its local frame, as in test_convex_hull_vs_plane
+bool test_convex_hull_vs_mesh(Vec3 hull_pos, Quat hull_rot, const Vec3* vertices, size_t vertex_count, Vec3 mesh_pos,
+                              Quat mesh_rot, const MeshShape* mesh, ContactManifold* manifold);
+bool test_capsule_vs_mesh(Vec3 cap_pos, Quat cap_rot, float cap_radius, float cap_half_height, Vec3 mesh_pos,
+                          Quat mesh_rot, const MeshShape* mesh, ContactManifold* manifold);
+bool sweep_sphere_vs_mesh(Vec3 start, Vec3 motion, float radius, Vec3 mesh_pos, Quat mesh_rot, const MeshShape* mesh,
+                          SweepHit* hit);
+
+/**
+ * Batch versions of the tests above: pair i is tested into results[i]. As in
+ * the single-pair tests, the sphere-sphere normal points from A to B and the
+ * sphere-box normal from the box to the sphere. Dispatched at runtime to the
+ * best variant for the CPU (see cpu_dispatch.h).
+ */
+void test_spheres_vs_spheres(const Vec3* centers_a, const float* radii_a, const Vec3* centers_b,
+                             const float* radii_b, size_t count, CollisionInfo* results);
+void test_spheres_vs_boxes(const Vec3* sphere_centers, const float* radii, const Vec3* box_centers,
+                           const Quat* box_orientations, const Vec3* box_extents, size_t count, CollisionInfo* results);
+
+/**
+ * Computes the world-space AABBs of a batch of bodies from their local-space bounds.
+ * All arrays hold 'count' elements.
+ * @param positions Body origins in world space.
+ * @param orientations Body rotations.
+ * @param local_bounds Bounds of each body's shape in its local frame.
+ * @param world_bounds Output AABBs.
+ */
+void update_aabbs(const Vec3* positions, const Quat* orientations, const AABB* local_bounds, AABB* world_bounds, size_t count);
 
 #ifdef __cplusplus
 }
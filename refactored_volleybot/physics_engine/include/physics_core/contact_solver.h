@@ -0,0 +1,120 @@
+#ifndef CONTACT_SOLVER_H
+#define CONTACT_SOLVER_H
+
+#include "simd_math.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One direction the contact solver pushes along (the normal or a friction
+// direction), with the Jacobian terms precomputed so the solver loop only does dot products.
+typedef struct {
+    Vec4 direction;
+    Vec4 r_a_cross;  // r_a x direction
+    Vec4 r_b_cross;  // r_b x direction
+    Vec4 angular_a;  // World inverse inertia of A times r_a_cross
+    Vec4 angular_b;  // World inverse inertia of B times r_b_cross
+    float mass;      // Inverse of the effective mass along the direction
+} ContactRow;
+
+// The solver's view of one contact between bodies body_a and body_b of a body store
+typedef struct {
+    ContactRow rows[3];  // The normal, then the two friction directions
+    float accumulated_impulse;
+    float accumulated_friction[2];
+    float friction;
+    float velocity_bias; // Target separating speed from restitution
+    float position_bias; // Separating speed that pushes the depth beyond the slop out, in the position solve
+    float accumulated_push;
+    uint32_t body_a, body_b;
+} SolverContact;
+
+// Velocities of the two bodies of a contact, kept in registers for the duration of a solve
+typedef struct {
+    Vec4 v_a, w_a, v_b, w_b;
+} ContactVelocities;
+
+/**
+ * Fills in the Jacobian terms of one row. The inverse inertias are in world space.
+ * Pass an inverse mass of 0 for static bodies; they then get no angular response either.
+ */
+PHYSICS_INLINE void contact_row_prepare(ContactRow* row, Vec4 direction, Vec4 r_a, Vec4 r_b,
+                                        float inv_mass_a, const Mat4* inv_inertia_a,
+                                        float inv_mass_b, const Mat4* inv_inertia_b) {
+    Vec4 zero = {0.0f, 0.0f, 0.0f, 0.0f};
+    row->direction = direction;
+    row->r_a_cross = vec4_cross3(r_a, direction);
+    row->r_b_cross = vec4_cross3(r_b, direction);
+    row->angular_a = inv_mass_a > 0.0f ? mat4_simd_transform_direction(inv_inertia_a, row->r_a_cross) : zero;
+    row->angular_b = inv_mass_b > 0.0f ? mat4_simd_transform_direction(inv_inertia_b, row->r_b_cross) : zero;
+
+    float angular_component = vec4_dot3(row->angular_a, row->r_a_cross) + vec4_dot3(row->angular_b, row->r_b_cross);
+    float effective_mass = inv_mass_a + inv_mass_b + angular_component;
+
+    // Prevent division by zero or very small numbers
+    row->mass = effective_mass > 1e-6f ? 1.0f / effective_mass : 0.0f;
+}
+
+// Speed of body B relative to body A at the contact point, along the row's direction
+PHYSICS_INLINE float contact_row_relative_speed(const ContactRow* row, const ContactVelocities* vel) {
+    return vec4_dot3(vec4_sub(vel->v_b, vel->v_a), row->direction) +
+           vec4_dot3(vel->w_b, row->r_b_cross) - vec4_dot3(vel->w_a, row->r_a_cross);
+}
+
+// Applies an impulse of the given magnitude along the row to body B, and its opposite to body A
+PHYSICS_INLINE void contact_row_apply(const ContactRow* row, float impulse, float inv_mass_a, float inv_mass_b,
+                                      ContactVelocities* vel) {
+    vel->v_a = vec4_add_scaled(vel->v_a, row->direction, -impulse * inv_mass_a);
+    vel->w_a = vec4_add_scaled(vel->w_a, row->angular_a, -impulse);
+    vel->v_b = vec4_add_scaled(vel->v_b, row->direction, impulse * inv_mass_b);
+    vel->w_b = vec4_add_scaled(vel->w_b, row->angular_b, impulse);
+}
+
+PHYSICS_INLINE ContactVelocities contact_velocities_load(const SolverContact* c, const Vec3* velocities,
+                                                         const Vec3* angular_velocities) {
+    ContactVelocities vel;
+    vel.v_a = vec4_load3(&velocities[c->body_a]);
+    vel.w_a = vec4_load3(&angular_velocities[c->body_a]);
+    vel.v_b = vec4_load3(&velocities[c->body_b]);
+    vel.w_b = vec4_load3(&angular_velocities[c->body_b]);
+    return vel;
+}
+
+// Static bodies are not written back: they may be in contact with several islands being solved at once
+PHYSICS_INLINE void contact_velocities_store(const SolverContact* c, const ContactVelocities* vel,
+                                             float inv_mass_a, float inv_mass_b,
+                                             Vec3* velocities, Vec3* angular_velocities) {
+    if (inv_mass_a > 0.0f) {
+        vec4_store3(vel->v_a, &velocities[c->body_a]);
+        vec4_store3(vel->w_a, &angular_velocities[c->body_a]);
+    }
+    if (inv_mass_b > 0.0f) {
+        vec4_store3(vel->v_b, &velocities[c->body_b]);
+        vec4_store3(vel->w_b, &angular_velocities[c->body_b]);
+    }
+}
+
+/**
+ * Runs one sequential impulse sweep over the contacts: friction clamped by the
+ * accumulated normal impulse, then the non-penetration impulse.
+ * Dispatched at runtime to the best variant for the CPU (see cpu_dispatch.h).
+ */
+void solve_contacts(SolverContact* contacts, size_t count, Vec3* velocities, Vec3* angular_velocities,
+                    const float* inverse_masses);
+
+/**
+ * Runs one sweep of the split impulse position solve: pushes along the normals until the bodies'
+ * correction velocities separate each contact at its position_bias. These velocities move the
+ * bodies for one step and are then dropped, so the correction adds no energy to the real velocities.
+ */
+void solve_contact_positions(SolverContact* contacts, size_t count, Vec3* correction_velocities,
+                             Vec3* correction_angular_velocities, const float* inverse_masses);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CONTACT_SOLVER_H
@@ -0,0 +1,73 @@
+#ifndef CPU_DISPATCH_H
+#define CPU_DISPATCH_H
+
+#include "vec3.h"
+#include "quat.h"
+#include "collision.h"
+#include "contact_solver.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Runtime selection of the hot batch kernels. Every kernel is compiled once per
+ * instruction set, and the best variant the CPU supports is picked when the
+ * library loads, so a single binary runs at full speed on every machine.
+ *
+ * The level can be forced with the VOLLEYBOT_SIMD_LEVEL environment variable
+ * (scalar, sse4, avx2 or avx512) or with simd_set_level(), e.g. to compare the
+ * speed and results of the variants.
+ */
+
+typedef enum {
+    SIMD_LEVEL_SCALAR = 0,
+    SIMD_LEVEL_SSE4 = 1,
+    SIMD_LEVEL_AVX2 = 2,
+    SIMD_LEVEL_AVX512 = 3
+} SimdLevel;
+
+typedef struct {
+    void (*integrate_bodies)(Vec3* positions, Vec3* velocities, Vec3* accelerations, const uint8_t* flags,
+                             size_t count, Vec3 gravity, float dt);
+    void (*integrate_orientations)(Quat* orientations, const Vec3* angular_velocities, const uint8_t* flags,
+                                   size_t count, float dt);
+    void (*update_inverse_inertias)(const Quat* orientations, const Mat4* local_inverse_inertias,
+                                    Mat4* world_inverse_inertias, size_t count);
+    void (*update_aabbs)(const Vec3* positions, const Quat* orientations, const AABB* local_bounds,
+                         AABB* world_bounds, size_t count);
+    void (*test_spheres_vs_spheres)(const Vec3* centers_a, const float* radii_a, const Vec3* centers_b,
+                                    const float* radii_b, size_t count, CollisionInfo* results);
+    void (*test_spheres_vs_boxes)(const Vec3* sphere_centers, const float* radii, const Vec3* box_centers,
+                                  const Quat* box_orientations, const Vec3* box_extents, size_t count,
+                                  CollisionInfo* results);
+    void (*solve_contacts)(SolverContact* contacts, size_t count, Vec3* velocities, Vec3* angular_velocities,
+                           const float* inverse_masses);
+    void (*solve_contact_positions)(SolverContact* contacts, size_t count, Vec3* correction_velocities,
+                                    Vec3* correction_angular_velocities, const float* inverse_masses);
+} PhysicsKernels;
+
+// The highest level both this CPU and this build support
+SimdLevel simd_detect_level(void);
+
+SimdLevel simd_get_level(void);
+
+/**
+ * Switches all kernels to the given level. Levels above simd_detect_level() are clamped.
+ * Not thread-safe: call it while no simulation is stepping.
+ * @return The level now in use.
+ */
+SimdLevel simd_set_level(SimdLevel level);
+
+const char* simd_level_name(SimdLevel level);
+
+// The kernel table for the current level
+const PhysicsKernels* physics_kernels(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CPU_DISPATCH_H
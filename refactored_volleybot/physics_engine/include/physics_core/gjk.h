@@ -0,0 +1,108 @@
+#ifndef GJK_H
+#define GJK_H
+
+#include "vec3.h"
+#include "quat.h"
+#include "collision.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Returns the point of a convex shape furthest along a direction. Both are in
+ * the shape's local frame, and the direction need not be unit length.
+ * Any convex shape that can answer this goes through GJK and EPA.
+ */
+typedef Vec3 (*SupportFunction)(const void* shape, Vec3 direction);
+
+// A convex shape placed in the world
+typedef struct {
+    SupportFunction support;
+    const void* shape;  // Passed to support
+    Vec3 position;
+    Quat orientation;
+} ConvexObject;
+
+// Shape data of the built-in support functions below, with the same local frames as the analytic tests in collision.h
+typedef struct {
+    float radius;          // Sphere, capsule and cylinder
+    float half_height;     // Capsule and cylinder
+    Vec3 extents;          // Box half extents
+    const Vec3* vertices;  // Convex hull points
+    size_t vertex_count;
+} ConvexShapeData;
+
+Vec3 support_sphere(const void* shape, Vec3 direction);
+Vec3 support_box(const void* shape, Vec3 direction);
+Vec3 support_capsule(const void* shape, Vec3 direction);
+Vec3 support_cylinder(const void* shape, Vec3 direction);
+// Scans every point, so hulls should be reduced to their corners first
+Vec3 support_convex_hull(const void* shape, Vec3 direction);
+
+// The simplex a GJK query ended with, as the support points on each shape in its local frame
+typedef struct {
+    int count;
+    Vec3 local_a[4];
+    Vec3 local_b[4];
+} GjkCache;
+
+typedef struct {
+    bool overlapping;
+    float distance;  // 0 when overlapping
+    Vec3 point_a;    // Closest points in world space, when separated
+    Vec3 point_b;
+    int iterations;
+} GjkResult;
+
+/**
+ * GJK distance query between two convex objects. The query starts from the simplex
+ * in 'cache', mapped through the objects' current transforms, and leaves its final
+ * simplex there. Between steps the objects barely move, so a warm started query
+ * usually converges in one or two iterations. A zeroed cache starts from scratch.
+ * @return True if the objects overlap.
+ */
+bool gjk_distance(const ConvexObject* a, const ConvexObject* b, GjkCache* cache, GjkResult* result);
+
+/**
+ * Continuous test of a sphere moving from 'start' by 'motion' against a convex object that holds
+ * still, like the sweep_sphere_vs_* tests of collision.h.
+ * @return True on a hit, with 'hit' filled in.
+ */
+bool sweep_sphere_vs_convex(Vec3 start, Vec3 motion, float radius, const ConvexObject* shape, SweepHit* hit);
+
+// A manifold point kept across steps, anchored in both bodies' local frames
+typedef struct {
+    Vec3 local_a;
+    Vec3 local_b;
+    uint32_t feature_id;
+} PersistentPoint;
+
+// Everything the convex narrow phase keeps for one pair between steps. Zero it for a new pair.
+typedef struct {
+    GjkCache simplex;
+    Vec3 normal;     // Normal of the last manifold
+    int point_count;
+    PersistentPoint points[MAX_MANIFOLD_POINTS];
+    uint32_t next_feature_id;
+} ConvexPairCache;
+
+/**
+ * General convex-vs-convex test: GJK finds whether the objects overlap, and EPA
+ * (expanding polytope) the normal and depth. That gives one contact point per
+ * step, so the pair cache adds it to the points of earlier steps that still touch,
+ * which builds up a full manifold for resting contact over a few steps. Cached points
+ * that have separated are kept for later steps but left out of the manifold.
+ * @return True if the objects overlap, with the manifold normal pointing from A to B.
+ */
+bool test_convex_vs_convex(const ConvexObject* a, const ConvexObject* b, ConvexPairCache* cache,
+                           ContactManifold* manifold);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GJK_H
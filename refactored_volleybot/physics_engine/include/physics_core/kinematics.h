@@ -2,6 +2,10 @@
 #define KINEMATICS_H
 
 #include "vec3.h"
+#include "quat.h"
+#include "mat4.h"
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,6 +21,38 @@ extern "C" {
  */
 void update_kinematics(Vec3* position, Vec3* velocity, const Vec3* acceleration, float dt);
 
+/* Per-body flags used by the batched kernels. */
+enum {
+    BODY_FLAG_STATIC = 1 << 0,    /* Zero mass, never moves */
+    BODY_FLAG_CHILD = 1 << 1,     /* Part of a composite object, placed by its parent */
+    BODY_FLAG_COMPOSITE = 1 << 2, /* Bounds are the union of its parts */
+    BODY_FLAG_BULLET = 1 << 3,    /* Swept along its motion every step (continuous collision) */
+    BODY_FLAG_SLEEPING = 1 << 4   /* At rest with its island; not moved, collided or solved until woken */
+};
+
+/**
+ * Integrates a batch of bodies stored as separate arrays, using the same scheme as update_kinematics.
+ * Gravity is added to each body's acceleration, which is then reset to zero for the next step.
+ * Bodies flagged BODY_FLAG_STATIC, BODY_FLAG_CHILD or BODY_FLAG_SLEEPING are skipped.
+ * @param count The number of elements in every array.
+ */
+void integrate_bodies(Vec3* positions, Vec3* velocities, Vec3* accelerations, const uint8_t* flags,
+                      size_t count, Vec3 gravity, float dt);
+
+/**
+ * Turns a batch of orientations by their angular velocities over dt, q += 0.5 * dt * (w, 0) * q, and
+ * renormalizes them. Bodies flagged BODY_FLAG_STATIC, BODY_FLAG_CHILD or BODY_FLAG_SLEEPING are skipped.
+ */
+void integrate_orientations(Quat* orientations, const Vec3* angular_velocities, const uint8_t* flags,
+                            size_t count, float dt);
+
+/**
+ * Rotates a batch of body-space inverse inertia tensors into world space, R * I^-1 * R^T with R built
+ * from each body's orientation. Only the upper 3x3 of the matrices is used, and the tensors must be symmetric.
+ */
+void update_inverse_inertias(const Quat* orientations, const Mat4* local_inverse_inertias,
+                             Mat4* world_inverse_inertias, size_t count);
+
 #ifdef __cplusplus
 }
 #endif
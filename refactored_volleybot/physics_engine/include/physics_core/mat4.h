@@ -2,14 +2,16 @@
 #define MAT4_H
 
 #include "vec3.h"
+#include "platform.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 // Represents a 4x4 matrix, stored in column-major order for graphics API compatibility.
+// Aligned so that each column can be loaded into one SSE register.
 typedef struct {
-    float m[4][4];
+    PHYSICS_ALIGN(16) float m[4][4];
 } Mat4;
 
 /* --- Core Matrix Operations --- */
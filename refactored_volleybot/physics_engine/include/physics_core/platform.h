@@ -0,0 +1,45 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+/*
+ * Compiler and instruction set detection shared by the math headers.
+ * The SIMD level is chosen at compile time from the target flags
+ * (e.g. -msse4.1 or -mavx2 -mfma, see VOLLEYBOT_SIMD in CMakeLists.txt).
+ */
+
+#if defined(__cplusplus)
+#define PHYSICS_ALIGN(n) alignas(n)
+#elif defined(_MSC_VER)
+#define PHYSICS_ALIGN(n) __declspec(align(n))
+#else
+#define PHYSICS_ALIGN(n) _Alignas(n)
+#endif
+
+#if defined(_MSC_VER)
+#define PHYSICS_INLINE static __forceinline
+#else
+#define PHYSICS_INLINE static inline __attribute__((always_inline))
+#endif
+
+/* Defining PHYSICS_NO_SIMD forces the scalar fallbacks, e.g. to compare results. */
+#if !defined(PHYSICS_NO_SIMD)
+#if defined(__AVX2__)
+#define PHYSICS_SIMD_AVX2 1
+#endif
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define PHYSICS_SIMD_SSE4 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PHYSICS_SIMD_SSE 1
+#endif
+#endif
+
+#if defined(PHYSICS_SIMD_AVX2)
+#include <immintrin.h>
+#elif defined(PHYSICS_SIMD_SSE4)
+#include <smmintrin.h>
+#elif defined(PHYSICS_SIMD_SSE)
+#include <emmintrin.h>
+#endif
+
+#endif // PLATFORM_H
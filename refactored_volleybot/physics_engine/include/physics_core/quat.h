@@ -0,0 +1,28 @@
+#ifndef QUAT_H
+#define QUAT_H
+
+#include "vec3.h"
+#include "mat4.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Represents a rotation as a unit quaternion (x, y, z is the vector part, w the scalar part).
+typedef struct {
+    float x, y, z, w;
+} Quat;
+
+void quat_identity(Quat* result);
+void quat_from_axis_angle(Vec3 axis, float angle_rad, Quat* result);
+void quat_multiply(const Quat* a, const Quat* b, Quat* result);
+void quat_normalize(const Quat* q, Quat* result);
+Vec3 quat_rotate(const Quat* q, Vec3 v);
+/* Writes the rotation into the upper 3x3 of 'result' and sets the rest to identity. */
+void quat_to_mat4(const Quat* q, Mat4* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // QUAT_H
@@ -0,0 +1,285 @@
+#ifndef SIMD_MATH_H
+#define SIMD_MATH_H
+
+#include "platform.h"
+#include "vec3.h"
+#include "mat4.h"
+
+/*
+ * Inline SIMD math kernels. These are the implementations behind the vec3_*
+ * and mat4_* functions; C++ code in hot loops (the contact and joint solvers)
+ * includes this header directly so the calls are inlined instead of going
+ * through the exported C functions.
+ *
+ * Vec4 is a 16-byte aligned vector that fits one SSE register. The *3
+ * functions ignore and zero the w component. Every kernel has an SSE and, where
+ * it pays off, an AVX2 path plus a scalar fallback, picked at compile time.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    PHYSICS_ALIGN(16) float x;
+    float y, z, w;
+} Vec4;
+
+#if defined(PHYSICS_SIMD_SSE)
+PHYSICS_INLINE __m128 vec4_reg(Vec4 v) { return _mm_load_ps(&v.x); }
+PHYSICS_INLINE Vec4 vec4_from_reg(__m128 r) { Vec4 v; _mm_store_ps(&v.x, r); return v; }
+// Broadcasts one lane of a register to all four lanes
+#define PHYSICS_SPLAT(r, i) _mm_shuffle_ps((r), (r), _MM_SHUFFLE(i, i, i, i))
+#if defined(__FMA__)
+#define PHYSICS_MADD(a, b, c) _mm_fmadd_ps((a), (b), (c))
+#define PHYSICS_MADD256(a, b, c) _mm256_fmadd_ps((a), (b), (c))
+#else
+#define PHYSICS_MADD(a, b, c) _mm_add_ps(_mm_mul_ps((a), (b)), (c))
+#define PHYSICS_MADD256(a, b, c) _mm256_add_ps(_mm256_mul_ps((a), (b)), (c))
+#endif
+#endif
+
+/* --- Conversion --- */
+PHYSICS_INLINE Vec4 vec4_load3(const Vec3* v) {
+    Vec4 result = {v->x, v->y, v->z, 0.0f};
+    return result;
+}
+
+PHYSICS_INLINE void vec4_store3(Vec4 v, Vec3* result) {
+    result->x = v.x;
+    result->y = v.y;
+    result->z = v.z;
+}
+
+PHYSICS_INLINE Vec3 vec4_to_vec3(Vec4 v) {
+    Vec3 result = {v.x, v.y, v.z};
+    return result;
+}
+
+/* --- Arithmetic --- */
+PHYSICS_INLINE Vec4 vec4_add(Vec4 a, Vec4 b) {
+#if defined(PHYSICS_SIMD_SSE)
+    return vec4_from_reg(_mm_add_ps(vec4_reg(a), vec4_reg(b)));
+#else
+    Vec4 result = {a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+    return result;
+#endif
+}
+
+PHYSICS_INLINE Vec4 vec4_sub(Vec4 a, Vec4 b) {
+#if defined(PHYSICS_SIMD_SSE)
+    return vec4_from_reg(_mm_sub_ps(vec4_reg(a), vec4_reg(b)));
+#else
+    Vec4 result = {a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w};
+    return result;
+#endif
+}
+
+PHYSICS_INLINE Vec4 vec4_scale(Vec4 v, float s) {
+#if defined(PHYSICS_SIMD_SSE)
+    return vec4_from_reg(_mm_mul_ps(vec4_reg(v), _mm_set1_ps(s)));
+#else
+    Vec4 result = {v.x * s, v.y * s, v.z * s, v.w * s};
+    return result;
+#endif
+}
+
+// a + b * s
+PHYSICS_INLINE Vec4 vec4_add_scaled(Vec4 a, Vec4 b, float s) {
+#if defined(PHYSICS_SIMD_SSE)
+    return vec4_from_reg(PHYSICS_MADD(vec4_reg(b), _mm_set1_ps(s), vec4_reg(a)));
+#else
+    Vec4 result = {a.x + b.x * s, a.y + b.y * s, a.z + b.z * s, a.w + b.w * s};
+    return result;
+#endif
+}
+
+/* --- Products --- */
+PHYSICS_INLINE float vec4_dot3(Vec4 a, Vec4 b) {
+#if defined(PHYSICS_SIMD_SSE4)
+    return _mm_cvtss_f32(_mm_dp_ps(vec4_reg(a), vec4_reg(b), 0x71));
+#elif defined(PHYSICS_SIMD_SSE)
+    __m128 product = _mm_mul_ps(vec4_reg(a), vec4_reg(b));
+    __m128 sum = _mm_add_ss(product, _mm_shuffle_ps(product, product, _MM_SHUFFLE(1, 1, 1, 1)));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(product, product, _MM_SHUFFLE(2, 2, 2, 2)));
+    return _mm_cvtss_f32(sum);
+#else
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+#endif
+}
+
+PHYSICS_INLINE Vec4 vec4_cross3(Vec4 a, Vec4 b) {
+#if defined(PHYSICS_SIMD_SSE)
+    // (a * b.yzx - a.yzx * b).yzx
+    __m128 ra = vec4_reg(a);
+    __m128 rb = vec4_reg(b);
+    __m128 a_yzx = _mm_shuffle_ps(ra, ra, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 b_yzx = _mm_shuffle_ps(rb, rb, _MM_SHUFFLE(3, 0, 2, 1));
+    __m128 c = _mm_sub_ps(_mm_mul_ps(ra, b_yzx), _mm_mul_ps(a_yzx, rb));
+    return vec4_from_reg(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+#else
+    Vec4 result = {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x, 0.0f};
+    return result;
+#endif
+}
+
+PHYSICS_INLINE float vec4_length3(Vec4 v) {
+    return sqrtf(vec4_dot3(v, v));
+}
+
+// Returns the zero vector for a zero-length input, like vec3_normalize
+PHYSICS_INLINE Vec4 vec4_normalize3(Vec4 v) {
+#if defined(PHYSICS_SIMD_SSE4)
+    __m128 r = vec4_reg(v);
+    __m128 length = _mm_sqrt_ps(_mm_dp_ps(r, r, 0x77));
+    __m128 nonzero = _mm_cmpgt_ps(length, _mm_setzero_ps());
+    return vec4_from_reg(_mm_and_ps(_mm_div_ps(r, length), nonzero));
+#else
+    float length = vec4_length3(v);
+    Vec4 zero = {0.0f, 0.0f, 0.0f, 0.0f};
+    return length > 0.0f ? vec4_scale(v, 1.0f / length) : zero;
+#endif
+}
+
+/* --- Matrix kernels (Mat4 is column-major and 16-byte aligned) --- */
+PHYSICS_INLINE void mat4_simd_multiply(const Mat4* a, const Mat4* b, Mat4* result) {
+#if defined(PHYSICS_SIMD_AVX2)
+    // Two result columns per 256-bit register: each 128-bit lane holds one column of b
+    __m256 a0 = _mm256_broadcast_ps((const __m128*)a->m[0]);
+    __m256 a1 = _mm256_broadcast_ps((const __m128*)a->m[1]);
+    __m256 a2 = _mm256_broadcast_ps((const __m128*)a->m[2]);
+    __m256 a3 = _mm256_broadcast_ps((const __m128*)a->m[3]);
+    __m256 b01 = _mm256_loadu_ps(b->m[0]);
+    __m256 b23 = _mm256_loadu_ps(b->m[2]);
+
+    __m256 r01 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b01, b01, 0x00));
+    r01 = PHYSICS_MADD256(a1, _mm256_shuffle_ps(b01, b01, 0x55), r01);
+    r01 = PHYSICS_MADD256(a2, _mm256_shuffle_ps(b01, b01, 0xAA), r01);
+    r01 = PHYSICS_MADD256(a3, _mm256_shuffle_ps(b01, b01, 0xFF), r01);
+
+    __m256 r23 = _mm256_mul_ps(a0, _mm256_shuffle_ps(b23, b23, 0x00));
+    r23 = PHYSICS_MADD256(a1, _mm256_shuffle_ps(b23, b23, 0x55), r23);
+    r23 = PHYSICS_MADD256(a2, _mm256_shuffle_ps(b23, b23, 0xAA), r23);
+    r23 = PHYSICS_MADD256(a3, _mm256_shuffle_ps(b23, b23, 0xFF), r23);
+
+    // Both inputs are fully read above, so result may alias a or b
+    _mm256_storeu_ps(result->m[0], r01);
+    _mm256_storeu_ps(result->m[2], r23);
+#elif defined(PHYSICS_SIMD_SSE)
+    __m128 a0 = _mm_load_ps(a->m[0]);
+    __m128 a1 = _mm_load_ps(a->m[1]);
+    __m128 a2 = _mm_load_ps(a->m[2]);
+    __m128 a3 = _mm_load_ps(a->m[3]);
+    __m128 columns[4];
+    for (int c = 0; c < 4; ++c) {
+        __m128 bc = _mm_load_ps(b->m[c]);
+        __m128 r = _mm_mul_ps(a0, PHYSICS_SPLAT(bc, 0));
+        r = PHYSICS_MADD(a1, PHYSICS_SPLAT(bc, 1), r);
+        r = PHYSICS_MADD(a2, PHYSICS_SPLAT(bc, 2), r);
+        r = PHYSICS_MADD(a3, PHYSICS_SPLAT(bc, 3), r);
+        columns[c] = r;
+    }
+    for (int c = 0; c < 4; ++c) {
+        _mm_store_ps(result->m[c], columns[c]);
+    }
+#else
+    Mat4 temp; // Allows result to alias a or b
+    for (int c = 0; c < 4; ++c) {
+        for (int r = 0; r < 4; ++r) {
+            temp.m[c][r] = a->m[0][r] * b->m[c][0] +
+                           a->m[1][r] * b->m[c][1] +
+                           a->m[2][r] * b->m[c][2] +
+                           a->m[3][r] * b->m[c][3];
+        }
+    }
+    *result = temp;
+#endif
+}
+
+// Rotates and scales a direction by the upper 3x3 of m
+PHYSICS_INLINE Vec4 mat4_simd_transform_direction(const Mat4* m, Vec4 v) {
+#if defined(PHYSICS_SIMD_SSE)
+    __m128 rv = vec4_reg(v);
+    __m128 r = _mm_mul_ps(_mm_load_ps(m->m[0]), PHYSICS_SPLAT(rv, 0));
+    r = PHYSICS_MADD(_mm_load_ps(m->m[1]), PHYSICS_SPLAT(rv, 1), r);
+    r = PHYSICS_MADD(_mm_load_ps(m->m[2]), PHYSICS_SPLAT(rv, 2), r);
+    // Clear w, which picked up the projective row of the matrix
+    return vec4_from_reg(_mm_and_ps(r, _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1))));
+#else
+    Vec4 result = {
+        m->m[0][0] * v.x + m->m[1][0] * v.y + m->m[2][0] * v.z,
+        m->m[0][1] * v.x + m->m[1][1] * v.y + m->m[2][1] * v.z,
+        m->m[0][2] * v.x + m->m[1][2] * v.y + m->m[2][2] * v.z,
+        0.0f
+    };
+    return result;
+#endif
+}
+
+// Transforms a point, including the perspective divide for non-affine matrices
+PHYSICS_INLINE Vec4 mat4_simd_transform_point(const Mat4* m, Vec4 v) {
+#if defined(PHYSICS_SIMD_SSE)
+    __m128 rv = vec4_reg(v);
+    __m128 r = PHYSICS_MADD(_mm_load_ps(m->m[0]), PHYSICS_SPLAT(rv, 0), _mm_load_ps(m->m[3]));
+    r = PHYSICS_MADD(_mm_load_ps(m->m[1]), PHYSICS_SPLAT(rv, 1), r);
+    r = PHYSICS_MADD(_mm_load_ps(m->m[2]), PHYSICS_SPLAT(rv, 2), r);
+    Vec4 result = vec4_from_reg(r);
+    float w = result.w;
+    if (w != 1.0f && w != 0.0f) {
+        result = vec4_scale(result, 1.0f / w);
+    }
+    result.w = 1.0f;
+    return result;
+#else
+    float w = m->m[0][3] * v.x + m->m[1][3] * v.y + m->m[2][3] * v.z + m->m[3][3];
+    if (w == 0.0f) w = 1.0f; // Avoid division by zero
+    Vec4 result = {
+        (m->m[0][0] * v.x + m->m[1][0] * v.y + m->m[2][0] * v.z + m->m[3][0]) / w,
+        (m->m[0][1] * v.x + m->m[1][1] * v.y + m->m[2][1] * v.z + m->m[3][1]) / w,
+        (m->m[0][2] * v.x + m->m[1][2] * v.y + m->m[2][2] * v.z + m->m[3][2]) / w,
+        1.0f
+    };
+    return result;
+#endif
+}
+
+// Inverts a rigid transform (rotation + translation) by transposing the rotation
+PHYSICS_INLINE void mat4_simd_affine_inverse(const Mat4* m, Mat4* result) {
+#if defined(PHYSICS_SIMD_SSE)
+    __m128 c0 = _mm_load_ps(m->m[0]);
+    __m128 c1 = _mm_load_ps(m->m[1]);
+    __m128 c2 = _mm_load_ps(m->m[2]);
+    __m128 t = _mm_load_ps(m->m[3]);
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    // After the transpose the w lanes of c0..c2 hold zeros from the zero column
+    __m128 translation = _mm_mul_ps(c0, PHYSICS_SPLAT(t, 0));
+    translation = PHYSICS_MADD(c1, PHYSICS_SPLAT(t, 1), translation);
+    translation = PHYSICS_MADD(c2, PHYSICS_SPLAT(t, 2), translation);
+    translation = _mm_sub_ps(_mm_set_ps(1.0f, 0.0f, 0.0f, 0.0f), translation);
+    _mm_store_ps(result->m[0], c0);
+    _mm_store_ps(result->m[1], c1);
+    _mm_store_ps(result->m[2], c2);
+    _mm_store_ps(result->m[3], translation);
+#else
+    Mat4 temp; // Allows result to alias m
+    temp.m[0][0] = m->m[0][0]; temp.m[0][1] = m->m[1][0]; temp.m[0][2] = m->m[2][0];
+    temp.m[1][0] = m->m[0][1]; temp.m[1][1] = m->m[1][1]; temp.m[1][2] = m->m[2][1];
+    temp.m[2][0] = m->m[0][2]; temp.m[2][1] = m->m[1][2]; temp.m[2][2] = m->m[2][2];
+
+    float tx = m->m[3][0], ty = m->m[3][1], tz = m->m[3][2];
+    temp.m[3][0] = -(tx * temp.m[0][0] + ty * temp.m[1][0] + tz * temp.m[2][0]);
+    temp.m[3][1] = -(tx * temp.m[0][1] + ty * temp.m[1][1] + tz * temp.m[2][1]);
+    temp.m[3][2] = -(tx * temp.m[0][2] + ty * temp.m[1][2] + tz * temp.m[2][2]);
+
+    temp.m[0][3] = 0.0f; temp.m[1][3] = 0.0f; temp.m[2][3] = 0.0f;
+    temp.m[3][3] = 1.0f;
+    *result = temp;
+#endif
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SIMD_MATH_H
@@ -0,0 +1,129 @@
+#ifndef AABB_TREE_H
+#define AABB_TREE_H
+
+#include "primitive.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * A dynamic bounding volume hierarchy of AABBs. Leaves store "fat" AABBs that
+ * are enlarged by a margin, so a body that only moves a little stays inside
+ * its leaf and the tree does not need to change. Inserts pick the sibling
+ * with the lowest surface area cost, and rotations keep the tree balanced.
+ */
+class DynamicAABBTree {
+public:
+    static const int32_t null_node = -1;
+    // Traversal stack depth. A balanced tree of a million leaves is ~30 levels deep.
+    static const int max_stack_depth = 256;
+
+    explicit DynamicAABBTree(float fat_margin = 0.05f);
+
+    /**
+     * Inserts a leaf for the given tight AABB and returns its proxy ID.
+     * @param aabb The tight AABB of the object. The stored bounds are fattened by the margin.
+     * @param user_data A value handed back by queries, e.g. the body index.
+     */
+    int32_t create_proxy(const AABB& aabb, uint32_t user_data);
+    void destroy_proxy(int32_t proxy_id);
+
+    /**
+     * Updates a proxy after its object moved. Nothing happens while the tight
+     * AABB is still inside the fat AABB.
+     * @param displacement The distance moved since the last update. The new fat AABB is extended along it.
+     * @return True if the leaf was reinserted.
+     */
+    bool move_proxy(int32_t proxy_id, const AABB& aabb, const Vec3& displacement);
+
+    uint32_t get_user_data(int32_t proxy_id) const { return nodes[proxy_id].user_data; }
+    const AABB& get_fat_aabb(int32_t proxy_id) const { return nodes[proxy_id].aabb; }
+    int get_height() const { return root == null_node ? 0 : nodes[root].height; }
+    int get_proxy_count() const { return proxy_count; }
+
+    /**
+     * Calls callback(user_data) for every leaf whose fat AABB overlaps 'aabb'.
+     * The callback returns false to stop the query early.
+     */
+    template <typename Callback>
+    void query(const AABB& aabb, Callback&& callback) const;
+
+    /**
+     * Casts a ray against the leaves' fat AABBs. callback(user_data, max_distance)
+     * is called for every leaf the ray enters before max_distance. It returns the
+     * new max_distance to clip the ray (e.g. the distance to an exact hit), the
+     * value it was given to continue unchanged, or 0 to stop.
+     * @param direction Must be normalized.
+     */
+    template <typename Callback>
+    void raycast(const Vec3& origin, const Vec3& direction, float max_distance, Callback&& callback) const;
+
+private:
+    struct TreeNode {
+        AABB aabb;
+        int32_t parent;   // Doubles as the "next" link while the node is free
+        int32_t child1;
+        int32_t child2;
+        int32_t height;   // Leaves have height 0, free nodes -1
+        uint32_t user_data;
+
+        bool is_leaf() const { return child1 == null_node; }
+    };
+
+    int32_t allocate_node();
+    void free_node(int32_t node_id);
+    void insert_leaf(int32_t leaf);
+    void remove_leaf(int32_t leaf);
+    int32_t balance(int32_t node_id);
+
+    static bool ray_hits_aabb(const AABB& box, const Vec3& origin, const Vec3& inv_direction, float max_distance);
+
+    std::vector<TreeNode> nodes;
+    int32_t root;
+    int32_t free_list;
+    int proxy_count;
+    float fat_margin;
+};
+
+template <typename Callback>
+void DynamicAABBTree::query(const AABB& aabb, Callback&& callback) const {
+    if (root == null_node) return;
+    int32_t stack[max_stack_depth];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0) {
+        const TreeNode& node = nodes[stack[--count]];
+        if (!aabb_overlap(node.aabb, aabb)) continue;
+        if (node.is_leaf()) {
+            if (!callback(node.user_data)) return;
+        } else {
+            if (count + 2 > max_stack_depth) continue; // Degenerate tree, cannot happen when balanced
+            stack[count++] = node.child1;
+            stack[count++] = node.child2;
+        }
+    }
+}
+
+template <typename Callback>
+void DynamicAABBTree::raycast(const Vec3& origin, const Vec3& direction, float max_distance, Callback&& callback) const {
+    if (root == null_node) return;
+    // Division by zero gives +/-inf, which the slab test handles correctly
+    Vec3 inv_direction = {1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z};
+    int32_t stack[max_stack_depth];
+    int count = 0;
+    stack[count++] = root;
+    while (count > 0) {
+        const TreeNode& node = nodes[stack[--count]];
+        if (!ray_hits_aabb(node.aabb, origin, inv_direction, max_distance)) continue;
+        if (node.is_leaf()) {
+            float new_max = callback(node.user_data, max_distance);
+            if (new_max <= 0.0f) return;
+            max_distance = new_max;
+        } else {
+            if (count + 2 > max_stack_depth) continue; // Degenerate tree, cannot happen when balanced
+            stack[count++] = node.child1;
+            stack[count++] = node.child2;
+        }
+    }
+}
+
+#endif // AABB_TREE_H
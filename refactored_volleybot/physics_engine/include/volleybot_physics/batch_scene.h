@@ -0,0 +1,88 @@
+#ifndef BATCH_SCENE_H
+#define BATCH_SCENE_H
+
+#include "scene.h"
+#include "joint.h"
+#include "body_store.h"
+#include <memory>
+#include <vector>
+
+/**
+ * N independent copies ("worlds") of a template Scene that are stepped together
+ * in one call, e.g. the environments of a vectorized RL rollout.
+ *
+ * All worlds share one BodyStore with the bodies laid out world-major: world w
+ * owns the slots [w * bodies_per_world, (w + 1) * bodies_per_world), in the
+ * template's order. Integration and the AABB refresh run once over the whole
+ * store, so they vectorize across worlds. Collision detection, the contact cache
+ * and the solver stay per world, so worlds never interact, and whole worlds are
+ * stepped in parallel on the TaskScheduler.
+ *
+ * Actions drive the revolute joint motors: each world takes one target speed per
+ * joint, in the template's Scene::get_revolute_joints() order. The motors'
+ * max force is taken from the template.
+ */
+class BatchScene {
+public:
+    /**
+     * Builds the worlds from the template's current bodies, joints, gravity, solver settings
+     * and broadphase type. The template is only read, and can be changed or dropped afterwards.
+     */
+    BatchScene(const Scene& template_scene, int num_worlds);
+
+    /**
+     * Advances every world by dt.
+     * @param actions get_action_size() motor speeds per world, world-major, or nullptr to keep the current speeds.
+     */
+    void step(const float* actions, float dt);
+    // Applies the actions once, then advances n agent steps of frame_skip substeps of dt each
+    void step_n(const float* actions, float dt, int n, int frame_skip = 1);
+
+    // Puts one world back into the state it was built in, motor targets included. Out of range indices are ignored.
+    void reset_world(int world);
+    void reset();
+
+    // Saves one world's bodies, motor targets and contact cache (see snapshot.h). Out of range indices leave 'out' empty.
+    void save_world_snapshot(int world, std::vector<uint8_t>& out) const;
+    // Restores a snapshot of any world of this batch, or of a scene built like its template, into one world
+    bool restore_world_snapshot(int world, const uint8_t* data, size_t size);
+    // Overwrites world 'dst' with the current state of world 'src', e.g. to branch rollouts from one state
+    bool copy_world(int src, int dst);
+
+    int get_num_worlds() const { return (int)worlds.size(); }
+    size_t get_bodies_per_world() const { return bodies_per_world; }
+    size_t get_action_size() const { return action_size; }
+
+    // Store slot of the first body of a world
+    uint32_t get_world_offset(int world) const { return (uint32_t)(world * bodies_per_world); }
+
+    // World-major body state arrays. They are never reallocated after construction.
+    const BodyStore& get_body_store() const { return body_store; }
+    BodyStore& get_body_store() { return body_store; }
+
+    // Relative speed of each motorized joint at the end of the last step, world-major like the actions
+    const std::vector<float>& get_joint_speeds() const { return joint_speeds; }
+    // Sets the motor target speeds from get_action_size() values per world, as step() does with its actions
+    void set_motor_speeds(const float* speeds);
+
+private:
+    // Worlds per task when the step is split across the TaskScheduler
+    static constexpr size_t world_grain_size = 1;
+
+    // Refreshes joint_speeds[begin, end)
+    void update_joint_speeds(size_t begin, size_t end);
+    bool is_valid_world(int world) const { return world >= 0 && world < (int)worlds.size(); }
+
+    // Declared first so it outlives the worlds, whose primitives are handles into it
+    BodyStore body_store;
+    std::vector<std::unique_ptr<Scene>> worlds;
+    std::vector<RevoluteJoint*> motors;     // action_size per world, world-major
+    std::vector<uint8_t> initial_snapshot;  // World 0 as built, for resets
+    std::vector<uint8_t> copy_buffer;       // Reused by copy_world
+    std::vector<float> joint_speeds;
+    Vec3 gravity;
+    size_t bodies_per_world;
+    size_t action_size;
+};
+
+#endif // BATCH_SCENE_H
@@ -0,0 +1,87 @@
+#ifndef BODY_STORE_H
+#define BODY_STORE_H
+
+#include "physics_core/vec3.h"
+#include "physics_core/mat4.h"
+#include "physics_core/quat.h"
+#include "physics_core/collision.h"
+#include "physics_core/kinematics.h"
+#include <cstdint>
+#include <vector>
+
+class Primitive;
+
+// The dynamic state of a single body. A primitive keeps one of these while it
+// is not part of a scene; once added, its state moves into the scene's BodyStore.
+struct BodyState {
+    Vec3 position;
+    Vec3 velocity;
+    Vec3 acceleration;      // Accumulated force / mass, cleared every step
+    Vec3 angular_velocity;
+    Quat orientation;
+    Mat4 inverse_inertia;   // World space, derived from the orientation every step
+    Mat4 local_inverse_inertia; // Body space
+    AABB local_bounds;      // Bounds of the shape in its local frame
+    AABB aabb;              // World space
+    float inverse_mass;
+    float sleep_time;       // Seconds the body has moved slowly enough to sleep
+    uint8_t flags;          // BODY_FLAG_* from kinematics.h
+};
+
+/**
+ * Structure-of-arrays storage for all rigid bodies of a Scene. Each field of
+ * BodyState lives in its own contiguous array, so integration, AABB updates and
+ * the solver stream through exactly the data they use. A Primitive attached to
+ * the store is a handle: its accessors read and write its slot in these arrays.
+ */
+class BodyStore {
+public:
+    // Appends a body and returns its index
+    uint32_t add(const BodyState& state, Primitive* owner);
+
+    // Copies all fields of one body out of the arrays
+    void read(uint32_t index, BodyState* out_state) const;
+    // Overwrites all fields of one body, keeping its owner and its place in a sleeping island
+    void write(uint32_t index, const BodyState& state);
+
+    size_t size() const { return positions.size(); }
+    void clear();
+
+    // Run the integration and AABB kernels over the slots [begin, end), so callers can split the store into chunks
+    void integrate(size_t begin, size_t end, Vec3 gravity, float dt);
+    void update_aabbs(size_t begin, size_t end);
+    // Rotates the body-space inverse inertias of [begin, end) into world space for the current orientations
+    void update_inverse_inertias(size_t begin, size_t end);
+
+    // Moves and turns the bodies by their correction velocities over dt, then zeroes those velocities
+    void apply_corrections(const uint32_t* bodies, size_t count, float dt);
+
+    // Puts the bodies to sleep as one island: they are stopped, and waking any of them wakes them all
+    void sleep(const uint32_t* bodies, size_t count);
+    // Wakes a sleeping body and the rest of its island, restarting their sleep timers. Awake bodies are left as they are.
+    void wake(uint32_t index);
+    bool is_sleeping(uint32_t index) const { return (flags[index] & BODY_FLAG_SLEEPING) != 0; }
+
+    std::vector<Vec3> positions;
+    std::vector<Vec3> velocities;
+    std::vector<Vec3> accelerations;
+    std::vector<Vec3> angular_velocities;
+    // Velocities of the split impulse position solve, which only move the bodies out of penetration. Zero between steps.
+    std::vector<Vec3> correction_velocities;
+    std::vector<Vec3> correction_angular_velocities;
+    std::vector<Quat> orientations;
+    std::vector<Mat4> inverse_inertias;
+    std::vector<Mat4> local_inverse_inertias;
+    std::vector<AABB> local_bounds;
+    std::vector<AABB> aabbs;
+    std::vector<float> inverse_masses;
+    std::vector<float> sleep_times;
+    // The next body of the same sleeping island, so the bodies of an island form a ring. An awake body links to itself.
+    std::vector<uint32_t> sleep_links;
+    // The composite a part belongs to, which moves the part and takes the impulses of its contacts. Other bodies are their own.
+    std::vector<uint32_t> parents;
+    std::vector<uint8_t> flags;
+    std::vector<Primitive*> owners;
+};
+
+#endif // BODY_STORE_H
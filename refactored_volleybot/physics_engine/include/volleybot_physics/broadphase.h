@@ -0,0 +1,179 @@
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include "primitive.h"
+#include "body_store.h"
+#include "aabb_tree.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class BroadphaseType {
+    SWEEP_AND_PRUNE,
+    AABB_TREE,
+    SPATIAL_HASH
+};
+
+// A pair of bodies whose AABBs overlap. The indices refer to slots in the
+// scene's BodyStore, and 'a' is always smaller than 'b'.
+struct BroadphasePair {
+    uint32_t a;
+    uint32_t b;
+};
+
+// Returns the x, y or z component of a vector (axis 0, 1 or 2).
+inline float vec3_component(const Vec3& v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// Bodies with zero mass never move, so pairs of them are never reported.
+inline bool is_static_body(const BodyStore& bodies, uint32_t body) {
+    return (bodies.flags[body] & BODY_FLAG_STATIC) != 0;
+}
+
+// Interface for the broadphase collision culling stage. The Scene computes
+// every body's AABB in the store before calling find_pairs each step.
+// Implementations index their own state by position in the proxy list rather
+// than by store slot, since several scenes may share one store (see BatchScene).
+class Broadphase {
+public:
+    virtual ~Broadphase() = default;
+
+    /**
+     * Updates the broadphase from the bodies' current AABBs and collects all overlapping pairs.
+     * @param bodies The scene's body store, read for the AABBs and static flags.
+     * @param proxies The store slots that take part in collision (the scene's top-level bodies).
+     *                Slots may be appended between calls, but never removed or reordered.
+     * @param out_pairs Cleared and then filled with the candidate pairs for the narrowphase.
+     */
+    virtual void find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies, std::vector<BroadphasePair>& out_pairs) = 0;
+
+    virtual BroadphaseType get_type() const = 0;
+};
+
+// Creates a broadphase of the given type with its default settings.
+std::unique_ptr<Broadphase> create_broadphase(BroadphaseType type);
+
+/**
+ * Incremental Sweep and Prune. The min/max endpoints of every AABB along one
+ * axis are kept sorted across steps. Bodies move little from one frame to the
+ * next, so re-sorting the previous order with insertion sort is close to O(n).
+ * A sweep over the sorted endpoints then yields the overlapping pairs.
+ */
+class SweepAndPrune : public Broadphase {
+public:
+    SweepAndPrune();
+
+    void find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies, std::vector<BroadphasePair>& out_pairs) override;
+    BroadphaseType get_type() const override { return BroadphaseType::SWEEP_AND_PRUNE; }
+
+    int get_sweep_axis() const { return sweep_axis; }
+
+private:
+    struct Endpoint {
+        float value;
+        uint32_t proxy;  // Index into the proxy list
+        bool is_min;
+    };
+
+    // Rebuilds the endpoint list from scratch and picks the sweep axis with the largest spread.
+    void rebuild(const BodyStore& bodies, const std::vector<uint32_t>& proxies);
+    void update_endpoints(const BodyStore& bodies, const std::vector<uint32_t>& proxies);
+    void insertion_sort();
+
+    std::vector<Endpoint> endpoints;
+    std::vector<uint32_t> active;       // Proxies whose interval is open during the sweep
+    std::vector<uint32_t> active_slot;  // Position of each proxy in 'active'
+    size_t proxy_count;
+    int sweep_axis;
+};
+
+/**
+ * Broadphase built on two dynamic AABB trees. Static bodies (zero mass) go
+ * into a tree without margins that is only refit for the ones moved by hand
+ * since the last step; dynamic bodies live in a
+ * second tree with fat AABBs, so bodies that barely move cost no reinsertion.
+ * Each dynamic body queries both trees, which is O(log n) per body instead of
+ * a scan over every static body.
+ */
+class AABBTreeBroadphase : public Broadphase {
+public:
+    explicit AABBTreeBroadphase(float fat_margin = 0.05f);
+
+    void find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies, std::vector<BroadphasePair>& out_pairs) override;
+    BroadphaseType get_type() const override { return BroadphaseType::AABB_TREE; }
+
+    /**
+     * Collects the indices of all bodies whose AABB overlaps 'aabb'.
+     * The bounds are as of the last find_pairs call.
+     */
+    void query_overlap(const AABB& aabb, std::vector<uint32_t>& out_bodies) const;
+
+    /**
+     * Collects the indices of all bodies whose fat AABB is hit by the ray.
+     * Callers run the exact shape test on the returned candidates.
+     * @param direction Must be normalized.
+     */
+    void raycast(const Vec3& origin, const Vec3& direction, float max_distance, std::vector<uint32_t>& out_bodies) const;
+
+    const DynamicAABBTree& get_static_tree() const { return static_tree; }
+    const DynamicAABBTree& get_dynamic_tree() const { return dynamic_tree; }
+
+private:
+    struct Proxy {
+        uint32_t body;   // Store slot
+        int32_t id;      // Node in static_tree or dynamic_tree
+        bool is_static;
+        Vec3 last_center;
+    };
+
+    DynamicAABBTree static_tree;
+    DynamicAABBTree dynamic_tree;
+    std::vector<Proxy> proxies;             // In the order of the scene's proxy list; the index is the tree leaves' user data
+    std::vector<uint32_t> static_proxies;   // Indices into 'proxies'
+    std::vector<uint32_t> dynamic_proxies;  // Indices into 'proxies'
+    std::vector<AABB> tight_aabbs;          // Bounds from the last update by proxy, used by the queries
+};
+
+/**
+ * Uniform spatial hash grid. In a bounded arena full of similar-sized bodies
+ * this beats the sort-based methods: the grid is rebuilt from scratch each
+ * step in linear time with a counting sort of (cell, body) entries into hash
+ * buckets. Bodies that would cover too many cells, such as the ground and the
+ * net, are kept in an overflow list and tested against every other body.
+ */
+class SpatialHashGrid : public Broadphase {
+public:
+    /**
+     * @param cell_size Edge length of a grid cell. Zero picks twice the median body size on the first build.
+     * @param max_cells_per_body Bodies overlapping more cells than this go to the overflow list.
+     */
+    explicit SpatialHashGrid(float cell_size = 0.0f, int max_cells_per_body = 27);
+
+    void find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies, std::vector<BroadphasePair>& out_pairs) override;
+    BroadphaseType get_type() const override { return BroadphaseType::SPATIAL_HASH; }
+
+    float get_cell_size() const { return cell_size; }
+    size_t get_overflow_count() const { return overflow.size(); }
+
+private:
+    struct CellEntry {
+        int32_t x, y, z;
+        uint32_t proxy;
+    };
+
+    void choose_cell_size(const BodyStore& bodies, const std::vector<uint32_t>& proxies);
+    int32_t cell_coord(float value) const;
+    uint32_t hash_cell(int32_t x, int32_t y, int32_t z) const;
+
+    float cell_size;
+    int max_cells_per_body;
+    uint32_t bucket_mask;
+    std::vector<uint32_t> bucket_start;    // Prefix sums into 'entries', one extra slot at the end
+    std::vector<CellEntry> entries;         // Entries grouped by bucket
+    std::vector<CellEntry> unsorted;        // Entries in body order, before the counting sort
+    std::vector<uint32_t> overflow;         // Proxy indices
+    std::vector<uint8_t> in_overflow;       // Indexed by proxy
+};
+
+#endif // BROADPHASE_H
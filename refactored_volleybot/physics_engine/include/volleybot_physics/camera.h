@@ -20,6 +20,8 @@ public:
      * @param local_offset The camera's position relative to the parent.
      */
     void attach_to(const Primitive* parent, Vec3 local_offset);
+    // Attaches the camera with an orientation relative to the parent too. The camera looks down its local -Z axis.
+    void attach_to(const Primitive* parent, const Mat4& local_transform);
 
     void set_perspective(float fov_y_rad, float near_plane, float far_plane);
 
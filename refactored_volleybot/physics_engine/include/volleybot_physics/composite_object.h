@@ -11,6 +11,7 @@
 struct BodyPart {
     std::shared_ptr<Primitive> primitive;
     Mat4 local_transform; 
+    Quat local_orientation; // The rotation part of local_transform
 };
 
 class CompositeObject : public Primitive {
@@ -20,15 +21,23 @@ public:
     // Add a primitive to this composite object, returning its ID
     int add_part(std::shared_ptr<Primitive> part, Vec3 local_position, Vec3 local_rotation_axis, float local_rotation_angle_rad);
 
-    // Add a joint between two parts using their IDs
+    // Add a joint between two parts using their IDs. The parts stay where the object places them, so the
+    // joint cannot turn; join separate bodies with Scene::add_joint for one that does.
     void add_revolute_joint(int part_id_a, int part_id_b, const Vec3& world_anchor, const Vec3& axis);
 
     // Overridden functions from Primitive
+    std::shared_ptr<Primitive> clone() const override;
     void compute_aabb() override;
+    // Attaching a composite also attaches all of its parts to the same store
+    void attach(BodyStore* target, uint8_t extra_flags = 0) override;
+    void detach() override;
     
     // This will be called by the scene to update all parts' world positions
     void update_child_transforms();
 
+    // Sets this object's AABB to the union of its parts' current AABBs, without recomputing them
+    void merge_part_aabbs();
+
     const std::vector<BodyPart>& get_parts() const { return parts; }
     const std::vector<std::unique_ptr<Joint>>& get_joints() const { return joints; }
     RevoluteJoint* get_revolute_joint(int joint_id);
@@ -0,0 +1,97 @@
+#ifndef CONTACT_CACHE_H
+#define CONTACT_CACHE_H
+
+#include "primitive.h"
+#include "physics_core/gjk.h"
+#include <cstdint>
+#include <vector>
+
+// Identifies one contact point across steps: the two touching primitives and
+// the geometric feature (e.g. a box face or edge) that produced the point.
+struct ContactKey {
+    const Primitive* a;
+    const Primitive* b;
+    uint32_t feature_id;
+};
+
+// The impulses the solver accumulated for a contact during the last step.
+struct CachedImpulse {
+    float normal;
+    float tangent[2];
+};
+
+/**
+ * Persistent pair cache used to warm start the contact solver. The impulses
+ * of every contact are written at the end of a step and looked up again the
+ * next step. Entries are kept in a sorted array, so lookups are binary
+ * searches and the cache does no allocation once it has grown.
+ */
+class ContactCache {
+public:
+    // Finds the impulses stored for this contact during the previous step. Returns false if it is new.
+    bool find(const ContactKey& key, CachedImpulse* out_impulse) const;
+
+    // Replaces the cache contents with the given contacts. Must be called once per step after solving.
+    void begin_update();
+    void add(const ContactKey& key, const CachedImpulse& impulse);
+    void end_update();
+
+    void clear() { entries.clear(); }
+    size_t size() const { return entries.size(); }
+
+    // Entry i in key order, e.g. to save the cache in a snapshot
+    const ContactKey& get_key(size_t i) const { return entries[i].key; }
+    const CachedImpulse& get_impulse(size_t i) const { return entries[i].impulse; }
+
+private:
+    struct Entry {
+        ContactKey key;
+        CachedImpulse impulse;
+    };
+
+    static bool key_less(const ContactKey& x, const ContactKey& y);
+
+    std::vector<Entry> entries;
+};
+
+/**
+ * Per-pair state of the convex (GJK/EPA) narrow phase: the last simplex, which
+ * warm starts the next query, and the persistent manifold points. Like
+ * ContactCache, it only keeps the pairs that were tested during the last step.
+ */
+class ConvexCache {
+public:
+    /**
+     * Returns the pair's state from the previous step, or a zeroed one for a new pair, and
+     * keeps it for the next step. The reference is valid until the next acquire() or end_update().
+     */
+    ConvexPairCache& acquire(const Primitive* a, const Primitive* b);
+
+    // Call once per step around the narrow phase
+    void begin_update();
+    void end_update();
+
+    void clear();
+    size_t size() const { return current.size(); }
+
+    // Entry i in key order, e.g. to save the cache in a snapshot
+    const Primitive* get_a(size_t i) const { return current[i].a; }
+    const Primitive* get_b(size_t i) const { return current[i].b; }
+    const ConvexPairCache& get_pair(size_t i) const { return current[i].pair; }
+    // Adds an entry while restoring a snapshot, between clear() and end_update()
+    void add(const Primitive* a, const Primitive* b, const ConvexPairCache& pair);
+
+private:
+    struct Entry {
+        const Primitive* a;
+        const Primitive* b;
+        ConvexPairCache pair;
+    };
+
+    static bool entry_less(const Entry& x, const Entry& y);
+
+    std::vector<Entry> previous; // Sorted
+    std::vector<Entry> current;
+};
+
+#endif // CONTACT_CACHE_H
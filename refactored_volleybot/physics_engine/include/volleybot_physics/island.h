@@ -0,0 +1,81 @@
+#ifndef ISLAND_H
+#define ISLAND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The two bodies of a contact or joint, as body store slots
+struct BodyPair {
+    uint32_t a, b;
+};
+
+// The constraints and bodies of one island, as ranges of ConstraintIslands::get_contact_order(),
+// get_joint_order() and get_bodies()
+struct Island {
+    uint32_t first_contact, contact_count;
+    uint32_t first_joint, joint_count;
+    uint32_t first_body, body_count;
+};
+
+// Consecutive islands solved by one task
+struct IslandBatch {
+    uint32_t first_island, island_count;
+};
+
+/**
+ * Splits a step's contacts and joints into islands: groups that share no dynamic body, found by
+ * union-find over the bodies each constraint connects. Static bodies join no island, so the robots
+ * standing on one floor are still separate islands. No island's impulses reach another's bodies,
+ * so islands can be solved concurrently, with the same result as solving them one after another.
+ * Islands are also what falls asleep together, so they can list their bodies too.
+ *
+ * The storage is kept between steps, so building islands does no allocation once it has grown.
+ */
+class ConstraintIslands {
+public:
+    // Islands are merged into batches of at least this many constraints, so tiny ones do not each cost a task
+    static constexpr size_t min_batch_constraints = 64;
+
+    /**
+     * Groups the constraints by island. Islands are numbered in the order of their first contact,
+     * then their first joint, then their first link, and keep their constraints in the given order.
+     * @param links Bodies that are one island without a constraint between them, e.g. a composite and its
+     *              parts. A body linked to itself gets an island even if nothing touches it.
+     * @param inverse_masses Of every body store slot; bodies with 0 are static.
+     */
+    void build(const BodyPair* contacts, size_t contact_count, const BodyPair* joints, size_t joint_count,
+               const BodyPair* links, size_t link_count, const float* inverse_masses);
+
+    // Indices of the contacts passed to build(), grouped by island
+    const std::vector<uint32_t>& get_contact_order() const { return contact_order; }
+    // Indices of the joints passed to build(), grouped by island
+    const std::vector<uint32_t>& get_joint_order() const { return joint_order; }
+    // The dynamic bodies of the constraints and links, as body store slots in ascending order within each island
+    const std::vector<uint32_t>& get_bodies() const { return bodies; }
+    const std::vector<Island>& get_islands() const { return islands; }
+    const std::vector<IslandBatch>& get_batches() const { return batches; }
+
+private:
+    uint32_t find(uint32_t node);
+    void unite(uint32_t x, uint32_t y);
+    // Sorts constraint indices by island, keeping their order within each
+    void group(const std::vector<uint32_t>& island_of, std::vector<uint32_t>& order, std::vector<uint32_t>& counts);
+
+    uint32_t first_body = 0;        // The lowest body slot the constraints touch, which is node 0
+    std::vector<uint32_t> parents;  // Union-find forest over the slots from first_body to the highest touched
+    std::vector<uint8_t> touched;   // Per node, whether it is a dynamic body of a constraint or link
+    std::vector<uint32_t> island_of_root;
+    std::vector<uint32_t> contact_islands;
+    std::vector<uint32_t> joint_islands;
+    std::vector<uint32_t> contact_order;
+    std::vector<uint32_t> joint_order;
+    std::vector<uint32_t> contact_counts;
+    std::vector<uint32_t> joint_counts;
+    std::vector<uint32_t> body_counts;
+    std::vector<uint32_t> bodies;
+    std::vector<Island> islands;
+    std::vector<IslandBatch> batches;
+};
+
+#endif // ISLAND_H
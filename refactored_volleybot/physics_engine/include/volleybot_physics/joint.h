@@ -16,6 +16,12 @@ public:
     // The solver will call this to apply the constraint impulse
     virtual void apply_constraint(float dt) = 0;
 
+    // Returns a copy of this joint that connects the given bodies instead, e.g. the parts of a cloned composite
+    virtual std::unique_ptr<Joint> clone(Primitive* a, Primitive* b) const = 0;
+
+    Primitive* get_body_a() const { return bodyA; }
+    Primitive* get_body_b() const { return bodyB; }
+
 protected:
     Primitive* bodyA;
     Primitive* bodyB;
@@ -26,17 +32,31 @@ protected:
     Vec3 local_anchor_b;
 };
 
+/**
+ * A hinge: keeps the anchor of both bodies together and lets them turn about the axis only. The axis
+ * is fixed in both bodies, and the motor drives the speed of B about it relative to A.
+ */
 class RevoluteJoint : public Joint {
 public:
+    // The anchor and axis are taken in world space, with both bodies in their starting poses
     RevoluteJoint(Primitive* a, Primitive* b, const Vec3& world_anchor, const Vec3& axis);
 
     void apply_constraint(float dt) override;
+    std::unique_ptr<Joint> clone(Primitive* a, Primitive* b) const override;
 
+    // A new target speed or force wakes the two bodies if they are sleeping
     void set_motor(float speed, float max_force);
+    // Changes the target speed only, keeping the max force
+    void set_motor_speed(float speed);
+    float get_motor_speed() const { return motor_speed; }
     float get_relative_speed() const;
+    // The hinge axis in world space, as body A carries it
+    Vec3 get_axis() const;
 
 private:
-    Vec3 motor_axis;
+    // The axis in the local space of each body
+    Vec3 local_axis_a;
+    Vec3 local_axis_b;
     float motor_speed;
     float max_motor_force;
 };
@@ -0,0 +1,149 @@
+#ifndef MESH_ASSET_H
+#define MESH_ASSET_H
+
+#include "physics_core/vec3.h"
+#include "physics_core/mat4.h"
+#include "physics_core/collision.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Volume, center of mass and inertia of the solid a closed mesh bounds, at unit density
+struct MassProperties {
+    float volume;
+    Vec3 center_of_mass;  // In the mesh's frame
+    Mat4 inertia;         // About the center of mass, along the mesh's axes; scale it by the density
+};
+
+/**
+ * Integrates the mass properties of a closed mesh over signed tetrahedra (divergence theorem).
+ * The result does not depend on whether the triangles wind outwards or inwards, as long as they
+ * all wind the same way. Meshes with holes get the properties of their patched-up solid, roughly.
+ */
+MassProperties compute_mass_properties(const Vec3* vertices, const unsigned int* indices, size_t triangle_count);
+
+/**
+ * The geometry of a triangle mesh: its vertices and their normals, its triangles in BVH order,
+ * the BVH itself, its convex hull (built by quickhull) and the mass properties of both. An asset never changes
+ * once made, so any number of TriangleMeshes, Scenes and BatchScene worlds can share one.
+ *
+ * Cooking writes all of it to a binary file in the layout it has in memory. Loading a cooked
+ * file maps it read-only rather than parsing and building anything, so it costs page faults
+ * instead of parse time, and every process that loads the same file shares one physical copy
+ * of the geometry through the page cache.
+ */
+class MeshAsset {
+public:
+    ~MeshAsset();
+    MeshAsset(const MeshAsset&) = delete;
+    MeshAsset& operator=(const MeshAsset&) = delete;
+
+    // Builds the BVH, hull, normals and mass properties of three indices per triangle. A trailing partial triangle is dropped.
+    static std::shared_ptr<MeshAsset> build(std::vector<Vec3> vertices, std::vector<unsigned int> indices);
+
+    /**
+     * Reads every face of an .obj file, in the file's coordinates. Polygons are split into
+     * triangles; normals, texture coordinates and .mtl materials are ignored.
+     * @return The asset, or nullptr if the file cannot be read or has no faces.
+     */
+    static std::shared_ptr<MeshAsset> load_obj(const std::string& path);
+
+    /**
+     * Reads a binary or ASCII .stl file, in the file's coordinates. STL stores each triangle's
+     * corners separately, so corners closer than a millionth of the mesh's size are welded into
+     * one vertex, found through a spatial hash, which makes a closed part a closed mesh again.
+     * Triangles that welding collapses are dropped.
+     * @return The asset, or nullptr if the file cannot be read or has no triangles.
+     */
+    static std::shared_ptr<MeshAsset> load_stl(const std::string& path);
+
+    // Loads a mesh source file by its extension, .obj or .stl, or returns nullptr
+    static std::shared_ptr<MeshAsset> load(const std::string& path);
+
+    /**
+     * Maps a cooked mesh file. While an asset mapped from a path is alive, loading the same
+     * unchanged file again returns it instead of mapping it twice.
+     * @return The asset, or nullptr if the file cannot be mapped, was cooked by another version, or has
+     *         indices or BVH nodes that point outside its arrays.
+     */
+    static std::shared_ptr<MeshAsset> load_cooked(const std::string& path);
+
+    /**
+     * Writes the asset as a cooked mesh file. The file is written next to 'path' and renamed
+     * over it, so processes that still map an older version keep their copy intact.
+     * @return False if the file cannot be written.
+     */
+    bool write_cooked(const std::string& path) const;
+
+    // Loads a mesh source file like load() and writes it to 'cooked_path'
+    static bool cook(const std::string& source_path, const std::string& cooked_path);
+
+    const Vec3* get_vertices() const { return vertices; }
+    size_t get_vertex_count() const { return vertex_count; }
+    // One per vertex: the area weighted average of the normals of the triangles around it
+    const Vec3* get_normals() const { return normals; }
+    // Three per triangle, in BVH order
+    const unsigned int* get_indices() const { return indices; }
+    size_t get_triangle_count() const { return triangle_count; }
+    const BvhNode* get_bvh_nodes() const { return nodes; }
+    size_t get_node_count() const { return node_count; }
+    // Corners of the mesh's convex hull, in the mesh's frame. A flat mesh has every point it uses here instead.
+    const Vec3* get_hull_points() const { return hull_points; }
+    size_t get_hull_point_count() const { return hull_point_count; }
+    // The hull's triangles over its corners, facing outwards; none for a flat mesh
+    const unsigned int* get_hull_indices() const { return hull_indices; }
+    size_t get_hull_triangle_count() const { return hull_triangle_count; }
+
+    // Mass properties of the solid the mesh bounds, meaningful if it is closed
+    const MassProperties& get_mass_properties() const { return mass_properties; }
+    // Mass properties of the solid convex hull, zero for a flat mesh
+    const MassProperties& get_hull_mass_properties() const { return hull_mass_properties; }
+    /**
+     * The solid a body made from the mesh has: the mesh's own if it is closed, else its hull.
+     * Scale the inertia by mass / volume for the body's.
+     */
+    const MassProperties& get_solid_mass_properties() const { return closed ? mass_properties : hull_mass_properties; }
+    // True if every edge is shared by exactly two triangles, so the mesh bounds a solid
+    bool is_closed() const { return closed; }
+
+    // Bounds of the mesh in its own frame
+    AABB get_bounds() const;
+    // The geometry as the collision kernels take it
+    MeshShape get_shape() const { return {vertices, indices, triangle_count, nodes, node_count}; }
+    // True if the arrays live in a mapped cooked file
+    bool is_mapped() const { return mapping != nullptr; }
+
+private:
+    MeshAsset() = default;
+
+    // The arrays, pointing into either the storage below or the mapping
+    const Vec3* vertices = nullptr;
+    size_t vertex_count = 0;
+    const Vec3* normals = nullptr;
+    const unsigned int* indices = nullptr;
+    size_t triangle_count = 0;
+    const BvhNode* nodes = nullptr;
+    size_t node_count = 0;
+    const Vec3* hull_points = nullptr;
+    size_t hull_point_count = 0;
+    const unsigned int* hull_indices = nullptr;
+    size_t hull_triangle_count = 0;
+    MassProperties mass_properties = {};
+    MassProperties hull_mass_properties = {};
+    bool closed = false;
+
+    // Storage of built assets
+    std::vector<Vec3> vertex_storage;
+    std::vector<Vec3> normal_storage;
+    std::vector<unsigned int> index_storage;
+    std::vector<BvhNode> node_storage;
+    std::vector<Vec3> hull_storage;
+    std::vector<unsigned int> hull_index_storage;
+
+    // The mapped file of loaded assets
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+#endif // MESH_ASSET_H
@@ -0,0 +1,104 @@
+#ifndef MJCF_MODEL_H
+#define MJCF_MODEL_H
+
+#include "primitive.h"
+#include "camera.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Scene;
+
+// A velocity actuator of the model: its control is a target speed for one revolute joint of the scene
+struct MjcfActuator {
+    std::string name;
+    int joint_index;   // Index into Scene::get_revolute_joints()
+    float gear;        // The joint turns at control / gear once the motor has caught up
+    bool ctrl_limited;
+    float ctrl_min, ctrl_max;
+};
+
+/**
+ * Imports the MuJoCo XML (MJCF) subset the volleyball environment is written in, straight into a
+ * Scene, and keeps the names of what it made so they can be looked up afterwards.
+ *
+ * What is read:
+ * - <include>, spliced in place; file paths are relative to the main file, as in MuJoCo
+ * - <compiler angle meshdir eulerseq>, <option gravity timestep>
+ * - <asset>: <mesh> from .stl or .obj files, and the rgba of <material>
+ * - <body> with pos and quat/axisangle/euler/xyaxes/zaxis, and a <freejoint> or hinge <joint>s
+ * - <geom> of type plane, box, sphere, cylinder, capsule or mesh, with mass or density, friction and rgba/material
+ * - <camera>, <light>, and <velocity> actuators on hinge joints
+ *
+ * Below a body with a free joint, each body with a hinge becomes a rigid body of its own, and the bodies
+ * without one are welded to their parent's. Each rigid body is the primitive of its only geom, or a
+ * CompositeObject of all its geoms with its origin at their center of mass. Hinges become RevoluteJoints of
+ * the scene (see Scene::add_joint) between a body and its parent, and only the first hinge of a body is
+ * used. Every other geom is welded to the world and added as a static primitive. Mesh geoms collide as
+ * ConvexHulls, as MuJoCo's do. MJCF is Z-up, so the scene's gravity is set to the file's, or to MuJoCo's
+ * default of 9.81 down Z, and the contact slop is cut down to a thousandth of the model's size.
+ *
+ * Default classes, slide and ball joints, tendons, sensors, equality constraints and contact filtering are
+ * not read; unsupported joints and actuators are reported and skipped.
+ */
+class MjcfModel {
+public:
+    /**
+     * Reads an MJCF file and adds its bodies, joints and lights to 'scene', and makes the file's first
+     * camera the scene's camera, at 640 by 480. The whole file is read and checked before anything is added.
+     * @return The model, or nullptr if the file cannot be read or parsed or refers to a missing mesh.
+     */
+    static std::shared_ptr<MjcfModel> load(const std::string& path, Scene& scene);
+
+    // The rigid body a body is part of: a CompositeObject, a primitive, or nullptr for unknown or static bodies
+    std::shared_ptr<Primitive> find_body(const std::string& name) const;
+    // The primitive a geom became, a part of a composite unless it is a rigid body of its own
+    std::shared_ptr<Primitive> find_geom(const std::string& name) const;
+    // Index of a hinge joint in Scene::get_revolute_joints(), or -1
+    int find_joint(const std::string& name) const;
+    // Index of an actuator in get_actuators(), or -1
+    int find_actuator(const std::string& name) const;
+    const std::vector<MjcfActuator>& get_actuators() const { return actuators; }
+
+    /**
+     * Turns one control per actuator, clamped to its control range, into motor target speeds.
+     * 'speeds' holds one per revolute joint of the scene, as Scene::set_motor_speeds and
+     * BatchScene::step take them; the entries of joints without an actuator are left as they are.
+     */
+    void controls_to_motor_speeds(const float* controls, float* speeds) const;
+    // Sets the motor target speeds of the actuated joints of 'scene' from one control per actuator
+    void apply_controls(Scene& scene, const float* controls) const;
+
+    // Names of the file's cameras, in file order
+    std::vector<std::string> get_camera_names() const;
+    // A camera as the file places it, following its body if it has one, or nullptr for an unknown name
+    std::unique_ptr<Camera> make_camera(const std::string& name, int width, int height) const;
+
+    // The file's <option timestep>, MuJoCo's 0.002 if not given
+    float get_timestep() const { return timestep; }
+
+private:
+    // Reads the file into a body tree, then turns the tree into the scene's objects
+    class Builder;
+
+    struct CameraSpec {
+        std::string name;
+        std::shared_ptr<Primitive> parent; // nullptr for a camera fixed in the world
+        Vec3 position;                     // In the parent's frame, or the world's
+        Quat orientation;                  // Looks down its -Z axis with +Y up, as in MuJoCo
+        float fov_y_rad;
+        float near_plane, far_plane;
+    };
+
+    MjcfModel() = default;
+
+    std::unordered_map<std::string, std::shared_ptr<Primitive>> bodies;
+    std::unordered_map<std::string, std::shared_ptr<Primitive>> geoms;
+    std::unordered_map<std::string, int> joints;
+    std::vector<MjcfActuator> actuators;
+    std::vector<CameraSpec> cameras;
+    float timestep = 0.002f;
+};
+
+#endif // MJCF_MODEL_H
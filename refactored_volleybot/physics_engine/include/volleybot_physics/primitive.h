@@ -3,77 +3,146 @@
 
 #include "physics_core/vec3.h"
 #include "physics_core/mat4.h"
+#include "physics_core/quat.h"
+#include "physics_core/collision.h"
 #include "material.h"
+#include "body_store.h"
+#include "mesh_asset.h"
 #include <memory>
 #include <vector>
 
-// Defines an Axis-Aligned Bounding Box
-struct AABB {
-    Vec3 min;
-    Vec3 max;
-};
+inline bool aabb_overlap(const AABB& a, const AABB& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x &&
+           a.min.y <= b.max.y && a.max.y >= b.min.y &&
+           a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
 
 enum class PrimitiveType {
     SPHERE,
     BOX,
     CYLINDER,
     MESH,
+    CAPSULE,
+    CONVEX_HULL,
+    PLANE,
     COMPOSITE // For composite objects
 };
 
+/**
+ * Base class of all simulated shapes. A primitive's dynamic state (position,
+ * velocity, orientation, ...) lives in the BodyStore of the scene it was added
+ * to, and the primitive acts as a handle to its slot there. Before it is added
+ * to a scene, the primitive holds that state itself.
+ */
 class Primitive {
 public:
     Primitive(std::shared_ptr<Material> mat);
-    virtual ~Primitive() = default;
+    virtual ~Primitive();
+
+    Primitive(const Primitive&) = delete;
+    Primitive& operator=(const Primitive&) = delete;
 
     void update_physics(float dt, Vec3 gravity);
 
-    // Computes the world-space AABB for the primitive
-    virtual void compute_aabb() = 0;
+    /**
+     * Returns a detached copy of this primitive with the same shape, material and current state,
+     * e.g. to build the worlds of a BatchScene from a template. Composites copy their parts and joints.
+     */
+    virtual std::shared_ptr<Primitive> clone() const = 0;
+
+    // Computes the world-space AABB for the primitive from its local bounds and transform
+    virtual void compute_aabb();
 
     PrimitiveType get_type() const { return type; }
     std::shared_ptr<Material> get_material() const { return material; }
 
-    Vec3 get_position() const { return position; }
-    Vec3 get_velocity() const { return velocity; }
-    Vec3 get_angular_velocity() const { return angular_velocity; }
+    Vec3 get_position() const { return state_field(&BodyStore::positions, &BodyState::position); }
+    Vec3 get_velocity() const { return state_field(&BodyStore::velocities, &BodyState::velocity); }
+    Vec3 get_angular_velocity() const { return state_field(&BodyStore::angular_velocities, &BodyState::angular_velocity); }
+    Quat get_orientation() const { return state_field(&BodyStore::orientations, &BodyState::orientation); }
     Vec3 get_center_of_mass() const { return center_of_mass; }
-    const Mat4& get_transform() const { return transform; }
-    const AABB& get_aabb() const { return aabb; }
+    Vec3 get_world_center_of_mass() const;
+    Mat4 get_transform() const;
+    const AABB& get_aabb() const { return state_field(&BodyStore::aabbs, &BodyState::aabb); }
+    float get_inverse_mass() const { return state_field(&BodyStore::inverse_masses, &BodyState::inverse_mass); }
     const Mat4& get_inertia_tensor() const { return inertia_tensor; }
-    const Mat4& get_inverse_inertia_tensor() const { return inverse_inertia_tensor; }
+    // World-space inverse inertia, as used by the solver
+    const Mat4& get_inverse_inertia_tensor() const { return state_field(&BodyStore::inverse_inertias, &BodyState::inverse_inertia); }
 
+    // Setting the state or applying a force or impulse wakes a sleeping body
     void set_position(const Vec3& pos);
     void set_velocity(const Vec3& vel);
+    void set_angular_velocity(const Vec3& ang_vel);
+    // Rotates the body about its origin. The quaternion is normalized.
+    void set_orientation(const Quat& orientation);
     void apply_force(const Vec3& force);
 
+    // A sleeping body rests with the rest of its island until something wakes it (see Scene::set_sleep_settings)
+    bool is_sleeping() const { return (state_field(&BodyStore::flags, &BodyState::flags) & BODY_FLAG_SLEEPING) != 0; }
+    // Wakes the body and the rest of its island, if it is sleeping
+    void wake_up();
+
+    /**
+     * Bullets are swept from where they start a step to where they end it, and stop at the
+     * first shape in between, so a small fast body cannot pass through a thin one. Sweeping
+     * costs more than the discrete tests, so only flag the bodies that need it. Only spheres
+     * added to the scene on their own are swept; the flag does nothing on other bodies.
+     */
+    void set_bullet(bool bullet);
+    bool is_bullet() const { return (state_field(&BodyStore::flags, &BodyState::flags) & BODY_FLAG_BULLET) != 0; }
+
     // Applies an impulse at a specific point, affecting both linear and angular velocity
     void apply_impulse(const Vec3& impulse, const Vec3& world_contact_point);
     void apply_angular_impulse(const Vec3& impulse);
 
+    /**
+     * Moves this primitive's state into a body store. From then on all accessors
+     * operate on the store's arrays. A primitive belongs to at most one store.
+     * @param extra_flags BODY_FLAG_* bits to set in addition to the ones derived from the mass.
+     */
+    virtual void attach(BodyStore* target, uint8_t extra_flags = 0);
+    // Copies the state back out of the store, e.g. when the scene is destroyed
+    virtual void detach();
+    bool is_attached() const { return store != nullptr; }
+    BodyStore* get_store() const { return store; }
+    uint32_t get_body_index() const { return body_index; }
+
 protected:
-    // Linear Motion
-    Vec3 position;
-    Vec3 velocity;
-    Vec3 acceleration;
+    // Refreshes the inverse mass, inverse inertia and static flag from the material and inertia tensor
+    void update_mass_properties();
+    // Takes the center of mass and inertia of a solid of unit density, scaled to the material's mass
+    void set_solid_mass_properties(const MassProperties& solid);
+    // Rotates the body-space inverse inertia into world space for the current orientation
+    void update_world_inverse_inertia();
+
+    // Copies the mass properties and dynamic state of another primitive into this detached one, for clone()
+    void copy_body_from(const Primitive& other);
+
+    // Returns one field of the dynamic state, wherever it currently lives
+    template <typename T>
+    T& state_field(std::vector<T> BodyStore::*array, T BodyState::*field) const {
+        return store ? (store->*array)[body_index] : detached.get()->*field;
+    }
 
     // Angular Motion
-    Vec3 angular_velocity;
     Vec3 center_of_mass; // In local coordinates
     Mat4 inertia_tensor; // In local coordinates
-    Mat4 inverse_inertia_tensor;
+    Mat4 inverse_inertia_tensor; // In local coordinates
 
     // General Properties
-    Mat4 transform;
     std::shared_ptr<Material> material;
-    AABB aabb;
     PrimitiveType type;
+
+private:
+    BodyStore* store;
+    uint32_t body_index;
+    std::unique_ptr<BodyState> detached;
 };
 
 class Sphere : public Primitive {
 public:
     Sphere(float radius, std::shared_ptr<Material> mat);
-    void compute_aabb() override;
+    std::shared_ptr<Primitive> clone() const override;
     float get_radius() const { return radius; }
 private:
     float radius;
@@ -82,30 +151,40 @@ private:
 class Box : public Primitive {
 public:
     Box(const Vec3& extents, std::shared_ptr<Material> mat);
-    void compute_aabb() override;
+    std::shared_ptr<Primitive> clone() const override;
     Vec3 get_extents() const { return extents; }
 private:
     Vec3 extents;
 };
 
-// Represents geometry loaded from a file, like an .obj file.
+/**
+ * Triangles in the local frame, e.g. the court or the net loaded from an .obj file, with a
+ * BVH over them so shapes are only tested against the triangles near them. Meant for static
+ * geometry: spheres, boxes, cylinders, capsules and convex hulls collide with it, and a moving
+ * mesh rests on planes with the corners of its hull. Other meshes do not collide with it.
+ * The geometry is a MeshAsset, shared by clones and by every mesh made from the same asset.
+ * The mass properties are those of the solid the mesh bounds if it is closed, else its hull's.
+ */
 class TriangleMesh : public Primitive {
 public:
-    TriangleMesh(std::shared_ptr<Material> mat);
+    // Three indices per triangle. The BVH build reorders the triangles.
+    TriangleMesh(std::vector<Vec3> vertices, std::vector<unsigned int> indices, std::shared_ptr<Material> mat);
+    TriangleMesh(std::shared_ptr<MeshAsset> asset, std::shared_ptr<Material> mat);
+    std::shared_ptr<Primitive> clone() const override;
 
-    const std::vector<Vec3>& get_vertices() const { return vertices; }
-    const std::vector<unsigned int>& get_indices() const { return indices; }
+    const std::shared_ptr<MeshAsset>& get_asset() const { return asset; }
+    // The geometry as the collision kernels take it, pointing into the asset's arrays
+    MeshShape get_shape() const { return asset->get_shape(); }
 
 private:
-    // The Scene will be responsible for filling this data during load time.
-    friend class Scene;
-    std::vector<Vec3> vertices;
-    std::vector<unsigned int> indices;
+    std::shared_ptr<MeshAsset> asset;
 };
 
+// A solid cylinder along its local Y axis, centered on its position. 'sides' is only used to draw it.
 class Cylinder : public Primitive {
 public:
     Cylinder(float height, float radius, int sides, std::shared_ptr<Material> mat);
+    std::shared_ptr<Primitive> clone() const override;
     float get_height() const { return height; }
     float get_radius() const { return radius; }
     int get_sides() const { return sides; }
@@ -115,4 +194,46 @@ private:
     int sides;
 };
 
+// A cylinder with hemispherical caps along its local Y axis. 'height' is the distance between the two cap centers.
+class Capsule : public Primitive {
+public:
+    Capsule(float height, float radius, std::shared_ptr<Material> mat);
+    std::shared_ptr<Primitive> clone() const override;
+    float get_height() const { return height; }
+    float get_radius() const { return radius; }
+private:
+    float height;
+    float radius;
+};
+
+/**
+ * A convex shape given by points in the local frame, e.g. a robot part's mesh, colliding
+ * through GJK/EPA. The points are reduced to the corners of their hull, which is all the
+ * support function scans, and the center of mass and inertia are the solid hull's. Points
+ * that span no volume are kept as given, with the inertia of their bounding box.
+ */
+class ConvexHull : public Primitive {
+public:
+    ConvexHull(const std::vector<Vec3>& points, std::shared_ptr<Material> mat);
+    // The hull of a mesh, e.g. a robot part loaded from an .stl file. Far cheaper to collide than its triangles.
+    ConvexHull(const MeshAsset& asset, std::shared_ptr<Material> mat);
+    std::shared_ptr<Primitive> clone() const override;
+    const std::vector<Vec3>& get_vertices() const { return vertices; }
+private:
+    std::vector<Vec3> vertices;
+};
+
+/**
+ * An infinite ground plane through its position, facing its local +Y axis, and solid below.
+ * It is static whatever its material's mass. Its AABB covers half_size around its position.
+ */
+class Plane : public Primitive {
+public:
+    static constexpr float half_size = 1000.0f;
+
+    Plane(std::shared_ptr<Material> mat);
+    std::shared_ptr<Primitive> clone() const override;
+    Vec3 get_normal() const;
+};
+
 #endif // PRIMITIVE_H
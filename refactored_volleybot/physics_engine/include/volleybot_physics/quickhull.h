@@ -0,0 +1,22 @@
+#ifndef QUICKHULL_H
+#define QUICKHULL_H
+
+#include "physics_core/vec3.h"
+#include <vector>
+
+// A convex hull as triangles over its corners, wound counterclockwise seen from outside
+struct HullMesh {
+    std::vector<Vec3> vertices;
+    std::vector<unsigned int> indices;  // Three per triangle
+};
+
+/**
+ * Builds the convex hull of a point cloud with quickhull: starting from a tetrahedron of
+ * extreme points, the point furthest outside any face is added until none is left outside.
+ * Points within a small tolerance of the hull, relative to the cloud's size, count as inside,
+ * so nearly coplanar faces do not add needless corners.
+ * @return False, leaving 'hull' empty, if the points do not span a volume, e.g. a flat mesh.
+ */
+bool build_convex_hull(const Vec3* points, size_t count, HullMesh& hull);
+
+#endif // QUICKHULL_H
@@ -6,6 +6,12 @@
 #include "joint.h"
 #include "camera.h"
 #include "light.h"
+#include "broadphase.h"
+#include "contact_cache.h"
+#include "body_store.h"
+#include "snapshot.h"
+#include "island.h"
+#include "physics_core/contact_solver.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -15,8 +21,34 @@ struct CollisionConstraint {
     Primitive* b;
     Vec3 normal;
     float depth;
-    // For solver
-    float accumulated_impulse;
+    uint32_t feature_id; // Which feature of the pair made this contact, for the contact cache
+    Vec3 contact_point;  // World space, from the narrow phase
+    Vec3 r_a, r_b;       // From each body's center of mass to the contact point
+};
+
+// Shape pairs found by the broadphase, gathered so the batch collision kernels can test them together
+struct ShapePairBatch {
+    std::vector<Primitive*> first;
+    std::vector<Primitive*> second;
+    std::vector<Vec3> centers_a;
+    std::vector<float> radii_a;
+    std::vector<Vec3> centers_b;
+    std::vector<float> radii_b;     // Only for sphere-sphere batches
+    std::vector<Quat> orientations_b; // Only for sphere-box batches
+    std::vector<Vec3> extents_b;      // Only for sphere-box batches
+
+    void add(Primitive* a, Primitive* b, const Vec3& center_a, float radius_a, const Vec3& center_b, float radius_b);
+    void add(Primitive* a, Primitive* b, const Vec3& center_a, float radius_a, const Vec3& center_b,
+             const Quat& orientation_b, const Vec3& extents);
+    void clear();
+    size_t size() const { return first.size(); }
+};
+
+// When the bodies of an island fall asleep (see Scene::set_sleep_settings)
+struct SleepSettings {
+    float linear_speed = 0.05f;  // m/s
+    float angular_speed = 0.05f; // rad/s
+    float time = 0.5f;           // Seconds every body of an island must stay below both speeds. 0 turns sleeping off.
 };
 
 class Scene {
@@ -25,38 +57,208 @@ public:
     ~Scene();
 
     void step(float dt);
+    // Advances n agent steps of frame_skip substeps of dt each, e.g. to apply one action over several frames
+    void step_n(float dt, int n, int frame_skip = 1);
     void render();
 
     void add_primitive(std::shared_ptr<Primitive> primitive);
     void add_composite_object(std::shared_ptr<CompositeObject> object);
+    /**
+     * Joins two bodies that were added to this scene on their own, e.g. the links of a robot. Jointed
+     * bodies do not collide with each other, so the hinge of a wheel may sit inside both. Joints between
+     * composite parts, or bodies of another scene, are reported and dropped.
+     */
     void add_joint(std::unique_ptr<Joint> joint);
     void add_light(std::unique_ptr<Light> light);
     void set_camera(std::unique_ptr<Camera> camera);
 
-    Primitive* load_obj_as_primitive(const std::string& filepath, std::shared_ptr<Material> material);
+    // The acceleration of every dynamic body, 9.81 down Y unless set
+    void set_gravity(const Vec3& new_gravity) { gravity = new_gravity; }
+    Vec3 get_gravity() const { return gravity; }
+
+    // Replaces the broadphase, e.g. with an AABBTreeBroadphase. Sweep and Prune is the default.
+    void set_broadphase(std::unique_ptr<Broadphase> new_broadphase);
+    Broadphase* get_broadphase() const { return broadphase.get(); }
+
+    // Velocity iterations of the constraint solver, 8 unless set. Stacks of boxes need that many to stay upright.
+    void set_solver_iterations(int iterations) { solver_iterations = iterations > 0 ? iterations : 1; }
+    int get_solver_iterations() const { return solver_iterations; }
+
+    // How deep resting contacts may stay before position correction pushes them apart, 0.01 unless set.
+    // Scale it down for models of a few centimeters.
+    void set_contact_slop(float slop) { contact_slop = slop > 0.0f ? slop : 0.0f; }
+    float get_contact_slop() const { return contact_slop; }
+
+    /**
+     * Islands of bodies that have all been slower than the given speeds for the given time fall asleep:
+     * they are stopped, and skipped by integration, the narrow phase and the solver until woken. Contacts
+     * from awake bodies, forces, impulses, setting the state, and new motor targets of their joints wake
+     * a sleeping island. Turning sleeping off wakes every body.
+     */
+    void set_sleep_settings(const SleepSettings& settings);
+    const SleepSettings& get_sleep_settings() const { return sleep_settings; }
+
+    // Switches to a broadphase implementation with default settings. The new one is built on the next step.
+    void set_broadphase_type(BroadphaseType type);
+    BroadphaseType get_broadphase_type() const { return broadphase->get_type(); }
+
+    /**
+     * Loads every face of an .obj file as one TriangleMesh, in the file's coordinates, and adds it
+     * to the scene. Polygons are split into triangles; normals, texture coordinates and .mtl
+     * materials are ignored.
+     * @return The mesh, or nullptr if the file cannot be read or has no faces.
+     */
+    std::shared_ptr<TriangleMesh> load_obj_as_primitive(const std::string& filepath, std::shared_ptr<Material> material);
+    // Loads a binary or ASCII .stl file like load_obj_as_primitive, welding the corners STL stores per triangle (see MeshAsset::load_stl)
+    std::shared_ptr<TriangleMesh> load_stl_as_primitive(const std::string& filepath, std::shared_ptr<Material> material);
+    /**
+     * Maps a mesh cooked by MeshAsset::cook and adds it to the scene like load_obj_as_primitive.
+     * Scenes and processes that load the same file share its geometry.
+     * @return The mesh, or nullptr if the file is not a cooked mesh of this version.
+     */
+    std::shared_ptr<TriangleMesh> load_cooked_mesh_as_primitive(const std::string& filepath,
+                                                                std::shared_ptr<Material> material);
+
+    // The body state arrays, indexed by Primitive::get_body_index(). Adding bodies may reallocate them.
+    const BodyStore& get_body_store() const { return body_store; }
+    BodyStore& get_body_store() { return body_store; }
+
+    // Revolute joints of the composites, in the order the composites were added and then by joint ID,
+    // followed by those added with add_joint. Joints added to a composite after it joined the scene are not included.
+    const std::vector<RevoluteJoint*>& get_revolute_joints() const { return revolute_joints; }
+    // Relative speed of each revolute joint at the end of the last step
+    const std::vector<float>& get_joint_speeds() const { return joint_speeds; }
+    // Sets the motor target speed of every revolute joint from get_revolute_joints().size() values
+    void set_motor_speeds(const float* speeds);
+
+    // Saves the bodies, motor targets and contact caches into 'out' (see snapshot.h), reusing its capacity
+    void save_snapshot(std::vector<uint8_t>& out) const;
+    /**
+     * Restores a snapshot saved from this scene or an identically built one, e.g. to reset an
+     * environment or to branch several rollouts from one state.
+     * @return False, leaving the scene unchanged, if the snapshot has different bodies or joints.
+     */
+    bool restore_snapshot(const uint8_t* data, size_t size);
 
 private:
+    // Work per task when a pass is split across the TaskScheduler. Smaller passes run inline.
+    static constexpr size_t body_grain_size = 2048;
+    static constexpr size_t pair_grain_size = 512;
+    // Impacts a bullet resolves within one step before it stops where it is
+    static constexpr int max_bullet_substeps = 4;
+    // How far short of the surface a swept bullet stops, so it does not start the next sweep touching
+    static constexpr float bullet_margin = 0.001f;
+
+    // BatchScene runs its worlds' step phases itself, with the store-wide passes done once for all worlds
+    friend class BatchScene;
+
+    // A scene whose bodies live in a store shared with other scenes. Only BatchScene makes these.
+    explicit Scene(BodyStore* shared_store);
+
+    // Places composite parts relative to their integrated parents
+    void update_composite_parts();
+    // Everything after integration and the AABB refresh: bullet sweeps, collision detection, solving and position correction
+    void collide_and_solve(float dt);
+    // Notes where this scene's bullets start the step, before integration moves them
+    void begin_bullet_sweeps();
+    /**
+     * Sweeps each bullet from its start to its integrated position. At the first shape in the way it
+     * stops, takes the impact as an impulse, and moves on with its new velocity for the rest of the
+     * step, up to max_bullet_substeps times. The other bodies hold still at their integrated poses.
+     */
+    void sweep_bullets(float dt);
+    // Earliest hit of a sphere moving by 'motion' against the scene's other bodies
+    bool find_bullet_hit(const Primitive* bullet, float radius, const Vec3& start, const Vec3& motion,
+                         SweepHit* hit, Primitive** hit_body) const;
+    // Sweep against one body, recursing into the parts of composites
+    bool sweep_against(Primitive* target, const AABB& swept_bounds, float radius, const Vec3& start, const Vec3& motion,
+                       SweepHit* hit, Primitive** hit_body) const;
+    // Bounces the bullet off the body it hit with a restitution impulse; friction is left to the discrete contact
+    void apply_bullet_impact(Primitive* body, Primitive* bullet, const SweepHit& hit);
+    void update_joint_speeds();
+    // Wraps a loaded mesh asset in a TriangleMesh and adds it, or returns nullptr for a null asset
+    std::shared_ptr<TriangleMesh> add_mesh_asset(std::shared_ptr<MeshAsset> asset, std::shared_ptr<Material> material);
+    // The slots [first_body, first_body + body_count) with this scene's joints and contact caches
+    SnapshotTarget snapshot_target(uint32_t first_body, uint32_t body_count) const;
+
     void broad_phase();
+    // True for the pairs of bodies add_joint joined, which do not collide
+    bool is_jointed(uint32_t a, uint32_t b) const;
+    // Wakes the sleeping islands touched by the collision constraints from 'first' on, and returns whether there were any
+    bool wake_touched_islands(size_t first);
     void narrow_phase(Primitive* a, Primitive* b);
+    // Narrow phase of the pairs with a cylinder, capsule or plane as b, the shape later in PrimitiveType order
+    void round_shape_phase(Primitive* a, Primitive* b);
+    // Narrow phase of the pairs with a triangle mesh
+    void mesh_phase(Primitive* a, Primitive* b);
+    // GJK/EPA narrow phase of the convex pairs without an analytic test, e.g. convex hulls
+    void convex_phase(Primitive* a, Primitive* b);
+    // Tests the queued shape pairs and turns the hits into collision constraints
+    void run_pair_batches();
+    // Adds one constraint per manifold point
+    void add_manifold(Primitive* a, Primitive* b, const ContactManifold& manifold);
+    /**
+     * Groups this step's contacts and joints into islands that share no dynamic body, and reorders
+     * 'collision_constraints' so each island's contacts are contiguous.
+     */
+    void build_islands();
+    // Solves each island's joints and contacts for every solver iteration, with the islands spread across the TaskScheduler
     void solve_constraints(float dt);
+    // Advances the sleep timers of the awake bodies, and puts the islands whose bodies have all been slow for long enough to sleep
+    void update_sleep(float dt);
+
+    // Computes the solver terms of each contact and applies last step's impulses (warm starting)
+    void prepare_contacts(float dt);
+    void store_contacts();
 
     /**
-     * TODO: This is for you to implement!
-     * After the solver corrects velocities, this method should correct positions.
-     * Loop through all constraints in 'collision_constraints' and move the objects
-     * apart along the collision normal by the penetration depth.
-     * A simple approach is to move each object by half the depth.
-     * A more advanced approach (Baumgarte stabilization) uses a factor to prevent over-correction.
+     * After the solver has corrected velocities, pushes the bodies of each contact apart with a split impulse:
+     * a second sequential impulse solve over the contact normals, into correction velocities that move and turn
+     * the bodies for this step only. Only the depth beyond the contact slop is corrected, and only 20% of it per
+     * step, so resting contacts do not jitter. Static bodies never move, and the real velocities gain nothing.
      */
-    void resolve_penetration();
+    void resolve_penetration(float dt);
 
     std::vector<std::shared_ptr<Primitive>> physics_bodies;
-    std::vector<std::unique_ptr<Joint>> joints;
+    std::vector<CompositeObject*> composites;
+    // State of every body, including the parts of composites. This is 'owned_store'
+    // unless the scene shares a store with others.
+    BodyStore owned_store;
+    BodyStore& body_store;
+    // Store slots of the top-level bodies, which are what the broadphase sees
+    std::vector<uint32_t> broadphase_proxies;
+    std::vector<std::unique_ptr<Joint>> joints; // Those added with add_joint
+    std::vector<RevoluteJoint*> revolute_joints;
+    std::vector<uint64_t> jointed_pairs; // Sorted store slot pairs of 'joints', lower slot in the high half
+    std::vector<float> joint_speeds;
     std::vector<std::unique_ptr<Light>> lights;
     std::unique_ptr<Camera> active_camera;
     Vec3 gravity;
 
+    std::unique_ptr<Broadphase> broadphase;
+    std::vector<BroadphasePair> candidate_pairs;
+    std::vector<BroadphasePair> dormant_pairs; // Candidates with no awake dynamic body, tested only if one wakes
     std::vector<CollisionConstraint> collision_constraints;
+    std::vector<SolverContact> solver_contacts; // Parallel to collision_constraints
+    ConstraintIslands islands;
+    std::vector<Joint*> solver_joints; // The awake joints, grouped by island
+    std::vector<BodyPair> contact_bodies;
+    std::vector<BodyPair> joint_bodies;
+    std::vector<BodyPair> body_links; // Puts every awake body in an island for update_sleep, with composites' parts in theirs
+    // Scratch for the reordering: the constraints as the narrow phase found them, and the joints as gathered
+    std::vector<CollisionConstraint> constraint_scratch;
+    std::vector<Joint*> gathered_joints;
+    ShapePairBatch sphere_pairs;
+    ShapePairBatch sphere_box_pairs;
+    std::vector<CollisionInfo> pair_results;
+    ContactCache contact_cache;
+    ConvexCache convex_cache;
+    // Store slots of this step's bullets, and where each started
+    std::vector<uint32_t> bullets;
+    std::vector<Vec3> bullet_starts;
+    int solver_iterations;
+    float contact_slop;
+    SleepSettings sleep_settings;
 };
 
 #endif // SCENE_H
@@ -0,0 +1,50 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "body_store.h"
+#include "contact_cache.h"
+#include "joint.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compact binary snapshots of a scene's dynamic state: the bodies' positions,
+ * velocities, accumulated accelerations, angular velocities, orientations,
+ * sleep timers, sleeping islands and flags, the motor target of every revolute
+ * joint, and the contact and convex pair caches.
+ *
+ * A snapshot is a SnapshotHeader followed by one tightly packed array per
+ * field, so saving and restoring are a handful of memcpys. Contacts and the
+ * links between sleeping bodies are stored by body slot relative to the first
+ * body rather than by pointer or absolute slot, so a
+ * snapshot of one world of a BatchScene can be restored into any other world.
+ */
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t body_count;
+    uint32_t joint_count;
+    uint32_t contact_count;
+    uint32_t convex_pair_count;
+};
+
+// The part of a scene a snapshot is taken from or restored into
+struct SnapshotTarget {
+    BodyStore* store;
+    uint32_t first_body;   // Store slot of the first body
+    uint32_t body_count;
+    const std::vector<RevoluteJoint*>* joints;
+    ContactCache* contacts;
+    ConvexCache* convex_pairs;
+};
+
+// Writes the target's state into 'out'. Its capacity is reused, so repeated saves do not allocate.
+void write_snapshot(const SnapshotTarget& source, std::vector<uint8_t>& out);
+
+/**
+ * Restores a snapshot into the target. Nothing is allocated once the caches have grown to the snapshot's size.
+ * @return False, leaving the target unchanged, if the data is not a snapshot or has a different number of bodies or joints.
+ */
+bool read_snapshot(const SnapshotTarget& target, const uint8_t* data, size_t size);
+
+#endif // SNAPSHOT_H
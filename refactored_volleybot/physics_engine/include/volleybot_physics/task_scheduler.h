@@ -0,0 +1,86 @@
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Work-stealing thread pool that runs the parallel parts of a step. Every
+ * thread has its own task deque: it pushes and pops at the back, and idle
+ * threads steal from the front of the others' deques, so the chunks of an
+ * uneven loop (e.g. worlds with very different contact counts) spread out
+ * on their own.
+ *
+ * A thread that waits for a parallel_for keeps running tasks in the
+ * meantime, so parallel loops can nest: BatchScene runs its worlds in
+ * parallel, and each world may split its own passes again.
+ */
+class TaskScheduler {
+public:
+    /**
+     * @param num_threads Threads working on a parallel_for, counting the calling thread, so 1 runs everything
+     *                    inline. 0 uses VOLLEYBOT_NUM_THREADS if set, otherwise the hardware thread count.
+     * @param pin_threads Pins worker i to the i-th core the process may run on (Linux only), so workers
+     *                    of several training processes on one box do not migrate between each other's cores.
+     */
+    explicit TaskScheduler(int num_threads = 0, bool pin_threads = false);
+    ~TaskScheduler();
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /**
+     * Calls body(begin, end) on disjoint ranges covering [0, count) and returns once all of them are done.
+     * @param grain_size The smallest range worth a task. Loops of at most this many items run inline.
+     */
+    void parallel_for(size_t count, size_t grain_size, const std::function<void(size_t, size_t)>& body);
+
+    int get_thread_count() const { return (int)queues.size(); }
+    bool get_pin_threads() const { return pin_threads; }
+
+    // The process-wide scheduler that Scene and BatchScene use
+    static TaskScheduler& global();
+
+    /**
+     * Replaces the global scheduler, e.g. to cap the threads of each training process on a shared machine.
+     * Not thread-safe: call it while no scene is stepping.
+     */
+    static void configure_global(int num_threads, bool pin_threads = false);
+
+private:
+    struct Task {
+        const std::function<void(size_t, size_t)>* body;
+        size_t begin;
+        size_t end;
+        std::atomic<size_t>* pending; // Tasks of the same parallel_for still to finish
+    };
+
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void worker_loop(size_t index);
+    // Index of the calling thread's queue; threads outside the pool share queue 0
+    size_t current_queue() const;
+    bool pop_local(size_t index, Task* out_task);
+    bool steal(size_t thief, Task* out_task);
+    static void run(const Task& task);
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<size_t> queued_tasks;
+    std::atomic<bool> stopping;
+    std::mutex sleep_mutex;
+    std::condition_variable wake_workers;
+    bool pin_threads;
+};
+
+#endif // TASK_SCHEDULER_H
@@ -1,5 +1,8 @@
 #include "physics_core/collision.h"
 #include "physics_core/vec3.h"
+#include "physics_core/cpu_dispatch.h"
+#include "physics_core/gjk.h"
+#include <float.h>
 #include <math.h>
 
 CollisionInfo test_sphere_vs_sphere(Vec3 pos_a, float radius_a, Vec3 pos_b, float radius_b) {
@@ -25,24 +28,25 @@ CollisionInfo test_sphere_vs_sphere(Vec3 pos_a, float radius_a, Vec3 pos_b, floa
     return info;
 }
 
-CollisionInfo test_sphere_vs_box(Vec3 sphere_pos, float sphere_radius, Vec3 box_pos, Vec3 box_extents) {
+CollisionInfo test_sphere_vs_box(Vec3 sphere_pos, float sphere_radius, Vec3 box_pos, Quat box_rot, Vec3 box_extents) {
     CollisionInfo info = {false};
 
-    // Get box min/max points
-    Vec3 box_min, box_max;
-    vec3_sub(&box_pos, &box_extents, &box_min);
-    vec3_add(&box_pos, &box_extents, &box_max);
+    // Work in the box's local frame, where it is axis-aligned around the origin
+    Quat inverse_rot = {-box_rot.x, -box_rot.y, -box_rot.z, box_rot.w};
+    Vec3 offset;
+    vec3_sub(&sphere_pos, &box_pos, &offset);
+    Vec3 local_pos = quat_rotate(&inverse_rot, offset);
 
     // Find the closest point on the box to the sphere's center
-    float closest_x = fmaxf(box_min.x, fminf(sphere_pos.x, box_max.x));
-    float closest_y = fmaxf(box_min.y, fminf(sphere_pos.y, box_max.y));
-    float closest_z = fmaxf(box_min.z, fminf(sphere_pos.z, box_max.z));
+    float closest_x = fmaxf(-box_extents.x, fminf(local_pos.x, box_extents.x));
+    float closest_y = fmaxf(-box_extents.y, fminf(local_pos.y, box_extents.y));
+    float closest_z = fmaxf(-box_extents.z, fminf(local_pos.z, box_extents.z));
 
     Vec3 closest_point = {closest_x, closest_y, closest_z};
 
     // Check if the distance from the closest point to the sphere center is less than the radius
     Vec3 delta;
-    vec3_sub(&sphere_pos, &closest_point, &delta);
+    vec3_sub(&local_pos, &closest_point, &delta);
     float dist_sq = vec3_length_sq(&delta);
 
     if (dist_sq < sphere_radius * sphere_radius) {
@@ -54,14 +58,1541 @@ CollisionInfo test_sphere_vs_box(Vec3 sphere_pos, float sphere_radius, Vec3 box_
         } else {
             // Sphere center is inside the box, find a good push-out direction
             // For simplicity, we'll push out from the center of the box
-            vec3_sub(&sphere_pos, &box_pos, &info.normal);
+            info.normal = local_pos;
             if (vec3_length_sq(&info.normal) < 1e-6) {
                 vec3_set(&info.normal, 0, 1, 0); // Default push-out
             } else {
                 vec3_normalize(&info.normal, &info.normal);
             }
         }
+        info.normal = quat_rotate(&box_rot, info.normal);
     }
 
     return info;
 }
+
+void update_aabbs(const Vec3* positions, const Quat* orientations, const AABB* local_bounds, AABB* world_bounds, size_t count) {
+    physics_kernels()->update_aabbs(positions, orientations, local_bounds, world_bounds, count);
+}
+
+/* --- Box vs box --- */
+
+// Face contacts are preferred over edge contacts of about the same depth, so resting boxes keep their face manifold
+#define EDGE_AXIS_RELATIVE_TOLERANCE 0.95f
+#define EDGE_AXIS_ABSOLUTE_TOLERANCE 0.01f
+#define CLIP_MAX_POINTS 8
+/*
+ * The side planes of the reference face are moved out by this fraction of its half extents, so a corner of a
+ * box of the same size resting on it stays a corner, rather than being cut now and kept the next step with a new id
+ */
+#define CLIP_SIDE_MARGIN 0.02f
+// Clipped points up to this far above the reference face are kept, so a slightly tilted box stays on all its corners
+#define BOX_CONTACT_MARGIN 0.01f
+
+static Vec3 vec3_add_scaled(Vec3 v, Vec3 direction, float s) {
+    Vec3 result = {v.x + direction.x * s, v.y + direction.y * s, v.z + direction.z * s};
+    return result;
+}
+
+/**
+ * A clipped polygon vertex with an id of the features it came from: a corner of the incident face (0-3),
+ * or a clip plane and the edge it cut. 'edge' names the edge leaving the vertex: an incident face
+ * edge (0-3) or the part of a reference side plane (4 + plane) a previous clip left behind.
+ */
+typedef struct {
+    Vec3 point;
+    uint32_t id;
+    uint32_t edge;
+} ClipVertex;
+
+/**
+ * Keeps the part of the polygon with dot(p, normal) <= offset. New vertices get the id of the clip plane
+ * and the edge it cut, so the id stays the same however many vertices earlier clips added or removed.
+ */
+static int clip_polygon(const ClipVertex* in, int count, Vec3 normal, float offset, uint32_t plane_id, ClipVertex* out) {
+    int out_count = 0;
+    for (int i = 0; i < count; ++i) {
+        const ClipVertex* current = &in[i];
+        const ClipVertex* next = &in[(i + 1) % count];
+        float d0 = vec3_dot(&current->point, &normal) - offset;
+        float d1 = vec3_dot(&next->point, &normal) - offset;
+
+        if (d0 <= 0.0f) {
+            out[out_count++] = *current;
+        }
+        if ((d0 < 0.0f && d1 > 0.0f) || (d0 > 0.0f && d1 < 0.0f)) {
+            float t = d0 / (d0 - d1);
+            Vec3 edge;
+            vec3_sub(&next->point, &current->point, &edge);
+            out[out_count].point = vec3_add_scaled(current->point, edge, t);
+            out[out_count].id = 0x40u | (plane_id << 3) | current->edge;
+            // Leaving the kept side, the next edge runs along the clip plane; entering it, the cut edge goes on
+            out[out_count].edge = d0 < 0.0f ? 4u + plane_id : current->edge;
+            ++out_count;
+        }
+    }
+    return out_count;
+}
+
+// Twice the signed area of the triangle (a, b, c) as seen along 'normal'
+static float signed_area(const Vec3* a, const Vec3* b, const Vec3* c, const Vec3* normal) {
+    Vec3 ab, ac, cross;
+    vec3_sub(b, a, &ab);
+    vec3_sub(c, a, &ac);
+    vec3_cross(&ab, &ac, &cross);
+    return vec3_dot(&cross, normal);
+}
+
+/**
+ * Picks at most MAX_MANIFOLD_POINTS of the candidates that span the largest area: the deepest
+ * point, the one farthest from it, and the ones furthest out on either side of the line between them.
+ */
+static void reduce_manifold(const ManifoldPoint* candidates, int count, ContactManifold* manifold) {
+    if (count <= MAX_MANIFOLD_POINTS) {
+        for (int i = 0; i < count; ++i) manifold->points[i] = candidates[i];
+        manifold->point_count = count;
+        return;
+    }
+
+    int first = 0;
+    for (int i = 1; i < count; ++i) {
+        if (candidates[i].depth > candidates[first].depth) first = i;
+    }
+    int second = first == 0 ? 1 : 0;
+    float best = -1.0f;
+    for (int i = 0; i < count; ++i) {
+        float dist_sq = vec3_dist_sq(&candidates[i].point, &candidates[first].point);
+        if (i != first && dist_sq > best) {
+            best = dist_sq;
+            second = i;
+        }
+    }
+    int third = -1, fourth = -1;
+    float max_area = 0.0f, min_area = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        float area = signed_area(&candidates[first].point, &candidates[second].point, &candidates[i].point, &manifold->normal);
+        if (area > max_area) { max_area = area; third = i; }
+        if (area < min_area) { min_area = area; fourth = i; }
+    }
+
+    manifold->point_count = 0;
+    manifold->points[manifold->point_count++] = candidates[first];
+    manifold->points[manifold->point_count++] = candidates[second];
+    if (third >= 0) manifold->points[manifold->point_count++] = candidates[third];
+    if (fourth >= 0) manifold->points[manifold->point_count++] = candidates[fourth];
+}
+
+bool test_box_vs_box(Vec3 pos_a, Quat rot_a, Vec3 extents_a, Vec3 pos_b, Quat rot_b, Vec3 extents_b,
+                     ContactManifold* manifold) {
+    const Vec3 unit_axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    Vec3 axes_a[3], axes_b[3];
+    float half_a[3] = {extents_a.x, extents_a.y, extents_a.z};
+    float half_b[3] = {extents_b.x, extents_b.y, extents_b.z};
+    for (int i = 0; i < 3; ++i) {
+        axes_a[i] = quat_rotate(&rot_a, unit_axes[i]);
+        axes_b[i] = quat_rotate(&rot_b, unit_axes[i]);
+    }
+
+    Vec3 delta;
+    vec3_sub(&pos_b, &pos_a, &delta);
+
+    // rotation[i][j] expresses B's axis j in A's frame. The epsilon keeps near-parallel edge pairs from producing a false separating axis.
+    float rotation[3][3], abs_rotation[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            rotation[i][j] = vec3_dot(&axes_a[i], &axes_b[j]);
+            abs_rotation[i][j] = fabsf(rotation[i][j]) + 1e-6f;
+        }
+    }
+
+    // 1. Face axes of A (0-2) and B (3-5): find the one with the least penetration
+    float face_depth = INFINITY;
+    int face_axis = -1;
+    for (int i = 0; i < 3; ++i) {
+        float radius_b = half_b[0] * abs_rotation[i][0] + half_b[1] * abs_rotation[i][1] + half_b[2] * abs_rotation[i][2];
+        float depth = half_a[i] + radius_b - fabsf(vec3_dot(&delta, &axes_a[i]));
+        if (depth < 0.0f) return false;
+        if (depth < face_depth) { face_depth = depth; face_axis = i; }
+    }
+    for (int j = 0; j < 3; ++j) {
+        float radius_a = half_a[0] * abs_rotation[0][j] + half_a[1] * abs_rotation[1][j] + half_a[2] * abs_rotation[2][j];
+        float depth = radius_a + half_b[j] - fabsf(vec3_dot(&delta, &axes_b[j]));
+        if (depth < 0.0f) return false;
+        if (depth < face_depth) { face_depth = depth; face_axis = 3 + j; }
+    }
+
+    // 2. Edge axes: cross products of an axis of A and one of B
+    float edge_depth = INFINITY;
+    int edge_a = -1, edge_b = -1;
+    Vec3 edge_normal = {0, 0, 0};
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            Vec3 axis;
+            vec3_cross(&axes_a[i], &axes_b[j], &axis);
+            float length = vec3_length(&axis);
+            if (length < 1e-4f) continue; // Parallel edges; their face axes already cover this direction
+            vec3_scale(&axis, 1.0f / length, &axis);
+
+            float radius_a = 0.0f, radius_b = 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                radius_a += half_a[k] * fabsf(vec3_dot(&axes_a[k], &axis));
+                radius_b += half_b[k] * fabsf(vec3_dot(&axes_b[k], &axis));
+            }
+            float depth = radius_a + radius_b - fabsf(vec3_dot(&delta, &axis));
+            if (depth < 0.0f) return false;
+            if (depth < edge_depth) {
+                edge_depth = depth;
+                edge_a = i;
+                edge_b = j;
+                edge_normal = axis;
+            }
+        }
+    }
+
+    // 3. Edge contact: one point, midway between the closest points of the two edges
+    if (edge_a >= 0 && edge_depth < EDGE_AXIS_RELATIVE_TOLERANCE * face_depth - EDGE_AXIS_ABSOLUTE_TOLERANCE) {
+        Vec3 normal = edge_normal;
+        if (vec3_dot(&normal, &delta) < 0.0f) vec3_negate(&normal, &normal);
+
+        // The edge of each box that sticks out furthest toward the other box
+        Vec3 point_a = pos_a, point_b = pos_b;
+        uint32_t signs_a = 0, signs_b = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (k != edge_a) {
+                float side = vec3_dot(&axes_a[k], &normal) > 0.0f ? 1.0f : -1.0f;
+                point_a = vec3_add_scaled(point_a, axes_a[k], side * half_a[k]);
+                signs_a = (signs_a << 1) | (side > 0.0f);
+            }
+            if (k != edge_b) {
+                float side = vec3_dot(&axes_b[k], &normal) > 0.0f ? -1.0f : 1.0f;
+                point_b = vec3_add_scaled(point_b, axes_b[k], side * half_b[k]);
+                signs_b = (signs_b << 1) | (side > 0.0f);
+            }
+        }
+
+        // Closest points of the lines point_a + s * axes_a[edge_a] and point_b + t * axes_b[edge_b], clamped to the edges
+        Vec3 between;
+        vec3_sub(&point_b, &point_a, &between);
+        float d = rotation[edge_a][edge_b];
+        float e_a = vec3_dot(&axes_a[edge_a], &between);
+        float e_b = vec3_dot(&axes_b[edge_b], &between);
+        float denominator = 1.0f - d * d;
+        float s = denominator > 1e-6f ? (e_a - d * e_b) / denominator : 0.0f;
+        float t = d * s - e_b;
+        s = fmaxf(-half_a[edge_a], fminf(s, half_a[edge_a]));
+        t = fmaxf(-half_b[edge_b], fminf(t, half_b[edge_b]));
+
+        Vec3 closest_a = vec3_add_scaled(point_a, axes_a[edge_a], s);
+        Vec3 closest_b = vec3_add_scaled(point_b, axes_b[edge_b], t);
+        manifold->normal = normal;
+        manifold->point_count = 1;
+        vec3_add(&closest_a, &closest_b, &manifold->points[0].point);
+        vec3_scale(&manifold->points[0].point, 0.5f, &manifold->points[0].point);
+        manifold->points[0].depth = edge_depth;
+        manifold->points[0].feature_id = 0x1000000u | (uint32_t)(edge_a * 4 + signs_a) << 8 | (uint32_t)(edge_b * 4 + signs_b);
+        return true;
+    }
+
+    // 4. Face contact: one box's face is the reference, the most opposed face of the other box is clipped against it
+    bool reference_is_a = face_axis < 3;
+    int reference_axis = face_axis % 3;
+    Vec3 normal = reference_is_a ? axes_a[reference_axis] : axes_b[reference_axis];
+    if (vec3_dot(&normal, &delta) < 0.0f) vec3_negate(&normal, &normal);
+
+    const Vec3* ref_axes = reference_is_a ? axes_a : axes_b;
+    const Vec3* inc_axes = reference_is_a ? axes_b : axes_a;
+    const float* ref_half = reference_is_a ? half_a : half_b;
+    const float* inc_half = reference_is_a ? half_b : half_a;
+    Vec3 ref_pos = reference_is_a ? pos_a : pos_b;
+    Vec3 inc_pos = reference_is_a ? pos_b : pos_a;
+
+    // The reference face normal points toward the incident box
+    Vec3 ref_normal = normal;
+    if (!reference_is_a) vec3_negate(&ref_normal, &ref_normal);
+    int ref_face = reference_axis * 2 + (vec3_dot(&ref_normal, &ref_axes[reference_axis]) > 0.0f ? 0 : 1);
+
+    int inc_axis = 0;
+    float best_alignment = -1.0f;
+    for (int k = 0; k < 3; ++k) {
+        float alignment = fabsf(vec3_dot(&inc_axes[k], &ref_normal));
+        if (alignment > best_alignment) { best_alignment = alignment; inc_axis = k; }
+    }
+    float inc_side = vec3_dot(&inc_axes[inc_axis], &ref_normal) > 0.0f ? -1.0f : 1.0f;
+    int inc_face = inc_axis * 2 + (inc_side > 0.0f ? 0 : 1);
+
+    int u = (inc_axis + 1) % 3, v = (inc_axis + 2) % 3;
+    Vec3 inc_center = vec3_add_scaled(inc_pos, inc_axes[inc_axis], inc_side * inc_half[inc_axis]);
+    const float corner_signs[4][2] = {{1, 1}, {-1, 1}, {-1, -1}, {1, -1}};
+    ClipVertex polygon[CLIP_MAX_POINTS], clipped[CLIP_MAX_POINTS];
+    int count = 4;
+    for (int c = 0; c < 4; ++c) {
+        Vec3 corner = vec3_add_scaled(inc_center, inc_axes[u], corner_signs[c][0] * inc_half[u]);
+        polygon[c].point = vec3_add_scaled(corner, inc_axes[v], corner_signs[c][1] * inc_half[v]);
+        polygon[c].id = (uint32_t)c;
+        polygon[c].edge = (uint32_t)c;
+    }
+
+    // Clip against the four side planes of the reference face
+    uint32_t plane_id = 0;
+    for (int k = 0; k < 3 && count > 0; ++k) {
+        if (k == reference_axis) continue;
+        for (int side = -1; side <= 1 && count > 0; side += 2) {
+            Vec3 plane_normal;
+            vec3_scale(&ref_axes[k], (float)side, &plane_normal);
+            float offset = vec3_dot(&ref_pos, &plane_normal) + ref_half[k] * (1.0f + CLIP_SIDE_MARGIN);
+            count = clip_polygon(polygon, count, plane_normal, offset, plane_id++, clipped);
+            for (int i = 0; i < count; ++i) polygon[i] = clipped[i];
+        }
+    }
+
+    // Keep the points below the reference face, or just above it
+    Vec3 ref_center = vec3_add_scaled(ref_pos, ref_normal, ref_half[reference_axis]);
+    float ref_offset = vec3_dot(&ref_center, &ref_normal);
+    ManifoldPoint candidates[CLIP_MAX_POINTS];
+    int candidate_count = 0;
+    uint32_t face_pair = (uint32_t)((reference_is_a ? 0 : 8) + ref_face) << 16 | (uint32_t)inc_face << 8;
+    for (int i = 0; i < count; ++i) {
+        float depth = ref_offset - vec3_dot(&polygon[i].point, &ref_normal);
+        if (depth < -BOX_CONTACT_MARGIN) continue;
+        ManifoldPoint* candidate = &candidates[candidate_count++];
+        candidate->point = vec3_add_scaled(polygon[i].point, ref_normal, 0.5f * depth);
+        candidate->depth = depth;
+        candidate->feature_id = face_pair | polygon[i].id;
+    }
+    if (candidate_count == 0) return false;
+
+    manifold->normal = normal;
+    reduce_manifold(candidates, candidate_count, manifold);
+    return true;
+}
+
+/* --- Capsules, cylinders and planes --- */
+
+// Curved contacts whose normal is within about 18 degrees of the deepest one's share its manifold
+#define ROUND_NORMAL_AGREEMENT 0.95f
+#define ROUND_MAX_CONTACTS 16
+
+// A contact point with its own normal, before the points of a pair are merged into one manifold
+typedef struct {
+    Vec3 point;
+    Vec3 normal;
+    float depth;
+    uint32_t feature_id;
+} ShapeContact;
+
+// A box or cylinder, the convex shapes that capsules are tested against
+typedef struct {
+    Vec3 pos;
+    Quat rot;
+    bool is_cylinder;
+    Vec3 extents;      // Box half extents
+    float radius;      // Cylinder radius
+    float half_height; // Cylinder half height
+} ConvexShape;
+
+static Vec3 local_up_axis(Quat rot) {
+    Vec3 up = {0, 1, 0};
+    return quat_rotate(&rot, up);
+}
+
+// The end cap centers of a capsule
+static void capsule_segment(Vec3 pos, Quat rot, float half_height, Vec3* p0, Vec3* p1) {
+    Vec3 axis = local_up_axis(rot);
+    *p0 = vec3_add_scaled(pos, axis, -half_height);
+    *p1 = vec3_add_scaled(pos, axis, half_height);
+}
+
+// Any unit vector perpendicular to the unit vector v
+static Vec3 perpendicular(Vec3 v) {
+    Vec3 other = {0, 0, 0}, result;
+    if (fabsf(v.x) < 0.57f) other.x = 1.0f; else other.y = 1.0f;
+    vec3_cross(&v, &other, &result);
+    vec3_normalize(&result, &result);
+    return result;
+}
+
+// Parameter in [0, 1] of the point of the segment [p0, p1] closest to q
+static float segment_param(Vec3 p0, Vec3 p1, Vec3 q) {
+    Vec3 d, offset;
+    vec3_sub(&p1, &p0, &d);
+    vec3_sub(&q, &p0, &offset);
+    float length_sq = vec3_length_sq(&d);
+    if (length_sq < 1e-12f) return 0.0f;
+    return fmaxf(0.0f, fminf(vec3_dot(&offset, &d) / length_sq, 1.0f));
+}
+
+static Vec3 segment_point(Vec3 p0, Vec3 p1, float t) {
+    Vec3 d;
+    vec3_sub(&p1, &p0, &d);
+    return vec3_add_scaled(p0, d, t);
+}
+
+/**
+ * Parameters s and t of the closest points p0 + s * (p1 - p0) and q0 + t * (q1 - q0)
+ * of two segments (Ericson, Real-Time Collision Detection, 5.1.9).
+ */
+static void closest_segment_params(Vec3 p0, Vec3 p1, Vec3 q0, Vec3 q1, float* s, float* t) {
+    Vec3 d1, d2, r;
+    vec3_sub(&p1, &p0, &d1);
+    vec3_sub(&q1, &q0, &d2);
+    vec3_sub(&p0, &q0, &r);
+    float a = vec3_dot(&d1, &d1);
+    float e = vec3_dot(&d2, &d2);
+    float f = vec3_dot(&d2, &r);
+
+    if (a < 1e-12f && e < 1e-12f) { *s = 0.0f; *t = 0.0f; return; }
+    if (a < 1e-12f) {
+        *s = 0.0f;
+        *t = fmaxf(0.0f, fminf(f / e, 1.0f));
+        return;
+    }
+    float c = vec3_dot(&d1, &r);
+    if (e < 1e-12f) {
+        *t = 0.0f;
+        *s = fmaxf(0.0f, fminf(-c / a, 1.0f));
+        return;
+    }
+
+    float b = vec3_dot(&d1, &d2);
+    float denominator = a * e - b * b;
+    *s = denominator > 1e-12f ? fmaxf(0.0f, fminf((b * f - c * e) / denominator, 1.0f)) : 0.0f;
+    *t = (b * *s + f) / e;
+    if (*t < 0.0f) {
+        *t = 0.0f;
+        *s = fmaxf(0.0f, fminf(-c / a, 1.0f));
+    } else if (*t > 1.0f) {
+        *t = 1.0f;
+        *s = fmaxf(0.0f, fminf((b - c) / a, 1.0f));
+    }
+}
+
+// Signed distance from a local point to the surface of a box centered on the origin (negative inside), and the outward normal there
+static float box_surface_distance(Vec3 p, Vec3 extents, Vec3* normal) {
+    Vec3 clamped = {fmaxf(-extents.x, fminf(p.x, extents.x)),
+                    fmaxf(-extents.y, fminf(p.y, extents.y)),
+                    fmaxf(-extents.z, fminf(p.z, extents.z))};
+    Vec3 delta;
+    vec3_sub(&p, &clamped, &delta);
+    float dist = vec3_length(&delta);
+    if (dist > 0.0f) {
+        vec3_scale(&delta, 1.0f / dist, normal);
+        return dist;
+    }
+
+    // Inside: leave through the nearest face
+    float gaps[3] = {extents.x - fabsf(p.x), extents.y - fabsf(p.y), extents.z - fabsf(p.z)};
+    float coords[3] = {p.x, p.y, p.z};
+    int axis = 0;
+    if (gaps[1] < gaps[axis]) axis = 1;
+    if (gaps[2] < gaps[axis]) axis = 2;
+    float n[3] = {0, 0, 0};
+    n[axis] = coords[axis] < 0.0f ? -1.0f : 1.0f;
+    vec3_set(normal, n[0], n[1], n[2]);
+    return -gaps[axis];
+}
+
+// Signed distance from a local point to the surface of a cylinder centered on the origin along Y, and the outward normal there
+static float cylinder_surface_distance(Vec3 p, float radius, float half_height, Vec3* normal) {
+    float radial = sqrtf(p.x * p.x + p.z * p.z);
+    Vec3 radial_dir = {1, 0, 0};
+    if (radial > 1e-6f) vec3_set(&radial_dir, p.x / radial, 0, p.z / radial);
+    Vec3 cap_dir = {0, p.y < 0.0f ? -1.0f : 1.0f, 0};
+    float past_cap = fabsf(p.y) - half_height;
+    float past_side = radial - radius;
+
+    if (past_cap > 0.0f && past_side > 0.0f) {
+        // Beyond the rim: the closest point is on the rim circle
+        Vec3 delta;
+        vec3_scale(&radial_dir, past_side, &delta);
+        delta = vec3_add_scaled(delta, cap_dir, past_cap);
+        float dist = vec3_length(&delta);
+        vec3_scale(&delta, 1.0f / dist, normal);
+        return dist;
+    }
+    // Beside the side, above a cap, or inside: whichever surface is nearest (or furthest, from inside)
+    if (past_cap > past_side) {
+        *normal = cap_dir;
+        return past_cap;
+    }
+    *normal = radial_dir;
+    return past_side;
+}
+
+// Signed distance from a world point to the shape's surface, and the world-space outward normal there
+static float shape_surface_distance(const ConvexShape* shape, Vec3 point, Vec3* normal) {
+    Quat inverse_rot = {-shape->rot.x, -shape->rot.y, -shape->rot.z, shape->rot.w};
+    Vec3 offset;
+    vec3_sub(&point, &shape->pos, &offset);
+    Vec3 local = quat_rotate(&inverse_rot, offset);
+
+    Vec3 local_normal;
+    float dist = shape->is_cylinder ? cylinder_surface_distance(local, shape->radius, shape->half_height, &local_normal)
+                                    : box_surface_distance(local, shape->extents, &local_normal);
+    *normal = quat_rotate(&shape->rot, local_normal);
+    return dist;
+}
+
+// Contact of a sphere with a box or cylinder. The normal points from the shape to the sphere.
+static bool sphere_shape_contact(const ConvexShape* shape, Vec3 center, float radius, uint32_t feature_id, ShapeContact* out) {
+    Vec3 normal;
+    float dist = shape_surface_distance(shape, center, &normal);
+    if (dist >= radius) return false;
+    out->normal = normal;
+    out->depth = radius - dist;
+    out->point = vec3_add_scaled(center, normal, -0.5f * (dist + radius));
+    out->feature_id = feature_id;
+    return true;
+}
+
+// Contact of two spheres, e.g. the closest points of two capsule segments. The normal points from a to b.
+static bool sphere_pair_contact(Vec3 a, float radius_a, Vec3 b, float radius_b, uint32_t feature_id, ShapeContact* out) {
+    CollisionInfo info = test_sphere_vs_sphere(a, radius_a, b, radius_b);
+    if (!info.has_collided) return false;
+    out->normal = info.normal;
+    out->depth = info.depth;
+    out->point = vec3_add_scaled(a, info.normal, radius_a - 0.5f * info.depth);
+    out->feature_id = feature_id;
+    return true;
+}
+
+// Contact of a point of a shape, rounded by 'radius', with a plane. The normal points from the shape into the plane.
+static bool plane_contact(Vec3 point, float radius, Vec3 plane_pos, Vec3 plane_normal, uint32_t feature_id, ShapeContact* out) {
+    Vec3 offset;
+    vec3_sub(&point, &plane_pos, &offset);
+    float dist = vec3_dot(&offset, &plane_normal) - radius;
+    if (dist >= 0.0f) return false;
+    vec3_negate(&plane_normal, &out->normal);
+    out->depth = -dist;
+    out->point = vec3_add_scaled(point, plane_normal, -(radius + 0.5f * dist));
+    out->feature_id = feature_id;
+    return true;
+}
+
+/**
+ * Merges the contacts of one pair into a manifold. Contacts on curved surfaces can disagree on
+ * the normal, so the manifold takes the deepest contact's normal and keeps the points that agree with it.
+ */
+static bool finish_manifold(const ShapeContact* contacts, int count, ContactManifold* manifold) {
+    if (count == 0) return false;
+    int deepest = 0;
+    for (int i = 1; i < count; ++i) {
+        if (contacts[i].depth > contacts[deepest].depth) deepest = i;
+    }
+
+    manifold->normal = contacts[deepest].normal;
+    ManifoldPoint candidates[ROUND_MAX_CONTACTS];
+    int candidate_count = 0;
+    for (int i = 0; i < count; ++i) {
+        if (vec3_dot(&contacts[i].normal, &manifold->normal) < ROUND_NORMAL_AGREEMENT) continue;
+        candidates[candidate_count].point = contacts[i].point;
+        candidates[candidate_count].depth = contacts[i].depth;
+        candidates[candidate_count].feature_id = contacts[i].feature_id;
+        ++candidate_count;
+    }
+    reduce_manifold(candidates, candidate_count, manifold);
+    return true;
+}
+
+/**
+ * The rim points of a cylinder that reach furthest along 'direction': on each cap, the one furthest
+ * along it, the opposite one and the two halfway between them. Caps facing 'direction' head on get
+ * an arbitrary but fixed starting point, so standing cylinders rest on four points of the rim.
+ */
+static void cylinder_rim_points(Vec3 pos, Vec3 axis, float radius, float half_height, Vec3 direction, Vec3 rim[8]) {
+    Vec3 u = vec3_add_scaled(direction, axis, -vec3_dot(&direction, &axis));
+    float length = vec3_length(&u);
+    if (length > 1e-4f) {
+        vec3_scale(&u, 1.0f / length, &u);
+    } else {
+        u = perpendicular(axis);
+    }
+    Vec3 w;
+    vec3_cross(&axis, &u, &w);
+
+    for (int cap = 0; cap < 2; ++cap) {
+        Vec3 center = vec3_add_scaled(pos, axis, cap == 0 ? -half_height : half_height);
+        rim[cap * 4 + 0] = vec3_add_scaled(center, u, radius);
+        rim[cap * 4 + 1] = vec3_add_scaled(center, w, radius);
+        rim[cap * 4 + 2] = vec3_add_scaled(center, u, -radius);
+        rim[cap * 4 + 3] = vec3_add_scaled(center, w, -radius);
+    }
+}
+
+/**
+ * Capsule against a box or cylinder: the two end caps and the point of the capsule's segment
+ * closest to the shape are each tested as spheres. The closest point is found by alternating
+ * projections between the segment and the shape, which converge for any pair of convex sets.
+ */
+static bool test_shape_vs_capsule(const ConvexShape* shape, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                                  float cap_half_height, ContactManifold* manifold) {
+    Vec3 p0, p1;
+    capsule_segment(cap_pos, cap_rot, cap_half_height, &p0, &p1);
+
+    float t = 0.5f;
+    for (int iteration = 0; iteration < 16; ++iteration) {
+        Vec3 point = segment_point(p0, p1, t), normal;
+        float dist = shape_surface_distance(shape, point, &normal);
+        if (dist <= 0.0f) break; // The segment enters the shape
+        float next = segment_param(p0, p1, vec3_add_scaled(point, normal, -dist));
+        if (fabsf(next - t) < 1e-5f) break;
+        t = next;
+    }
+
+    ShapeContact contacts[3];
+    int count = 0;
+    count += sphere_shape_contact(shape, p0, cap_radius, 0, &contacts[count]);
+    count += sphere_shape_contact(shape, p1, cap_radius, 1, &contacts[count]);
+    // Skip the closest point when it is one of the end caps
+    if (t > 0.01f && t < 0.99f) {
+        count += sphere_shape_contact(shape, segment_point(p0, p1, t), cap_radius, 2, &contacts[count]);
+    }
+    return finish_manifold(contacts, count, manifold);
+}
+
+bool test_sphere_vs_capsule(Vec3 sphere_pos, float sphere_radius, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                            float cap_half_height, ContactManifold* manifold) {
+    Vec3 p0, p1;
+    capsule_segment(cap_pos, cap_rot, cap_half_height, &p0, &p1);
+    Vec3 closest = segment_point(p0, p1, segment_param(p0, p1, sphere_pos));
+
+    ShapeContact contact;
+    if (!sphere_pair_contact(sphere_pos, sphere_radius, closest, cap_radius, 0, &contact)) return false;
+    return finish_manifold(&contact, 1, manifold);
+}
+
+bool test_sphere_vs_cylinder(Vec3 sphere_pos, float sphere_radius, Vec3 cyl_pos, Quat cyl_rot, float cyl_radius,
+                             float cyl_half_height, ContactManifold* manifold) {
+    ConvexShape cylinder = {cyl_pos, cyl_rot, true, {0, 0, 0}, cyl_radius, cyl_half_height};
+    ShapeContact contact;
+    if (!sphere_shape_contact(&cylinder, sphere_pos, sphere_radius, 0, &contact)) return false;
+    vec3_negate(&contact.normal, &contact.normal); // From the sphere to the cylinder
+    return finish_manifold(&contact, 1, manifold);
+}
+
+bool test_sphere_vs_plane(Vec3 sphere_pos, float sphere_radius, Vec3 plane_pos, Vec3 plane_normal, ContactManifold* manifold) {
+    ShapeContact contact;
+    if (!plane_contact(sphere_pos, sphere_radius, plane_pos, plane_normal, 0, &contact)) return false;
+    return finish_manifold(&contact, 1, manifold);
+}
+
+bool test_box_vs_capsule(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                         float cap_half_height, ContactManifold* manifold) {
+    ConvexShape box = {box_pos, box_rot, false, box_extents, 0.0f, 0.0f};
+    return test_shape_vs_capsule(&box, cap_pos, cap_rot, cap_radius, cap_half_height, manifold);
+}
+
+bool test_box_vs_plane(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 plane_pos, Vec3 plane_normal,
+                       ContactManifold* manifold) {
+    ShapeContact contacts[8];
+    int count = 0;
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        Vec3 local = {corner & 1 ? box_extents.x : -box_extents.x,
+                      corner & 2 ? box_extents.y : -box_extents.y,
+                      corner & 4 ? box_extents.z : -box_extents.z};
+        Vec3 point = quat_rotate(&box_rot, local);
+        vec3_add(&point, &box_pos, &point);
+        count += plane_contact(point, 0.0f, plane_pos, plane_normal, corner, &contacts[count]);
+    }
+    return finish_manifold(contacts, count, manifold);
+}
+
+bool test_box_vs_cylinder(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 cyl_pos, Quat cyl_rot, float cyl_radius,
+                          float cyl_half_height, ContactManifold* manifold) {
+    const Vec3 unit_axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+    float half[3] = {box_extents.x, box_extents.y, box_extents.z};
+    Vec3 axes[3];
+    for (int k = 0; k < 3; ++k) axes[k] = quat_rotate(&box_rot, unit_axes[k]);
+    Vec3 axis = local_up_axis(cyl_rot);
+    Vec3 delta;
+    vec3_sub(&cyl_pos, &box_pos, &delta);
+
+    // 1. Separating axis test on the box's face normals, the cylinder's axis and the box's edges crossed with that
+    //    axis, which separate a box edge from the cylinder's side. The normal is the one of least penetration.
+    float best_depth = INFINITY;
+    int best_axis = -1;
+    Vec3 normal = axis;
+    for (int k = 0; k < 7; ++k) {
+        Vec3 candidate = k < 3 ? axes[k] : axis;
+        if (k > 3) {
+            vec3_cross(&axes[k - 4], &axis, &candidate);
+            float length = vec3_length(&candidate);
+            if (length < 1e-4f) continue;  // The edge runs along the axis, and the face axes cover it
+            vec3_scale(&candidate, 1.0f / length, &candidate);
+        }
+        float along = fabsf(vec3_dot(&candidate, &axis));
+        float cyl_extent = cyl_half_height * along + cyl_radius * sqrtf(fmaxf(0.0f, 1.0f - along * along));
+        float box_extent = 0.0f;
+        for (int j = 0; j < 3; ++j) box_extent += half[j] * fabsf(vec3_dot(&axes[j], &candidate));
+        float depth = box_extent + cyl_extent - fabsf(vec3_dot(&delta, &candidate));
+        if (depth < 0.0f) return false;
+        if (depth < best_depth) {
+            best_depth = depth;
+            best_axis = k;
+            normal = candidate;
+        }
+    }
+    if (vec3_dot(&normal, &delta) < 0.0f) vec3_negate(&normal, &normal);
+
+    // How far each shape reaches along the normal, from its center
+    float box_reach = 0.0f;
+    for (int j = 0; j < 3; ++j) box_reach += half[j] * fabsf(vec3_dot(&axes[j], &normal));
+    float along = fabsf(vec3_dot(&normal, &axis));
+    float cyl_reach = cyl_half_height * along + cyl_radius * sqrtf(fmaxf(0.0f, 1.0f - along * along));
+    ConvexShape box = {box_pos, box_rot, false, box_extents, 0.0f, 0.0f};
+    ConvexShape cylinder = {cyl_pos, cyl_rot, true, {0, 0, 0}, cyl_radius, cyl_half_height};
+    uint32_t axis_id = (uint32_t)best_axis << 8;
+
+    ShapeContact contacts[16];
+    int count = 0;
+    Vec3 surface_normal;
+
+    // 2. Rim points of the cylinder inside the box, pushed out along the normal
+    Vec3 toward_box, rim[8];
+    vec3_negate(&normal, &toward_box);
+    cylinder_rim_points(cyl_pos, axis, cyl_radius, cyl_half_height, toward_box, rim);
+    for (uint32_t i = 0; i < 8; ++i) {
+        if (shape_surface_distance(&box, rim[i], &surface_normal) > 0.0f) continue;
+        Vec3 offset;
+        vec3_sub(&rim[i], &box_pos, &offset);
+        ShapeContact* contact = &contacts[count++];
+        contact->depth = box_reach - vec3_dot(&offset, &normal);
+        contact->point = vec3_add_scaled(rim[i], normal, 0.5f * contact->depth);
+        contact->normal = normal;
+        contact->feature_id = axis_id | i;
+    }
+
+    // 3. Corners of the box inside the cylinder
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        Vec3 local = {corner & 1 ? box_extents.x : -box_extents.x,
+                      corner & 2 ? box_extents.y : -box_extents.y,
+                      corner & 4 ? box_extents.z : -box_extents.z};
+        Vec3 point = quat_rotate(&box_rot, local);
+        vec3_add(&point, &box_pos, &point);
+        if (shape_surface_distance(&cylinder, point, &surface_normal) > 0.0f) continue;
+        Vec3 offset;
+        vec3_sub(&point, &cyl_pos, &offset);
+        ShapeContact* contact = &contacts[count++];
+        contact->depth = vec3_dot(&offset, &normal) + cyl_reach;
+        contact->point = vec3_add_scaled(point, normal, -0.5f * contact->depth);
+        contact->normal = normal;
+        contact->feature_id = axis_id | 8u | corner;
+    }
+    if (count > 0) return finish_manifold(contacts, count, manifold);
+
+    // 4. No rim point or corner is inside the other shape, e.g. a box edge against the side or the rim. The
+    //    cylinder's curved side has more separating axes than the test above tries, so GJK/EPA settles it.
+    ConvexShapeData box_data = {0.0f, 0.0f, box_extents, NULL, 0};
+    ConvexShapeData cylinder_data = {cyl_radius, cyl_half_height, {0, 0, 0}, NULL, 0};
+    ConvexObject box_object = {support_box, &box_data, box_pos, box_rot};
+    ConvexObject cylinder_object = {support_cylinder, &cylinder_data, cyl_pos, cyl_rot};
+    ConvexPairCache cache = {0};
+    if (!test_convex_vs_convex(&box_object, &cylinder_object, &cache, manifold)) return false;
+    manifold->points[0].feature_id = 16u;
+    return true;
+}
+
+bool test_cylinder_vs_capsule(Vec3 cyl_pos, Quat cyl_rot, float cyl_radius, float cyl_half_height, Vec3 cap_pos,
+                              Quat cap_rot, float cap_radius, float cap_half_height, ContactManifold* manifold) {
+    ConvexShape cylinder = {cyl_pos, cyl_rot, true, {0, 0, 0}, cyl_radius, cyl_half_height};
+    return test_shape_vs_capsule(&cylinder, cap_pos, cap_rot, cap_radius, cap_half_height, manifold);
+}
+
+bool test_cylinder_vs_plane(Vec3 cyl_pos, Quat cyl_rot, float cyl_radius, float cyl_half_height, Vec3 plane_pos,
+                            Vec3 plane_normal, ContactManifold* manifold) {
+    Vec3 down, rim[8];
+    vec3_negate(&plane_normal, &down);
+    cylinder_rim_points(cyl_pos, local_up_axis(cyl_rot), cyl_radius, cyl_half_height, down, rim);
+
+    ShapeContact contacts[8];
+    int count = 0;
+    for (uint32_t i = 0; i < 8; ++i) {
+        count += plane_contact(rim[i], 0.0f, plane_pos, plane_normal, i, &contacts[count]);
+    }
+    return finish_manifold(contacts, count, manifold);
+}
+
+bool test_capsule_vs_capsule(Vec3 pos_a, Quat rot_a, float radius_a, float half_height_a, Vec3 pos_b, Quat rot_b,
+                             float radius_b, float half_height_b, ContactManifold* manifold) {
+    Vec3 p0, p1, q0, q1;
+    capsule_segment(pos_a, rot_a, half_height_a, &p0, &p1);
+    capsule_segment(pos_b, rot_b, half_height_b, &q0, &q1);
+
+    ShapeContact contacts[4];
+    int count = 0;
+    Vec3 d1, d2, cross;
+    vec3_sub(&p1, &p0, &d1);
+    vec3_sub(&q1, &q0, &d2);
+    vec3_cross(&d1, &d2, &cross);
+    bool parallel = vec3_length_sq(&cross) < 1e-4f * vec3_length_sq(&d1) * vec3_length_sq(&d2);
+
+    if (parallel) {
+        // Side by side: contacts at both ends of the overlap, from the end caps of either capsule
+        Vec3 ends[4][2] = {{p0, segment_point(q0, q1, segment_param(q0, q1, p0))},
+                           {p1, segment_point(q0, q1, segment_param(q0, q1, p1))},
+                           {segment_point(p0, p1, segment_param(p0, p1, q0)), q0},
+                           {segment_point(p0, p1, segment_param(p0, p1, q1)), q1}};
+        for (uint32_t i = 0; i < 4; ++i) {
+            // An end cap beyond the other segment's end pairs up with that end, like the other cap does
+            bool duplicate = false;
+            for (uint32_t j = 0; j < i; ++j) {
+                duplicate |= vec3_dist_sq(&ends[i][0], &ends[j][0]) < 1e-8f && vec3_dist_sq(&ends[i][1], &ends[j][1]) < 1e-8f;
+            }
+            if (duplicate) continue;
+            count += sphere_pair_contact(ends[i][0], radius_a, ends[i][1], radius_b, i, &contacts[count]);
+        }
+    }
+    if (count == 0) {
+        float s, t;
+        closest_segment_params(p0, p1, q0, q1, &s, &t);
+        count += sphere_pair_contact(segment_point(p0, p1, s), radius_a, segment_point(q0, q1, t), radius_b, 4, &contacts[count]);
+    }
+    return finish_manifold(contacts, count, manifold);
+}
+
+bool test_capsule_vs_plane(Vec3 cap_pos, Quat cap_rot, float cap_radius, float cap_half_height, Vec3 plane_pos,
+                           Vec3 plane_normal, ContactManifold* manifold) {
+    Vec3 p0, p1;
+    capsule_segment(cap_pos, cap_rot, cap_half_height, &p0, &p1);
+    ShapeContact contacts[2];
+    int count = 0;
+    count += plane_contact(p0, cap_radius, plane_pos, plane_normal, 0, &contacts[count]);
+    count += plane_contact(p1, cap_radius, plane_pos, plane_normal, 1, &contacts[count]);
+    return finish_manifold(contacts, count, manifold);
+}
+
+bool test_convex_hull_vs_plane(Vec3 hull_pos, Quat hull_rot, const Vec3* vertices, size_t vertex_count, Vec3 plane_pos,
+                               Vec3 plane_normal, ContactManifold* manifold) {
+    // Hulls can have any number of points, so the reduction of reduce_manifold runs over them in passes instead of on a copy
+    ShapeContact deepest = {{0, 0, 0}, {0, 0, 0}, 0.0f, 0};
+    bool hit = false;
+    for (size_t i = 0; i < vertex_count; ++i) {
+        Vec3 point = quat_rotate(&hull_rot, vertices[i]);
+        vec3_add(&point, &hull_pos, &point);
+        ShapeContact contact;
+        if (plane_contact(point, 0.0f, plane_pos, plane_normal, (uint32_t)i, &contact) && contact.depth > deepest.depth) {
+            deepest = contact;
+            hit = true;
+        }
+    }
+    if (!hit) return false;
+
+    ShapeContact picks[MAX_MANIFOLD_POINTS];
+    int pick_count = 1;
+    picks[0] = deepest;
+    float best = 0.0f, max_area = 0.0f, min_area = 0.0f;
+    for (int pass = 0; pass < 2; ++pass) {
+        ShapeContact second = picks[0], positive = picks[0], negative = picks[0];
+        bool has_positive = false, has_negative = false;
+        for (size_t i = 0; i < vertex_count; ++i) {
+            Vec3 point = quat_rotate(&hull_rot, vertices[i]);
+            vec3_add(&point, &hull_pos, &point);
+            ShapeContact contact;
+            if (!plane_contact(point, 0.0f, plane_pos, plane_normal, (uint32_t)i, &contact)) continue;
+            if (pass == 0) {
+                // The point furthest from the deepest one
+                float dist_sq = vec3_dist_sq(&contact.point, &picks[0].point);
+                if (dist_sq > best) { best = dist_sq; second = contact; }
+            } else {
+                // The points furthest out on either side of the line between the first two
+                float area = signed_area(&picks[0].point, &picks[1].point, &contact.point, &contact.normal);
+                if (area > max_area) { max_area = area; positive = contact; has_positive = true; }
+                if (area < min_area) { min_area = area; negative = contact; has_negative = true; }
+            }
+        }
+        if (pass == 0) {
+            if (best == 0.0f) break;
+            picks[pick_count++] = second;
+        } else {
+            if (has_positive) picks[pick_count++] = positive;
+            if (has_negative) picks[pick_count++] = negative;
+        }
+    }
+    return finish_manifold(picks, pick_count, manifold);
+}
+
+/* --- Swept spheres --- */
+
+// A sweep reports a hit once the sphere is this close to the surface
+#define SWEEP_TOLERANCE 1e-4f
+#define SWEEP_MAX_ITERATIONS 32
+
+// Distance from a world point to a convex shape (negative inside), and the outward normal there
+typedef float (*SurfaceDistance)(const void* shape, Vec3 point, Vec3* normal);
+
+/**
+ * Conservative advancement of a sphere's center towards a convex shape. Along a line the
+ * distance to a convex set is convex, so the tangent at the current point never crosses
+ * the radius later than the true distance does: each Newton step lands at or before the
+ * time of impact, and once the center moves away it never comes back.
+ * A sphere that starts out overlapping the shape is left to the discrete tests.
+ */
+static bool sweep_to_surface(SurfaceDistance distance, const void* shape, Vec3 start, Vec3 motion, float radius,
+                             SweepHit* hit) {
+    float t = 0.0f;
+    for (int i = 0; i < SWEEP_MAX_ITERATIONS; ++i) {
+        Vec3 center = vec3_add_scaled(start, motion, t);
+        Vec3 normal;
+        float gap = distance(shape, center, &normal) - radius;
+        if (t == 0.0f && gap < 0.0f) return false;
+        float closing = -vec3_dot(&normal, &motion);
+        if (closing <= 0.0f) return false;
+        if (gap < SWEEP_TOLERANCE || i == SWEEP_MAX_ITERATIONS - 1) {
+            hit->toi = t;
+            hit->normal = normal;
+            hit->point = vec3_add_scaled(center, normal, -radius);
+            return true;
+        }
+        t += gap / closing;
+        if (t > 1.0f) return false;
+    }
+    return false;
+}
+
+// Shape is a segment as two points; a point is a segment of zero length
+static float segment_distance(const void* shape, Vec3 point, Vec3* normal) {
+    const Vec3* segment = (const Vec3*)shape;
+    Vec3 closest = segment_point(segment[0], segment[1], segment_param(segment[0], segment[1], point));
+    Vec3 delta;
+    vec3_sub(&point, &closest, &delta);
+    float dist = vec3_length(&delta);
+    if (dist > 1e-9f) {
+        vec3_scale(&delta, 1.0f / dist, normal);
+    } else {
+        vec3_set(normal, 0, 1, 0);
+    }
+    return dist;
+}
+
+static float box_or_cylinder_distance(const void* shape, Vec3 point, Vec3* normal) {
+    return shape_surface_distance((const ConvexShape*)shape, point, normal);
+}
+
+// Shape is the plane's position and its unit normal
+static float plane_distance(const void* shape, Vec3 point, Vec3* normal) {
+    const Vec3* plane = (const Vec3*)shape;
+    Vec3 offset;
+    vec3_sub(&point, &plane[0], &offset);
+    *normal = plane[1];
+    return vec3_dot(&offset, &plane[1]);
+}
+
+// Closest point of the triangle abc to p (Ericson, Real-Time Collision Detection, 5.1.5)
+static Vec3 closest_point_on_triangle(Vec3 p, Vec3 a, Vec3 b, Vec3 c) {
+    Vec3 ab, ac, ap, bp, cp;
+    vec3_sub(&b, &a, &ab);
+    vec3_sub(&c, &a, &ac);
+    vec3_sub(&p, &a, &ap);
+    float d1 = vec3_dot(&ab, &ap), d2 = vec3_dot(&ac, &ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    vec3_sub(&p, &b, &bp);
+    float d3 = vec3_dot(&ab, &bp), d4 = vec3_dot(&ac, &bp);
+    if (d3 >= 0.0f && d4 <= d3) return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) return vec3_add_scaled(a, ab, d1 / (d1 - d3));
+
+    vec3_sub(&p, &c, &cp);
+    float d5 = vec3_dot(&ab, &cp), d6 = vec3_dot(&ac, &cp);
+    if (d6 >= 0.0f && d5 <= d6) return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) return vec3_add_scaled(a, ac, d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        Vec3 bc;
+        vec3_sub(&c, &b, &bc);
+        return vec3_add_scaled(b, bc, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+    }
+
+    float denominator = 1.0f / (va + vb + vc);
+    return vec3_add_scaled(vec3_add_scaled(a, ab, vb * denominator), ac, vc * denominator);
+}
+
+// Shape is the triangle's three corners. Triangles are two-sided and have no inside.
+static float triangle_distance(const void* shape, Vec3 point, Vec3* normal) {
+    const Vec3* corners = (const Vec3*)shape;
+    Vec3 closest = closest_point_on_triangle(point, corners[0], corners[1], corners[2]);
+    Vec3 delta;
+    vec3_sub(&point, &closest, &delta);
+    float dist = vec3_length(&delta);
+    if (dist > 1e-9f) {
+        vec3_scale(&delta, 1.0f / dist, normal);
+    } else {
+        Vec3 e0, e1;
+        vec3_sub(&corners[1], &corners[0], &e0);
+        vec3_sub(&corners[2], &corners[0], &e1);
+        vec3_cross(&e0, &e1, normal);
+        vec3_normalize(normal, normal);
+    }
+    return dist;
+}
+
+bool sweep_sphere_vs_sphere(Vec3 start, Vec3 motion, float radius, Vec3 other_pos, float other_radius, SweepHit* hit) {
+    Vec3 point[2] = {other_pos, other_pos};
+    if (!sweep_to_surface(segment_distance, point, start, motion, radius + other_radius, hit)) return false;
+    hit->point = vec3_add_scaled(hit->point, hit->normal, other_radius);
+    return true;
+}
+
+bool sweep_sphere_vs_box(Vec3 start, Vec3 motion, float radius, Vec3 box_pos, Quat box_rot, Vec3 box_extents,
+                         SweepHit* hit) {
+    ConvexShape box = {box_pos, box_rot, false, box_extents, 0.0f, 0.0f};
+    return sweep_to_surface(box_or_cylinder_distance, &box, start, motion, radius, hit);
+}
+
+bool sweep_sphere_vs_capsule(Vec3 start, Vec3 motion, float radius, Vec3 cap_pos, Quat cap_rot, float cap_radius,
+                             float cap_half_height, SweepHit* hit) {
+    Vec3 segment[2];
+    capsule_segment(cap_pos, cap_rot, cap_half_height, &segment[0], &segment[1]);
+    if (!sweep_to_surface(segment_distance, segment, start, motion, radius + cap_radius, hit)) return false;
+    // The sweep ran against the capsule's core segment; move the point out to its surface
+    hit->point = vec3_add_scaled(hit->point, hit->normal, cap_radius);
+    return true;
+}
+
+bool sweep_sphere_vs_cylinder(Vec3 start, Vec3 motion, float radius, Vec3 cyl_pos, Quat cyl_rot, float cyl_radius,
+                              float cyl_half_height, SweepHit* hit) {
+    ConvexShape cylinder = {cyl_pos, cyl_rot, true, {0, 0, 0}, cyl_radius, cyl_half_height};
+    return sweep_to_surface(box_or_cylinder_distance, &cylinder, start, motion, radius, hit);
+}
+
+bool sweep_sphere_vs_plane(Vec3 start, Vec3 motion, float radius, Vec3 plane_pos, Vec3 plane_normal, SweepHit* hit) {
+    Vec3 plane[2] = {plane_pos, plane_normal};
+    return sweep_to_surface(plane_distance, plane, start, motion, radius, hit);
+}
+
+/* --- Triangle meshes --- */
+
+#define BVH_LEAF_SIZE 4
+// Below this depth nodes become leaves whatever their size, which bounds the stack of the queries
+#define BVH_MAX_DEPTH 48
+#define MESH_MAX_CONTACTS ROUND_MAX_CONTACTS
+// How much deeper than the shape's points the mesh's corners and edges must reach to make contacts
+#define MESH_FEATURE_MARGIN 1e-3f
+
+static float vec3_axis(Vec3 v, int axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+static void aabb_grow(AABB* bounds, Vec3 p) {
+    bounds->min.x = fminf(bounds->min.x, p.x);
+    bounds->min.y = fminf(bounds->min.y, p.y);
+    bounds->min.z = fminf(bounds->min.z, p.z);
+    bounds->max.x = fmaxf(bounds->max.x, p.x);
+    bounds->max.y = fmaxf(bounds->max.y, p.y);
+    bounds->max.z = fmaxf(bounds->max.z, p.z);
+}
+
+static bool aabbs_overlap(const AABB* a, const AABB* b) {
+    return a->min.x <= b->max.x && a->max.x >= b->min.x &&
+           a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+static Vec3 triangle_centroid(const Vec3* vertices, const unsigned int* triangle) {
+    Vec3 sum;
+    vec3_add(&vertices[triangle[0]], &vertices[triangle[1]], &sum);
+    vec3_add(&sum, &vertices[triangle[2]], &sum);
+    vec3_scale(&sum, 1.0f / 3.0f, &sum);
+    return sum;
+}
+
+typedef struct {
+    const Vec3* vertices;
+    unsigned int* indices;
+    BvhNode* nodes;
+    uint32_t node_count;
+} BvhBuilder;
+
+// Builds the subtree over the triangles [first, first + count) and returns the index of its root
+static uint32_t build_bvh_node(BvhBuilder* builder, uint32_t first, uint32_t count, int depth) {
+    uint32_t index = builder->node_count++;
+    const Vec3* vertices = builder->vertices;
+    unsigned int* indices = builder->indices;
+
+    Vec3 start = vertices[indices[3 * first]];
+    AABB bounds = {start, start};
+    Vec3 centroid = triangle_centroid(vertices, &indices[3 * first]);
+    AABB centroid_bounds = {centroid, centroid};
+    for (uint32_t i = first; i < first + count; ++i) {
+        for (int k = 0; k < 3; ++k) aabb_grow(&bounds, vertices[indices[3 * i + k]]);
+        aabb_grow(&centroid_bounds, triangle_centroid(vertices, &indices[3 * i]));
+    }
+    builder->nodes[index].bounds = bounds;
+    if (count <= BVH_LEAF_SIZE || depth >= BVH_MAX_DEPTH) {
+        builder->nodes[index].offset = first;
+        builder->nodes[index].count = count;
+        return index;
+    }
+
+    // Split at the middle of the centroids' longest axis, or in half when the centroids coincide
+    Vec3 extent;
+    vec3_sub(&centroid_bounds.max, &centroid_bounds.min, &extent);
+    int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+    float split = 0.5f * (vec3_axis(centroid_bounds.min, axis) + vec3_axis(centroid_bounds.max, axis));
+    uint32_t middle = first;
+    for (uint32_t i = first; i < first + count; ++i) {
+        if (vec3_axis(triangle_centroid(vertices, &indices[3 * i]), axis) < split) {
+            for (int k = 0; k < 3; ++k) {
+                unsigned int swap = indices[3 * i + k];
+                indices[3 * i + k] = indices[3 * middle + k];
+                indices[3 * middle + k] = swap;
+            }
+            ++middle;
+        }
+    }
+    if (middle == first || middle == first + count) middle = first + count / 2;
+
+    // The first child follows its parent, so only the second one's index is stored
+    build_bvh_node(builder, first, middle - first, depth + 1);
+    uint32_t second = build_bvh_node(builder, middle, first + count - middle, depth + 1);
+    builder->nodes[index].offset = second;
+    builder->nodes[index].count = 0;
+    return index;
+}
+
+size_t mesh_bvh_max_nodes(size_t triangle_count) {
+    return triangle_count > 0 ? 2 * triangle_count - 1 : 0;
+}
+
+size_t mesh_bvh_build(const Vec3* vertices, unsigned int* indices, size_t triangle_count, BvhNode* nodes) {
+    if (triangle_count == 0) return 0;
+    BvhBuilder builder = {vertices, indices, nodes, 0};
+    build_bvh_node(&builder, 0, (uint32_t)triangle_count, 0);
+    return builder.node_count;
+}
+
+bool mesh_bvh_is_valid(const MeshShape* mesh) {
+    if (mesh->node_count == 0) return true;
+    // Walks the whole tree the way mesh_query does, so a tree that passes fits its stack
+    uint32_t stack[BVH_MAX_DEPTH + 2];
+    int depths[BVH_MAX_DEPTH + 2];
+    int top = 0;
+    size_t visited = 0;
+    stack[top] = 0;
+    depths[top++] = 0;
+    while (top > 0) {
+        --top;
+        uint32_t index = stack[top];
+        int depth = depths[top];
+        if (++visited > mesh->node_count) return false;
+        const BvhNode* node = &mesh->nodes[index];
+        if (node->count > 0) {
+            if ((uint64_t)node->offset + node->count > mesh->triangle_count) return false;
+            continue;
+        }
+        // Children come after their parent, which also rules out cycles
+        if (depth >= BVH_MAX_DEPTH || (size_t)index + 1 >= mesh->node_count || node->offset <= index + 1 ||
+            node->offset >= mesh->node_count) {
+            return false;
+        }
+        stack[top] = node->offset;
+        depths[top++] = depth + 1;
+        stack[top] = index + 1;
+        depths[top++] = depth + 1;
+    }
+    return visited == mesh->node_count;
+}
+
+// Called for every triangle of the leaves a query reaches, with its corners in the mesh's frame
+typedef void (*TriangleVisitor)(void* context, uint32_t triangle, const Vec3 corners[3]);
+
+// Walks the BVH down to the leaves whose bounds overlap 'bounds', given in the mesh's frame
+static void mesh_query(const MeshShape* mesh, const AABB* bounds, TriangleVisitor visit, void* context) {
+    if (mesh->node_count == 0) return;
+    uint32_t stack[BVH_MAX_DEPTH + 2];
+    int top = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        uint32_t index = stack[--top];
+        const BvhNode* node = &mesh->nodes[index];
+        if (!aabbs_overlap(&node->bounds, bounds)) continue;
+        if (node->count == 0) {
+            stack[top++] = node->offset;
+            stack[top++] = index + 1;
+            continue;
+        }
+        for (uint32_t i = node->offset; i < node->offset + node->count; ++i) {
+            const unsigned int* triangle = &mesh->indices[3 * i];
+            Vec3 corners[3] = {mesh->vertices[triangle[0]], mesh->vertices[triangle[1]], mesh->vertices[triangle[2]]};
+            visit(context, i, corners);
+        }
+    }
+}
+
+// A shape moved into a mesh's frame, with the contacts found so far against the mesh's triangles
+typedef struct {
+    Vec3 pos;
+    Quat rot;
+    float radius;          // Sphere and capsule
+    Vec3 p0, p1;           // Capsule segment
+    ConvexShape shape;     // Box or cylinder
+    Vec3 corners[8];       // Box corners
+    ConvexShapeData hull_data;  // Convex hull points, in the hull's frame
+    ConvexObject hull;          // The hull placed at pos and rot, for GJK/EPA against each triangle
+    ShapeContact contacts[MESH_MAX_CONTACTS];
+    int count;
+    // The deepest contact of each point of the shape, over all triangles
+    ShapeContact deepest[8];
+    bool has_deepest[8];
+} MeshQuery;
+
+// Moves a world pose into the mesh's frame
+static void mesh_query_init(MeshQuery* query, Vec3 pos, Quat rot, Vec3 mesh_pos, Quat mesh_rot) {
+    Quat inverse_rot = {-mesh_rot.x, -mesh_rot.y, -mesh_rot.z, mesh_rot.w};
+    Vec3 offset;
+    vec3_sub(&pos, &mesh_pos, &offset);
+    query->pos = quat_rotate(&inverse_rot, offset);
+    quat_multiply(&inverse_rot, &rot, &query->rot);
+    query->count = 0;
+    for (int i = 0; i < 8; ++i) query->has_deepest[i] = false;
+}
+
+static void mesh_query_add(MeshQuery* query, const ShapeContact* contact) {
+    if (query->count < MESH_MAX_CONTACTS) {
+        query->contacts[query->count++] = *contact;
+        return;
+    }
+    // Full: a deeper contact takes the place of the shallowest
+    int shallowest = 0;
+    for (int i = 1; i < MESH_MAX_CONTACTS; ++i) {
+        if (query->contacts[i].depth < query->contacts[shallowest].depth) shallowest = i;
+    }
+    if (contact->depth > query->contacts[shallowest].depth) query->contacts[shallowest] = *contact;
+}
+
+/**
+ * Keeps one contact per point of the shape, e.g. per box corner. On a flat stretch of mesh, the
+ * triangles next to the one under a point also reach it, through their edges, with tilted normals
+ * and shifted points. Friction at those points would brake a rolling sphere.
+ */
+static void mesh_query_keep_deepest(MeshQuery* query, int point, const ShapeContact* contact) {
+    if (!query->has_deepest[point] || contact->depth > query->deepest[point].depth) {
+        query->deepest[point] = *contact;
+        query->has_deepest[point] = true;
+    }
+}
+
+/**
+ * Merges the contacts into a manifold and moves it back to world space. The mesh's own corners and
+ * edges only count where they reach further into the shape than the shape's points reach into the
+ * mesh, like a ridge under a box face: on flat ground they would just add points at the same depth
+ * that swap in and out of the manifold from step to step.
+ */
+static bool mesh_query_finish(MeshQuery* query, Vec3 mesh_pos, Quat mesh_rot, ContactManifold* manifold) {
+    float point_depth = -FLT_MAX;
+    for (int i = 0; i < 8; ++i) {
+        if (query->has_deepest[i] && query->deepest[i].depth > point_depth) point_depth = query->deepest[i].depth;
+    }
+    int kept = 0;
+    for (int i = 0; i < query->count; ++i) {
+        if (query->contacts[i].depth > point_depth + MESH_FEATURE_MARGIN) query->contacts[kept++] = query->contacts[i];
+    }
+    query->count = kept;
+    for (int i = 0; i < 8; ++i) {
+        if (query->has_deepest[i]) mesh_query_add(query, &query->deepest[i]);
+    }
+    if (!finish_manifold(query->contacts, query->count, manifold)) return false;
+    manifold->normal = quat_rotate(&mesh_rot, manifold->normal);
+    for (int i = 0; i < manifold->point_count; ++i) {
+        Vec3 point = quat_rotate(&mesh_rot, manifold->points[i].point);
+        vec3_add(&point, &mesh_pos, &manifold->points[i].point);
+    }
+    return true;
+}
+
+// Contact of a sphere with a two-sided triangle. The normal points from the sphere to the triangle.
+static bool sphere_triangle_contact(Vec3 center, float radius, const Vec3 corners[3], uint32_t feature_id, ShapeContact* out) {
+    Vec3 normal;
+    float dist = triangle_distance(corners, center, &normal);
+    if (dist >= radius) return false;
+    vec3_negate(&normal, &out->normal);
+    out->depth = radius - dist;
+    out->point = vec3_add_scaled(center, normal, -0.5f * (dist + radius));
+    out->feature_id = feature_id;
+    return true;
+}
+
+static void visit_sphere(void* context, uint32_t triangle, const Vec3 corners[3]) {
+    MeshQuery* query = (MeshQuery*)context;
+    (void)triangle;
+    ShapeContact contact;
+    if (sphere_triangle_contact(query->pos, query->radius, corners, 0, &contact)) mesh_query_keep_deepest(query, 0, &contact);
+}
+
+static void visit_capsule(void* context, uint32_t triangle, const Vec3 corners[3]) {
+    MeshQuery* query = (MeshQuery*)context;
+    (void)triangle;
+    // Spheres along the segment: its two ends, and its closest points to each triangle edge, which
+    // all share the third contact as they stand in for the segment's middle
+    Vec3 centers[5] = {query->p0, query->p1};
+    for (int k = 0; k < 3; ++k) {
+        float s, t;
+        closest_segment_params(query->p0, query->p1, corners[k], corners[(k + 1) % 3], &s, &t);
+        centers[2 + k] = segment_point(query->p0, query->p1, s);
+    }
+    for (uint32_t i = 0; i < 5; ++i) {
+        uint32_t point = i < 2 ? i : 2;
+        ShapeContact contact;
+        if (sphere_triangle_contact(centers[i], query->radius, corners, point, &contact)) {
+            mesh_query_keep_deepest(query, (int)point, &contact);
+        }
+    }
+}
+
+static bool point_in_triangle(Vec3 p, const Vec3 corners[3], Vec3 face_normal) {
+    for (int k = 0; k < 3; ++k) {
+        Vec3 edge, offset, cross;
+        vec3_sub(&corners[(k + 1) % 3], &corners[k], &edge);
+        vec3_sub(&p, &corners[k], &offset);
+        vec3_cross(&edge, &offset, &cross);
+        if (vec3_dot(&cross, &face_normal) < 0.0f) return false;
+    }
+    return true;
+}
+
+/**
+ * Contacts of a box or cylinder with a two-sided triangle: the shape's corners (box) or rim
+ * points (cylinder) behind the triangle's face, seen from the shape's center, then the triangle's
+ * corners and its edges' points closest to the center that are inside the shape.
+ */
+static void visit_convex_shape(void* context, uint32_t triangle, const Vec3 corners[3]) {
+    MeshQuery* query = (MeshQuery*)context;
+    Vec3 e0, e1, face_normal;
+    vec3_sub(&corners[1], &corners[0], &e0);
+    vec3_sub(&corners[2], &corners[0], &e1);
+    vec3_cross(&e0, &e1, &face_normal);
+    float area = vec3_length(&face_normal);
+    if (area < 1e-12f) return;
+    vec3_scale(&face_normal, 1.0f / area, &face_normal);
+
+    // Towards the shape's center, so thin two-sided meshes push shapes back out the side they came from
+    Vec3 out = face_normal, offset;
+    vec3_sub(&query->pos, &corners[0], &offset);
+    if (vec3_dot(&offset, &out) < 0.0f) vec3_negate(&out, &out);
+
+    Vec3 rim[8];
+    const Vec3* points = query->corners;
+    if (query->shape.is_cylinder) {
+        Vec3 down;
+        vec3_negate(&out, &down);
+        cylinder_rim_points(query->pos, local_up_axis(query->rot), query->shape.radius, query->shape.half_height, down, rim);
+        points = rim;
+    }
+    for (uint32_t i = 0; i < 8; ++i) {
+        vec3_sub(&points[i], &corners[0], &offset);
+        float dist = vec3_dot(&offset, &out);
+        if (dist >= 0.0f) continue;
+        Vec3 projected = vec3_add_scaled(points[i], out, -dist);
+        if (!point_in_triangle(projected, corners, face_normal)) continue;
+        ShapeContact contact;
+        vec3_negate(&out, &contact.normal);
+        contact.depth = -dist;
+        contact.point = vec3_add_scaled(points[i], out, -0.5f * dist);
+        contact.feature_id = i;
+        mesh_query_keep_deepest(query, (int)i, &contact);
+    }
+
+    Vec3 inner[6] = {corners[0], corners[1], corners[2]};
+    for (int k = 0; k < 3; ++k) {
+        // The point of each edge closest to the center stands in for the edge
+        float t = segment_param(corners[k], corners[(k + 1) % 3], query->pos);
+        inner[3 + k] = segment_point(corners[k], corners[(k + 1) % 3], t);
+    }
+    for (uint32_t i = 0; i < 6; ++i) {
+        Vec3 normal;
+        float dist = shape_surface_distance(&query->shape, inner[i], &normal);
+        if (dist >= 0.0f) continue;
+        ShapeContact contact;
+        contact.normal = normal;
+        contact.depth = -dist;
+        contact.point = vec3_add_scaled(inner[i], normal, -0.5f * dist);
+        contact.feature_id = 8 + triangle * 8 + i;
+        mesh_query_add(query, &contact);
+    }
+}
+
+/**
+ * Contacts of a convex hull with a two-sided triangle. GJK/EPA against the triangle, taken as a hull
+ * of three points, finds the normal and the deepest point. When that normal is the triangle's, the
+ * hull rests on the face, so its points behind the face, seen from its center, become contacts too.
+ */
+static void visit_convex_hull(void* context, uint32_t triangle, const Vec3 corners[3]) {
+    MeshQuery* query = (MeshQuery*)context;
+    ConvexShapeData triangle_data = {0.0f, 0.0f, {0, 0, 0}, corners, 3};
+    ConvexObject triangle_object = {support_convex_hull, &triangle_data, {0, 0, 0}, {0, 0, 0, 1}};
+    ConvexPairCache cache = {0};
+    ContactManifold deepest;
+    if (!test_convex_vs_convex(&query->hull, &triangle_object, &cache, &deepest)) return;
+
+    ShapeContact contact;
+    contact.normal = deepest.normal;
+    contact.depth = deepest.points[0].depth;
+    contact.point = deepest.points[0].point;
+    contact.feature_id = 8 + triangle * 8;
+    mesh_query_add(query, &contact);
+
+    Vec3 e0, e1, face_normal;
+    vec3_sub(&corners[1], &corners[0], &e0);
+    vec3_sub(&corners[2], &corners[0], &e1);
+    vec3_cross(&e0, &e1, &face_normal);
+    float area = vec3_length(&face_normal);
+    if (area < 1e-12f) return;
+    vec3_scale(&face_normal, 1.0f / area, &face_normal);
+    if (fabsf(vec3_dot(&face_normal, &deepest.normal)) < ROUND_NORMAL_AGREEMENT) return;
+
+    Vec3 out = face_normal, offset;
+    vec3_sub(&query->pos, &corners[0], &offset);
+    if (vec3_dot(&offset, &out) < 0.0f) vec3_negate(&out, &out);
+    for (size_t i = 0; i < query->hull_data.vertex_count; ++i) {
+        Vec3 point = quat_rotate(&query->rot, query->hull_data.vertices[i]);
+        vec3_add(&point, &query->pos, &point);
+        vec3_sub(&point, &corners[0], &offset);
+        float dist = vec3_dot(&offset, &out);
+        if (dist >= 0.0f) continue;
+        Vec3 projected = vec3_add_scaled(point, out, -dist);
+        if (!point_in_triangle(projected, corners, face_normal)) continue;
+        vec3_negate(&out, &contact.normal);
+        contact.depth = -dist;
+        contact.point = vec3_add_scaled(point, out, -0.5f * dist);
+        // Hull points keep their ids across triangles, apart from the triangles' own features
+        contact.feature_id = 0x80000000u | (uint32_t)i;
+        mesh_query_add(query, &contact);
+    }
+}
+
+// Bounds of a sphere around 'center' grown by 'radius', in the mesh's frame
+static AABB sphere_bounds(Vec3 center, float radius) {
+    AABB bounds = {{center.x - radius, center.y - radius, center.z - radius},
+                   {center.x + radius, center.y + radius, center.z + radius}};
+    return bounds;
+}
+
+bool test_sphere_vs_mesh(Vec3 sphere_pos, float sphere_radius, Vec3 mesh_pos, Quat mesh_rot, const MeshShape* mesh,
+                         ContactManifold* manifold) {
+    MeshQuery query;
+    Quat identity = {0, 0, 0, 1};
+    mesh_query_init(&query, sphere_pos, identity, mesh_pos, mesh_rot);
+    query.radius = sphere_radius;
+    AABB bounds = sphere_bounds(query.pos, sphere_radius);
+    mesh_query(mesh, &bounds, visit_sphere, &query);
+    return mesh_query_finish(&query, mesh_pos, mesh_rot, manifold);
+}
+
+bool test_box_vs_mesh(Vec3 box_pos, Quat box_rot, Vec3 box_extents, Vec3 mesh_pos, Quat mesh_rot, const MeshShape* mesh,
+                      ContactManifold* manifold) {
+    MeshQuery query;
+    mesh_query_init(&query, box_pos, box_rot, mesh_pos, mesh_rot);
+    ConvexShape box = {query.pos, query.rot, false, box_extents, 0.0f, 0.0f};
+    query.shape = box;
+    AABB bounds = {query.pos, query.pos};
+    for (uint32_t corner = 0; corner < 8; ++corner) {
+        Vec3 local = {corner & 1 ? box_extents.x : -box_extents.x,
+                      corner & 2 ? box_extents.y : -box_extents.y,
+                      corner & 4 ? box_extents.z : -box_extents.z};
+        Vec3 point = quat_rotate(&query.rot, local);
+        vec3_add(&point, &query.pos, &query.corners[corner]);
+        aabb_grow(&bounds, query.corners[corner]);
+    }
+    mesh_query(mesh, &bounds, visit_convex_shape, &query);
+    return mesh_query_finish(&query, mesh_pos, mesh_rot, manifold);
+}
+
+bool test_cylinder_vs_mesh(Vec3 cyl_pos, Quat cyl_rot, float cyl_radius, float cyl_half_height, Vec3 mesh_pos,
+                           Quat mesh_rot, const MeshShape* mesh, ContactManifold* manifold) {
+    MeshQuery query;
+    mesh_query_init(&query, cyl_pos, cyl_rot, mesh_pos, mesh_rot);
+    ConvexShape cylinder = {query.pos, query.rot, true, {0, 0, 0}, cyl_radius, cyl_half_height};
+    query.shape = cylinder;
+    // The sphere around the cylinder is loose, but needs no rotation
+    AABB bounds = sphere_bounds(query.pos, sqrtf(cyl_radius * cyl_radius + cyl_half_height * cyl_half_height));
+    mesh_query(mesh, &bounds, visit_convex_shape, &query);
+    return mesh_query_finish(&query, mesh_pos, mesh_rot, manifold);
+}
+
+bool test_convex_hull_vs_mesh(Vec3 hull_pos, Quat hull_rot, const Vec3* vertices, size_t vertex_count, Vec3 mesh_pos,
+                              Quat mesh_rot, const MeshShape* mesh, ContactManifold* manifold) {
+    if (vertex_count == 0) return false;
+    MeshQuery query;
+    mesh_query_init(&query, hull_pos, hull_rot, mesh_pos, mesh_rot);
+    ConvexShapeData hull_data = {0.0f, 0.0f, {0, 0, 0}, vertices, vertex_count};
+    query.hull_data = hull_data;
+    ConvexObject hull = {support_convex_hull, &query.hull_data, query.pos, query.rot};
+    query.hull = hull;
+    AABB bounds = {query.pos, query.pos};
+    for (size_t i = 0; i < vertex_count; ++i) {
+        Vec3 point = quat_rotate(&query.rot, vertices[i]);
+        vec3_add(&point, &query.pos, &point);
+        aabb_grow(&bounds, point);
+    }
+    mesh_query(mesh, &bounds, visit_convex_hull, &query);
+    return mesh_query_finish(&query, mesh_pos, mesh_rot, manifold);
+}
+
+bool test_capsule_vs_mesh(Vec3 cap_pos, Quat cap_rot, float cap_radius, float cap_half_height, Vec3 mesh_pos,
+                          Quat mesh_rot, const MeshShape* mesh, ContactManifold* manifold) {
+    MeshQuery query;
+    mesh_query_init(&query, cap_pos, cap_rot, mesh_pos, mesh_rot);
+    query.radius = cap_radius;
+    capsule_segment(query.pos, query.rot, cap_half_height, &query.p0, &query.p1);
+    AABB bounds = sphere_bounds(query.p0, cap_radius);
+    AABB end_bounds = sphere_bounds(query.p1, cap_radius);
+    aabb_grow(&bounds, end_bounds.min);
+    aabb_grow(&bounds, end_bounds.max);
+    mesh_query(mesh, &bounds, visit_capsule, &query);
+    return mesh_query_finish(&query, mesh_pos, mesh_rot, manifold);
+}
+
+// A sweep through a mesh: the earliest hit over the triangles near the swept sphere
+typedef struct {
+    Vec3 start, motion;
+    float radius;
+    SweepHit hit;
+    bool found;
+} MeshSweep;
+
+static void visit_sweep(void* context, uint32_t triangle, const Vec3 corners[3]) {
+    (void)triangle;
+    MeshSweep* sweep = (MeshSweep*)context;
+    SweepHit candidate;
+    if (!sweep_to_surface(triangle_distance, corners, sweep->start, sweep->motion, sweep->radius, &candidate)) return;
+    if (sweep->found) {
+        // Near a shared edge both triangles are reached at the same time, within the tolerance. The
+        // one hit face on has the true normal; the other's points at its edge and is tilted.
+        float lead = (sweep->hit.toi - candidate.toi) * vec3_length(&sweep->motion);
+        if (lead < -SWEEP_TOLERANCE) return;
+        if (lead <= SWEEP_TOLERANCE &&
+            vec3_dot(&candidate.normal, &sweep->motion) >= vec3_dot(&sweep->hit.normal, &sweep->motion)) {
+            return;
+        }
+    }
+    sweep->hit = candidate;
+    sweep->found = true;
+}
+
+bool sweep_sphere_vs_mesh(Vec3 start, Vec3 motion, float radius, Vec3 mesh_pos, Quat mesh_rot, const MeshShape* mesh,
+                          SweepHit* hit) {
+    // Sweep in the mesh's frame, so the triangles need not be transformed
+    MeshQuery frame;
+    Quat identity = {0, 0, 0, 1};
+    mesh_query_init(&frame, start, identity, mesh_pos, mesh_rot);
+    Quat inverse_rot = {-mesh_rot.x, -mesh_rot.y, -mesh_rot.z, mesh_rot.w};
+    MeshSweep sweep = {frame.pos, quat_rotate(&inverse_rot, motion), radius, {0.0f, {0, 0, 0}, {0, 0, 0}}, false};
+
+    Vec3 end;
+    vec3_add(&sweep.start, &sweep.motion, &end);
+    AABB bounds = sphere_bounds(sweep.start, radius);
+    AABB end_bounds = sphere_bounds(end, radius);
+    aabb_grow(&bounds, end_bounds.min);
+    aabb_grow(&bounds, end_bounds.max);
+    mesh_query(mesh, &bounds, visit_sweep, &sweep);
+    if (!sweep.found) return false;
+
+    *hit = sweep.hit;
+    hit->normal = quat_rotate(&mesh_rot, hit->normal);
+    hit->point = quat_rotate(&mesh_rot, hit->point);
+    vec3_add(&hit->point, &mesh_pos, &hit->point);
+    return true;
+}
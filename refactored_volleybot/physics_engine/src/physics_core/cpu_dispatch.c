@@ -0,0 +1,148 @@
+#include "physics_core/cpu_dispatch.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+extern const PhysicsKernels physics_kernels_scalar;
+#if defined(PHYSICS_DISPATCH_X86)
+extern const PhysicsKernels physics_kernels_sse4;
+extern const PhysicsKernels physics_kernels_avx2;
+extern const PhysicsKernels physics_kernels_avx512;
+#endif
+
+static SimdLevel active_level = SIMD_LEVEL_SCALAR;
+static const PhysicsKernels* active_kernels = NULL;
+
+#if defined(PHYSICS_DISPATCH_X86) && defined(_MSC_VER)
+// MSVC has no __builtin_cpu_supports, so read CPUID and check that the OS saves the wide registers
+static SimdLevel detect_x86_level(void) {
+    int info[4];
+    __cpuid(info, 1);
+    int has_sse4 = (info[2] & (1 << 19)) != 0;
+    int has_fma = (info[2] & (1 << 12)) != 0;
+    int has_osxsave = (info[2] & (1 << 27)) != 0;
+    if (!has_sse4) return SIMD_LEVEL_SCALAR;
+    if (!has_osxsave) return SIMD_LEVEL_SSE4;
+
+    unsigned long long xcr0 = _xgetbv(0);
+    int os_avx = (xcr0 & 0x6) == 0x6;      // XMM and YMM state
+    int os_avx512 = (xcr0 & 0xE6) == 0xE6; // Plus opmask and ZMM state
+
+    __cpuidex(info, 7, 0);
+    int has_avx2 = (info[1] & (1 << 5)) != 0;
+    int has_avx512 = (info[1] & (1 << 16)) && (info[1] & (1 << 17)) && (info[1] & (1 << 31)); // F, DQ, VL
+
+    if (os_avx512 && has_avx512 && has_avx2 && has_fma) return SIMD_LEVEL_AVX512;
+    if (os_avx && has_avx2 && has_fma) return SIMD_LEVEL_AVX2;
+    return SIMD_LEVEL_SSE4;
+}
+#elif defined(PHYSICS_DISPATCH_X86)
+static SimdLevel detect_x86_level(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+        __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("fma")) {
+        return SIMD_LEVEL_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SIMD_LEVEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SIMD_LEVEL_SSE4;
+    }
+    return SIMD_LEVEL_SCALAR;
+}
+#endif
+
+SimdLevel simd_detect_level(void) {
+#if defined(PHYSICS_DISPATCH_X86)
+    return detect_x86_level();
+#else
+    return SIMD_LEVEL_SCALAR;
+#endif
+}
+
+const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SIMD_LEVEL_SSE4: return "sse4";
+        case SIMD_LEVEL_AVX2: return "avx2";
+        case SIMD_LEVEL_AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
+
+SimdLevel simd_set_level(SimdLevel level) {
+    SimdLevel supported = simd_detect_level();
+    if (level > supported) level = supported;
+    if (level < SIMD_LEVEL_SCALAR) level = SIMD_LEVEL_SCALAR;
+
+    switch (level) {
+#if defined(PHYSICS_DISPATCH_X86)
+        case SIMD_LEVEL_AVX512: active_kernels = &physics_kernels_avx512; break;
+        case SIMD_LEVEL_AVX2: active_kernels = &physics_kernels_avx2; break;
+        case SIMD_LEVEL_SSE4: active_kernels = &physics_kernels_sse4; break;
+#endif
+        default: active_kernels = &physics_kernels_scalar; level = SIMD_LEVEL_SCALAR; break;
+    }
+    active_level = level;
+    return level;
+}
+
+// Picks the best level, unless VOLLEYBOT_SIMD_LEVEL asks for a specific one
+static void select_default_level(void) {
+    SimdLevel level = simd_detect_level();
+    const char* forced = getenv("VOLLEYBOT_SIMD_LEVEL");
+    if (forced) {
+        for (int candidate = SIMD_LEVEL_SCALAR; candidate <= SIMD_LEVEL_AVX512; ++candidate) {
+            if (strcmp(forced, simd_level_name((SimdLevel)candidate)) == 0) {
+                level = (SimdLevel)candidate;
+            }
+        }
+    }
+    simd_set_level(level);
+}
+
+#if defined(__GNUC__)
+// Select the kernels while the library loads, before any thread can step a scene
+__attribute__((constructor)) static void init_kernels_on_load(void) {
+    select_default_level();
+}
+#endif
+
+SimdLevel simd_get_level(void) {
+    physics_kernels();
+    return active_level;
+}
+
+const PhysicsKernels* physics_kernels(void) {
+    // Compilers without load-time constructors select on first use instead
+    if (!active_kernels) {
+        select_default_level();
+    }
+    return active_kernels;
+}
+
+/* --- Dispatching entry points of the batch kernels --- */
+
+void test_spheres_vs_spheres(const Vec3* centers_a, const float* radii_a, const Vec3* centers_b,
+                             const float* radii_b, size_t count, CollisionInfo* results) {
+    physics_kernels()->test_spheres_vs_spheres(centers_a, radii_a, centers_b, radii_b, count, results);
+}
+
+void test_spheres_vs_boxes(const Vec3* sphere_centers, const float* radii, const Vec3* box_centers,
+                           const Quat* box_orientations, const Vec3* box_extents, size_t count, CollisionInfo* results) {
+    physics_kernels()->test_spheres_vs_boxes(sphere_centers, radii, box_centers, box_orientations, box_extents, count, results);
+}
+
+void solve_contacts(SolverContact* contacts, size_t count, Vec3* velocities, Vec3* angular_velocities,
+                    const float* inverse_masses) {
+    physics_kernels()->solve_contacts(contacts, count, velocities, angular_velocities, inverse_masses);
+}
+
+void solve_contact_positions(SolverContact* contacts, size_t count, Vec3* correction_velocities,
+                             Vec3* correction_angular_velocities, const float* inverse_masses) {
+    physics_kernels()->solve_contact_positions(contacts, count, correction_velocities, correction_angular_velocities,
+                                               inverse_masses);
+}
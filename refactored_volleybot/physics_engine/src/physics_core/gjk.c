@@ -0,0 +1,676 @@
+#include "physics_core/gjk.h"
+#include <math.h>
+#include <string.h>
+
+#define GJK_MAX_ITERATIONS 32
+#define EPA_MAX_ITERATIONS 64
+#define EPA_MAX_VERTICES 64
+#define EPA_MAX_FACES 128
+#define EPA_MAX_EDGES 64
+// EPA stops once a new support point gets the closest face less than this much further out
+#define EPA_TOLERANCE 1e-4f
+// Persistent points that separate or slide apart by more than this are dropped
+#define CONTACT_BREAKING_DISTANCE 0.02f
+// A normal that turns further than about 18 degrees in one step starts the manifold over
+#define NORMAL_AGREEMENT 0.95f
+
+/* --- Support functions --- */
+
+Vec3 support_sphere(const void* shape, Vec3 direction) {
+    const ConvexShapeData* data = (const ConvexShapeData*)shape;
+    float length = vec3_length(&direction);
+    Vec3 result = {0, 0, 0};
+    if (length > 0.0f) vec3_scale(&direction, data->radius / length, &result);
+    return result;
+}
+
+Vec3 support_box(const void* shape, Vec3 direction) {
+    const ConvexShapeData* data = (const ConvexShapeData*)shape;
+    Vec3 result = {direction.x < 0.0f ? -data->extents.x : data->extents.x,
+                   direction.y < 0.0f ? -data->extents.y : data->extents.y,
+                   direction.z < 0.0f ? -data->extents.z : data->extents.z};
+    return result;
+}
+
+Vec3 support_capsule(const void* shape, Vec3 direction) {
+    const ConvexShapeData* data = (const ConvexShapeData*)shape;
+    Vec3 result = support_sphere(shape, direction);
+    result.y += direction.y < 0.0f ? -data->half_height : data->half_height;
+    return result;
+}
+
+Vec3 support_cylinder(const void* shape, Vec3 direction) {
+    const ConvexShapeData* data = (const ConvexShapeData*)shape;
+    float radial = sqrtf(direction.x * direction.x + direction.z * direction.z);
+    Vec3 result = {0, direction.y < 0.0f ? -data->half_height : data->half_height, 0};
+    if (radial > 0.0f) {
+        result.x = direction.x * data->radius / radial;
+        result.z = direction.z * data->radius / radial;
+    }
+    return result;
+}
+
+Vec3 support_convex_hull(const void* shape, Vec3 direction) {
+    const ConvexShapeData* data = (const ConvexShapeData*)shape;
+    Vec3 result = {0, 0, 0};
+    float best = -INFINITY;
+    for (size_t i = 0; i < data->vertex_count; ++i) {
+        float along = vec3_dot(&data->vertices[i], &direction);
+        if (along > best) {
+            best = along;
+            result = data->vertices[i];
+        }
+    }
+    return result;
+}
+
+/* --- Shared helpers --- */
+
+// A point of the Minkowski difference A - B, with the points of A and B it came from
+typedef struct {
+    Vec3 w;
+    Vec3 a, b;             // World space
+    Vec3 local_a, local_b; // Each object's local frame, for the cache
+} SimplexVertex;
+
+typedef struct {
+    SimplexVertex vertices[4];
+    float weights[4];      // Barycentric weights of the point closest to the origin
+    int count;
+} Simplex;
+
+static Vec3 to_world(const ConvexObject* object, Vec3 local) {
+    Vec3 world = quat_rotate(&object->orientation, local);
+    vec3_add(&world, &object->position, &world);
+    return world;
+}
+
+static Vec3 to_local(const ConvexObject* object, Vec3 world) {
+    Quat inverse = {-object->orientation.x, -object->orientation.y, -object->orientation.z, object->orientation.w};
+    Vec3 offset;
+    vec3_sub(&world, &object->position, &offset);
+    return quat_rotate(&inverse, offset);
+}
+
+static void make_vertex(const ConvexObject* a, const ConvexObject* b, Vec3 local_a, Vec3 local_b, SimplexVertex* out) {
+    out->local_a = local_a;
+    out->local_b = local_b;
+    out->a = to_world(a, local_a);
+    out->b = to_world(b, local_b);
+    vec3_sub(&out->a, &out->b, &out->w);
+}
+
+// The point of A - B furthest along a world direction
+static void support_vertex(const ConvexObject* a, const ConvexObject* b, Vec3 direction, SimplexVertex* out) {
+    Quat inverse_a = {-a->orientation.x, -a->orientation.y, -a->orientation.z, a->orientation.w};
+    Quat inverse_b = {-b->orientation.x, -b->orientation.y, -b->orientation.z, b->orientation.w};
+    Vec3 opposite;
+    vec3_negate(&direction, &opposite);
+    Vec3 local_a = a->support(a->shape, quat_rotate(&inverse_a, direction));
+    Vec3 local_b = b->support(b->shape, quat_rotate(&inverse_b, opposite));
+    make_vertex(a, b, local_a, local_b, out);
+}
+
+static Vec3 add_scaled(Vec3 v, Vec3 direction, float s) {
+    Vec3 result = {v.x + direction.x * s, v.y + direction.y * s, v.z + direction.z * s};
+    return result;
+}
+
+static Vec3 triangle_normal(Vec3 a, Vec3 b, Vec3 c) {
+    Vec3 ab, ac, normal;
+    vec3_sub(&b, &a, &ab);
+    vec3_sub(&c, &a, &ac);
+    vec3_cross(&ab, &ac, &normal);
+    return normal;
+}
+
+/* --- GJK --- */
+
+// Keeps the listed vertices of the simplex, in order, with their weights
+static void keep_vertices(Simplex* simplex, int count, const int* indices, const float* weights) {
+    SimplexVertex kept[4];
+    for (int i = 0; i < count; ++i) kept[i] = simplex->vertices[indices[i]];
+    for (int i = 0; i < count; ++i) {
+        simplex->vertices[i] = kept[i];
+        simplex->weights[i] = weights[i];
+    }
+    simplex->count = count;
+}
+
+// Reduces the segment of the first two vertices to the feature closest to the origin
+static void solve_segment(Simplex* simplex) {
+    Vec3 a = simplex->vertices[0].w, ab, ao;
+    vec3_sub(&simplex->vertices[1].w, &a, &ab);
+    vec3_negate(&a, &ao);
+    float length_sq = vec3_length_sq(&ab);
+    float t = length_sq > 0.0f ? vec3_dot(&ao, &ab) / length_sq : 0.0f;
+    if (t <= 0.0f) {
+        float w[1] = {1.0f};
+        keep_vertices(simplex, 1, (int[]){0}, w);
+    } else if (t >= 1.0f) {
+        float w[1] = {1.0f};
+        keep_vertices(simplex, 1, (int[]){1}, w);
+    } else {
+        simplex->weights[0] = 1.0f - t;
+        simplex->weights[1] = t;
+        simplex->count = 2;
+    }
+}
+
+// Reduces a triangle to the feature closest to the origin (Ericson, Real-Time Collision Detection, 5.1.5)
+static void solve_triangle(Simplex* simplex, const int* ids) {
+    Vec3 a = simplex->vertices[ids[0]].w, b = simplex->vertices[ids[1]].w, c = simplex->vertices[ids[2]].w;
+    Vec3 ab, ac, ap, bp, cp;
+    vec3_sub(&b, &a, &ab);
+    vec3_sub(&c, &a, &ac);
+    vec3_negate(&a, &ap);
+    vec3_negate(&b, &bp);
+    vec3_negate(&c, &cp);
+
+    float d1 = vec3_dot(&ab, &ap), d2 = vec3_dot(&ac, &ap);
+    if (d1 <= 0.0f && d2 <= 0.0f) {
+        float w[1] = {1.0f};
+        keep_vertices(simplex, 1, (int[]){ids[0]}, w);
+        return;
+    }
+    float d3 = vec3_dot(&ab, &bp), d4 = vec3_dot(&ac, &bp);
+    if (d3 >= 0.0f && d4 <= d3) {
+        float w[1] = {1.0f};
+        keep_vertices(simplex, 1, (int[]){ids[1]}, w);
+        return;
+    }
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+        float t = d1 / (d1 - d3);
+        float w[2] = {1.0f - t, t};
+        keep_vertices(simplex, 2, (int[]){ids[0], ids[1]}, w);
+        return;
+    }
+    float d5 = vec3_dot(&ab, &cp), d6 = vec3_dot(&ac, &cp);
+    if (d6 >= 0.0f && d5 <= d6) {
+        float w[1] = {1.0f};
+        keep_vertices(simplex, 1, (int[]){ids[2]}, w);
+        return;
+    }
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+        float t = d2 / (d2 - d6);
+        float w[2] = {1.0f - t, t};
+        keep_vertices(simplex, 2, (int[]){ids[0], ids[2]}, w);
+        return;
+    }
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+        float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        float w[2] = {1.0f - t, t};
+        keep_vertices(simplex, 2, (int[]){ids[1], ids[2]}, w);
+        return;
+    }
+    if (va + vb + vc <= 1e-20f) {
+        // A degenerate triangle: fall back to its first edge
+        float w[2] = {1.0f, 0.0f};
+        keep_vertices(simplex, 2, ids, w);
+        solve_segment(simplex);
+        return;
+    }
+    float denominator = 1.0f / (va + vb + vc);
+    float v = vb * denominator, u = vc * denominator;
+    float w[3] = {1.0f - v - u, v, u};
+    keep_vertices(simplex, 3, ids, w);
+}
+
+static Vec3 closest_point(const Simplex* simplex) {
+    Vec3 point = {0, 0, 0};
+    for (int i = 0; i < simplex->count; ++i) {
+        point = add_scaled(point, simplex->vertices[i].w, simplex->weights[i]);
+    }
+    return point;
+}
+
+/**
+ * Reduces the simplex to the smallest one containing its point closest to the origin.
+ * @return False if the tetrahedron contains the origin.
+ */
+static bool solve_simplex(Simplex* simplex) {
+    if (simplex->count == 1) {
+        simplex->weights[0] = 1.0f;
+    } else if (simplex->count == 2) {
+        solve_segment(simplex);
+    } else if (simplex->count == 3) {
+        solve_triangle(simplex, (int[]){0, 1, 2});
+    } else {
+        // A flat tetrahedron cannot contain the origin, so it is solved as its first face
+        Vec3 base = triangle_normal(simplex->vertices[0].w, simplex->vertices[1].w, simplex->vertices[2].w), apex;
+        vec3_sub(&simplex->vertices[3].w, &simplex->vertices[0].w, &apex);
+        if (fabsf(vec3_dot(&base, &apex)) <= 1e-6f * vec3_length(&base) * vec3_length(&apex)) {
+            solve_triangle(simplex, (int[]){0, 1, 2});
+            return true;
+        }
+
+        // The origin is outside a face if it lies across that face's plane from the fourth vertex
+        static const int faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+        Simplex best = *simplex;
+        float best_dist_sq = INFINITY;
+        for (int f = 0; f < 4; ++f) {
+            Vec3 a = simplex->vertices[faces[f][0]].w, opposite;
+            Vec3 normal = triangle_normal(a, simplex->vertices[faces[f][1]].w, simplex->vertices[faces[f][2]].w);
+            vec3_sub(&simplex->vertices[faces[f][3]].w, &a, &opposite);
+            float origin_side = -vec3_dot(&a, &normal);
+            float opposite_side = vec3_dot(&opposite, &normal);
+            if (origin_side * opposite_side >= 0.0f) continue;
+
+            Simplex candidate = *simplex;
+            solve_triangle(&candidate, faces[f]);
+            Vec3 point = closest_point(&candidate);
+            float dist_sq = vec3_length_sq(&point);
+            if (dist_sq < best_dist_sq) {
+                best_dist_sq = dist_sq;
+                best = candidate;
+            }
+        }
+        if (best_dist_sq == INFINITY) return false;
+        *simplex = best;
+    }
+    return true;
+}
+
+// Runs GJK from the cached simplex. Leaves the final simplex in 'simplex'.
+static void run_gjk(const ConvexObject* a, const ConvexObject* b, const GjkCache* cache, Simplex* simplex, GjkResult* result) {
+    simplex->count = 0;
+    for (int i = 0; i < cache->count && i < 4; ++i) {
+        make_vertex(a, b, cache->local_a[i], cache->local_b[i], &simplex->vertices[simplex->count++]);
+    }
+    if (simplex->count == 0) {
+        Vec3 direction;
+        vec3_sub(&b->position, &a->position, &direction);
+        if (vec3_length_sq(&direction) < 1e-12f) vec3_set(&direction, 1, 0, 0);
+        support_vertex(a, b, direction, &simplex->vertices[simplex->count++]);
+    }
+
+    result->overlapping = false;
+    result->iterations = 0;
+    while (true) {
+        if (!solve_simplex(simplex)) {
+            result->overlapping = true;
+            break;
+        }
+        Vec3 v = closest_point(simplex);
+        float dist_sq = vec3_length_sq(&v);
+        if (dist_sq < 1e-12f) {
+            result->overlapping = true;
+            break;
+        }
+        if (result->iterations++ >= GJK_MAX_ITERATIONS) break;
+
+        Vec3 direction;
+        vec3_negate(&v, &direction);
+        SimplexVertex next;
+        support_vertex(a, b, direction, &next);
+
+        // Stop when the new point gets no closer to the origin than the current one, or repeats a vertex
+        if (dist_sq - vec3_dot(&v, &next.w) <= 1e-6f * dist_sq) break;
+        bool repeated = false;
+        for (int i = 0; i < simplex->count; ++i) {
+            repeated |= vec3_dist_sq(&simplex->vertices[i].w, &next.w) < 1e-12f;
+        }
+        if (repeated) break;
+        simplex->vertices[simplex->count++] = next;
+    }
+
+    result->point_a = result->point_b = (Vec3){0, 0, 0};
+    for (int i = 0; i < simplex->count; ++i) {
+        result->point_a = add_scaled(result->point_a, simplex->vertices[i].a, simplex->weights[i]);
+        result->point_b = add_scaled(result->point_b, simplex->vertices[i].b, simplex->weights[i]);
+    }
+    result->distance = result->overlapping ? 0.0f : vec3_dist(&result->point_a, &result->point_b);
+}
+
+static void store_simplex(const Simplex* simplex, GjkCache* cache) {
+    cache->count = simplex->count;
+    for (int i = 0; i < simplex->count; ++i) {
+        cache->local_a[i] = simplex->vertices[i].local_a;
+        cache->local_b[i] = simplex->vertices[i].local_b;
+    }
+}
+
+bool gjk_distance(const ConvexObject* a, const ConvexObject* b, GjkCache* cache, GjkResult* result) {
+    Simplex simplex;
+    run_gjk(a, b, cache, &simplex, result);
+    store_simplex(&simplex, cache);
+    return result->overlapping;
+}
+
+bool sweep_sphere_vs_convex(Vec3 start, Vec3 motion, float radius, const ConvexObject* shape, SweepHit* hit) {
+    // The sphere's center as a point shape, so GJK gives its distance to the shape
+    ConvexShapeData point_data = {0};
+    ConvexObject point = {support_sphere, &point_data, start, {0, 0, 0, 1}};
+    GjkCache cache = {0};
+
+    // Conservative advancement as in the analytic sweeps of collision.c, with each step's simplex warm starting the next
+    float t = 0.0f;
+    for (int i = 0; i < GJK_MAX_ITERATIONS; ++i) {
+        Vec3 step;
+        vec3_scale(&motion, t, &step);
+        vec3_add(&start, &step, &point.position);
+        GjkResult result;
+        if (gjk_distance(&point, shape, &cache, &result) || result.distance < 1e-9f) {
+            // Only reachable at the start: the steps below stop short of the surface
+            return false;
+        }
+        Vec3 normal;
+        vec3_sub(&result.point_a, &result.point_b, &normal);
+        vec3_scale(&normal, 1.0f / result.distance, &normal);
+        float gap = result.distance - radius;
+        if (t == 0.0f && gap < 0.0f) return false;
+        float closing = -vec3_dot(&normal, &motion);
+        if (closing <= 0.0f) return false;
+        if (gap < EPA_TOLERANCE || i == GJK_MAX_ITERATIONS - 1) {
+            hit->toi = t;
+            hit->normal = normal;
+            hit->point = result.point_b;
+            return true;
+        }
+        t += gap / closing;
+        if (t > 1.0f) return false;
+    }
+    return false;
+}
+
+/* --- EPA --- */
+
+typedef struct {
+    int v[3];
+    Vec3 normal;   // Unit length, pointing out of the polytope
+    float dist;    // Distance of the face's plane from the origin
+} EpaFace;
+
+typedef struct {
+    SimplexVertex vertices[EPA_MAX_VERTICES];
+    int vertex_count;
+    EpaFace faces[EPA_MAX_FACES];
+    int face_count;
+} Polytope;
+
+static bool add_face(Polytope* polytope, int i0, int i1, int i2) {
+    if (polytope->face_count == EPA_MAX_FACES) return false;
+    EpaFace* face = &polytope->faces[polytope->face_count];
+    face->v[0] = i0;
+    face->v[1] = i1;
+    face->v[2] = i2;
+    Vec3 p0 = polytope->vertices[i0].w;
+    Vec3 normal = triangle_normal(p0, polytope->vertices[i1].w, polytope->vertices[i2].w);
+    float length = vec3_length(&normal);
+    if (length < 1e-12f) return true; // Degenerate; leave it out
+    vec3_scale(&normal, 1.0f / length, &face->normal);
+    face->dist = vec3_dot(&face->normal, &p0);
+    ++polytope->face_count;
+    return true;
+}
+
+// Grows a GJK simplex that ended at a point, segment or triangle into a tetrahedron
+static bool expand_to_tetrahedron(const ConvexObject* a, const ConvexObject* b, Simplex* simplex) {
+    static const Vec3 axes[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    if (simplex->count == 1) {
+        for (int i = 0; i < 6 && simplex->count == 1; ++i) {
+            support_vertex(a, b, axes[i], &simplex->vertices[1]);
+            if (vec3_dist_sq(&simplex->vertices[1].w, &simplex->vertices[0].w) > 1e-10f) simplex->count = 2;
+        }
+        if (simplex->count == 1) return false;
+    }
+    if (simplex->count == 2) {
+        Vec3 axis, side, other;
+        vec3_sub(&simplex->vertices[1].w, &simplex->vertices[0].w, &axis);
+        vec3_normalize(&axis, &axis);
+        vec3_set(&other, fabsf(axis.x) < 0.57f ? 1.0f : 0.0f, fabsf(axis.x) < 0.57f ? 0.0f : 1.0f, 0.0f);
+        vec3_cross(&axis, &other, &side);
+        vec3_normalize(&side, &side);
+        vec3_cross(&axis, &side, &other);
+        // Try directions around the segment until one leaves its line
+        for (int k = 0; k < 6 && simplex->count == 2; ++k) {
+            float angle = (float)k * 1.0471976f;
+            Vec3 direction = add_scaled(add_scaled((Vec3){0, 0, 0}, side, cosf(angle)), other, sinf(angle));
+            support_vertex(a, b, direction, &simplex->vertices[2]);
+            Vec3 offset, off_line;
+            vec3_sub(&simplex->vertices[2].w, &simplex->vertices[0].w, &offset);
+            vec3_cross(&offset, &axis, &off_line);
+            if (vec3_length_sq(&off_line) > 1e-10f) simplex->count = 3;
+        }
+        if (simplex->count == 2) return false;
+    }
+    if (simplex->count == 3) {
+        Vec3 normal = triangle_normal(simplex->vertices[0].w, simplex->vertices[1].w, simplex->vertices[2].w);
+        for (int side = 0; side < 2 && simplex->count == 3; ++side) {
+            Vec3 direction = normal;
+            if (side == 1) vec3_negate(&normal, &direction);
+            support_vertex(a, b, direction, &simplex->vertices[3]);
+            Vec3 offset;
+            vec3_sub(&simplex->vertices[3].w, &simplex->vertices[0].w, &offset);
+            if (fabsf(vec3_dot(&offset, &normal)) > 1e-10f) simplex->count = 4;
+        }
+        if (simplex->count == 3) return false;
+    }
+    return true;
+}
+
+// Adds the edge to the horizon, or removes it if its twin from a neighboring removed face is already there
+static bool toggle_edge(int (*edges)[2], int* edge_count, int from, int to) {
+    for (int i = 0; i < *edge_count; ++i) {
+        if (edges[i][0] == to && edges[i][1] == from) {
+            edges[i][0] = edges[*edge_count - 1][0];
+            edges[i][1] = edges[*edge_count - 1][1];
+            --*edge_count;
+            return true;
+        }
+    }
+    if (*edge_count == EPA_MAX_EDGES) return false;
+    edges[*edge_count][0] = from;
+    edges[*edge_count][1] = to;
+    ++*edge_count;
+    return true;
+}
+
+/**
+ * Expands the tetrahedron around the origin toward the boundary of A - B. The closest face of
+ * the final polytope gives the normal and depth, and the origin's projection onto it the contact points.
+ */
+static bool run_epa(const ConvexObject* a, const ConvexObject* b, const Simplex* simplex, Vec3* normal, float* depth,
+                    Vec3* point_a, Vec3* point_b) {
+    Polytope polytope;
+    polytope.vertex_count = 4;
+    polytope.face_count = 0;
+    for (int i = 0; i < 4; ++i) polytope.vertices[i] = simplex->vertices[i];
+
+    // Orient the faces outward: vertex 3 must lie behind face (0, 1, 2)
+    Vec3 offset;
+    vec3_sub(&polytope.vertices[3].w, &polytope.vertices[0].w, &offset);
+    Vec3 base_normal = triangle_normal(polytope.vertices[0].w, polytope.vertices[1].w, polytope.vertices[2].w);
+    if (vec3_dot(&base_normal, &offset) > 0.0f) {
+        SimplexVertex swap = polytope.vertices[1];
+        polytope.vertices[1] = polytope.vertices[2];
+        polytope.vertices[2] = swap;
+    }
+    add_face(&polytope, 0, 1, 2);
+    add_face(&polytope, 0, 3, 1);
+    add_face(&polytope, 0, 2, 3);
+    add_face(&polytope, 1, 3, 2);
+    if (polytope.face_count < 4) return false;
+
+    int closest = 0;
+    for (int iteration = 0; iteration < EPA_MAX_ITERATIONS; ++iteration) {
+        closest = 0;
+        for (int f = 1; f < polytope.face_count; ++f) {
+            if (polytope.faces[f].dist < polytope.faces[closest].dist) closest = f;
+        }
+        EpaFace face = polytope.faces[closest];
+
+        SimplexVertex next;
+        support_vertex(a, b, face.normal, &next);
+        if (vec3_dot(&next.w, &face.normal) - face.dist < EPA_TOLERANCE) break;
+        if (polytope.vertex_count == EPA_MAX_VERTICES) break;
+
+        // Remove every face the new point sees, and close the hole with faces to the new point
+        int edges[EPA_MAX_EDGES][2];
+        int edge_count = 0;
+        bool overflow = false;
+        for (int f = polytope.face_count - 1; f >= 0; --f) {
+            EpaFace* candidate = &polytope.faces[f];
+            Vec3 to_point;
+            vec3_sub(&next.w, &polytope.vertices[candidate->v[0]].w, &to_point);
+            if (vec3_dot(&candidate->normal, &to_point) <= 0.0f) continue;
+            for (int e = 0; e < 3; ++e) {
+                overflow |= !toggle_edge(edges, &edge_count, candidate->v[e], candidate->v[(e + 1) % 3]);
+            }
+            polytope.faces[f] = polytope.faces[--polytope.face_count];
+        }
+        if (overflow) return false;
+
+        int index = polytope.vertex_count++;
+        polytope.vertices[index] = next;
+        for (int e = 0; e < edge_count; ++e) {
+            if (!add_face(&polytope, edges[e][0], edges[e][1], index)) return false;
+        }
+        if (polytope.face_count == 0) return false;
+    }
+
+    closest = 0;
+    for (int f = 1; f < polytope.face_count; ++f) {
+        if (polytope.faces[f].dist < polytope.faces[closest].dist) closest = f;
+    }
+    const EpaFace* face = &polytope.faces[closest];
+    *normal = face->normal;
+    *depth = fmaxf(face->dist, 0.0f);
+
+    // Barycentric coordinates of the origin's projection onto the face
+    const SimplexVertex* v0 = &polytope.vertices[face->v[0]];
+    const SimplexVertex* v1 = &polytope.vertices[face->v[1]];
+    const SimplexVertex* v2 = &polytope.vertices[face->v[2]];
+    Vec3 projection, e0, e1, e2;
+    vec3_scale(&face->normal, face->dist, &projection);
+    vec3_sub(&v1->w, &v0->w, &e0);
+    vec3_sub(&v2->w, &v0->w, &e1);
+    vec3_sub(&projection, &v0->w, &e2);
+    float d00 = vec3_dot(&e0, &e0), d01 = vec3_dot(&e0, &e1), d11 = vec3_dot(&e1, &e1);
+    float d20 = vec3_dot(&e2, &e0), d21 = vec3_dot(&e2, &e1);
+    float denominator = d00 * d11 - d01 * d01;
+    float v = 0.0f, w = 0.0f;
+    if (fabsf(denominator) > 1e-20f) {
+        v = (d11 * d20 - d01 * d21) / denominator;
+        w = (d00 * d21 - d01 * d20) / denominator;
+    }
+    float u = 1.0f - v - w;
+    *point_a = add_scaled(add_scaled(add_scaled((Vec3){0, 0, 0}, v0->a, u), v1->a, v), v2->a, w);
+    *point_b = add_scaled(add_scaled(add_scaled((Vec3){0, 0, 0}, v0->b, u), v1->b, v), v2->b, w);
+    return true;
+}
+
+/* --- Persistent manifold --- */
+
+// Twice the largest area the quadrilateral of four points can span, whichever way it is connected
+static float quad_area(const Vec3* p0, const Vec3* p1, const Vec3* p2, const Vec3* p3) {
+    const Vec3* pairs[3][4] = {{p0, p1, p2, p3}, {p0, p2, p1, p3}, {p0, p3, p1, p2}};
+    float best = 0.0f;
+    for (int i = 0; i < 3; ++i) {
+        Vec3 d0, d1, cross;
+        vec3_sub(pairs[i][0], pairs[i][1], &d0);
+        vec3_sub(pairs[i][2], pairs[i][3], &d1);
+        vec3_cross(&d0, &d1, &cross);
+        best = fmaxf(best, vec3_length_sq(&cross));
+    }
+    return best;
+}
+
+// Refreshes the pair's points for the new transforms and normal, dropping those that separated or slid apart
+static void refresh_points(const ConvexObject* a, const ConvexObject* b, Vec3 normal, ConvexPairCache* cache) {
+    if (vec3_dot(&normal, &cache->normal) < NORMAL_AGREEMENT) cache->point_count = 0;
+    int kept = 0;
+    for (int i = 0; i < cache->point_count; ++i) {
+        Vec3 world_a = to_world(a, cache->points[i].local_a);
+        Vec3 world_b = to_world(b, cache->points[i].local_b);
+        Vec3 gap;
+        vec3_sub(&world_a, &world_b, &gap);
+        float depth = vec3_dot(&gap, &normal);
+        Vec3 tangential = add_scaled(gap, normal, -depth);
+        if (depth < -CONTACT_BREAKING_DISTANCE) continue;
+        if (vec3_length_sq(&tangential) > CONTACT_BREAKING_DISTANCE * CONTACT_BREAKING_DISTANCE) continue;
+        cache->points[kept++] = cache->points[i];
+    }
+    cache->point_count = kept;
+    cache->normal = normal;
+}
+
+// Adds the new point, replacing a point near it or, with the manifold full, the one whose loss costs the least area
+static void add_point(const ConvexObject* a, Vec3 world_a, Vec3 local_a, Vec3 local_b, ConvexPairCache* cache) {
+    PersistentPoint point = {local_a, local_b, 0};
+    for (int i = 0; i < cache->point_count; ++i) {
+        Vec3 other = to_world(a, cache->points[i].local_a);
+        if (vec3_dist_sq(&other, &world_a) < CONTACT_BREAKING_DISTANCE * CONTACT_BREAKING_DISTANCE) {
+            // The same contact as before, so it keeps its id and warm starts
+            point.feature_id = cache->points[i].feature_id;
+            cache->points[i] = point;
+            return;
+        }
+    }
+
+    point.feature_id = cache->next_feature_id++;
+    if (cache->point_count < MAX_MANIFOLD_POINTS) {
+        cache->points[cache->point_count++] = point;
+        return;
+    }
+
+    Vec3 corners[MAX_MANIFOLD_POINTS + 1];
+    for (int i = 0; i < MAX_MANIFOLD_POINTS; ++i) corners[i] = to_world(a, cache->points[i].local_a);
+    corners[MAX_MANIFOLD_POINTS] = world_a;
+    int replaced = 0;
+    float best_area = -1.0f;
+    for (int skip = 0; skip < MAX_MANIFOLD_POINTS; ++skip) {
+        const Vec3* rest[MAX_MANIFOLD_POINTS];
+        int n = 0;
+        for (int i = 0; i <= MAX_MANIFOLD_POINTS; ++i) {
+            if (i != skip) rest[n++] = &corners[i];
+        }
+        float area = quad_area(rest[0], rest[1], rest[2], rest[3]);
+        if (area > best_area) {
+            best_area = area;
+            replaced = skip;
+        }
+    }
+    cache->points[replaced] = point;
+}
+
+bool test_convex_vs_convex(const ConvexObject* a, const ConvexObject* b, ConvexPairCache* cache,
+                           ContactManifold* manifold) {
+    Simplex simplex;
+    GjkResult result;
+    run_gjk(a, b, &cache->simplex, &simplex, &result);
+    store_simplex(&simplex, &cache->simplex);
+
+    Vec3 normal, point_a, point_b;
+    float depth;
+    if (!result.overlapping || !expand_to_tetrahedron(a, b, &simplex) ||
+        !run_epa(a, b, &simplex, &normal, &depth, &point_a, &point_b)) {
+        cache->point_count = 0;
+        return false;
+    }
+
+    refresh_points(a, b, normal, cache);
+    add_point(a, point_a, to_local(a, point_a), to_local(b, point_b), cache);
+
+    // Points that have come apart stay in the cache in case they close again, but are not contacts:
+    // the solver would push the bodies apart across the gap
+    manifold->normal = normal;
+    manifold->point_count = 0;
+    for (int i = 0; i < cache->point_count; ++i) {
+        Vec3 world_a = to_world(a, cache->points[i].local_a);
+        Vec3 world_b = to_world(b, cache->points[i].local_b);
+        Vec3 gap;
+        vec3_sub(&world_a, &world_b, &gap);
+        float depth = vec3_dot(&gap, &normal);
+        if (depth < 0.0f) continue;
+        ManifoldPoint* out = &manifold->points[manifold->point_count++];
+        vec3_add(&world_a, &world_b, &out->point);
+        vec3_scale(&out->point, 0.5f, &out->point);
+        out->depth = depth;
+        out->feature_id = cache->points[i].feature_id;
+    }
+    return manifold->point_count > 0;
+}
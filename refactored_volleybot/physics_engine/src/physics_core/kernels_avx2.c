@@ -0,0 +1,4 @@
+/* AVX2 + FMA variant: eight bodies per block fill the 256-bit registers. */
+#define KERNEL_SUFFIX avx2
+#define KERNEL_BLOCK 8
+#include "kernels_impl.h"
@@ -0,0 +1,4 @@
+/* AVX-512 variant: sixteen bodies per block fill the 512-bit registers. */
+#define KERNEL_SUFFIX avx512
+#define KERNEL_BLOCK 16
+#include "kernels_impl.h"
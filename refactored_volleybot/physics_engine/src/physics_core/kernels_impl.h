@@ -0,0 +1,399 @@
+/*
+ * Batch kernels, compiled once per instruction set. Each kernels_<level>.c
+ * defines KERNEL_SUFFIX and KERNEL_BLOCK and includes this file, and the build
+ * compiles it with that level's target flags (see CMakeLists.txt).
+ *
+ * The batch loops work on blocks of KERNEL_BLOCK bodies: the inputs are
+ * gathered into small local arrays, processed by fixed-length loops that the
+ * compiler turns into full-width vector code for the target, and scattered
+ * back. The contact solver is inherently sequential and instead gets the
+ * per-contact Vec4 kernels of simd_math.h built for the target.
+ */
+
+#include "physics_core/cpu_dispatch.h"
+#include "physics_core/kinematics.h"
+#include <math.h>
+
+#define KERNEL_CONCAT2(name, suffix) name##_##suffix
+#define KERNEL_CONCAT(name, suffix) KERNEL_CONCAT2(name, suffix)
+#define KERNEL(name) KERNEL_CONCAT(name, KERNEL_SUFFIX)
+
+static void KERNEL(integrate_bodies)(Vec3* positions, Vec3* velocities, Vec3* accelerations, const uint8_t* flags,
+                                     size_t count, Vec3 gravity, float dt) {
+    const float half_dt_sq = 0.5f * dt * dt;
+    const float gravity_xyz[3] = {gravity.x, gravity.y, gravity.z};
+
+    // A block of bodies is 3 * KERNEL_BLOCK consecutive floats in each array.
+    // Gravity repeats every three floats, so the pattern for a block is fixed.
+    float block_gravity[3 * KERNEL_BLOCK];
+    for (int k = 0; k < 3 * KERNEL_BLOCK; ++k) {
+        block_gravity[k] = gravity_xyz[k % 3];
+    }
+
+    size_t i = 0;
+    for (; i + KERNEL_BLOCK <= count; i += KERNEL_BLOCK) {
+        float* p = &positions[i].x;
+        float* v = &velocities[i].x;
+        float* a = &accelerations[i].x;
+
+        int moving[3 * KERNEL_BLOCK];
+        for (int k = 0; k < 3 * KERNEL_BLOCK; ++k) {
+            moving[k] = !(flags[i + k / 3] & (BODY_FLAG_STATIC | BODY_FLAG_CHILD | BODY_FLAG_SLEEPING));
+        }
+        for (int k = 0; k < 3 * KERNEL_BLOCK; ++k) {
+            float acceleration = a[k] + block_gravity[k];
+            // p_new = p_old + v_old*dt + 0.5*a*dt*dt, v_new = v_old + a*dt
+            float new_p = p[k] + v[k] * dt + acceleration * half_dt_sq;
+            float new_v = v[k] + acceleration * dt;
+            p[k] = moving[k] ? new_p : p[k];
+            v[k] = moving[k] ? new_v : v[k];
+            // Forces must be re-applied each frame
+            a[k] = 0.0f;
+        }
+    }
+
+    for (; i < count; ++i) {
+        if (!(flags[i] & (BODY_FLAG_STATIC | BODY_FLAG_CHILD | BODY_FLAG_SLEEPING))) {
+            Vec3 a = {accelerations[i].x + gravity.x, accelerations[i].y + gravity.y, accelerations[i].z + gravity.z};
+            positions[i].x += velocities[i].x * dt + a.x * half_dt_sq;
+            positions[i].y += velocities[i].y * dt + a.y * half_dt_sq;
+            positions[i].z += velocities[i].z * dt + a.z * half_dt_sq;
+            velocities[i].x += a.x * dt;
+            velocities[i].y += a.y * dt;
+            velocities[i].z += a.z * dt;
+        }
+        vec3_set(&accelerations[i], 0, 0, 0);
+    }
+}
+
+static void KERNEL(integrate_orientations)(Quat* orientations, const Vec3* angular_velocities, const uint8_t* flags,
+                                           size_t count, float dt) {
+    const float half_dt = 0.5f * dt;
+    for (size_t start = 0; start < count; start += KERNEL_BLOCK) {
+        size_t n = count - start < KERNEL_BLOCK ? count - start : KERNEL_BLOCK;
+
+        // Unused lanes of a partial block stay zero, and are never written back
+        float qx[KERNEL_BLOCK] = {0}, qy[KERNEL_BLOCK] = {0}, qz[KERNEL_BLOCK] = {0}, qw[KERNEL_BLOCK] = {0};
+        float wx[KERNEL_BLOCK] = {0}, wy[KERNEL_BLOCK] = {0}, wz[KERNEL_BLOCK] = {0};
+        int moving[KERNEL_BLOCK] = {0};
+        for (size_t j = 0; j < n; ++j) {
+            const Quat* q = &orientations[start + j];
+            const Vec3* w = &angular_velocities[start + j];
+            qx[j] = q->x; qy[j] = q->y; qz[j] = q->z; qw[j] = q->w;
+            wx[j] = w->x; wy[j] = w->y; wz[j] = w->z;
+            moving[j] = !(flags[start + j] & (BODY_FLAG_STATIC | BODY_FLAG_CHILD | BODY_FLAG_SLEEPING));
+        }
+
+        for (int j = 0; j < KERNEL_BLOCK; ++j) {
+            // dq = 0.5 * dt * (w, 0) * q
+            float x = qx[j] + half_dt * (qw[j] * wx[j] + wy[j] * qz[j] - wz[j] * qy[j]);
+            float y = qy[j] + half_dt * (qw[j] * wy[j] + wz[j] * qx[j] - wx[j] * qz[j]);
+            float z = qz[j] + half_dt * (qw[j] * wz[j] + wx[j] * qy[j] - wy[j] * qx[j]);
+            float w = qw[j] - half_dt * (wx[j] * qx[j] + wy[j] * qy[j] + wz[j] * qz[j]);
+            float length_sq = x * x + y * y + z * z + w * w;
+            float inv_length = length_sq > 0.0f ? 1.0f / sqrtf(length_sq) : 0.0f;
+            qx[j] = moving[j] ? x * inv_length : qx[j];
+            qy[j] = moving[j] ? y * inv_length : qy[j];
+            qz[j] = moving[j] ? z * inv_length : qz[j];
+            qw[j] = moving[j] ? w * inv_length : qw[j];
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            Quat* q = &orientations[start + j];
+            q->x = qx[j]; q->y = qy[j]; q->z = qz[j]; q->w = qw[j];
+        }
+    }
+}
+
+static void KERNEL(update_inverse_inertias)(const Quat* orientations, const Mat4* local_inverse_inertias,
+                                            Mat4* world_inverse_inertias, size_t count) {
+    for (size_t start = 0; start < count; start += KERNEL_BLOCK) {
+        size_t n = count - start < KERNEL_BLOCK ? count - start : KERNEL_BLOCK;
+
+        // The six distinct entries of each symmetric tensor
+        float qx[KERNEL_BLOCK] = {0}, qy[KERNEL_BLOCK] = {0}, qz[KERNEL_BLOCK] = {0}, qw[KERNEL_BLOCK] = {0};
+        float i00[KERNEL_BLOCK] = {0}, i11[KERNEL_BLOCK] = {0}, i22[KERNEL_BLOCK] = {0};
+        float i01[KERNEL_BLOCK] = {0}, i02[KERNEL_BLOCK] = {0}, i12[KERNEL_BLOCK] = {0};
+        for (size_t j = 0; j < n; ++j) {
+            const Quat* q = &orientations[start + j];
+            const Mat4* local = &local_inverse_inertias[start + j];
+            qx[j] = q->x; qy[j] = q->y; qz[j] = q->z; qw[j] = q->w;
+            i00[j] = local->m[0][0]; i11[j] = local->m[1][1]; i22[j] = local->m[2][2];
+            i01[j] = local->m[0][1]; i02[j] = local->m[0][2]; i12[j] = local->m[1][2];
+        }
+
+        float w00[KERNEL_BLOCK], w11[KERNEL_BLOCK], w22[KERNEL_BLOCK];
+        float w01[KERNEL_BLOCK], w02[KERNEL_BLOCK], w12[KERNEL_BLOCK];
+        for (int j = 0; j < KERNEL_BLOCK; ++j) {
+            float xx = qx[j] * qx[j], yy = qy[j] * qy[j], zz = qz[j] * qz[j];
+            float xy = qx[j] * qy[j], xz = qx[j] * qz[j], yz = qy[j] * qz[j];
+            float wx = qw[j] * qx[j], wy = qw[j] * qy[j], wz = qw[j] * qz[j];
+            float r00 = 1.0f - 2.0f * (yy + zz), r01 = 2.0f * (xy - wz), r02 = 2.0f * (xz + wy);
+            float r10 = 2.0f * (xy + wz), r11 = 1.0f - 2.0f * (xx + zz), r12 = 2.0f * (yz - wx);
+            float r20 = 2.0f * (xz - wy), r21 = 2.0f * (yz + wx), r22 = 1.0f - 2.0f * (xx + yy);
+
+            // T = R * I, then W = T * R^T, of which only the upper triangle is needed
+            float t00 = r00 * i00[j] + r01 * i01[j] + r02 * i02[j];
+            float t01 = r00 * i01[j] + r01 * i11[j] + r02 * i12[j];
+            float t02 = r00 * i02[j] + r01 * i12[j] + r02 * i22[j];
+            float t10 = r10 * i00[j] + r11 * i01[j] + r12 * i02[j];
+            float t11 = r10 * i01[j] + r11 * i11[j] + r12 * i12[j];
+            float t12 = r10 * i02[j] + r11 * i12[j] + r12 * i22[j];
+            float t20 = r20 * i00[j] + r21 * i01[j] + r22 * i02[j];
+            float t21 = r20 * i01[j] + r21 * i11[j] + r22 * i12[j];
+            float t22 = r20 * i02[j] + r21 * i12[j] + r22 * i22[j];
+            w00[j] = t00 * r00 + t01 * r01 + t02 * r02;
+            w01[j] = t00 * r10 + t01 * r11 + t02 * r12;
+            w02[j] = t00 * r20 + t01 * r21 + t02 * r22;
+            w11[j] = t10 * r10 + t11 * r11 + t12 * r12;
+            w12[j] = t10 * r20 + t11 * r21 + t12 * r22;
+            w22[j] = t20 * r20 + t21 * r21 + t22 * r22;
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            Mat4* out = &world_inverse_inertias[start + j];
+            mat4_zero(out);
+            out->m[0][0] = w00[j]; out->m[1][1] = w11[j]; out->m[2][2] = w22[j];
+            out->m[0][1] = out->m[1][0] = w01[j];
+            out->m[0][2] = out->m[2][0] = w02[j];
+            out->m[1][2] = out->m[2][1] = w12[j];
+        }
+    }
+}
+
+static void KERNEL(update_aabbs)(const Vec3* positions, const Quat* orientations, const AABB* local_bounds,
+                                 AABB* world_bounds, size_t count) {
+    for (size_t start = 0; start < count; start += KERNEL_BLOCK) {
+        size_t n = count - start < KERNEL_BLOCK ? count - start : KERNEL_BLOCK;
+
+        // Gather the block into structure-of-arrays form. Unused lanes of a partial block stay zero.
+        float qx[KERNEL_BLOCK] = {0}, qy[KERNEL_BLOCK] = {0}, qz[KERNEL_BLOCK] = {0}, qw[KERNEL_BLOCK] = {0};
+        float cx[KERNEL_BLOCK] = {0}, cy[KERNEL_BLOCK] = {0}, cz[KERNEL_BLOCK] = {0};
+        float ex[KERNEL_BLOCK] = {0}, ey[KERNEL_BLOCK] = {0}, ez[KERNEL_BLOCK] = {0};
+        for (size_t j = 0; j < n; ++j) {
+            const Quat* q = &orientations[start + j];
+            const AABB* local = &local_bounds[start + j];
+            qx[j] = q->x; qy[j] = q->y; qz[j] = q->z; qw[j] = q->w;
+            cx[j] = 0.5f * (local->min.x + local->max.x);
+            cy[j] = 0.5f * (local->min.y + local->max.y);
+            cz[j] = 0.5f * (local->min.z + local->max.z);
+            ex[j] = 0.5f * (local->max.x - local->min.x);
+            ey[j] = 0.5f * (local->max.y - local->min.y);
+            ez[j] = 0.5f * (local->max.z - local->min.z);
+        }
+
+        float wcx[KERNEL_BLOCK], wcy[KERNEL_BLOCK], wcz[KERNEL_BLOCK];
+        float wex[KERNEL_BLOCK], wey[KERNEL_BLOCK], wez[KERNEL_BLOCK];
+        for (int j = 0; j < KERNEL_BLOCK; ++j) {
+            // Rotation matrix of the quaternion, row by row
+            float xx = qx[j] * qx[j], yy = qy[j] * qy[j], zz = qz[j] * qz[j];
+            float xy = qx[j] * qy[j], xz = qx[j] * qz[j], yz = qy[j] * qz[j];
+            float wx = qw[j] * qx[j], wy = qw[j] * qy[j], wz = qw[j] * qz[j];
+            float r00 = 1.0f - 2.0f * (yy + zz), r01 = 2.0f * (xy - wz), r02 = 2.0f * (xz + wy);
+            float r10 = 2.0f * (xy + wz), r11 = 1.0f - 2.0f * (xx + zz), r12 = 2.0f * (yz - wx);
+            float r20 = 2.0f * (xz - wy), r21 = 2.0f * (yz + wx), r22 = 1.0f - 2.0f * (xx + yy);
+
+            // A rotated box's AABB has extents |R| * e
+            wcx[j] = r00 * cx[j] + r01 * cy[j] + r02 * cz[j];
+            wcy[j] = r10 * cx[j] + r11 * cy[j] + r12 * cz[j];
+            wcz[j] = r20 * cx[j] + r21 * cy[j] + r22 * cz[j];
+            wex[j] = fabsf(r00) * ex[j] + fabsf(r01) * ey[j] + fabsf(r02) * ez[j];
+            wey[j] = fabsf(r10) * ex[j] + fabsf(r11) * ey[j] + fabsf(r12) * ez[j];
+            wez[j] = fabsf(r20) * ex[j] + fabsf(r21) * ey[j] + fabsf(r22) * ez[j];
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            const Vec3* p = &positions[start + j];
+            AABB* out = &world_bounds[start + j];
+            out->min.x = p->x + wcx[j] - wex[j];
+            out->min.y = p->y + wcy[j] - wey[j];
+            out->min.z = p->z + wcz[j] - wez[j];
+            out->max.x = p->x + wcx[j] + wex[j];
+            out->max.y = p->y + wcy[j] + wey[j];
+            out->max.z = p->z + wcz[j] + wez[j];
+        }
+    }
+}
+
+static void KERNEL(test_spheres_vs_spheres)(const Vec3* centers_a, const float* radii_a, const Vec3* centers_b,
+                                            const float* radii_b, size_t count, CollisionInfo* results) {
+    for (size_t start = 0; start < count; start += KERNEL_BLOCK) {
+        size_t n = count - start < KERNEL_BLOCK ? count - start : KERNEL_BLOCK;
+
+        float dx[KERNEL_BLOCK] = {0}, dy[KERNEL_BLOCK] = {0}, dz[KERNEL_BLOCK] = {0}, radii_sum[KERNEL_BLOCK] = {0};
+        for (size_t j = 0; j < n; ++j) {
+            dx[j] = centers_b[start + j].x - centers_a[start + j].x;
+            dy[j] = centers_b[start + j].y - centers_a[start + j].y;
+            dz[j] = centers_b[start + j].z - centers_a[start + j].z;
+            radii_sum[j] = radii_a[start + j] + radii_b[start + j];
+        }
+
+        int hit[KERNEL_BLOCK];
+        float nx[KERNEL_BLOCK], ny[KERNEL_BLOCK], nz[KERNEL_BLOCK], depth[KERNEL_BLOCK];
+        for (int j = 0; j < KERNEL_BLOCK; ++j) {
+            float dist_sq = dx[j] * dx[j] + dy[j] * dy[j] + dz[j] * dz[j];
+            float dist = sqrtf(dist_sq);
+            int separated = dist > 0.0f;
+            float inv_dist = separated ? 1.0f / dist : 0.0f;
+            hit[j] = dist_sq < radii_sum[j] * radii_sum[j];
+            depth[j] = radii_sum[j] - dist;
+            // Spheres in the exact same position are pushed apart on the Y axis
+            nx[j] = dx[j] * inv_dist;
+            ny[j] = separated ? dy[j] * inv_dist : 1.0f;
+            nz[j] = dz[j] * inv_dist;
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            CollisionInfo* info = &results[start + j];
+            info->has_collided = hit[j] != 0;
+            info->normal.x = nx[j];
+            info->normal.y = ny[j];
+            info->normal.z = nz[j];
+            info->depth = hit[j] ? depth[j] : 0.0f;
+        }
+    }
+}
+
+static void KERNEL(test_spheres_vs_boxes)(const Vec3* sphere_centers, const float* radii, const Vec3* box_centers,
+                                          const Quat* box_orientations, const Vec3* box_extents, size_t count,
+                                          CollisionInfo* results) {
+    for (size_t start = 0; start < count; start += KERNEL_BLOCK) {
+        size_t n = count - start < KERNEL_BLOCK ? count - start : KERNEL_BLOCK;
+
+        // Sphere center relative to the box center, in world axes
+        float dx[KERNEL_BLOCK] = {0}, dy[KERNEL_BLOCK] = {0}, dz[KERNEL_BLOCK] = {0};
+        float qx[KERNEL_BLOCK] = {0}, qy[KERNEL_BLOCK] = {0}, qz[KERNEL_BLOCK] = {0}, qw[KERNEL_BLOCK] = {0};
+        float ex[KERNEL_BLOCK] = {0}, ey[KERNEL_BLOCK] = {0}, ez[KERNEL_BLOCK] = {0}, r[KERNEL_BLOCK] = {0};
+        for (size_t j = 0; j < n; ++j) {
+            const Quat* q = &box_orientations[start + j];
+            dx[j] = sphere_centers[start + j].x - box_centers[start + j].x;
+            dy[j] = sphere_centers[start + j].y - box_centers[start + j].y;
+            dz[j] = sphere_centers[start + j].z - box_centers[start + j].z;
+            qx[j] = q->x; qy[j] = q->y; qz[j] = q->z; qw[j] = q->w;
+            ex[j] = box_extents[start + j].x;
+            ey[j] = box_extents[start + j].y;
+            ez[j] = box_extents[start + j].z;
+            r[j] = radii[start + j];
+        }
+
+        int hit[KERNEL_BLOCK];
+        float nx[KERNEL_BLOCK], ny[KERNEL_BLOCK], nz[KERNEL_BLOCK], depth[KERNEL_BLOCK];
+        for (int j = 0; j < KERNEL_BLOCK; ++j) {
+            // Rotation matrix of the box. Zeroed lanes of a partial block get the identity.
+            float xx = qx[j] * qx[j], yy = qy[j] * qy[j], zz = qz[j] * qz[j];
+            float xy = qx[j] * qy[j], xz = qx[j] * qz[j], yz = qy[j] * qz[j];
+            float wx = qw[j] * qx[j], wy = qw[j] * qy[j], wz = qw[j] * qz[j];
+            float r00 = 1.0f - 2.0f * (yy + zz), r01 = 2.0f * (xy - wz), r02 = 2.0f * (xz + wy);
+            float r10 = 2.0f * (xy + wz), r11 = 1.0f - 2.0f * (xx + zz), r12 = 2.0f * (yz - wx);
+            float r20 = 2.0f * (xz - wy), r21 = 2.0f * (yz + wx), r22 = 1.0f - 2.0f * (xx + yy);
+
+            // The test runs in the box's local frame, where it is axis-aligned
+            float sx = r00 * dx[j] + r10 * dy[j] + r20 * dz[j];
+            float sy = r01 * dx[j] + r11 * dy[j] + r21 * dz[j];
+            float sz = r02 * dx[j] + r12 * dy[j] + r22 * dz[j];
+
+            // Delta from the closest point on the box to the sphere's center. Written as a distance past each face
+            // rather than sx - clamp(sx), which FMA contraction may leave with a tiny, meaningless nonzero delta.
+            float cx = fmaxf(fabsf(sx) - ex[j], 0.0f);
+            float cy = fmaxf(fabsf(sy) - ey[j], 0.0f);
+            float cz = fmaxf(fabsf(sz) - ez[j], 0.0f);
+            cx = sx < 0.0f ? -cx : cx;
+            cy = sy < 0.0f ? -cy : cy;
+            cz = sz < 0.0f ? -cz : cz;
+            float dist_sq = cx * cx + cy * cy + cz * cz;
+            float dist = sqrtf(dist_sq);
+            hit[j] = dist_sq < r[j] * r[j];
+            depth[j] = r[j] - dist;
+
+            // With the center inside the box, push out from the box center instead
+            int outside = dist > 0.0f;
+            float px = outside ? cx : sx;
+            float py = outside ? cy : sy;
+            float pz = outside ? cz : sz;
+            float length_sq = px * px + py * py + pz * pz;
+            int usable = outside || length_sq >= 1e-6f;
+            float inv_length = usable ? 1.0f / sqrtf(length_sq) : 0.0f;
+            float lx = px * inv_length;
+            float ly = usable ? py * inv_length : 1.0f; // Default push-out
+            float lz = pz * inv_length;
+
+            // Back to world axes
+            nx[j] = r00 * lx + r01 * ly + r02 * lz;
+            ny[j] = r10 * lx + r11 * ly + r12 * lz;
+            nz[j] = r20 * lx + r21 * ly + r22 * lz;
+        }
+
+        for (size_t j = 0; j < n; ++j) {
+            CollisionInfo* info = &results[start + j];
+            info->has_collided = hit[j] != 0;
+            info->normal.x = nx[j];
+            info->normal.y = ny[j];
+            info->normal.z = nz[j];
+            info->depth = hit[j] ? depth[j] : 0.0f;
+        }
+    }
+}
+
+static void KERNEL(solve_contacts)(SolverContact* contacts, size_t count, Vec3* velocities, Vec3* angular_velocities,
+                                   const float* inverse_masses) {
+    for (size_t i = 0; i < count; ++i) {
+        SolverContact* c = &contacts[i];
+        float inv_mass_a = inverse_masses[c->body_a];
+        float inv_mass_b = inverse_masses[c->body_b];
+        ContactVelocities vel = contact_velocities_load(c, velocities, angular_velocities);
+
+        // Coulomb friction: the accumulated tangential impulse is clamped by the normal impulse
+        float max_friction_impulse = c->friction * c->accumulated_impulse;
+        for (int t = 0; t < 2; ++t) {
+            const ContactRow* row = &c->rows[1 + t];
+            float jt = -contact_row_relative_speed(row, &vel) * row->mass;
+
+            float old_impulse = c->accumulated_friction[t];
+            c->accumulated_friction[t] = fmaxf(-max_friction_impulse, fminf(old_impulse + jt, max_friction_impulse));
+            jt = c->accumulated_friction[t] - old_impulse;
+
+            contact_row_apply(row, jt, inv_mass_a, inv_mass_b, &vel);
+        }
+
+        // The total normal impulse may only push the bodies apart
+        const ContactRow* row = &c->rows[0];
+        float j = (c->velocity_bias - contact_row_relative_speed(row, &vel)) * row->mass;
+        float old_impulse = c->accumulated_impulse;
+        c->accumulated_impulse = fmaxf(old_impulse + j, 0.0f);
+        j = c->accumulated_impulse - old_impulse;
+
+        contact_row_apply(row, j, inv_mass_a, inv_mass_b, &vel);
+        contact_velocities_store(c, &vel, inv_mass_a, inv_mass_b, velocities, angular_velocities);
+    }
+}
+
+static void KERNEL(solve_contact_positions)(SolverContact* contacts, size_t count, Vec3* correction_velocities,
+                                            Vec3* correction_angular_velocities, const float* inverse_masses) {
+    for (size_t i = 0; i < count; ++i) {
+        SolverContact* c = &contacts[i];
+        float inv_mass_a = inverse_masses[c->body_a];
+        float inv_mass_b = inverse_masses[c->body_b];
+        ContactVelocities vel = contact_velocities_load(c, correction_velocities, correction_angular_velocities);
+
+        // Only the normal row: the push may only separate, and friction has no part in it
+        const ContactRow* row = &c->rows[0];
+        float j = (c->position_bias - contact_row_relative_speed(row, &vel)) * row->mass;
+        float old_push = c->accumulated_push;
+        c->accumulated_push = fmaxf(old_push + j, 0.0f);
+        j = c->accumulated_push - old_push;
+
+        contact_row_apply(row, j, inv_mass_a, inv_mass_b, &vel);
+        contact_velocities_store(c, &vel, inv_mass_a, inv_mass_b, correction_velocities, correction_angular_velocities);
+    }
+}
+
+const PhysicsKernels KERNEL(physics_kernels) = {
+    KERNEL(integrate_bodies),
+    KERNEL(integrate_orientations),
+    KERNEL(update_inverse_inertias),
+    KERNEL(update_aabbs),
+    KERNEL(test_spheres_vs_spheres),
+    KERNEL(test_spheres_vs_boxes),
+    KERNEL(solve_contacts),
+    KERNEL(solve_contact_positions)
+};
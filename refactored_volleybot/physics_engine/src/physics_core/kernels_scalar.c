@@ -0,0 +1,4 @@
+/* Plain C, built without SIMD intrinsics or auto-vectorization. */
+#define KERNEL_SUFFIX scalar
+#define KERNEL_BLOCK 1
+#include "kernels_impl.h"
@@ -0,0 +1,4 @@
+/* SSE4.1 variant: four bodies per block fill the 128-bit registers. */
+#define KERNEL_SUFFIX sse4
+#define KERNEL_BLOCK 4
+#include "kernels_impl.h"
@@ -1,4 +1,5 @@
 #include "physics_core/kinematics.h"
+#include "physics_core/cpu_dispatch.h"
 
 void update_kinematics(Vec3* position, Vec3* velocity, const Vec3* acceleration, float dt) {
     // Using the Velocity Verlet integration scheme.
@@ -22,3 +23,18 @@ void update_kinematics(Vec3* position, Vec3* velocity, const Vec3* acceleration,
     vec3_scale(acceleration, dt, &velocity_change);
     vec3_add(velocity, &velocity_change, velocity);
 }
+
+void integrate_bodies(Vec3* positions, Vec3* velocities, Vec3* accelerations, const uint8_t* flags,
+                      size_t count, Vec3 gravity, float dt) {
+    physics_kernels()->integrate_bodies(positions, velocities, accelerations, flags, count, gravity, dt);
+}
+
+void integrate_orientations(Quat* orientations, const Vec3* angular_velocities, const uint8_t* flags,
+                            size_t count, float dt) {
+    physics_kernels()->integrate_orientations(orientations, angular_velocities, flags, count, dt);
+}
+
+void update_inverse_inertias(const Quat* orientations, const Mat4* local_inverse_inertias,
+                             Mat4* world_inverse_inertias, size_t count) {
+    physics_kernels()->update_inverse_inertias(orientations, local_inverse_inertias, world_inverse_inertias, count);
+}
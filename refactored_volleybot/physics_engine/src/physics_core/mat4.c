@@ -1,4 +1,5 @@
 #include "physics_core/mat4.h"
+#include "physics_core/simd_math.h"
 #include <string.h> // For memset
 #include <math.h>
 
@@ -23,37 +24,15 @@ void mat4_identity(Mat4* result) {
 }
 
 void mat4_multiply(const Mat4* a, const Mat4* b, Mat4* result) {
-    Mat4 temp; // Use a temporary matrix to allow for aliasing (e.g., result = a * result)
-
-    for (int c = 0; c < 4; ++c) {
-        for (int r = 0; r < 4; ++r) {
-            temp.m[c][r] = a->m[0][r] * b->m[c][0] + 
-                           a->m[1][r] * b->m[c][1] + 
-                           a->m[2][r] * b->m[c][2] + 
-                           a->m[3][r] * b->m[c][3];
-        }
-    }
-
-    memcpy(result->m, temp.m, sizeof(temp.m));
+    mat4_simd_multiply(a, b, result);
 }
 
 Vec3 mat4_transform_point(const Mat4* m, Vec3 v) {
-    Vec3 result;
-    float w = m->m[0][3] * v.x + m->m[1][3] * v.y + m->m[2][3] * v.z + m->m[3][3];
-    if (w == 0.0f) w = 1.0f; // Avoid division by zero
-
-    result.x = (m->m[0][0] * v.x + m->m[1][0] * v.y + m->m[2][0] * v.z + m->m[3][0]) / w;
-    result.y = (m->m[0][1] * v.x + m->m[1][1] * v.y + m->m[2][1] * v.z + m->m[3][1]) / w;
-    result.z = (m->m[0][2] * v.x + m->m[1][2] * v.y + m->m[2][2] * v.z + m->m[3][2]) / w;
-    return result;
+    return vec4_to_vec3(mat4_simd_transform_point(m, vec4_load3(&v)));
 }
 
 Vec3 mat4_transform_direction(const Mat4* m, Vec3 v) {
-    Vec3 result;
-    result.x = m->m[0][0] * v.x + m->m[1][0] * v.y + m->m[2][0] * v.z;
-    result.y = m->m[0][1] * v.x + m->m[1][1] * v.y + m->m[2][1] * v.z;
-    result.z = m->m[0][2] * v.x + m->m[1][2] * v.y + m->m[2][2] * v.z;
-    return result;
+    return vec4_to_vec3(mat4_simd_transform_direction(m, vec4_load3(&v)));
 }
 
 void mat4_translate(Vec3 t, Mat4* result) {
@@ -137,20 +116,7 @@ void mat4_perspective(float fov_y_rad, float aspect_ratio, float near_plane, flo
 }
 
 void mat4_affine_inverse(const Mat4* m, Mat4* result) {
-    // Transpose the rotation part (upper 3x3)
-    result->m[0][0] = m->m[0][0]; result->m[0][1] = m->m[1][0]; result->m[0][2] = m->m[2][0];
-    result->m[1][0] = m->m[0][1]; result->m[1][1] = m->m[1][1]; result->m[1][2] = m->m[2][1];
-    result->m[2][0] = m->m[0][2]; result->m[2][1] = m->m[1][2]; result->m[2][2] = m->m[2][2];
-
-    // Calculate the new translation part
-    Vec3 t = {m->m[3][0], m->m[3][1], m->m[3][2]};
-    result->m[3][0] = - (t.x * result->m[0][0] + t.y * result->m[1][0] + t.z * result->m[2][0]);
-    result->m[3][1] = - (t.x * result->m[0][1] + t.y * result->m[1][1] + t.z * result->m[2][1]);
-    result->m[3][2] = - (t.x * result->m[0][2] + t.y * result->m[1][2] + t.z * result->m[2][2]);
-
-    // The rest of the matrix is identity
-    result->m[0][3] = 0.0f; result->m[1][3] = 0.0f; result->m[2][3] = 0.0f;
-    result->m[3][3] = 1.0f;
+    mat4_simd_affine_inverse(m, result);
 }
 
 void mat3_inverse(const Mat4* m, Mat4* result) {
@@ -160,7 +126,12 @@ void mat3_inverse(const Mat4* m, Mat4* result) {
 
     float det = a*(e*i - f*h) - b*(d*i - f*g) + c*(d*h - e*g);
 
-    if (fabsf(det) < 1e-6) { // Check for singularity
+    // Singular relative to the size of the entries, so the small inertia of small bodies still inverts
+    float scale = 0.0f;
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) scale = fmaxf(scale, fabsf(m->m[column][row]));
+    }
+    if (fabsf(det) <= 1e-6f * scale * scale * scale) { // Check for singularity
         mat4_zero(result); // Return zero matrix for singular case
         return;
     }
@@ -0,0 +1,74 @@
+#include "physics_core/quat.h"
+#include <math.h>
+
+void quat_identity(Quat* result) {
+    result->x = 0.0f;
+    result->y = 0.0f;
+    result->z = 0.0f;
+    result->w = 1.0f;
+}
+
+void quat_from_axis_angle(Vec3 axis, float angle_rad, Quat* result) {
+    Vec3 norm_axis;
+    vec3_normalize(&axis, &norm_axis);
+    float s = sinf(angle_rad * 0.5f);
+    result->x = norm_axis.x * s;
+    result->y = norm_axis.y * s;
+    result->z = norm_axis.z * s;
+    result->w = cosf(angle_rad * 0.5f);
+}
+
+void quat_multiply(const Quat* a, const Quat* b, Quat* result) {
+    Quat temp; // Allows aliasing (e.g., result = a * result)
+    temp.x = a->w * b->x + a->x * b->w + a->y * b->z - a->z * b->y;
+    temp.y = a->w * b->y - a->x * b->z + a->y * b->w + a->z * b->x;
+    temp.z = a->w * b->z + a->x * b->y - a->y * b->x + a->z * b->w;
+    temp.w = a->w * b->w - a->x * b->x - a->y * b->y - a->z * b->z;
+    *result = temp;
+}
+
+void quat_normalize(const Quat* q, Quat* result) {
+    float len_sq = q->x * q->x + q->y * q->y + q->z * q->z + q->w * q->w;
+    if (len_sq > 0.0f) {
+        float inv_len = 1.0f / sqrtf(len_sq);
+        result->x = q->x * inv_len;
+        result->y = q->y * inv_len;
+        result->z = q->z * inv_len;
+        result->w = q->w * inv_len;
+    } else {
+        quat_identity(result);
+    }
+}
+
+Vec3 quat_rotate(const Quat* q, Vec3 v) {
+    // v' = v + 2w(u x v) + 2(u x (u x v)), where u is the vector part
+    Vec3 u = {q->x, q->y, q->z};
+    Vec3 t, u_cross_t, result;
+    vec3_cross(&u, &v, &t);
+    vec3_scale(&t, 2.0f, &t);
+    vec3_cross(&u, &t, &u_cross_t);
+    result.x = v.x + q->w * t.x + u_cross_t.x;
+    result.y = v.y + q->w * t.y + u_cross_t.y;
+    result.z = v.z + q->w * t.z + u_cross_t.z;
+    return result;
+}
+
+void quat_to_mat4(const Quat* q, Mat4* result) {
+    float xx = q->x * q->x, yy = q->y * q->y, zz = q->z * q->z;
+    float xy = q->x * q->y, xz = q->x * q->z, yz = q->y * q->z;
+    float wx = q->w * q->x, wy = q->w * q->y, wz = q->w * q->z;
+
+    mat4_identity(result);
+    // Column-major: m[column][row]
+    result->m[0][0] = 1.0f - 2.0f * (yy + zz);
+    result->m[0][1] = 2.0f * (xy + wz);
+    result->m[0][2] = 2.0f * (xz - wy);
+
+    result->m[1][0] = 2.0f * (xy - wz);
+    result->m[1][1] = 1.0f - 2.0f * (xx + zz);
+    result->m[1][2] = 2.0f * (yz + wx);
+
+    result->m[2][0] = 2.0f * (xz + wy);
+    result->m[2][1] = 2.0f * (yz - wx);
+    result->m[2][2] = 1.0f - 2.0f * (xx + yy);
+}
@@ -1,4 +1,5 @@
 #include "physics_core/vec3.h"
+#include "physics_core/simd_math.h"
 #include <math.h> 
 
 /* --- Vector Creation --- */
@@ -45,18 +46,8 @@ float vec3_length(const Vec3* v) {
 }
 
 void vec3_normalize(const Vec3* v, Vec3* result) {
-    float len = vec3_length(v);
-    // Safety check for division by zero
-    if (len > 0.0f) {
-        float inv_len = 1.0f / len;
-        result->x = v->x * inv_len;
-        result->y = v->y * inv_len;
-        result->z = v->z * inv_len;
-    } else {
-        result->x = 0.0f;
-        result->y = 0.0f;
-        result->z = 0.0f;
-    }
+    // Returns the zero vector for zero-length input
+    vec4_store3(vec4_normalize3(vec4_load3(v)), result);
 }
 
 float vec3_dot(const Vec3* a, const Vec3* b) {
@@ -64,9 +55,7 @@ float vec3_dot(const Vec3* a, const Vec3* b) {
 }
 
 void vec3_cross(const Vec3* a, const Vec3* b, Vec3* result) {
-    result->x = a->y * b->z - a->z * b->y;
-    result->y = a->z * b->x - a->x * b->z;
-    result->z = a->x * b->y - a->y * b->x;
+    vec4_store3(vec4_cross3(vec4_load3(a), vec4_load3(b)), result);
 }
 
 /* --- Utility & Physics Functions --- */
@@ -0,0 +1,286 @@
+#include "volleybot_physics/aabb_tree.h"
+#include <algorithm>
+#include <math.h>
+
+// --- AABB helpers --- //
+
+static AABB aabb_union(const AABB& a, const AABB& b) {
+    AABB result;
+    result.min = {fminf(a.min.x, b.min.x), fminf(a.min.y, b.min.y), fminf(a.min.z, b.min.z)};
+    result.max = {fmaxf(a.max.x, b.max.x), fmaxf(a.max.y, b.max.y), fmaxf(a.max.z, b.max.z)};
+    return result;
+}
+
+// Half the surface area. The insertion cost heuristic only compares areas, so the factor of 2 is dropped.
+static float aabb_area(const AABB& a) {
+    float dx = a.max.x - a.min.x;
+    float dy = a.max.y - a.min.y;
+    float dz = a.max.z - a.min.z;
+    return dx * dy + dy * dz + dz * dx;
+}
+
+static bool aabb_contains(const AABB& outer, const AABB& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z &&
+           inner.max.x <= outer.max.x && inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+// --- DynamicAABBTree --- //
+
+DynamicAABBTree::DynamicAABBTree(float fat_margin)
+    : root(null_node), free_list(null_node), proxy_count(0), fat_margin(fat_margin) {}
+
+int32_t DynamicAABBTree::allocate_node() {
+    int32_t node_id;
+    if (free_list != null_node) {
+        node_id = free_list;
+        free_list = nodes[node_id].parent;
+    } else {
+        node_id = (int32_t)nodes.size();
+        nodes.push_back({});
+    }
+    TreeNode& node = nodes[node_id];
+    node.parent = null_node;
+    node.child1 = null_node;
+    node.child2 = null_node;
+    node.height = 0;
+    node.user_data = 0;
+    return node_id;
+}
+
+void DynamicAABBTree::free_node(int32_t node_id) {
+    nodes[node_id].parent = free_list;
+    nodes[node_id].height = -1;
+    free_list = node_id;
+}
+
+int32_t DynamicAABBTree::create_proxy(const AABB& aabb, uint32_t user_data) {
+    int32_t proxy_id = allocate_node();
+    Vec3 margin = {fat_margin, fat_margin, fat_margin};
+    vec3_sub(&aabb.min, &margin, &nodes[proxy_id].aabb.min);
+    vec3_add(&aabb.max, &margin, &nodes[proxy_id].aabb.max);
+    nodes[proxy_id].user_data = user_data;
+    insert_leaf(proxy_id);
+    ++proxy_count;
+    return proxy_id;
+}
+
+void DynamicAABBTree::destroy_proxy(int32_t proxy_id) {
+    remove_leaf(proxy_id);
+    free_node(proxy_id);
+    --proxy_count;
+}
+
+bool DynamicAABBTree::move_proxy(int32_t proxy_id, const AABB& aabb, const Vec3& displacement) {
+    if (aabb_contains(nodes[proxy_id].aabb, aabb)) {
+        return false;
+    }
+
+    remove_leaf(proxy_id);
+
+    // Fatten by the margin, then stretch in the direction of motion so a body
+    // moving steadily does not fall out of its leaf again next step.
+    AABB fat;
+    Vec3 margin = {fat_margin, fat_margin, fat_margin};
+    vec3_sub(&aabb.min, &margin, &fat.min);
+    vec3_add(&aabb.max, &margin, &fat.max);
+
+    const float prediction = 2.0f;
+    Vec3 d;
+    vec3_scale(&displacement, prediction, &d);
+    if (d.x < 0.0f) fat.min.x += d.x; else fat.max.x += d.x;
+    if (d.y < 0.0f) fat.min.y += d.y; else fat.max.y += d.y;
+    if (d.z < 0.0f) fat.min.z += d.z; else fat.max.z += d.z;
+
+    nodes[proxy_id].aabb = fat;
+    insert_leaf(proxy_id);
+    return true;
+}
+
+void DynamicAABBTree::insert_leaf(int32_t leaf) {
+    if (root == null_node) {
+        root = leaf;
+        nodes[root].parent = null_node;
+        return;
+    }
+
+    // Walk down the tree towards the cheapest sibling. The cost of a node is
+    // the area it would grow by, plus the growth inherited by its ancestors.
+    AABB leaf_aabb = nodes[leaf].aabb;
+    int32_t index = root;
+    while (!nodes[index].is_leaf()) {
+        int32_t child1 = nodes[index].child1;
+        int32_t child2 = nodes[index].child2;
+
+        float area = aabb_area(nodes[index].aabb);
+        float combined_area = aabb_area(aabb_union(nodes[index].aabb, leaf_aabb));
+
+        // Cost of making a new parent for this node and the new leaf
+        float cost = 2.0f * combined_area;
+        // Minimum cost of pushing the leaf further down the tree
+        float inheritance_cost = 2.0f * (combined_area - area);
+
+        float costs[2];
+        int32_t children[2] = {child1, child2};
+        for (int c = 0; c < 2; ++c) {
+            const TreeNode& child = nodes[children[c]];
+            float grown = aabb_area(aabb_union(leaf_aabb, child.aabb));
+            costs[c] = child.is_leaf() ? grown + inheritance_cost
+                                       : (grown - aabb_area(child.aabb)) + inheritance_cost;
+        }
+
+        if (cost < costs[0] && cost < costs[1]) break;
+        index = costs[0] < costs[1] ? child1 : child2;
+    }
+    int32_t sibling = index;
+
+    // Create a new parent for the sibling and the leaf
+    int32_t old_parent = nodes[sibling].parent;
+    int32_t new_parent = allocate_node();
+    nodes[new_parent].parent = old_parent;
+    nodes[new_parent].aabb = aabb_union(leaf_aabb, nodes[sibling].aabb);
+    nodes[new_parent].height = nodes[sibling].height + 1;
+    nodes[new_parent].child1 = sibling;
+    nodes[new_parent].child2 = leaf;
+    nodes[sibling].parent = new_parent;
+    nodes[leaf].parent = new_parent;
+
+    if (old_parent != null_node) {
+        if (nodes[old_parent].child1 == sibling) {
+            nodes[old_parent].child1 = new_parent;
+        } else {
+            nodes[old_parent].child2 = new_parent;
+        }
+    } else {
+        root = new_parent;
+    }
+
+    // Walk back up, refitting bounds and heights
+    index = nodes[leaf].parent;
+    while (index != null_node) {
+        index = balance(index);
+        int32_t child1 = nodes[index].child1;
+        int32_t child2 = nodes[index].child2;
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        nodes[index].aabb = aabb_union(nodes[child1].aabb, nodes[child2].aabb);
+        index = nodes[index].parent;
+    }
+}
+
+void DynamicAABBTree::remove_leaf(int32_t leaf) {
+    if (leaf == root) {
+        root = null_node;
+        return;
+    }
+
+    int32_t parent = nodes[leaf].parent;
+    int32_t grand_parent = nodes[parent].parent;
+    int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grand_parent == null_node) {
+        root = sibling;
+        nodes[sibling].parent = null_node;
+        free_node(parent);
+        return;
+    }
+
+    // Replace the parent by the sibling and refit the ancestors
+    if (nodes[grand_parent].child1 == parent) {
+        nodes[grand_parent].child1 = sibling;
+    } else {
+        nodes[grand_parent].child2 = sibling;
+    }
+    nodes[sibling].parent = grand_parent;
+    free_node(parent);
+
+    int32_t index = grand_parent;
+    while (index != null_node) {
+        index = balance(index);
+        int32_t child1 = nodes[index].child1;
+        int32_t child2 = nodes[index].child2;
+        nodes[index].aabb = aabb_union(nodes[child1].aabb, nodes[child2].aabb);
+        nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+        index = nodes[index].parent;
+    }
+}
+
+// Performs a left or right rotation if node A is imbalanced and returns the new subtree root.
+int32_t DynamicAABBTree::balance(int32_t index_a) {
+    TreeNode& a = nodes[index_a];
+    if (a.is_leaf() || a.height < 2) {
+        return index_a;
+    }
+
+    int32_t index_b = a.child1;
+    int32_t index_c = a.child2;
+    int32_t balance_factor = nodes[index_c].height - nodes[index_b].height;
+
+    // Rotate the taller child up. 'up' replaces A, 'down' stays as A's child.
+    auto rotate = [&](int32_t index_up, int32_t index_down) {
+        TreeNode& up = nodes[index_up];
+        int32_t index_f = up.child1;
+        int32_t index_g = up.child2;
+
+        // Swap A and the rising child
+        up.child1 = index_a;
+        up.parent = a.parent;
+        a.parent = index_up;
+
+        if (up.parent != null_node) {
+            if (nodes[up.parent].child1 == index_a) {
+                nodes[up.parent].child1 = index_up;
+            } else {
+                nodes[up.parent].child2 = index_up;
+            }
+        } else {
+            root = index_up;
+        }
+
+        // Keep the taller grandchild under the rising node and give the other to A
+        int32_t keep = index_f, give = index_g;
+        if (nodes[index_f].height < nodes[index_g].height) {
+            keep = index_g;
+            give = index_f;
+        }
+        up.child2 = keep;
+        if (a.child1 == index_up) {
+            a.child1 = give;
+        } else {
+            a.child2 = give;
+        }
+        nodes[give].parent = index_a;
+
+        a.aabb = aabb_union(nodes[index_down].aabb, nodes[give].aabb);
+        a.height = 1 + std::max(nodes[index_down].height, nodes[give].height);
+        up.aabb = aabb_union(a.aabb, nodes[keep].aabb);
+        up.height = 1 + std::max(a.height, nodes[keep].height);
+        return index_up;
+    };
+
+    if (balance_factor > 1) {
+        return rotate(index_c, index_b);
+    }
+    if (balance_factor < -1) {
+        return rotate(index_b, index_c);
+    }
+    return index_a;
+}
+
+bool DynamicAABBTree::ray_hits_aabb(const AABB& box, const Vec3& origin, const Vec3& inv_direction, float max_distance) {
+    // Slab test
+    float t1 = (box.min.x - origin.x) * inv_direction.x;
+    float t2 = (box.max.x - origin.x) * inv_direction.x;
+    float t_min = fminf(t1, t2);
+    float t_max = fmaxf(t1, t2);
+
+    t1 = (box.min.y - origin.y) * inv_direction.y;
+    t2 = (box.max.y - origin.y) * inv_direction.y;
+    t_min = fmaxf(t_min, fminf(t1, t2));
+    t_max = fminf(t_max, fmaxf(t1, t2));
+
+    t1 = (box.min.z - origin.z) * inv_direction.z;
+    t2 = (box.max.z - origin.z) * inv_direction.z;
+    t_min = fmaxf(t_min, fminf(t1, t2));
+    t_max = fminf(t_max, fmaxf(t1, t2));
+
+    return t_max >= fmaxf(t_min, 0.0f) && t_min <= max_distance;
+}
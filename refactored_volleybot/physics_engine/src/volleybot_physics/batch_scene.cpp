@@ -0,0 +1,130 @@
+#include "volleybot_physics/batch_scene.h"
+#include "volleybot_physics/composite_object.h"
+#include "volleybot_physics/task_scheduler.h"
+
+BatchScene::BatchScene(const Scene& template_scene, int num_worlds)
+    : gravity(template_scene.gravity), bodies_per_world(0), action_size(0) {
+    for (int w = 0; w < num_worlds; ++w) {
+        // Adding the copies one world at a time keeps each world's slots contiguous
+        std::unique_ptr<Scene> world(new Scene(&body_store));
+        world->gravity = template_scene.gravity;
+        world->solver_iterations = template_scene.solver_iterations;
+        world->contact_slop = template_scene.contact_slop;
+        world->sleep_settings = template_scene.sleep_settings;
+        world->set_broadphase_type(template_scene.get_broadphase_type());
+        for (const auto& body : template_scene.physics_bodies) {
+            world->add_primitive(body->clone());
+        }
+        // Joints are only added between bodies of the scene, so each finds its bodies' copies at the same index
+        auto copy_of = [&](const Primitive* body) {
+            size_t index = 0;
+            while (template_scene.physics_bodies[index].get() != body) ++index;
+            return world->physics_bodies[index].get();
+        };
+        for (const auto& joint : template_scene.joints) {
+            world->add_joint(joint->clone(copy_of(joint->get_body_a()), copy_of(joint->get_body_b())));
+        }
+
+        motors.insert(motors.end(), world->revolute_joints.begin(), world->revolute_joints.end());
+        worlds.push_back(std::move(world));
+    }
+
+    if (!worlds.empty()) {
+        bodies_per_world = body_store.size() / worlds.size();
+        action_size = motors.size() / worlds.size();
+    }
+
+    save_world_snapshot(0, initial_snapshot);
+    joint_speeds.resize(motors.size());
+    update_joint_speeds(0, motors.size());
+}
+
+void BatchScene::set_motor_speeds(const float* speeds) {
+    for (size_t i = 0; i < motors.size(); ++i) {
+        motors[i]->set_motor_speed(speeds[i]);
+    }
+}
+
+void BatchScene::update_joint_speeds(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        joint_speeds[i] = motors[i]->get_relative_speed();
+    }
+}
+
+void BatchScene::step(const float* actions, float dt) {
+    if (actions) {
+        set_motor_speeds(actions);
+    }
+
+    TaskScheduler& scheduler = TaskScheduler::global();
+
+    scheduler.parallel_for(worlds.size(), world_grain_size, [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; ++w) {
+            worlds[w]->begin_bullet_sweeps();
+        }
+    });
+
+    // Integration and the AABB and inertia refresh are passes over every world's bodies,
+    // split into chunks regardless of world boundaries
+    scheduler.parallel_for(body_store.size(), Scene::body_grain_size, [&](size_t begin, size_t end) {
+        body_store.integrate(begin, end, gravity, dt);
+    });
+    scheduler.parallel_for(worlds.size(), world_grain_size, [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; ++w) {
+            worlds[w]->update_composite_parts();
+        }
+    });
+    scheduler.parallel_for(body_store.size(), Scene::body_grain_size, [&](size_t begin, size_t end) {
+        body_store.update_aabbs(begin, end);
+        body_store.update_inverse_inertias(begin, end);
+    });
+
+    // The rest of the step only touches one world's slots, so whole worlds are the tasks
+    scheduler.parallel_for(worlds.size(), world_grain_size, [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; ++w) {
+            worlds[w]->collide_and_solve(dt);
+        }
+        update_joint_speeds(begin * action_size, end * action_size);
+    });
+}
+
+void BatchScene::step_n(const float* actions, float dt, int n, int frame_skip) {
+    int substeps = n * frame_skip;
+    for (int i = 0; i < substeps; ++i) {
+        // The motor targets persist, so later substeps need not set them again
+        step(i == 0 ? actions : nullptr, dt);
+    }
+}
+
+void BatchScene::reset_world(int world) {
+    // The initial snapshot has an empty contact cache, so no impulses from before the reset warm start the solver
+    restore_world_snapshot(world, initial_snapshot.data(), initial_snapshot.size());
+}
+
+void BatchScene::reset() {
+    for (int w = 0; w < (int)worlds.size(); ++w) {
+        reset_world(w);
+    }
+}
+
+void BatchScene::save_world_snapshot(int world, std::vector<uint8_t>& out) const {
+    if (!is_valid_world(world)) {
+        out.clear();
+        return;
+    }
+    write_snapshot(worlds[world]->snapshot_target(get_world_offset(world), (uint32_t)bodies_per_world), out);
+}
+
+bool BatchScene::restore_world_snapshot(int world, const uint8_t* data, size_t size) {
+    if (!is_valid_world(world)) return false;
+    SnapshotTarget target = worlds[world]->snapshot_target(get_world_offset(world), (uint32_t)bodies_per_world);
+    if (!read_snapshot(target, data, size)) return false;
+    update_joint_speeds(world * action_size, (world + 1) * action_size);
+    return true;
+}
+
+bool BatchScene::copy_world(int src, int dst) {
+    if (!is_valid_world(src) || !is_valid_world(dst)) return false;
+    save_world_snapshot(src, copy_buffer);
+    return restore_world_snapshot(dst, copy_buffer.data(), copy_buffer.size());
+}
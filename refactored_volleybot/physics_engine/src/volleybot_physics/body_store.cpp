@@ -0,0 +1,121 @@
+#include "volleybot_physics/body_store.h"
+
+uint32_t BodyStore::add(const BodyState& state, Primitive* owner) {
+    positions.push_back(state.position);
+    velocities.push_back(state.velocity);
+    accelerations.push_back(state.acceleration);
+    angular_velocities.push_back(state.angular_velocity);
+    correction_velocities.push_back({0.0f, 0.0f, 0.0f});
+    correction_angular_velocities.push_back({0.0f, 0.0f, 0.0f});
+    orientations.push_back(state.orientation);
+    inverse_inertias.push_back(state.inverse_inertia);
+    local_inverse_inertias.push_back(state.local_inverse_inertia);
+    local_bounds.push_back(state.local_bounds);
+    aabbs.push_back(state.aabb);
+    inverse_masses.push_back(state.inverse_mass);
+    sleep_times.push_back(state.sleep_time);
+    sleep_links.push_back((uint32_t)sleep_links.size());
+    parents.push_back((uint32_t)parents.size());
+    flags.push_back(state.flags);
+    owners.push_back(owner);
+    return (uint32_t)(positions.size() - 1);
+}
+
+void BodyStore::read(uint32_t index, BodyState* out_state) const {
+    out_state->position = positions[index];
+    out_state->velocity = velocities[index];
+    out_state->acceleration = accelerations[index];
+    out_state->angular_velocity = angular_velocities[index];
+    out_state->orientation = orientations[index];
+    out_state->inverse_inertia = inverse_inertias[index];
+    out_state->local_inverse_inertia = local_inverse_inertias[index];
+    out_state->local_bounds = local_bounds[index];
+    out_state->aabb = aabbs[index];
+    out_state->inverse_mass = inverse_masses[index];
+    out_state->sleep_time = sleep_times[index];
+    out_state->flags = flags[index];
+}
+
+void BodyStore::write(uint32_t index, const BodyState& state) {
+    positions[index] = state.position;
+    velocities[index] = state.velocity;
+    accelerations[index] = state.acceleration;
+    angular_velocities[index] = state.angular_velocity;
+    orientations[index] = state.orientation;
+    inverse_inertias[index] = state.inverse_inertia;
+    local_inverse_inertias[index] = state.local_inverse_inertia;
+    local_bounds[index] = state.local_bounds;
+    aabbs[index] = state.aabb;
+    inverse_masses[index] = state.inverse_mass;
+    sleep_times[index] = state.sleep_time;
+    flags[index] = state.flags;
+}
+
+void BodyStore::integrate(size_t begin, size_t end, Vec3 gravity, float dt) {
+    integrate_bodies(positions.data() + begin, velocities.data() + begin, accelerations.data() + begin,
+                     flags.data() + begin, end - begin, gravity, dt);
+    integrate_orientations(orientations.data() + begin, angular_velocities.data() + begin, flags.data() + begin,
+                           end - begin, dt);
+}
+
+void BodyStore::update_aabbs(size_t begin, size_t end) {
+    ::update_aabbs(positions.data() + begin, orientations.data() + begin, local_bounds.data() + begin,
+                   aabbs.data() + begin, end - begin);
+}
+
+void BodyStore::update_inverse_inertias(size_t begin, size_t end) {
+    ::update_inverse_inertias(orientations.data() + begin, local_inverse_inertias.data() + begin,
+                              inverse_inertias.data() + begin, end - begin);
+}
+
+void BodyStore::apply_corrections(const uint32_t* bodies, size_t count, float dt) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t body = bodies[i];
+        positions[body] = positions[body] + correction_velocities[body] * dt;
+        integrate_orientations(&orientations[body], &correction_angular_velocities[body], &flags[body], 1, dt);
+        correction_velocities[body] = {0.0f, 0.0f, 0.0f};
+        correction_angular_velocities[body] = {0.0f, 0.0f, 0.0f};
+    }
+}
+
+void BodyStore::sleep(const uint32_t* bodies, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32_t body = bodies[i];
+        velocities[body] = {0.0f, 0.0f, 0.0f};
+        angular_velocities[body] = {0.0f, 0.0f, 0.0f};
+        flags[body] |= BODY_FLAG_SLEEPING;
+        sleep_links[body] = bodies[i + 1 < count ? i + 1 : 0];
+    }
+}
+
+void BodyStore::wake(uint32_t index) {
+    if (!is_sleeping(index)) return;
+    uint32_t body = index;
+    do {
+        uint32_t next = sleep_links[body];
+        flags[body] &= ~BODY_FLAG_SLEEPING;
+        sleep_times[body] = 0.0f;
+        sleep_links[body] = body;
+        body = next;
+    } while (body != index);
+}
+
+void BodyStore::clear() {
+    positions.clear();
+    velocities.clear();
+    accelerations.clear();
+    angular_velocities.clear();
+    correction_velocities.clear();
+    correction_angular_velocities.clear();
+    orientations.clear();
+    inverse_inertias.clear();
+    local_inverse_inertias.clear();
+    local_bounds.clear();
+    aabbs.clear();
+    inverse_masses.clear();
+    sleep_times.clear();
+    sleep_links.clear();
+    parents.clear();
+    flags.clear();
+    owners.clear();
+}
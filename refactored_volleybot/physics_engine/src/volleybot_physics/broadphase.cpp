@@ -0,0 +1,350 @@
+#include "volleybot_physics/broadphase.h"
+#include <algorithm>
+#include <cstring>
+
+// Orders endpoints by value. On ties, min endpoints come first so that
+// touching AABBs are still reported as a pair.
+static bool endpoint_less(float value_a, bool is_min_a, float value_b, bool is_min_b) {
+    if (value_a != value_b) return value_a < value_b;
+    return is_min_a && !is_min_b;
+}
+
+SweepAndPrune::SweepAndPrune() : proxy_count(0), sweep_axis(0) {}
+
+void SweepAndPrune::rebuild(const BodyStore& bodies, const std::vector<uint32_t>& proxies) {
+    proxy_count = proxies.size();
+
+    // Sweep along the axis where the AABB centers are spread out the most,
+    // since that axis separates the most bodies.
+    float mean[3] = {0, 0, 0};
+    float mean_sq[3] = {0, 0, 0};
+    for (uint32_t body : proxies) {
+        const AABB& box = bodies.aabbs[body];
+        for (int axis = 0; axis < 3; ++axis) {
+            float center = 0.5f * (vec3_component(box.min, axis) + vec3_component(box.max, axis));
+            mean[axis] += center;
+            mean_sq[axis] += center * center;
+        }
+    }
+    float best_variance = -1.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float n = proxy_count > 0 ? (float)proxy_count : 1.0f;
+        float variance = mean_sq[axis] / n - (mean[axis] / n) * (mean[axis] / n);
+        if (variance > best_variance) {
+            best_variance = variance;
+            sweep_axis = axis;
+        }
+    }
+
+    endpoints.resize(proxy_count * 2);
+    for (size_t i = 0; i < proxy_count; ++i) {
+        endpoints[2 * i] = {0.0f, (uint32_t)i, true};
+        endpoints[2 * i + 1] = {0.0f, (uint32_t)i, false};
+    }
+    update_endpoints(bodies, proxies);
+    std::sort(endpoints.begin(), endpoints.end(), [](const Endpoint& a, const Endpoint& b) {
+        return endpoint_less(a.value, a.is_min, b.value, b.is_min);
+    });
+
+    active.clear();
+    active.reserve(proxy_count);
+}
+
+void SweepAndPrune::update_endpoints(const BodyStore& bodies, const std::vector<uint32_t>& proxies) {
+    for (auto& endpoint : endpoints) {
+        const AABB& box = bodies.aabbs[proxies[endpoint.proxy]];
+        endpoint.value = vec3_component(endpoint.is_min ? box.min : box.max, sweep_axis);
+    }
+}
+
+void SweepAndPrune::insertion_sort() {
+    // Frame-to-frame coherence keeps the list nearly sorted, so each endpoint
+    // only moves a few slots and the whole pass is close to linear.
+    for (size_t i = 1; i < endpoints.size(); ++i) {
+        Endpoint key = endpoints[i];
+        size_t j = i;
+        while (j > 0 && endpoint_less(key.value, key.is_min, endpoints[j - 1].value, endpoints[j - 1].is_min)) {
+            endpoints[j] = endpoints[j - 1];
+            --j;
+        }
+        endpoints[j] = key;
+    }
+}
+
+void SweepAndPrune::find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies, std::vector<BroadphasePair>& out_pairs) {
+    out_pairs.clear();
+
+    if (proxies.size() != proxy_count) {
+        rebuild(bodies, proxies);
+    } else {
+        update_endpoints(bodies, proxies);
+        insertion_sort();
+    }
+    active_slot.resize(proxy_count);
+
+    active.clear();
+    for (const auto& endpoint : endpoints) {
+        uint32_t proxy = endpoint.proxy;
+        if (!endpoint.is_min) {
+            // Close the interval: swap-remove the proxy from the active list
+            uint32_t slot = active_slot[proxy];
+            uint32_t last = active.back();
+            active[slot] = last;
+            active_slot[last] = slot;
+            active.pop_back();
+            continue;
+        }
+
+        // The new interval overlaps every open one on the sweep axis, so only
+        // the full AABB test and the static filter remain.
+        uint32_t body = proxies[proxy];
+        const AABB& body_aabb = bodies.aabbs[body];
+        bool body_static = is_static_body(bodies, body);
+        for (uint32_t other_proxy : active) {
+            uint32_t other = proxies[other_proxy];
+            if (body_static && is_static_body(bodies, other)) continue;
+            if (!aabb_overlap(body_aabb, bodies.aabbs[other])) continue;
+            out_pairs.push_back({std::min(body, other), std::max(body, other)});
+        }
+
+        active_slot[proxy] = (uint32_t)active.size();
+        active.push_back(proxy);
+    }
+}
+
+// --- AABBTreeBroadphase --- //
+
+static Vec3 aabb_center(const AABB& box) {
+    Vec3 center;
+    vec3_add(&box.min, &box.max, &center);
+    vec3_scale(&center, 0.5f, &center);
+    return center;
+}
+
+AABBTreeBroadphase::AABBTreeBroadphase(float fat_margin)
+    : static_tree(0.0f), dynamic_tree(fat_margin) {}
+
+void AABBTreeBroadphase::find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxy_bodies, std::vector<BroadphasePair>& out_pairs) {
+    out_pairs.clear();
+    tight_aabbs.resize(proxy_bodies.size());
+
+    // Register bodies added since the last step
+    for (size_t k = proxies.size(); k < proxy_bodies.size(); ++k) {
+        uint32_t body = proxy_bodies[k];
+        const AABB& box = bodies.aabbs[body];
+        Proxy proxy;
+        proxy.body = body;
+        proxy.is_static = is_static_body(bodies, body);
+        proxy.last_center = aabb_center(box);
+        if (proxy.is_static) {
+            proxy.id = static_tree.create_proxy(box, (uint32_t)k);
+            static_proxies.push_back((uint32_t)k);
+        } else {
+            proxy.id = dynamic_tree.create_proxy(box, (uint32_t)k);
+            dynamic_proxies.push_back((uint32_t)k);
+        }
+        proxies.push_back(proxy);
+        tight_aabbs[k] = box;
+    }
+
+    // Static bodies only move when they are placed by hand, so only those whose bounds changed
+    // since the last step are refit. Their tree has no margin, so any move reinserts the leaf.
+    for (uint32_t k : static_proxies) {
+        Proxy& proxy = proxies[k];
+        const AABB& box = bodies.aabbs[proxy.body];
+        if (std::memcmp(&box, &tight_aabbs[k], sizeof(AABB)) == 0) continue;
+        Vec3 center = aabb_center(box);
+        Vec3 displacement;
+        vec3_sub(&center, &proxy.last_center, &displacement);
+        static_tree.move_proxy(proxy.id, box, displacement);
+        proxy.last_center = center;
+        tight_aabbs[k] = box;
+    }
+
+    // Refit the dynamic tree. move_proxy is a no-op while the body stays inside its fat AABB.
+    for (uint32_t k : dynamic_proxies) {
+        Proxy& proxy = proxies[k];
+        const AABB& box = bodies.aabbs[proxy.body];
+        Vec3 center = aabb_center(box);
+        Vec3 displacement;
+        vec3_sub(&center, &proxy.last_center, &displacement);
+        dynamic_tree.move_proxy(proxy.id, box, displacement);
+        proxy.last_center = center;
+        tight_aabbs[k] = box;
+    }
+
+    for (uint32_t k : dynamic_proxies) {
+        uint32_t body = proxies[k].body;
+        const AABB& box = tight_aabbs[k];
+
+        static_tree.query(box, [&](uint32_t other_proxy) {
+            if (aabb_overlap(box, tight_aabbs[other_proxy])) {
+                uint32_t other = proxies[other_proxy].body;
+                out_pairs.push_back({std::min(body, other), std::max(body, other)});
+            }
+            return true;
+        });
+
+        // Every dynamic pair is found from both sides; keep the one where k < other_proxy.
+        dynamic_tree.query(box, [&](uint32_t other_proxy) {
+            if (other_proxy > k && aabb_overlap(box, tight_aabbs[other_proxy])) {
+                uint32_t other = proxies[other_proxy].body;
+                out_pairs.push_back({std::min(body, other), std::max(body, other)});
+            }
+            return true;
+        });
+    }
+}
+
+void AABBTreeBroadphase::query_overlap(const AABB& aabb, std::vector<uint32_t>& out_bodies) const {
+    out_bodies.clear();
+    auto collect = [&](uint32_t proxy) {
+        if (aabb_overlap(aabb, tight_aabbs[proxy])) {
+            out_bodies.push_back(proxies[proxy].body);
+        }
+        return true;
+    };
+    static_tree.query(aabb, collect);
+    dynamic_tree.query(aabb, collect);
+}
+
+void AABBTreeBroadphase::raycast(const Vec3& origin, const Vec3& direction, float max_distance, std::vector<uint32_t>& out_bodies) const {
+    out_bodies.clear();
+    auto collect = [&](uint32_t proxy, float current_max) {
+        out_bodies.push_back(proxies[proxy].body);
+        return current_max;
+    };
+    static_tree.raycast(origin, direction, max_distance, collect);
+    dynamic_tree.raycast(origin, direction, max_distance, collect);
+}
+
+// --- SpatialHashGrid --- //
+
+SpatialHashGrid::SpatialHashGrid(float cell_size, int max_cells_per_body)
+    : cell_size(cell_size), max_cells_per_body(max_cells_per_body), bucket_mask(0) {}
+
+void SpatialHashGrid::choose_cell_size(const BodyStore& bodies, const std::vector<uint32_t>& proxies) {
+    // Twice the median of the bodies' largest AABB dimension puts a typical
+    // body in one to eight cells. The median ignores the few huge bodies.
+    std::vector<float> sizes;
+    sizes.reserve(proxies.size());
+    for (uint32_t body : proxies) {
+        const AABB& box = bodies.aabbs[body];
+        float size = fmaxf(box.max.x - box.min.x, fmaxf(box.max.y - box.min.y, box.max.z - box.min.z));
+        if (size > 0.0f) sizes.push_back(size);
+    }
+    if (sizes.empty()) return;
+    std::nth_element(sizes.begin(), sizes.begin() + sizes.size() / 2, sizes.end());
+    cell_size = 2.0f * sizes[sizes.size() / 2];
+}
+
+int32_t SpatialHashGrid::cell_coord(float value) const {
+    return (int32_t)floorf(value / cell_size);
+}
+
+uint32_t SpatialHashGrid::hash_cell(int32_t x, int32_t y, int32_t z) const {
+    uint32_t h = ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u);
+    return h & bucket_mask;
+}
+
+void SpatialHashGrid::find_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies, std::vector<BroadphasePair>& out_pairs) {
+    out_pairs.clear();
+    if (cell_size <= 0.0f) {
+        choose_cell_size(bodies, proxies);
+        if (cell_size <= 0.0f) return;
+    }
+
+    // 1. Bin every body into the cells its AABB covers
+    unsorted.clear();
+    overflow.clear();
+    in_overflow.assign(proxies.size(), 0);
+    for (uint32_t i = 0; i < (uint32_t)proxies.size(); ++i) {
+        const AABB& box = bodies.aabbs[proxies[i]];
+        int32_t x0 = cell_coord(box.min.x), x1 = cell_coord(box.max.x);
+        int32_t y0 = cell_coord(box.min.y), y1 = cell_coord(box.max.y);
+        int32_t z0 = cell_coord(box.min.z), z1 = cell_coord(box.max.z);
+        int64_t cell_count = (int64_t)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+        if (cell_count > max_cells_per_body) {
+            overflow.push_back(i);
+            in_overflow[i] = 1;
+            continue;
+        }
+        for (int32_t x = x0; x <= x1; ++x)
+            for (int32_t y = y0; y <= y1; ++y)
+                for (int32_t z = z0; z <= z1; ++z)
+                    unsorted.push_back({x, y, z, i});
+    }
+
+    // 2. Counting sort of the entries into a table of about twice as many buckets
+    uint32_t bucket_count = 16;
+    while (bucket_count < 2 * unsorted.size()) bucket_count <<= 1;
+    bucket_mask = bucket_count - 1;
+    bucket_start.assign(bucket_count + 1, 0);
+    for (const auto& entry : unsorted) {
+        ++bucket_start[hash_cell(entry.x, entry.y, entry.z) + 1];
+    }
+    for (uint32_t b = 0; b < bucket_count; ++b) {
+        bucket_start[b + 1] += bucket_start[b];
+    }
+    entries.resize(unsorted.size());
+    for (const auto& entry : unsorted) {
+        // bucket_start[b] is used as the write cursor and ends up at the start of bucket b + 1
+        entries[bucket_start[hash_cell(entry.x, entry.y, entry.z)]++] = entry;
+    }
+    // Shift the cursors back so bucket b spans [bucket_start[b], bucket_start[b + 1])
+    for (uint32_t b = bucket_count; b > 0; --b) {
+        bucket_start[b] = bucket_start[b - 1];
+    }
+    bucket_start[0] = 0;
+
+    // 3. Test bodies sharing a cell. A pair that shares several cells is only
+    // reported from the cell holding the min corner of the AABBs' intersection.
+    for (uint32_t b = 0; b < bucket_count; ++b) {
+        uint32_t begin = bucket_start[b], end = bucket_start[b + 1];
+        for (uint32_t i = begin; i < end; ++i) {
+            const CellEntry& e1 = entries[i];
+            for (uint32_t j = i + 1; j < end; ++j) {
+                const CellEntry& e2 = entries[j];
+                // Different cells can collide in the same bucket
+                if (e1.x != e2.x || e1.y != e2.y || e1.z != e2.z) continue;
+                uint32_t body1 = proxies[e1.proxy], body2 = proxies[e2.proxy];
+                if (is_static_body(bodies, body1) && is_static_body(bodies, body2)) continue;
+                const AABB& a = bodies.aabbs[body1];
+                const AABB& c = bodies.aabbs[body2];
+                if (!aabb_overlap(a, c)) continue;
+                if (cell_coord(fmaxf(a.min.x, c.min.x)) != e1.x ||
+                    cell_coord(fmaxf(a.min.y, c.min.y)) != e1.y ||
+                    cell_coord(fmaxf(a.min.z, c.min.z)) != e1.z) continue;
+                out_pairs.push_back({std::min(body1, body2), std::max(body1, body2)});
+            }
+        }
+    }
+
+    // 4. Oversized bodies are few, so they are tested against everything.
+    // Pairs of two overflow bodies are reported by the lower index.
+    for (uint32_t big_proxy : overflow) {
+        uint32_t big = proxies[big_proxy];
+        const AABB& big_aabb = bodies.aabbs[big];
+        bool big_static = is_static_body(bodies, big);
+        for (uint32_t k = 0; k < (uint32_t)proxies.size(); ++k) {
+            if (k == big_proxy) continue;
+            if (in_overflow[k] && k < big_proxy) continue;
+            uint32_t other = proxies[k];
+            if (big_static && is_static_body(bodies, other)) continue;
+            if (!aabb_overlap(big_aabb, bodies.aabbs[other])) continue;
+            out_pairs.push_back({std::min(big, other), std::max(big, other)});
+        }
+    }
+}
+
+std::unique_ptr<Broadphase> create_broadphase(BroadphaseType type) {
+    switch (type) {
+        case BroadphaseType::AABB_TREE:
+            return std::make_unique<AABBTreeBroadphase>();
+        case BroadphaseType::SPATIAL_HASH:
+            return std::make_unique<SpatialHashGrid>();
+        case BroadphaseType::SWEEP_AND_PRUNE:
+        default:
+            return std::make_unique<SweepAndPrune>();
+    }
+}
@@ -26,6 +26,11 @@ void Camera::attach_to(const Primitive* parent, Vec3 local_offset) {
     mat4_translate(local_offset, &this->local_transform);
 }
 
+void Camera::attach_to(const Primitive* parent, const Mat4& local_transform) {
+    this->parent_object = parent;
+    this->local_transform = local_transform;
+}
+
 void Camera::set_perspective(float fov_y_rad, float near_plane, float far_plane) {
     this->fov_y_rad = fov_y_rad;
     this->near_plane = near_plane;
@@ -40,7 +45,7 @@ void Camera::update_projection_matrix() {
 const Mat4& Camera::get_view_matrix() const {
     if (parent_object) {
         // Get the parent's latest world transform
-        const Mat4& parent_transform = parent_object->get_transform();
+        Mat4 parent_transform = parent_object->get_transform();
 
         // Calculate our final world transform
         Mat4 world_transform;
@@ -12,7 +12,16 @@ int CompositeObject::add_part(std::shared_ptr<Primitive> part, Vec3 local_positi
     Mat4 final_transform;
     mat4_multiply(&translation, &rotation, &final_transform);
 
-    parts.push_back({ std::move(part), final_transform });
+    Quat local_orientation;
+    quat_from_axis_angle(local_rotation_axis, local_rotation_angle_rad, &local_orientation);
+    quat_normalize(&local_orientation, &local_orientation); // A zero axis means no rotation
+
+    // Parts added after the object joined a scene need a slot in its store too
+    if (is_attached()) {
+        part->attach(get_store(), BODY_FLAG_CHILD);
+        get_store()->parents[part->get_body_index()] = get_body_index();
+    }
+    parts.push_back({ std::move(part), final_transform, local_orientation });
 
     // Recalculate the aggregate properties whenever a new part is added
     compute_mass_and_inertia();
@@ -41,6 +50,46 @@ void CompositeObject::add_revolute_joint(int part_id_a, int part_id_b, const Vec
     joints.push_back(std::make_unique<RevoluteJoint>(bodyA, bodyB, world_anchor, axis));
 }
 
+std::shared_ptr<Primitive> CompositeObject::clone() const {
+    auto copy = std::make_shared<CompositeObject>(material);
+    copy->copy_body_from(*this);
+    for (const auto& part : parts) {
+        copy->parts.push_back({part.primitive->clone(), part.local_transform, part.local_orientation});
+    }
+
+    // Reconnect each joint to the copies of the parts it connected
+    auto part_index = [this](const Primitive* primitive) {
+        for (size_t i = 0; i < parts.size(); ++i) {
+            if (parts[i].primitive.get() == primitive) return i;
+        }
+        return parts.size();
+    };
+    for (const auto& joint : joints) {
+        size_t index_a = part_index(joint->get_body_a());
+        size_t index_b = part_index(joint->get_body_b());
+        if (index_a == parts.size() || index_b == parts.size()) continue;
+        copy->joints.push_back(joint->clone(copy->parts[index_a].primitive.get(), copy->parts[index_b].primitive.get()));
+    }
+    return copy;
+}
+
+// R * I * R^T, with R the rotation of a part's transform
+static Mat4 rotate_inertia(const Mat4& transform, const Mat4& inertia) {
+    Mat4 rotated;
+    mat4_zero(&rotated);
+    // Column-major: m[column][row]
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            float sum = 0.0f;
+            for (int k = 0; k < 3; ++k) {
+                for (int l = 0; l < 3; ++l) sum += transform.m[k][i] * inertia.m[l][k] * transform.m[l][j];
+            }
+            rotated.m[j][i] = sum;
+        }
+    }
+    return rotated;
+}
+
 void CompositeObject::compute_mass_and_inertia() {
     // Calculate Total Mass and Combined Center of Mass
 
@@ -52,8 +101,8 @@ void CompositeObject::compute_mass_and_inertia() {
         float part_mass = part.primitive->get_material()->mass;
         total_mass += part_mass;
 
-        // Get the part's local position
-        Vec3 part_pos = mat4_transform_point(&part.local_transform, {0,0,0});
+        // The part's center of mass, which is off its origin for e.g. mesh parts
+        Vec3 part_pos = mat4_transform_point(&part.local_transform, part.primitive->get_center_of_mass());
         
         // Scale the position by the mass before adding it to the sum.
         Vec3 scaled_pos;
@@ -72,10 +121,10 @@ void CompositeObject::compute_mass_and_inertia() {
     mat4_zero(&total_inertia_tensor); // Use helper to initialize the matrix to zeros
 
     for (const auto& part : parts) {
-        // Get the inertia tensor of the part relative to its own center of mass
-        Mat4 part_inertia = part.primitive->get_inertia_tensor();
+        // Get the inertia tensor of the part relative to its own center of mass, turned into this object's axes
+        Mat4 part_inertia = rotate_inertia(part.local_transform, part.primitive->get_inertia_tensor());
         float part_mass = part.primitive->get_material()->mass;
-        Vec3 part_pos = mat4_transform_point(&part.local_transform, {0,0,0});
+        Vec3 part_pos = mat4_transform_point(&part.local_transform, part.primitive->get_center_of_mass());
 
         // Calculate the displacement vector 'd' from the composite CoM to the part's CoM
         Vec3 d;
@@ -110,11 +159,28 @@ void CompositeObject::compute_mass_and_inertia() {
     // Update Final Properties
     this->inertia_tensor = total_inertia_tensor;
     mat3_inverse(&this->inertia_tensor, &this->inverse_inertia_tensor);
+    update_mass_properties();
+}
+
+void CompositeObject::attach(BodyStore* target, uint8_t extra_flags) {
+    Primitive::attach(target, extra_flags | BODY_FLAG_COMPOSITE);
+    for (auto& part : parts) {
+        part.primitive->attach(target, BODY_FLAG_CHILD);
+        target->parents[part.primitive->get_body_index()] = get_body_index();
+    }
+}
+
+void CompositeObject::detach() {
+    for (auto& part : parts) {
+        part.primitive->detach();
+    }
+    Primitive::detach();
 }
 
 
 void CompositeObject::update_child_transforms() {
-    const Mat4& parent_transform = get_transform();
+    Mat4 parent_transform = get_transform();
+    Quat parent_orientation = get_orientation();
     for (auto& part : parts) {
         Mat4 child_world_transform;
         mat4_multiply(&parent_transform, &part.local_transform, &child_world_transform);
@@ -123,6 +189,11 @@ void CompositeObject::update_child_transforms() {
         // For now, we just place the children relative to the parent.
         Vec3 child_pos = mat4_transform_point(&child_world_transform, {0,0,0});
         part.primitive->set_position(child_pos);
+
+        // Parts turn with the parent, so the collision tests see tilted parts as tilted
+        Quat child_orientation;
+        quat_multiply(&parent_orientation, &part.local_orientation, &child_orientation);
+        part.primitive->set_orientation(child_orientation);
     }
 }
 
@@ -135,9 +206,20 @@ void CompositeObject::compute_aabb() {
     // and then transform them to world space to find the composite AABB.
     update_child_transforms();
 
-    bool first = true;
     for (const auto& part : parts) {
         part.primitive->compute_aabb();
+    }
+    merge_part_aabbs();
+}
+
+void CompositeObject::merge_part_aabbs() {
+    if (parts.empty()) {
+        return;
+    }
+
+    AABB& aabb = state_field(&BodyStore::aabbs, &BodyState::aabb);
+    bool first = true;
+    for (const auto& part : parts) {
         const AABB& child_aabb = part.primitive->get_aabb();
 
         if (first) {
@@ -0,0 +1,66 @@
+#include "volleybot_physics/contact_cache.h"
+#include <algorithm>
+
+bool ContactCache::key_less(const ContactKey& x, const ContactKey& y) {
+    if (x.a != y.a) return x.a < y.a;
+    if (x.b != y.b) return x.b < y.b;
+    return x.feature_id < y.feature_id;
+}
+
+bool ContactCache::find(const ContactKey& key, CachedImpulse* out_impulse) const {
+    auto it = std::lower_bound(entries.begin(), entries.end(), key, [](const Entry& entry, const ContactKey& k) {
+        return key_less(entry.key, k);
+    });
+    if (it == entries.end() || key_less(key, it->key)) {
+        return false;
+    }
+    *out_impulse = it->impulse;
+    return true;
+}
+
+void ContactCache::begin_update() {
+    entries.clear();
+}
+
+void ContactCache::add(const ContactKey& key, const CachedImpulse& impulse) {
+    entries.push_back({key, impulse});
+}
+
+void ContactCache::end_update() {
+    std::sort(entries.begin(), entries.end(), [](const Entry& x, const Entry& y) {
+        return key_less(x.key, y.key);
+    });
+}
+
+bool ConvexCache::entry_less(const Entry& x, const Entry& y) {
+    if (x.a != y.a) return x.a < y.a;
+    return x.b < y.b;
+}
+
+ConvexPairCache& ConvexCache::acquire(const Primitive* a, const Primitive* b) {
+    Entry entry = {a, b, {}};
+    auto it = std::lower_bound(previous.begin(), previous.end(), entry, entry_less);
+    if (it != previous.end() && !entry_less(entry, *it)) {
+        entry.pair = it->pair;
+    }
+    current.push_back(entry);
+    return current.back().pair;
+}
+
+void ConvexCache::begin_update() {
+    previous.swap(current);
+    current.clear();
+}
+
+void ConvexCache::end_update() {
+    std::sort(current.begin(), current.end(), entry_less);
+}
+
+void ConvexCache::clear() {
+    previous.clear();
+    current.clear();
+}
+
+void ConvexCache::add(const Primitive* a, const Primitive* b, const ConvexPairCache& pair) {
+    current.push_back({a, b, pair});
+}
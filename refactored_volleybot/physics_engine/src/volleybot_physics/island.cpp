@@ -0,0 +1,120 @@
+#include "volleybot_physics/island.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t no_island = UINT32_MAX;
+
+} // namespace
+
+uint32_t ConstraintIslands::find(uint32_t node) {
+    // Path halving: every other node on the way up is pointed at its grandparent
+    while (parents[node] != node) {
+        parents[node] = parents[parents[node]];
+        node = parents[node];
+    }
+    return node;
+}
+
+void ConstraintIslands::unite(uint32_t x, uint32_t y) {
+    x = find(x);
+    y = find(y);
+    // The lower root wins, so the forest depends only on the constraints and not on the order they are united in
+    if (x < y) parents[y] = x;
+    else if (y < x) parents[x] = y;
+}
+
+void ConstraintIslands::group(const std::vector<uint32_t>& island_of, std::vector<uint32_t>& order,
+                              std::vector<uint32_t>& counts) {
+    // A counting sort, stable so each island keeps its constraints in their original order
+    counts.assign(islands.size() + 1, 0);
+    for (uint32_t island : island_of) ++counts[island + 1];
+    for (size_t i = 1; i < counts.size(); ++i) counts[i] += counts[i - 1];
+    order.resize(island_of.size());
+    for (uint32_t i = 0; i < (uint32_t)island_of.size(); ++i) order[counts[island_of[i]]++] = i;
+}
+
+void ConstraintIslands::build(const BodyPair* contacts, size_t contact_count, const BodyPair* joints,
+                              size_t joint_count, const BodyPair* links, size_t link_count,
+                              const float* inverse_masses) {
+    // A scene's bodies are contiguous slots of the store, so the nodes are the slots from the lowest one touched
+    first_body = UINT32_MAX;
+    uint32_t last_body = 0;
+    auto extend = [&](const BodyPair& pair) {
+        first_body = std::min(first_body, std::min(pair.a, pair.b));
+        last_body = std::max(last_body, std::max(pair.a, pair.b));
+    };
+    for (size_t i = 0; i < contact_count; ++i) extend(contacts[i]);
+    for (size_t i = 0; i < joint_count; ++i) extend(joints[i]);
+    for (size_t i = 0; i < link_count; ++i) extend(links[i]);
+    size_t node_count = first_body <= last_body ? last_body - first_body + 1 : 0;
+
+    parents.resize(node_count);
+    for (uint32_t i = 0; i < (uint32_t)node_count; ++i) parents[i] = i;
+    touched.assign(node_count, 0);
+    auto connect = [&](const BodyPair& pair) {
+        bool dynamic_a = inverse_masses[pair.a] > 0.0f;
+        bool dynamic_b = inverse_masses[pair.b] > 0.0f;
+        if (dynamic_a) touched[pair.a - first_body] = 1;
+        if (dynamic_b) touched[pair.b - first_body] = 1;
+        // A static body's velocity is never written, so it links nothing
+        if (dynamic_a && dynamic_b) unite(pair.a - first_body, pair.b - first_body);
+    };
+    for (size_t i = 0; i < contact_count; ++i) connect(contacts[i]);
+    for (size_t i = 0; i < joint_count; ++i) connect(joints[i]);
+    for (size_t i = 0; i < link_count; ++i) connect(links[i]);
+
+    // A constraint belongs to the island of its dynamic body; one between two static bodies moves nothing and gets its own
+    islands.clear();
+    island_of_root.assign(node_count, no_island);
+    auto island_of = [&](const BodyPair& pair) {
+        uint32_t body = inverse_masses[pair.a] > 0.0f || inverse_masses[pair.b] <= 0.0f ? pair.a : pair.b;
+        uint32_t root = find(body - first_body);
+        if (island_of_root[root] == no_island) {
+            island_of_root[root] = (uint32_t)islands.size();
+            islands.push_back({0, 0, 0, 0, 0, 0});
+        }
+        return island_of_root[root];
+    };
+    contact_islands.resize(contact_count);
+    for (size_t i = 0; i < contact_count; ++i) contact_islands[i] = island_of(contacts[i]);
+    joint_islands.resize(joint_count);
+    for (size_t i = 0; i < joint_count; ++i) joint_islands[i] = island_of(joints[i]);
+    for (size_t i = 0; i < link_count; ++i) island_of(links[i]);
+
+    group(contact_islands, contact_order, contact_counts);
+    group(joint_islands, joint_order, joint_counts);
+
+    // The bodies are sorted by island like the constraints, visiting the nodes in slot order
+    body_counts.assign(islands.size() + 1, 0);
+    for (uint32_t node = 0; node < (uint32_t)node_count; ++node) {
+        if (touched[node]) ++body_counts[island_of_root[find(node)] + 1];
+    }
+    for (size_t i = 1; i < body_counts.size(); ++i) body_counts[i] += body_counts[i - 1];
+    bodies.resize(body_counts.back());
+    for (uint32_t node = 0; node < (uint32_t)node_count; ++node) {
+        if (touched[node]) bodies[body_counts[island_of_root[find(node)]]++] = first_body + node;
+    }
+
+    // After the sorts, counts[i] is the end of island i's range, which is the start of island i + 1's
+    for (size_t i = 0; i < islands.size(); ++i) {
+        Island& island = islands[i];
+        island.first_contact = i > 0 ? contact_counts[i - 1] : 0;
+        island.contact_count = contact_counts[i] - island.first_contact;
+        island.first_joint = i > 0 ? joint_counts[i - 1] : 0;
+        island.joint_count = joint_counts[i] - island.first_joint;
+        island.first_body = i > 0 ? body_counts[i - 1] : 0;
+        island.body_count = body_counts[i] - island.first_body;
+    }
+
+    batches.clear();
+    size_t batch_constraints = 0;
+    for (uint32_t i = 0; i < (uint32_t)islands.size(); ++i) {
+        if (batches.empty() || batch_constraints >= min_batch_constraints) {
+            batches.push_back({i, 0});
+            batch_constraints = 0;
+        }
+        ++batches.back().island_count;
+        batch_constraints += islands[i].contact_count + islands[i].joint_count;
+    }
+}
@@ -1,4 +1,5 @@
 #include "volleybot_physics/joint.h"
+#include "physics_core/simd_math.h"
 
 // --- Base Joint --- //
 Joint::Joint(Primitive* a, Primitive* b, JointType type)
@@ -7,133 +8,175 @@ Joint::Joint(Primitive* a, Primitive* b, JointType type)
 
 // --- Revolute Joint --- //
 RevoluteJoint::RevoluteJoint(Primitive* a, Primitive* b, const Vec3& world_anchor, const Vec3& axis)
-    : Joint(a, b, JointType::REVOLUTE), motor_axis(axis), motor_speed(0.0f), max_motor_force(0.0f) {
+    : Joint(a, b, JointType::REVOLUTE), motor_speed(0.0f), max_motor_force(0.0f) {
 
-    // Convert the world-space anchor point into the local space of each body.
+    // Convert the world-space anchor point and axis into the local space of each body.
     // This is crucial because the bodies will move, but their local anchor points remain constant.
+    Mat4 transform_a = a->get_transform();
+    Mat4 transform_b = b->get_transform();
     Mat4 inv_transform_a, inv_transform_b;
-    mat4_affine_inverse(&a->get_transform(), &inv_transform_a);
-    mat4_affine_inverse(&b->get_transform(), &inv_transform_b);
+    mat4_affine_inverse(&transform_a, &inv_transform_a);
+    mat4_affine_inverse(&transform_b, &inv_transform_b);
 
     this->local_anchor_a = mat4_transform_point(&inv_transform_a, world_anchor);
     this->local_anchor_b = mat4_transform_point(&inv_transform_b, world_anchor);
+
+    Vec3 unit_axis;
+    vec3_normalize(&axis, &unit_axis);
+    this->local_axis_a = mat4_transform_direction(&inv_transform_a, unit_axis);
+    this->local_axis_b = mat4_transform_direction(&inv_transform_b, unit_axis);
+}
+
+std::unique_ptr<Joint> RevoluteJoint::clone(Primitive* a, Primitive* b) const {
+    // The local anchors stay valid since the copies start in the same pose
+    auto copy = std::make_unique<RevoluteJoint>(*this);
+    copy->bodyA = a;
+    copy->bodyB = b;
+    return copy;
 }
 
 void RevoluteJoint::set_motor(float speed, float max_force) {
+    if (speed != motor_speed || max_force != max_motor_force) {
+        bodyA->wake_up();
+        bodyB->wake_up();
+    }
     motor_speed = speed;
     max_motor_force = max_force;
 }
 
+void RevoluteJoint::set_motor_speed(float speed) {
+    // Agents resend the same actions every step, which must not keep the robot awake
+    if (speed != motor_speed) {
+        bodyA->wake_up();
+        bodyB->wake_up();
+    }
+    motor_speed = speed;
+}
+
+Vec3 RevoluteJoint::get_axis() const {
+    Quat orientation_a = bodyA->get_orientation();
+    return quat_rotate(&orientation_a, this->local_axis_a);
+}
+
 float RevoluteJoint::get_relative_speed() const {
     Vec3 omega_a = bodyA->get_angular_velocity();
     Vec3 omega_b = bodyB->get_angular_velocity();
     Vec3 relative_omega;
     vec3_sub(&omega_b, &omega_a, &relative_omega);
-    return vec3_dot(&relative_omega, &this->motor_axis);
+    Vec3 axis = get_axis();
+    return vec3_dot(&relative_omega, &axis);
 }
 
 void RevoluteJoint::apply_constraint(float dt) {
-    // --- Part 1: Motor --- 
+    const Mat4& inv_inertia_a = bodyA->get_inverse_inertia_tensor();
+    const Mat4& inv_inertia_b = bodyB->get_inverse_inertia_tensor();
+    float inv_mass_a = bodyA->get_inverse_mass();
+    float inv_mass_b = bodyB->get_inverse_mass();
+    // A static body takes no impulse, whatever its inertia says
+    float share_a = inv_mass_a > 0.0f ? 1.0f : 0.0f;
+    float share_b = inv_mass_b > 0.0f ? 1.0f : 0.0f;
+
+    // The velocities stay in registers for the whole solve and are written back once at the end.
+    // Every impulse goes to B and its opposite to A, so each pushes B's velocity relative to A's.
+    Vec3 lin_vel_a = bodyA->get_velocity(), lin_vel_b = bodyB->get_velocity();
+    Vec3 ang_vel_a = bodyA->get_angular_velocity(), ang_vel_b = bodyB->get_angular_velocity();
+    Vec4 v_a = vec4_load3(&lin_vel_a), v_b = vec4_load3(&lin_vel_b);
+    Vec4 w_a = vec4_load3(&ang_vel_a), w_b = vec4_load3(&ang_vel_b);
+
+    // The bodies do not move during the solve, so neither do the anchors and axes
+    Mat4 transform_a = bodyA->get_transform();
+    Mat4 transform_b = bodyB->get_transform();
+    Vec3 local_com_a = bodyA->get_center_of_mass();
+    Vec3 local_com_b = bodyB->get_center_of_mass();
+    Vec4 world_anchor_a = mat4_simd_transform_point(&transform_a, vec4_load3(&this->local_anchor_a));
+    Vec4 world_anchor_b = mat4_simd_transform_point(&transform_b, vec4_load3(&this->local_anchor_b));
+    Vec4 r_a = vec4_sub(world_anchor_a, mat4_simd_transform_point(&transform_a, vec4_load3(&local_com_a)));
+    Vec4 r_b = vec4_sub(world_anchor_b, mat4_simd_transform_point(&transform_b, vec4_load3(&local_com_b)));
+    Vec4 axis_a = vec4_normalize3(mat4_simd_transform_direction(&transform_a, vec4_load3(&this->local_axis_a)));
+    Vec4 axis_b = vec4_normalize3(mat4_simd_transform_direction(&transform_b, vec4_load3(&this->local_axis_b)));
+
+    // --- Part 1: Motor ---
     if (this->max_motor_force > 0.0f) {
-        // Calculate effective mass for the angular motor
-        Vec3 inv_I_a_axis = mat4_transform_direction(&bodyA->get_inverse_inertia_tensor(), this->motor_axis);
-        Vec3 inv_I_b_axis = mat4_transform_direction(&bodyB->get_inverse_inertia_tensor(), this->motor_axis);
-        float effective_mass_angular = vec3_dot(&inv_I_a_axis, &this->motor_axis) + vec3_dot(&inv_I_b_axis, &this->motor_axis);
-
-        // Calculate the impulse to reach the target speed
-        float current_speed = get_relative_speed();
-        float speed_error = this->motor_speed - current_speed;
-        float impulse_magnitude = 0.0f;
-        if (effective_mass_angular < 1e-6f) {
-            impulse_magnitude = 0.0f;
-        } else {
-            impulse_magnitude = speed_error / effective_mass_angular;
+        Vec4 inv_I_a_axis = vec4_scale(mat4_simd_transform_direction(&inv_inertia_a, axis_a), share_a);
+        Vec4 inv_I_b_axis = vec4_scale(mat4_simd_transform_direction(&inv_inertia_b, axis_a), share_b);
+        float effective_mass_angular = vec4_dot3(inv_I_a_axis, axis_a) + vec4_dot3(inv_I_b_axis, axis_a);
+        if (effective_mass_angular >= 1e-6f) {
+            // The impulse to reach the target speed, clamped by the max force
+            float speed_error = this->motor_speed - vec4_dot3(vec4_sub(w_b, w_a), axis_a);
+            float max_impulse = this->max_motor_force * dt;
+            float impulse_magnitude = fmaxf(-max_impulse, fminf(speed_error / effective_mass_angular, max_impulse));
+            w_a = vec4_add_scaled(w_a, inv_I_a_axis, -impulse_magnitude);
+            w_b = vec4_add_scaled(w_b, inv_I_b_axis, impulse_magnitude);
         }
-
-        // Clamp by max force
-        float max_impulse = this->max_motor_force * dt;
-        impulse_magnitude = fmaxf(-max_impulse, fminf(impulse_magnitude, max_impulse));
-
-        // Apply the angular impulse
-        Vec3 angular_impulse;
-        vec3_scale(&this->motor_axis, impulse_magnitude, &angular_impulse);
-        bodyA->apply_angular_impulse(angular_impulse);
-        Vec3 negative_impulse;
-        vec3_negate(&angular_impulse, &negative_impulse);
-        bodyB->apply_angular_impulse(negative_impulse);
     }
 
     // --- Part 2: Hinge Constraint (Iterative Solver) ---
-    // This part ensures the anchor points on both bodies stick together.
-    // We solve this iteratively for each axis (x, y, z).
+    // The anchors must move together along x, y and z, and the bodies may only turn relative to each
+    // other about the axis, so the two directions across it are held too.
+    // Baumgarte stabilization steers a fraction of the drift of the anchors and axes back each step.
+    const float beta = 0.2f;
+    Vec4 anchor_bias = vec4_scale(vec4_sub(world_anchor_b, world_anchor_a), beta / dt);
+    Vec4 axis_bias = vec4_scale(vec4_cross3(axis_a, axis_b), beta / dt);
+
+    // Effective mass and angular response per direction depend only on r_a, r_b and the axis
+    Vec4 angular_a[3], angular_b[3];
+    float effective_mass[3];
+    for (int axis_idx = 0; axis_idx < 3; ++axis_idx) {
+        Vec4 normal = {axis_idx == 0 ? 1.0f : 0.0f, axis_idx == 1 ? 1.0f : 0.0f, axis_idx == 2 ? 1.0f : 0.0f, 0.0f};
+        Vec4 r_a_cross = vec4_cross3(r_a, normal);
+        Vec4 r_b_cross = vec4_cross3(r_b, normal);
+        angular_a[axis_idx] = vec4_scale(mat4_simd_transform_direction(&inv_inertia_a, r_a_cross), share_a);
+        angular_b[axis_idx] = vec4_scale(mat4_simd_transform_direction(&inv_inertia_b, r_b_cross), share_b);
+
+        float angular_component = vec4_dot3(angular_a[axis_idx], r_a_cross) + vec4_dot3(angular_b[axis_idx], r_b_cross);
+        effective_mass[axis_idx] = share_a * inv_mass_a + share_b * inv_mass_b + angular_component;
+    }
+
+    Vec4 helper = fabsf(axis_a.x) < 0.9f ? Vec4{1.0f, 0.0f, 0.0f, 0.0f} : Vec4{0.0f, 1.0f, 0.0f, 0.0f};
+    Vec4 across[2];
+    across[0] = vec4_normalize3(vec4_cross3(axis_a, helper));
+    across[1] = vec4_cross3(axis_a, across[0]);
+    Vec4 turn_a[2], turn_b[2];
+    float turn_mass[2];
+    for (int k = 0; k < 2; ++k) {
+        turn_a[k] = vec4_scale(mat4_simd_transform_direction(&inv_inertia_a, across[k]), share_a);
+        turn_b[k] = vec4_scale(mat4_simd_transform_direction(&inv_inertia_b, across[k]), share_b);
+        turn_mass[k] = vec4_dot3(turn_a[k], across[k]) + vec4_dot3(turn_b[k], across[k]);
+    }
+
     const int iterations = 8; // Number of solver iterations for stability
     for (int iter = 0; iter < iterations; ++iter) {
-        Vec3 world_anchor_a = mat4_transform_point(&bodyA->get_transform(), this->local_anchor_a);
-        Vec3 world_anchor_b = mat4_transform_point(&bodyB->get_transform(), this->local_anchor_b);
-
-        Vec3 r_a, r_b;
-        Vec3 bodyA_world_com = mat4_transform_point(&bodyA->get_transform(), bodyA->get_center_of_mass());
-        Vec3 bodyB_world_com = mat4_transform_point(&bodyB->get_transform(), bodyB->get_center_of_mass());
-        vec3_sub(&world_anchor_a, &bodyA_world_com, &r_a);
-        vec3_sub(&world_anchor_b, &bodyB_world_com, &r_b);
-
-        Vec3 v_a_angular, v_b_angular;
-        Vec3 ang_vel_a = bodyA->get_angular_velocity();
-        Vec3 ang_vel_b = bodyB->get_angular_velocity();
-        vec3_cross(&ang_vel_a, &r_a, &v_a_angular);
-        vec3_cross(&ang_vel_b, &r_b, &v_b_angular);
-        Vec3 v_a, v_b;
-        Vec3 lin_vel_a = bodyA->get_velocity();
-        Vec3 lin_vel_b = bodyB->get_velocity();
-        vec3_add(&lin_vel_a, &v_a_angular, &v_a);
-        vec3_add(&lin_vel_b, &v_b_angular, &v_b);
-
-        Vec3 relative_velocity;
-        vec3_sub(&v_b, &v_a, &relative_velocity);
-
-        // Positional correction (Baumgarte Stabilization)
-        Vec3 position_error;
-        vec3_sub(&world_anchor_b, &world_anchor_a, &position_error);
-        float beta = 0.2f; // Correction factor
-        float slop = 0.01f;
-        float correction_magnitude = fmaxf(0, vec3_length(&position_error) - slop);
-        Vec3 correction_velocity;
-        vec3_scale(&position_error, beta / dt * correction_magnitude, &correction_velocity);
-        
-        Vec3 total_velocity_error;
-        vec3_add(&relative_velocity, &correction_velocity, &total_velocity_error);
+        Vec4 relative_velocity = vec4_sub(vec4_add(v_b, vec4_cross3(w_b, r_b)), vec4_add(v_a, vec4_cross3(w_a, r_a)));
+        Vec4 total_velocity_error = vec4_add(relative_velocity, anchor_bias);
+        float errors[3] = {total_velocity_error.x, total_velocity_error.y, total_velocity_error.z};
 
         // Solve for impulse along each axis (x, y, z)
-        Vec3 normal_x = {1,0,0}; Vec3 normal_y = {0,1,0}; Vec3 normal_z = {0,0,1};
-        Vec3 normals[3] = {normal_x, normal_y, normal_z};
-
         for (int axis_idx = 0; axis_idx < 3; ++axis_idx) {
-            Vec3 normal = normals[axis_idx];
-            float current_relative_speed = vec3_dot(&total_velocity_error, &normal);
-
-            float inv_mass_a = bodyA->get_material()->mass > 0 ? 1.0f / bodyA->get_material()->mass : 0.0f;
-            float inv_mass_b = bodyB->get_material()->mass > 0 ? 1.0f / bodyB->get_material()->mass : 0.0f;
-
-            Vec3 r_a_cross_n, r_b_cross_n;
-            vec3_cross(&r_a, &normal, &r_a_cross_n);
-            vec3_cross(&r_b, &normal, &r_b_cross_n);
-
-            Vec3 I_inv_r_a_cross_n = mat4_transform_direction(&bodyA->get_inverse_inertia_tensor(), r_a_cross_n);
-            Vec3 I_inv_r_b_cross_n = mat4_transform_direction(&bodyB->get_inverse_inertia_tensor(), r_b_cross_n);
-
-            float angular_component = vec3_dot(&I_inv_r_a_cross_n, &r_a_cross_n) + vec3_dot(&I_inv_r_b_cross_n, &r_b_cross_n);
-            float effective_mass = inv_mass_a + inv_mass_b + angular_component;
-
-            if (effective_mass > 1e-6f) {
-                float impulse_magnitude = -current_relative_speed / effective_mass;
-                Vec3 impulse;
-                vec3_scale(&normal, impulse_magnitude, &impulse);
+            if (effective_mass[axis_idx] <= 1e-6f) continue;
+            float impulse_magnitude = -errors[axis_idx] / effective_mass[axis_idx];
+            (&v_a.x)[axis_idx] -= impulse_magnitude * share_a * inv_mass_a;
+            w_a = vec4_add_scaled(w_a, angular_a[axis_idx], -impulse_magnitude);
+            (&v_b.x)[axis_idx] += impulse_magnitude * share_b * inv_mass_b;
+            w_b = vec4_add_scaled(w_b, angular_b[axis_idx], impulse_magnitude);
+        }
 
-                bodyA->apply_impulse(impulse, world_anchor_a);
-                Vec3 negative_impulse;
-                vec3_negate(&impulse, &negative_impulse);
-                bodyB->apply_impulse(negative_impulse, world_anchor_b);
-            }
+        // Then the turning across the axis
+        for (int k = 0; k < 2; ++k) {
+            if (turn_mass[k] <= 1e-6f) continue;
+            float error = vec4_dot3(vec4_sub(w_b, w_a), across[k]) + vec4_dot3(axis_bias, across[k]);
+            float impulse_magnitude = -error / turn_mass[k];
+            w_a = vec4_add_scaled(w_a, turn_a[k], -impulse_magnitude);
+            w_b = vec4_add_scaled(w_b, turn_b[k], impulse_magnitude);
         }
     }
+
+    // A static body may be shared with other islands being solved at once, so it is not written back
+    if (inv_mass_a > 0.0f) {
+        bodyA->set_velocity(vec4_to_vec3(v_a));
+        bodyA->set_angular_velocity(vec4_to_vec3(w_a));
+    }
+    if (inv_mass_b > 0.0f) {
+        bodyB->set_velocity(vec4_to_vec3(v_b));
+        bodyB->set_angular_velocity(vec4_to_vec3(w_b));
+    }
 }
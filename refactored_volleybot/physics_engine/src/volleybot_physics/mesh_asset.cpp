@@ -0,0 +1,653 @@
+#include "volleybot_physics/mesh_asset.h"
+#include "volleybot_physics/quickhull.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define TINYOBJ_LOADER_C_IMPLEMENTATION
+#include "../tinyobj_loader_c.h"
+
+static const uint32_t cooked_mesh_magic = 0x4D434256; // "VBCM"
+static const uint32_t cooked_mesh_version = 3;
+
+// MassProperties without the padding of its Mat4
+struct CookedMassProperties {
+    float volume;
+    float center_of_mass[3];
+    float inertia[6];  // xx, yy, zz, xy, xz, yz
+};
+
+/**
+ * A cooked mesh file is this header followed by the vertices, normals, indices, BVH nodes, hull
+ * points and hull indices, each section starting on a 16 byte boundary. The arrays are used in
+ * place, so the struct sizes of the build that cooked the file are recorded and must match.
+ */
+struct CookedMeshHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertex_size;  // sizeof(Vec3)
+    uint32_t node_size;    // sizeof(BvhNode)
+    uint64_t vertex_count;
+    uint64_t triangle_count;
+    uint64_t node_count;
+    uint64_t hull_point_count;
+    uint64_t hull_triangle_count;
+    CookedMassProperties mass_properties;
+    CookedMassProperties hull_mass_properties;
+    uint32_t closed;
+    uint32_t padding;
+};
+
+static CookedMassProperties cook_mass_properties(const MassProperties& mass) {
+    const Mat4& inertia = mass.inertia;
+    return {mass.volume,
+            {mass.center_of_mass.x, mass.center_of_mass.y, mass.center_of_mass.z},
+            {inertia.m[0][0], inertia.m[1][1], inertia.m[2][2], inertia.m[0][1], inertia.m[0][2], inertia.m[1][2]}};
+}
+
+static MassProperties uncook_mass_properties(const CookedMassProperties& cooked) {
+    MassProperties mass;
+    mass.volume = cooked.volume;
+    mass.center_of_mass = {cooked.center_of_mass[0], cooked.center_of_mass[1], cooked.center_of_mass[2]};
+    mat4_zero(&mass.inertia);
+    mass.inertia.m[0][0] = cooked.inertia[0];
+    mass.inertia.m[1][1] = cooked.inertia[1];
+    mass.inertia.m[2][2] = cooked.inertia[2];
+    mass.inertia.m[0][1] = mass.inertia.m[1][0] = cooked.inertia[3];
+    mass.inertia.m[0][2] = mass.inertia.m[2][0] = cooked.inertia[4];
+    mass.inertia.m[1][2] = mass.inertia.m[2][1] = cooked.inertia[5];
+    return mass;
+}
+
+// Where each section of a cooked file starts, and the file's size
+struct CookedMeshLayout {
+    uint64_t vertices;
+    uint64_t normals;
+    uint64_t indices;
+    uint64_t nodes;
+    uint64_t hull_points;
+    uint64_t hull_indices;
+    uint64_t size;
+};
+
+static uint64_t align_section(uint64_t offset) {
+    return (offset + 15) & ~(uint64_t)15;
+}
+
+static CookedMeshLayout cooked_mesh_layout(const CookedMeshHeader& header) {
+    CookedMeshLayout layout;
+    layout.vertices = align_section(sizeof(CookedMeshHeader));
+    layout.normals = align_section(layout.vertices + header.vertex_count * sizeof(Vec3));
+    layout.indices = align_section(layout.normals + header.vertex_count * sizeof(Vec3));
+    layout.nodes = align_section(layout.indices + header.triangle_count * 3 * sizeof(unsigned int));
+    layout.hull_points = align_section(layout.nodes + header.node_count * sizeof(BvhNode));
+    layout.hull_indices = align_section(layout.hull_points + header.hull_point_count * sizeof(Vec3));
+    layout.size = layout.hull_indices + header.hull_triangle_count * 3 * sizeof(unsigned int);
+    return layout;
+}
+
+// True if each of the 'count' indices is below 'limit'
+static bool indices_below(const unsigned int* indices, size_t count, size_t limit) {
+    for (size_t i = 0; i < count; ++i) {
+        if (indices[i] >= limit) return false;
+    }
+    return true;
+}
+
+// Maps a whole file read-only, or returns nullptr
+static void* map_file(const std::string& path, size_t* size) {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+    LARGE_INTEGER file_size;
+    void* data = nullptr;
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping) {
+            // The view keeps the mapping alive once both handles are closed
+            data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)file_size.QuadPart;
+    }
+    CloseHandle(file);
+    return data;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat info;
+    void* data = nullptr;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED) data = nullptr;
+        *size = (size_t)info.st_size;
+    }
+    // The mapping outlives the descriptor
+    close(fd);
+    return data;
+#endif
+}
+
+static void unmap_file(void* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+// Tells a cooked file apart from an older one at the same path, which write_cooked replaces rather than overwrites
+struct FileStamp {
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    int64_t modified;
+
+    bool operator==(const FileStamp& other) const {
+        return device == other.device && inode == other.inode && size == other.size && modified == other.modified;
+    }
+};
+
+struct MappedMesh {
+    FileStamp stamp;
+    std::weak_ptr<MeshAsset> asset;
+};
+
+// Assets mapped from each path, so Scenes loading the same file share one mapping
+static std::mutex mapped_meshes_mutex;
+static std::unordered_map<std::string, MappedMesh> mapped_meshes;
+
+MeshAsset::~MeshAsset() {
+    if (mapping) unmap_file(mapping, mapping_size);
+}
+
+// Every vertex a triangle uses, once
+static std::vector<Vec3> distinct_used_vertices(const std::vector<Vec3>& vertices, const std::vector<unsigned int>& indices) {
+    std::vector<bool> used(vertices.size(), false);
+    for (unsigned int index : indices) used[index] = true;
+    std::vector<Vec3> points;
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        if (used[i]) points.push_back(vertices[i]);
+    }
+    auto less = [](const Vec3& a, const Vec3& b) {
+        return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.z < b.z);
+    };
+    auto equal = [](const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; };
+    std::sort(points.begin(), points.end(), less);
+    points.erase(std::unique(points.begin(), points.end(), equal), points.end());
+    return points;
+}
+
+MassProperties compute_mass_properties(const Vec3* vertices, const unsigned int* indices, size_t triangle_count) {
+    MassProperties result = {};
+    if (triangle_count == 0) return result;
+
+    // Tetrahedra from a corner of the mesh rather than the origin, which keeps meshes far from their origin precise
+    Vec3 apex = vertices[indices[0]];
+    double volume = 0.0;
+    double first[3] = {0.0, 0.0, 0.0};
+    double second[3][3] = {};
+    for (size_t t = 0; t < triangle_count; ++t) {
+        double p[3][3];
+        for (int k = 0; k < 3; ++k) {
+            const Vec3& v = vertices[indices[3 * t + k]];
+            p[k][0] = (double)v.x - apex.x;
+            p[k][1] = (double)v.y - apex.y;
+            p[k][2] = (double)v.z - apex.z;
+        }
+        // Six times the signed volume of the tetrahedron from the apex
+        double det = p[0][0] * (p[1][1] * p[2][2] - p[1][2] * p[2][1]) -
+                     p[0][1] * (p[1][0] * p[2][2] - p[1][2] * p[2][0]) +
+                     p[0][2] * (p[1][0] * p[2][1] - p[1][1] * p[2][0]);
+        volume += det / 6.0;
+        double sum[3];
+        for (int i = 0; i < 3; ++i) {
+            sum[i] = p[0][i] + p[1][i] + p[2][i];
+            first[i] += det * sum[i] / 24.0;
+        }
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                second[i][j] += det / 120.0 * (p[0][i] * p[0][j] + p[1][i] * p[1][j] + p[2][i] * p[2][j] + sum[i] * sum[j]);
+            }
+        }
+    }
+    // Inward winding gives everything the opposite sign
+    double sign = volume < 0.0 ? -1.0 : 1.0;
+    volume *= sign;
+    if (volume <= 0.0) return result;
+
+    double center[3];
+    for (int i = 0; i < 3; ++i) center[i] = sign * first[i] / volume;
+    // Second moments about the center of mass, then the inertia tensor from them
+    double moments[3][3];
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) moments[i][j] = sign * second[i][j] - volume * center[i] * center[j];
+    }
+    double trace = moments[0][0] + moments[1][1] + moments[2][2];
+    mat4_zero(&result.inertia);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) result.inertia.m[i][j] = (float)((i == j ? trace : 0.0) - moments[i][j]);
+    }
+    result.volume = (float)volume;
+    result.center_of_mass = {(float)(apex.x + center[0]), (float)(apex.y + center[1]), (float)(apex.z + center[2])};
+    return result;
+}
+
+// The normal of each vertex, averaged over the triangles around it by their area
+static std::vector<Vec3> vertex_normals(const std::vector<Vec3>& vertices, const std::vector<unsigned int>& indices) {
+    std::vector<Vec3> normals(vertices.size(), Vec3{0, 0, 0});
+    for (size_t i = 0; i + 3 <= indices.size(); i += 3) {
+        Vec3 e0, e1, face;
+        vec3_sub(&vertices[indices[i + 1]], &vertices[indices[i]], &e0);
+        vec3_sub(&vertices[indices[i + 2]], &vertices[indices[i]], &e1);
+        // Twice the triangle's area long
+        vec3_cross(&e0, &e1, &face);
+        for (int k = 0; k < 3; ++k) vec3_add(&normals[indices[i + k]], &face, &normals[indices[i + k]]);
+    }
+    for (Vec3& normal : normals) {
+        float length = vec3_length(&normal);
+        if (length > 0.0f) vec3_scale(&normal, 1.0f / length, &normal);
+    }
+    return normals;
+}
+
+// True if every edge is shared by exactly two triangles
+static bool is_closed_mesh(const std::vector<unsigned int>& indices) {
+    std::unordered_map<uint64_t, int> edges;
+    for (size_t i = 0; i + 3 <= indices.size(); i += 3) {
+        for (int k = 0; k < 3; ++k) {
+            uint64_t a = indices[i + k], b = indices[i + (k + 1) % 3];
+            ++edges[a < b ? (a << 32) | b : (b << 32) | a];
+        }
+    }
+    for (const auto& edge : edges) {
+        if (edge.second != 2) return false;
+    }
+    return !edges.empty();
+}
+
+std::shared_ptr<MeshAsset> MeshAsset::build(std::vector<Vec3> vertices, std::vector<unsigned int> indices) {
+    // Triangles pointing past the vertices, and a trailing partial triangle, are dropped
+    size_t kept = 0;
+    for (size_t i = 0; i + 3 <= indices.size(); i += 3) {
+        if (indices[i] < vertices.size() && indices[i + 1] < vertices.size() && indices[i + 2] < vertices.size()) {
+            std::copy(indices.begin() + i, indices.begin() + i + 3, indices.begin() + kept);
+            kept += 3;
+        }
+    }
+    indices.resize(kept);
+
+    std::shared_ptr<MeshAsset> asset(new MeshAsset());
+    size_t triangle_count = indices.size() / 3;
+    asset->node_storage.resize(mesh_bvh_max_nodes(triangle_count));
+    asset->node_storage.resize(mesh_bvh_build(vertices.data(), indices.data(), triangle_count, asset->node_storage.data()));
+    // A flat mesh has no hull to speak of, and keeps its points for support queries
+    std::vector<Vec3> used = distinct_used_vertices(vertices, indices);
+    HullMesh hull;
+    if (build_convex_hull(used.data(), used.size(), hull)) {
+        asset->hull_storage = std::move(hull.vertices);
+        asset->hull_index_storage = std::move(hull.indices);
+        asset->hull_mass_properties = compute_mass_properties(asset->hull_storage.data(), asset->hull_index_storage.data(),
+                                                              asset->hull_index_storage.size() / 3);
+    } else {
+        asset->hull_storage = std::move(used);
+    }
+    asset->normal_storage = vertex_normals(vertices, indices);
+    asset->mass_properties = compute_mass_properties(vertices.data(), indices.data(), triangle_count);
+    asset->closed = is_closed_mesh(indices);
+    asset->vertex_storage = std::move(vertices);
+    asset->index_storage = std::move(indices);
+
+    asset->vertices = asset->vertex_storage.data();
+    asset->vertex_count = asset->vertex_storage.size();
+    asset->normals = asset->normal_storage.data();
+    asset->indices = asset->index_storage.data();
+    asset->triangle_count = triangle_count;
+    asset->nodes = asset->node_storage.data();
+    asset->node_count = asset->node_storage.size();
+    asset->hull_points = asset->hull_storage.data();
+    asset->hull_point_count = asset->hull_storage.size();
+    asset->hull_indices = asset->hull_index_storage.data();
+    asset->hull_triangle_count = asset->hull_index_storage.size() / 3;
+    return asset;
+}
+
+// Hands tinyobj a whole file. The buffers live in 'context' until the parse is done.
+static void read_obj_file(void* context, const char* filename, int is_mtl, const char* obj_filename, char** buffer,
+                          size_t* length) {
+    (void)is_mtl;
+    (void)obj_filename;
+    *buffer = nullptr;
+    *length = 0;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) return;
+
+    // A deque keeps earlier buffers in place as the .mtl file is added after the .obj
+    auto* files = static_cast<std::deque<std::string>*>(context);
+    files->emplace_back(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    *buffer = &files->back()[0];
+    *length = files->back().size();
+}
+
+std::shared_ptr<MeshAsset> MeshAsset::load_obj(const std::string& path) {
+    tinyobj_attrib_t attrib;
+    tinyobj_shape_t* shapes = nullptr;
+    tinyobj_material_t* materials = nullptr;
+    size_t shape_count = 0, material_count = 0;
+    std::deque<std::string> files;
+    if (tinyobj_parse_obj(&attrib, &shapes, &shape_count, &materials, &material_count, path.c_str(), read_obj_file,
+                          &files, TINYOBJ_FLAG_TRIANGULATE) != TINYOBJ_SUCCESS) {
+        std::cerr << "Failed to load " << path << std::endl;
+        return nullptr;
+    }
+
+    std::vector<Vec3> vertices(attrib.num_vertices);
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = {attrib.vertices[3 * i], attrib.vertices[3 * i + 1], attrib.vertices[3 * i + 2]};
+    }
+
+    // Faces the triangulation left with more corners are split into fans
+    std::vector<unsigned int> indices;
+    size_t corner = 0;
+    for (unsigned int face = 0; face < attrib.num_face_num_verts; ++face) {
+        int corner_count = attrib.face_num_verts[face];
+        for (int k = 1; k + 1 < corner_count; ++k) {
+            int triangle[3] = {attrib.faces[corner].v_idx, attrib.faces[corner + k].v_idx, attrib.faces[corner + k + 1].v_idx};
+            bool valid = true;
+            for (int v : triangle) {
+                valid = valid && v >= 0 && (size_t)v < vertices.size();
+            }
+            if (valid) {
+                indices.insert(indices.end(), {(unsigned int)triangle[0], (unsigned int)triangle[1], (unsigned int)triangle[2]});
+            }
+        }
+        corner += corner_count;
+    }
+
+    tinyobj_attrib_free(&attrib);
+    tinyobj_shapes_free(shapes, shape_count);
+    tinyobj_materials_free(materials, material_count);
+    if (indices.empty()) {
+        std::cerr << "No faces in " << path << std::endl;
+        return nullptr;
+    }
+    return build(std::move(vertices), std::move(indices));
+}
+
+/**
+ * Merges corners closer than 'distance' into one vertex. A hash grid of cells 'distance' wide
+ * finds the candidates, as any corner's twin is in the corner's cell or one of the 26 around it.
+ * @return The vertex of each corner.
+ */
+static std::vector<unsigned int> weld_corners(const std::vector<Vec3>& corners, float distance, std::vector<Vec3>& vertices) {
+    // Coordinates wrap at 21 bits, which only makes far apart cells share a bucket
+    auto cell_key = [](int64_t x, int64_t y, int64_t z) {
+        return ((uint64_t)x & 0x1FFFFF) | (((uint64_t)y & 0x1FFFFF) << 21) | (((uint64_t)z & 0x1FFFFF) << 42);
+    };
+    std::unordered_map<uint64_t, std::vector<unsigned int>> cells;
+    std::vector<unsigned int> welded(corners.size());
+    float inverse_size = 1.0f / distance;
+    float distance_sq = distance * distance;
+    for (size_t i = 0; i < corners.size(); ++i) {
+        const Vec3& p = corners[i];
+        int64_t cx = (int64_t)std::floor(p.x * inverse_size);
+        int64_t cy = (int64_t)std::floor(p.y * inverse_size);
+        int64_t cz = (int64_t)std::floor(p.z * inverse_size);
+        bool found = false;
+        for (int64_t dx = -1; dx <= 1 && !found; ++dx) {
+            for (int64_t dy = -1; dy <= 1 && !found; ++dy) {
+                for (int64_t dz = -1; dz <= 1 && !found; ++dz) {
+                    auto cell = cells.find(cell_key(cx + dx, cy + dy, cz + dz));
+                    if (cell == cells.end()) continue;
+                    for (unsigned int v : cell->second) {
+                        Vec3 offset;
+                        vec3_sub(&vertices[v], &p, &offset);
+                        if (vec3_length_sq(&offset) <= distance_sq) {
+                            welded[i] = v;
+                            found = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if (!found) {
+            welded[i] = (unsigned int)vertices.size();
+            cells[cell_key(cx, cy, cz)].push_back(welded[i]);
+            vertices.push_back(p);
+        }
+    }
+    return welded;
+}
+
+// Corners of an ASCII STL file: the three numbers after each 'vertex' keyword
+static bool read_ascii_stl(const std::string& text, std::vector<Vec3>& corners) {
+    const char* cursor = text.c_str();
+    while ((cursor = std::strstr(cursor, "vertex")) != nullptr) {
+        bool keyword = (cursor == text.c_str() || std::isspace((unsigned char)cursor[-1])) && std::isspace((unsigned char)cursor[6]);
+        cursor += 6;
+        if (!keyword) continue;
+        float xyz[3];
+        for (float& value : xyz) {
+            char* end;
+            value = std::strtof(cursor, &end);
+            if (end == cursor) return false;
+            cursor = end;
+        }
+        corners.push_back({xyz[0], xyz[1], xyz[2]});
+    }
+    return corners.size() % 3 == 0;
+}
+
+std::shared_ptr<MeshAsset> MeshAsset::load_stl(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to load " << path << std::endl;
+        return nullptr;
+    }
+    std::string contents((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Binary files are an 80 byte header, a triangle count and 50 bytes per triangle. Some of them start
+    // with 'solid' like ASCII files do, so the size decides.
+    std::vector<Vec3> corners;
+    uint32_t binary_count = 0;
+    if (contents.size() >= 84) std::memcpy(&binary_count, contents.data() + 80, sizeof(binary_count));
+    if (contents.size() >= 84 && contents.size() == 84 + 50 * (uint64_t)binary_count) {
+        corners.resize(3 * (size_t)binary_count);
+        for (size_t t = 0; t < binary_count; ++t) {
+            // Each triangle is its normal, its three corners and two attribute bytes; the normal is recomputed
+            std::memcpy(&corners[3 * t], contents.data() + 84 + 50 * t + 12, 3 * sizeof(Vec3));
+        }
+    } else {
+        size_t start = contents.find_first_not_of(" \t\r\n");
+        if (start == std::string::npos || contents.compare(start, 5, "solid") != 0 || !read_ascii_stl(contents, corners)) {
+            std::cerr << "Not an STL file: " << path << std::endl;
+            return nullptr;
+        }
+    }
+
+    AABB bounds = {{INFINITY, INFINITY, INFINITY}, {-INFINITY, -INFINITY, -INFINITY}};
+    for (const Vec3& p : corners) {
+        bounds.min = {std::min(bounds.min.x, p.x), std::min(bounds.min.y, p.y), std::min(bounds.min.z, p.z)};
+        bounds.max = {std::max(bounds.max.x, p.x), std::max(bounds.max.y, p.y), std::max(bounds.max.z, p.z)};
+    }
+    Vec3 diagonal;
+    vec3_sub(&bounds.max, &bounds.min, &diagonal);
+    float weld_distance = 1e-6f * vec3_length(&diagonal);
+    std::vector<Vec3> vertices;
+    std::vector<unsigned int> welded = weld_corners(corners, weld_distance > 0.0f ? weld_distance : 1.0f, vertices);
+
+    std::vector<unsigned int> indices;
+    for (size_t i = 0; i + 3 <= welded.size(); i += 3) {
+        if (welded[i] != welded[i + 1] && welded[i + 1] != welded[i + 2] && welded[i] != welded[i + 2]) {
+            indices.insert(indices.end(), {welded[i], welded[i + 1], welded[i + 2]});
+        }
+    }
+    if (indices.empty()) {
+        std::cerr << "No faces in " << path << std::endl;
+        return nullptr;
+    }
+    return build(std::move(vertices), std::move(indices));
+}
+
+std::shared_ptr<MeshAsset> MeshAsset::load_cooked(const std::string& path) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        std::cerr << "Failed to load " << path << std::endl;
+        return nullptr;
+    }
+    FileStamp stamp = {(uint64_t)info.st_dev, (uint64_t)info.st_ino, (uint64_t)info.st_size, (int64_t)info.st_mtime};
+
+    std::lock_guard<std::mutex> lock(mapped_meshes_mutex);
+    auto found = mapped_meshes.find(path);
+    if (found != mapped_meshes.end() && found->second.stamp == stamp) {
+        if (auto asset = found->second.asset.lock()) return asset;
+    }
+
+    size_t size = 0;
+    void* data = map_file(path, &size);
+    if (!data) {
+        std::cerr << "Failed to map " << path << std::endl;
+        return nullptr;
+    }
+    // Owns the mapping from here on, so a rejected file is unmapped too
+    std::shared_ptr<MeshAsset> asset(new MeshAsset());
+    asset->mapping = data;
+    asset->mapping_size = size;
+
+    CookedMeshHeader header;
+    if (size < sizeof(header)) {
+        std::cerr << "Not a cooked mesh: " << path << std::endl;
+        return nullptr;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    // Counts beyond the file's size would overflow the layout's arithmetic
+    bool counts_fit = header.vertex_count <= size && header.triangle_count <= size && header.node_count <= size &&
+                      header.hull_point_count <= size && header.hull_triangle_count <= size;
+    if (header.magic != cooked_mesh_magic || header.version != cooked_mesh_version ||
+        header.vertex_size != sizeof(Vec3) || header.node_size != sizeof(BvhNode) || !counts_fit ||
+        cooked_mesh_layout(header).size != size) {
+        std::cerr << "Not a cooked mesh of this version: " << path << std::endl;
+        return nullptr;
+    }
+
+    CookedMeshLayout layout = cooked_mesh_layout(header);
+    const uint8_t* base = static_cast<const uint8_t*>(data);
+    asset->vertices = reinterpret_cast<const Vec3*>(base + layout.vertices);
+    asset->vertex_count = (size_t)header.vertex_count;
+    asset->normals = reinterpret_cast<const Vec3*>(base + layout.normals);
+    asset->indices = reinterpret_cast<const unsigned int*>(base + layout.indices);
+    asset->triangle_count = (size_t)header.triangle_count;
+    asset->nodes = reinterpret_cast<const BvhNode*>(base + layout.nodes);
+    asset->node_count = (size_t)header.node_count;
+    asset->hull_points = reinterpret_cast<const Vec3*>(base + layout.hull_points);
+    asset->hull_point_count = (size_t)header.hull_point_count;
+    asset->hull_indices = reinterpret_cast<const unsigned int*>(base + layout.hull_indices);
+    asset->hull_triangle_count = (size_t)header.hull_triangle_count;
+    asset->mass_properties = uncook_mass_properties(header.mass_properties);
+    asset->hull_mass_properties = uncook_mass_properties(header.hull_mass_properties);
+    asset->closed = header.closed != 0;
+
+    // The queries index the arrays with what the file holds, so a damaged file must not get that far
+    MeshShape shape = asset->get_shape();
+    if (!indices_below(asset->indices, 3 * asset->triangle_count, asset->vertex_count) ||
+        !indices_below(asset->hull_indices, 3 * asset->hull_triangle_count, asset->hull_point_count) ||
+        !mesh_bvh_is_valid(&shape)) {
+        std::cerr << "Corrupt cooked mesh: " << path << std::endl;
+        return nullptr;
+    }
+
+    mapped_meshes[path] = {stamp, asset};
+    return asset;
+}
+
+// Writes 'count' elements at 'offset', padding with zeros from where the file is
+template <typename T>
+static void write_section(std::ofstream& file, uint64_t& position, uint64_t offset, const T* values, size_t count) {
+    static const char zeros[16] = {};
+    file.write(zeros, (std::streamsize)(offset - position));
+    file.write(reinterpret_cast<const char*>(values), (std::streamsize)(count * sizeof(T)));
+    position = offset + count * sizeof(T);
+}
+
+bool MeshAsset::write_cooked(const std::string& path) const {
+    CookedMeshHeader header = {cooked_mesh_magic, cooked_mesh_version, (uint32_t)sizeof(Vec3), (uint32_t)sizeof(BvhNode),
+                               vertex_count, triangle_count, node_count, hull_point_count, hull_triangle_count,
+                               cook_mass_properties(mass_properties), cook_mass_properties(hull_mass_properties),
+                               closed ? 1u : 0u, 0};
+    CookedMeshLayout layout = cooked_mesh_layout(header);
+
+    std::string temp_path = path + ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+        uint64_t position = 0;
+        write_section(file, position, 0, &header, 1);
+        write_section(file, position, layout.vertices, vertices, vertex_count);
+        write_section(file, position, layout.normals, normals, vertex_count);
+        write_section(file, position, layout.indices, indices, 3 * triangle_count);
+        write_section(file, position, layout.nodes, nodes, node_count);
+        write_section(file, position, layout.hull_points, hull_points, hull_point_count);
+        write_section(file, position, layout.hull_indices, hull_indices, 3 * hull_triangle_count);
+        file.close();
+        if (!file) {
+            std::cerr << "Failed to write " << temp_path << std::endl;
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    bool renamed = MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    bool renamed = std::rename(temp_path.c_str(), path.c_str()) == 0;
+#endif
+    if (!renamed) {
+        std::cerr << "Failed to write " << path << std::endl;
+        std::remove(temp_path.c_str());
+    }
+    return renamed;
+}
+
+std::shared_ptr<MeshAsset> MeshAsset::load(const std::string& path) {
+    std::string extension = path.substr(std::min(path.size(), path.rfind('.')));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    if (extension == ".obj") {
+        return load_obj(path);
+    }
+    if (extension == ".stl") {
+        return load_stl(path);
+    }
+    std::cerr << "Unknown mesh format: " << path << std::endl;
+    return nullptr;
+}
+
+bool MeshAsset::cook(const std::string& source_path, const std::string& cooked_path) {
+    std::shared_ptr<MeshAsset> asset = load(source_path);
+    return asset && asset->write_cooked(cooked_path);
+}
+
+AABB MeshAsset::get_bounds() const {
+    return node_count > 0 ? nodes[0].bounds : AABB{{0, 0, 0}, {0, 0, 0}};
+}
@@ -0,0 +1,1041 @@
+#include "volleybot_physics/mjcf_model.h"
+#include "volleybot_physics/scene.h"
+#include "volleybot_physics/composite_object.h"
+#include "volleybot_physics/joint.h"
+#include "volleybot_physics/light.h"
+#include "volleybot_physics/mesh_asset.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const float pi = 3.14159265358979f;
+
+// --- XML --- //
+
+struct XmlElement {
+    std::string tag;
+    std::vector<std::pair<std::string, std::string>> attributes;
+    std::vector<XmlElement> children;
+
+    const char* get(const char* name) const {
+        for (const auto& attribute : attributes) {
+            if (attribute.first == name) return attribute.second.c_str();
+        }
+        return nullptr;
+    }
+};
+
+// Reads the element tree of an XML document. Text, comments, CDATA and processing instructions are skipped.
+class XmlReader {
+public:
+    XmlReader(const std::string& text, const std::string& path) : text(text), path(path), pos(0) {}
+
+    bool read(XmlElement& root) {
+        if (!skip_misc()) return false;
+        if (pos >= text.size() || text[pos] != '<') return fail("expected the root element");
+        if (!read_element(root, 0)) return false;
+        if (!skip_misc()) return false;
+        if (pos < text.size()) return fail("unexpected content after the root element");
+        return true;
+    }
+
+private:
+    // Elements nested deeper than this are taken for a broken file rather than recursed into
+    static constexpr int max_depth = 256;
+
+    bool fail(const std::string& message) const {
+        int line = 1 + (int)std::count(text.begin(), text.begin() + std::min(pos, text.size()), '\n');
+        std::cerr << path << ":" << line << ": " << message << std::endl;
+        return false;
+    }
+
+    bool at(const char* token) const { return text.compare(pos, std::strlen(token), token) == 0; }
+
+    void skip_space() {
+        while (pos < text.size() && std::isspace((unsigned char)text[pos])) ++pos;
+    }
+
+    // Skips to just past 'terminator'
+    bool skip_past(const char* terminator) {
+        size_t end = text.find(terminator, pos);
+        if (end == std::string::npos) return fail(std::string("missing '") + terminator + "'");
+        pos = end + std::strlen(terminator);
+        return true;
+    }
+
+    // Skips whitespace, comments, processing instructions and declarations between elements
+    bool skip_misc() {
+        for (;;) {
+            skip_space();
+            if (at("<!--")) {
+                if (!skip_past("-->")) return false;
+            } else if (at("<![CDATA[")) {
+                if (!skip_past("]]>")) return false;
+            } else if (at("<?")) {
+                if (!skip_past("?>")) return false;
+            } else if (at("<!")) {
+                if (!skip_past(">")) return false;
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool read_name(std::string& name) {
+        size_t start = pos;
+        while (pos < text.size() && (std::isalnum((unsigned char)text[pos]) || std::strchr("_-:.", text[pos]))) ++pos;
+        if (pos == start) return fail("expected a name");
+        name.assign(text, start, pos - start);
+        return true;
+    }
+
+    // Reads a quoted attribute value, replacing the predefined and numeric character references
+    bool read_value(std::string& value) {
+        char quote = pos < text.size() ? text[pos] : '\0';
+        if (quote != '"' && quote != '\'') return fail("expected a quoted attribute value");
+        size_t end = text.find(quote, ++pos);
+        if (end == std::string::npos) return fail("unterminated attribute value");
+        value.clear();
+        while (pos < end) {
+            if (text[pos] != '&') {
+                value += text[pos++];
+                continue;
+            }
+            size_t semicolon = text.find(';', pos);
+            if (semicolon == std::string::npos || semicolon > end) return fail("unterminated character reference");
+            std::string entity = text.substr(pos + 1, semicolon - pos - 1);
+            if (entity == "lt") value += '<';
+            else if (entity == "gt") value += '>';
+            else if (entity == "amp") value += '&';
+            else if (entity == "quot") value += '"';
+            else if (entity == "apos") value += '\'';
+            else if (entity.size() > 1 && entity[0] == '#') {
+                long code = entity[1] == 'x' ? std::strtol(entity.c_str() + 2, nullptr, 16) : std::strtol(entity.c_str() + 1, nullptr, 10);
+                if (code <= 0 || code > 127) return fail("unsupported character reference &" + entity + ";");
+                value += (char)code;
+            } else {
+                return fail("unknown entity &" + entity + ";");
+            }
+            pos = semicolon + 1;
+        }
+        pos = end + 1;
+        return true;
+    }
+
+    bool read_element(XmlElement& element, int depth) {
+        if (depth > max_depth) return fail("elements nested too deeply");
+        ++pos; // '<'
+        if (!read_name(element.tag)) return false;
+        for (;;) {
+            skip_space();
+            if (at("/>")) {
+                pos += 2;
+                return true;
+            }
+            if (at(">")) {
+                ++pos;
+                break;
+            }
+            std::pair<std::string, std::string> attribute;
+            if (!read_name(attribute.first)) return false;
+            skip_space();
+            if (!at("=")) return fail("expected '=' after " + attribute.first);
+            ++pos;
+            skip_space();
+            if (!read_value(attribute.second)) return false;
+            element.attributes.push_back(std::move(attribute));
+        }
+
+        for (;;) {
+            pos = text.find('<', pos); // Skips the text between elements
+            if (pos == std::string::npos) {
+                pos = text.size();
+                return fail("<" + element.tag + "> is not closed");
+            }
+            if (at("</")) {
+                pos += 2;
+                std::string name;
+                if (!read_name(name)) return false;
+                if (name != element.tag) return fail("</" + name + "> closes <" + element.tag + ">");
+                skip_space();
+                if (!at(">")) return fail("expected '>'");
+                ++pos;
+                return true;
+            }
+            if (at("<!") || at("<?")) {
+                if (!skip_misc()) return false;
+                continue;
+            }
+            element.children.emplace_back();
+            if (!read_element(element.children.back(), depth + 1)) return false;
+        }
+    }
+
+    const std::string& text;
+    const std::string& path;
+    size_t pos;
+};
+
+bool read_xml_file(const std::string& path, XmlElement& root) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "Failed to load " << path << std::endl;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+    return XmlReader(text, path).read(root);
+}
+
+// The directory part of a path, with its trailing separator
+std::string directory_of(const std::string& path) {
+    size_t separator = path.find_last_of("/\\");
+    return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+}
+
+std::string resolve_path(const std::string& directory, const std::string& file) {
+    bool absolute = !file.empty() && (file[0] == '/' || file[0] == '\\' || (file.size() > 1 && file[1] == ':'));
+    return absolute ? file : directory + file;
+}
+
+// Replaces each <include file> below 'element' by the children of the included file's root, recursively
+bool expand_includes(XmlElement& element, const std::string& directory, int depth) {
+    if (depth > 32) {
+        std::cerr << "MJCF includes nested too deeply, or including each other" << std::endl;
+        return false;
+    }
+    std::vector<XmlElement> expanded;
+    for (auto& child : element.children) {
+        if (child.tag != "include") {
+            if (!expand_includes(child, directory, depth)) return false;
+            expanded.push_back(std::move(child));
+            continue;
+        }
+        const char* file = child.get("file");
+        XmlElement included;
+        if (!file) {
+            std::cerr << "MJCF <include> without a file" << std::endl;
+            return false;
+        }
+        if (!read_xml_file(resolve_path(directory, file), included) || !expand_includes(included, directory, depth + 1)) {
+            return false;
+        }
+        for (auto& grandchild : included.children) expanded.push_back(std::move(grandchild));
+    }
+    element.children = std::move(expanded);
+    return true;
+}
+
+// --- Attributes --- //
+
+// Reads up to 'count' numbers of an attribute and returns how many there were, 0 if it is missing
+int read_floats(const XmlElement& element, const char* name, float* values, int count) {
+    const char* text = element.get(name);
+    if (!text) return 0;
+    int read = 0;
+    while (read < count) {
+        char* end;
+        float value = std::strtof(text, &end);
+        if (end == text) break;
+        values[read++] = value;
+        text = end;
+    }
+    return read;
+}
+
+float read_float(const XmlElement& element, const char* name, float fallback) {
+    float value;
+    return read_floats(element, name, &value, 1) == 1 ? value : fallback;
+}
+
+Vec3 read_vec3(const XmlElement& element, const char* name, Vec3 fallback) {
+    float values[3];
+    return read_floats(element, name, values, 3) == 3 ? Vec3{values[0], values[1], values[2]} : fallback;
+}
+
+// "true" or "false", or 'fallback' for anything else, e.g. "auto"
+bool read_bool(const XmlElement& element, const char* name, bool fallback) {
+    const char* text = element.get(name);
+    if (text && std::strcmp(text, "true") == 0) return true;
+    if (text && std::strcmp(text, "false") == 0) return false;
+    return fallback;
+}
+
+std::string read_string(const XmlElement& element, const char* name) {
+    const char* text = element.get(name);
+    return text ? text : "";
+}
+
+// An element for messages, e.g. "hinge joint 'rear'"
+std::string describe(const std::string& kind, const std::string& name) {
+    return name.empty() ? "unnamed " + kind : kind + " '" + name + "'";
+}
+
+// --- Frames --- //
+
+struct Pose {
+    Vec3 position;
+    Quat orientation;
+};
+
+const Pose identity_pose = {{0, 0, 0}, {0, 0, 0, 1}};
+
+Quat conjugate(const Quat& q) { return {-q.x, -q.y, -q.z, q.w}; }
+
+// The pose of 'child', given in the frame of 'parent', in the frame 'parent' is given in
+Pose compose(const Pose& parent, const Pose& child) {
+    Pose result;
+    Vec3 offset = quat_rotate(&parent.orientation, child.position);
+    vec3_add(&parent.position, &offset, &result.position);
+    quat_multiply(&parent.orientation, &child.orientation, &result.orientation);
+    quat_normalize(&result.orientation, &result.orientation);
+    return result;
+}
+
+Pose inverse(const Pose& pose) {
+    Pose result;
+    result.orientation = conjugate(pose.orientation);
+    Vec3 offset = quat_rotate(&result.orientation, pose.position);
+    vec3_negate(&offset, &result.position);
+    return result;
+}
+
+Vec3 transform_point(const Pose& pose, Vec3 point) {
+    Vec3 rotated = quat_rotate(&pose.orientation, point), result;
+    vec3_add(&rotated, &pose.position, &result);
+    return result;
+}
+
+// The rotation taking the unit axes to the columns x, y and z of a rotation matrix
+Quat quat_from_axes(const Vec3& x, const Vec3& y, const Vec3& z) {
+    float trace = x.x + y.y + z.z;
+    Quat q;
+    if (trace > 0.0f) {
+        float s = 2.0f * std::sqrt(trace + 1.0f);
+        q = {(y.z - z.y) / s, (z.x - x.z) / s, (x.y - y.x) / s, 0.25f * s};
+    } else if (x.x > y.y && x.x > z.z) {
+        float s = 2.0f * std::sqrt(1.0f + x.x - y.y - z.z);
+        q = {0.25f * s, (y.x + x.y) / s, (z.x + x.z) / s, (y.z - z.y) / s};
+    } else if (y.y > z.z) {
+        float s = 2.0f * std::sqrt(1.0f + y.y - x.x - z.z);
+        q = {(y.x + x.y) / s, 0.25f * s, (z.y + y.z) / s, (z.x - x.z) / s};
+    } else {
+        float s = 2.0f * std::sqrt(1.0f + z.z - x.x - y.y);
+        q = {(z.x + x.z) / s, (z.y + y.z) / s, 0.25f * s, (x.y - y.x) / s};
+    }
+    quat_normalize(&q, &q);
+    return q;
+}
+
+// The rotation of a quaternion as an axis and angle, as CompositeObject::add_part takes it
+void quat_to_axis_angle(const Quat& q, Vec3* axis, float* angle) {
+    Quat unit;
+    quat_normalize(&q, &unit);
+    if (unit.w < 0.0f) unit = {-unit.x, -unit.y, -unit.z, -unit.w};
+    float sine = std::sqrt(unit.x * unit.x + unit.y * unit.y + unit.z * unit.z);
+    if (sine < 1e-7f) {
+        *axis = {1, 0, 0};
+        *angle = 0.0f;
+        return;
+    }
+    *axis = {unit.x / sine, unit.y / sine, unit.z / sine};
+    *angle = 2.0f * std::atan2(sine, unit.w);
+}
+
+struct Compiler {
+    bool degrees = true;
+    std::string meshdir;
+    char eulerseq[3] = {'x', 'y', 'z'}; // Lowercase axes turn with the frame, uppercase ones stay fixed
+};
+
+// The orientation of an element from whichever of MJCF's alternative attributes it has
+Quat read_orientation(const XmlElement& element, const Compiler& compiler) {
+    float angle_scale = compiler.degrees ? pi / 180.0f : 1.0f;
+    float v[6];
+    Quat q = {0, 0, 0, 1};
+    if (read_floats(element, "quat", v, 4) == 4) {
+        q = {v[1], v[2], v[3], v[0]}; // MJCF writes w first
+        quat_normalize(&q, &q);
+    } else if (read_floats(element, "axisangle", v, 4) == 4) {
+        quat_from_axis_angle({v[0], v[1], v[2]}, v[3] * angle_scale, &q);
+    } else if (read_floats(element, "euler", v, 3) == 3) {
+        for (int i = 0; i < 3; ++i) {
+            char axis_name = compiler.eulerseq[i];
+            int axis_index = std::tolower((unsigned char)axis_name) - 'x';
+            Vec3 axis = {axis_index == 0 ? 1.0f : 0.0f, axis_index == 1 ? 1.0f : 0.0f, axis_index == 2 ? 1.0f : 0.0f};
+            Quat turn;
+            quat_from_axis_angle(axis, v[i] * angle_scale, &turn);
+            if (std::islower((unsigned char)axis_name)) {
+                quat_multiply(&q, &turn, &q);
+            } else {
+                quat_multiply(&turn, &q, &q);
+            }
+        }
+    } else if (read_floats(element, "xyaxes", v, 6) == 6) {
+        Vec3 x = {v[0], v[1], v[2]}, y = {v[3], v[4], v[5]}, z, along;
+        vec3_normalize(&x, &x);
+        vec3_scale(&x, vec3_dot(&x, &y), &along); // y need not be orthogonal to x
+        vec3_sub(&y, &along, &y);
+        vec3_normalize(&y, &y);
+        vec3_cross(&x, &y, &z);
+        q = quat_from_axes(x, y, z);
+    } else if (read_floats(element, "zaxis", v, 3) == 3) {
+        // The smallest rotation taking +Z to the axis
+        Vec3 up = {0, 0, 1}, z = {v[0], v[1], v[2]}, axis;
+        vec3_normalize(&z, &z);
+        vec3_cross(&up, &z, &axis);
+        float sine = vec3_length(&axis), cosine = vec3_dot(&up, &z);
+        if (sine > 1e-7f) {
+            quat_from_axis_angle(axis, std::atan2(sine, cosine), &q);
+        } else if (cosine < 0.0f) {
+            q = {1, 0, 0, 0};
+        }
+    }
+    return q;
+}
+
+Pose read_pose(const XmlElement& element, const Compiler& compiler) {
+    return {read_vec3(element, "pos", {0, 0, 0}), read_orientation(element, compiler)};
+}
+
+// --- Model tree --- //
+
+enum class GeomType { PLANE, BOX, SPHERE, CYLINDER, CAPSULE, MESH };
+
+struct GeomSpec {
+    std::string name;
+    GeomType type;
+    Pose pose;      // Of the primitive in its body's frame: MJCF's round shapes run along Z, ours along Y
+    float size[3];
+    std::shared_ptr<MeshAsset> mesh;
+    float mass;
+    float friction;
+    Vec3 color;
+};
+
+struct HingeSpec {
+    std::string name;
+    Vec3 position; // In its body's frame
+    Vec3 axis;
+};
+
+struct CameraElement {
+    std::string name;
+    Pose pose;
+    float fov_y_rad;
+};
+
+struct LightSpec {
+    Vec3 position;
+    Vec3 color;
+};
+
+struct BodySpec {
+    std::string name;
+    Pose pose;        // In the parent body's frame
+    bool free;
+    int parent;       // -1 for the world body
+    std::vector<int> children;
+    std::vector<GeomSpec> geoms;
+    std::vector<HingeSpec> hinges;
+    std::vector<CameraElement> cameras;
+    std::vector<LightSpec> lights;
+};
+
+struct ActuatorSpec {
+    std::string name;
+    std::string joint;
+    float gear;
+    float kv;
+    bool ctrl_limited;
+    float ctrl_range[2];
+    bool force_limited;
+    float force_range[2];
+};
+
+// Rough radius of a geom around its origin, for the camera clip planes
+float geom_radius(const GeomSpec& geom) {
+    if (geom.type == GeomType::MESH) {
+        AABB bounds = geom.mesh->get_bounds();
+        Vec3 corner = {std::max(std::fabs(bounds.min.x), std::fabs(bounds.max.x)),
+                       std::max(std::fabs(bounds.min.y), std::fabs(bounds.max.y)),
+                       std::max(std::fabs(bounds.min.z), std::fabs(bounds.max.z))};
+        return vec3_length(&corner);
+    }
+    if (geom.type == GeomType::PLANE) return std::sqrt(geom.size[0] * geom.size[0] + geom.size[1] * geom.size[1]);
+    Vec3 size = {geom.size[0], geom.size[1], geom.size[2]};
+    return vec3_length(&size);
+}
+
+std::shared_ptr<Primitive> make_primitive(const GeomSpec& geom, float mass) {
+    auto material = std::make_shared<Material>();
+    material->mass = mass;
+    material->friction = geom.friction;
+    material->color = geom.color;
+    switch (geom.type) {
+        case GeomType::PLANE: return std::make_shared<Plane>(material);
+        case GeomType::BOX: return std::make_shared<Box>(Vec3{geom.size[0], geom.size[1], geom.size[2]}, material);
+        case GeomType::SPHERE: return std::make_shared<Sphere>(geom.size[0], material);
+        case GeomType::CYLINDER: return std::make_shared<Cylinder>(2.0f * geom.size[1], geom.size[0], 16, material);
+        case GeomType::CAPSULE: return std::make_shared<Capsule>(2.0f * geom.size[1], geom.size[0], material);
+        case GeomType::MESH: return std::make_shared<ConvexHull>(*geom.mesh, material);
+    }
+    return nullptr;
+}
+
+void place(Primitive& primitive, const Pose& pose) {
+    primitive.set_position(pose.position);
+    primitive.set_orientation(pose.orientation);
+}
+
+} // namespace
+
+class MjcfModel::Builder {
+public:
+    Builder(MjcfModel& model, const std::string& path) : model(model), path(path), directory(directory_of(path)) {}
+
+    // Reads the whole file, failing on anything that would leave a half-built scene
+    bool read() {
+        XmlElement root;
+        if (!read_xml_file(path, root) || !expand_includes(root, directory, 0)) return false;
+        if (root.tag != "mujoco") return fail("the root element is <" + root.tag + ">, not <mujoco>");
+
+        // Assets may come after the bodies that use them, so the sections are read in dependency order
+        for (const auto& section : root.children) {
+            if (section.tag == "compiler") read_compiler(section);
+            else if (section.tag == "option") read_option(section);
+        }
+        for (const auto& section : root.children) {
+            if (section.tag == "asset") read_assets(section);
+        }
+        bodies.push_back({"world", identity_pose, false, -1, {}, {}, {}, {}, {}});
+        for (const auto& section : root.children) {
+            if (section.tag == "worldbody" && !read_body_contents(section, 0)) return false;
+        }
+        for (const auto& section : root.children) {
+            if (section.tag == "actuator" && !read_actuators(section)) return false;
+        }
+        return true;
+    }
+
+    void build(Scene& scene) {
+        scene.set_gravity(gravity);
+        model.timestep = timestep;
+        place_static(0, identity_pose, scene);
+
+        // Composites added after a joint move it along Scene::get_revolute_joints(), so the indices are taken once all are in
+        const auto& scene_joints = scene.get_revolute_joints();
+        for (const auto& hinge : hinge_joints) {
+            auto found = std::find(scene_joints.begin(), scene_joints.end(), hinge.second);
+            if (found != scene_joints.end()) model.joints[hinge.first] = (int)(found - scene_joints.begin());
+        }
+
+        // MuJoCo lets contacts rest without overlap, and the default slop is as big as a small robot's wheels
+        scene.set_contact_slop(0.001f * extent);
+
+        // MuJoCo's default clip planes, relative to the model's size
+        for (auto& camera : model.cameras) {
+            camera.near_plane = 0.01f * extent;
+            camera.far_plane = 50.0f * extent;
+        }
+        if (!model.cameras.empty()) {
+            scene.set_camera(model.make_camera(model.cameras[0].name, 640, 480));
+        }
+
+        for (const auto& actuator : actuator_specs) {
+            auto joint = model.joints.find(actuator.joint);
+            if (joint == model.joints.end()) {
+                warn(describe("actuator", actuator.name) + " drives the ignored " + describe("joint", actuator.joint) + " and is skipped");
+                continue;
+            }
+            MjcfActuator added = {actuator.name, joint->second, actuator.gear, actuator.ctrl_limited,
+                                  actuator.ctrl_range[0], actuator.ctrl_range[1]};
+            model.actuators.push_back(added);
+
+            // The actuator's force is kv * (control - gear * speed), applied through the gear. Its strongest
+            // push is across the whole control range, e.g. reversing from full speed.
+            float control_span = actuator.ctrl_limited ? actuator.ctrl_range[1] - actuator.ctrl_range[0] : 2.0f;
+            float max_torque = std::fabs(actuator.gear) * actuator.kv * control_span;
+            if (actuator.force_limited) {
+                max_torque = std::fabs(actuator.gear) * std::max(std::fabs(actuator.force_range[0]), std::fabs(actuator.force_range[1]));
+            }
+            scene.get_revolute_joints()[joint->second]->set_motor(0.0f, max_torque);
+        }
+    }
+
+private:
+    bool fail(const std::string& message) const {
+        std::cerr << path << ": " << message << std::endl;
+        return false;
+    }
+
+    void warn(const std::string& message) const { std::cerr << path << ": " << message << std::endl; }
+
+    void read_compiler(const XmlElement& element) {
+        if (const char* angle = element.get("angle")) compiler.degrees = std::strcmp(angle, "radian") != 0;
+        if (const char* meshdir = element.get("meshdir")) {
+            compiler.meshdir = meshdir;
+            if (!compiler.meshdir.empty() && compiler.meshdir.back() != '/' && compiler.meshdir.back() != '\\') compiler.meshdir += '/';
+        }
+        const char* sequence = element.get("eulerseq");
+        if (sequence && std::strlen(sequence) == 3 && std::strspn(sequence, "xyzXYZ") == 3) {
+            std::memcpy(compiler.eulerseq, sequence, 3);
+        } else if (sequence) {
+            warn(std::string("ignoring eulerseq ") + sequence);
+        }
+    }
+
+    void read_option(const XmlElement& element) {
+        gravity = read_vec3(element, "gravity", gravity);
+        timestep = read_float(element, "timestep", timestep);
+    }
+
+    void read_assets(const XmlElement& section) {
+        for (const auto& asset : section.children) {
+            if (asset.tag == "mesh") {
+                std::string file = read_string(asset, "file");
+                std::string name = read_string(asset, "name");
+                if (name.empty()) {
+                    // Unnamed meshes go by their file name without directories and extension
+                    size_t start = file.find_last_of("/\\") + 1;
+                    name = file.substr(start, file.rfind('.') > start ? file.rfind('.') - start : std::string::npos);
+                }
+                if (asset.get("scale")) warn(describe("mesh", name) + ": scale is not supported and is ignored");
+                mesh_files[name] = resolve_path(resolve_path(directory, compiler.meshdir), file);
+            } else if (asset.tag == "material") {
+                float rgba[4];
+                if (read_floats(asset, "rgba", rgba, 4) >= 3) materials[read_string(asset, "name")] = {rgba[0], rgba[1], rgba[2]};
+            }
+        }
+    }
+
+    // Loads a mesh asset on first use, so meshes the bodies do not use are never read
+    std::shared_ptr<MeshAsset> mesh(const std::string& name) {
+        auto loaded = meshes.find(name);
+        if (loaded != meshes.end()) return loaded->second;
+        auto file = mesh_files.find(name);
+        if (file == mesh_files.end()) {
+            fail("unknown " + describe("mesh", name));
+            return nullptr;
+        }
+        std::shared_ptr<MeshAsset> asset = MeshAsset::load(file->second);
+        if (asset) meshes[name] = asset;
+        return asset;
+    }
+
+    // Reads the geoms, joints, cameras, lights and child bodies of a body, or of the world body
+    bool read_body_contents(const XmlElement& element, int index) {
+        for (const auto& child : element.children) {
+            if (child.tag == "body") {
+                int child_index = (int)bodies.size();
+                bodies.push_back({read_string(child, "name"), read_pose(child, compiler), false, index, {}, {}, {}, {}, {}});
+                bodies[index].children.push_back(child_index);
+                if (!read_body_contents(child, child_index)) return false;
+            } else if (child.tag == "geom") {
+                GeomSpec geom;
+                bool supported = true;
+                if (!read_geom(child, geom, supported)) return false;
+                if (supported) bodies[index].geoms.push_back(std::move(geom));
+            } else if (child.tag == "freejoint") {
+                bodies[index].free = true;
+            } else if (child.tag == "joint") {
+                std::string type = child.get("type") ? child.get("type") : "hinge";
+                if (type == "free") {
+                    bodies[index].free = true;
+                } else if (type == "hinge") {
+                    Vec3 axis = read_vec3(child, "axis", {0, 0, 1});
+                    vec3_normalize(&axis, &axis);
+                    bodies[index].hinges.push_back({read_string(child, "name"), read_vec3(child, "pos", {0, 0, 0}), axis});
+                } else {
+                    warn(describe(type + " joint", read_string(child, "name")) + " is not supported; its body stays welded to its parent");
+                }
+            } else if (child.tag == "camera") {
+                bodies[index].cameras.push_back({read_string(child, "name"), read_pose(child, compiler),
+                                                 read_float(child, "fovy", 45.0f) * pi / 180.0f});
+            } else if (child.tag == "light") {
+                bodies[index].lights.push_back({read_vec3(child, "pos", {0, 0, 0}), read_vec3(child, "diffuse", {0.7f, 0.7f, 0.7f})});
+            }
+        }
+        return true;
+    }
+
+    // Reads a geom, or clears 'supported' for a type this engine has no shape for
+    bool read_geom(const XmlElement& element, GeomSpec& geom, bool& supported) {
+        std::string type = element.get("type") ? element.get("type") : "sphere";
+        geom.name = read_string(element, "name");
+        if (type == "plane") geom.type = GeomType::PLANE;
+        else if (type == "box") geom.type = GeomType::BOX;
+        else if (type == "sphere") geom.type = GeomType::SPHERE;
+        else if (type == "cylinder") geom.type = GeomType::CYLINDER;
+        else if (type == "capsule") geom.type = GeomType::CAPSULE;
+        else if (type == "mesh") geom.type = GeomType::MESH;
+        else {
+            warn(describe(type + " geom", geom.name) + " is not supported and is skipped");
+            supported = false;
+            return true;
+        }
+
+        geom.size[0] = geom.size[1] = geom.size[2] = 0.0f;
+        read_floats(element, "size", geom.size, 3);
+        geom.pose = read_pose(element, compiler);
+
+        // fromto gives a capsule or cylinder by its end points, along Z of its frame
+        float ends[6];
+        if ((geom.type == GeomType::CAPSULE || geom.type == GeomType::CYLINDER) && read_floats(element, "fromto", ends, 6) == 6) {
+            Vec3 from = {ends[0], ends[1], ends[2]}, to = {ends[3], ends[4], ends[5]}, axis, up = {0, 0, 1}, turn_axis;
+            vec3_sub(&to, &from, &axis);
+            geom.size[1] = 0.5f * vec3_length(&axis);
+            geom.pose.position = {0.5f * (from.x + to.x), 0.5f * (from.y + to.y), 0.5f * (from.z + to.z)};
+            vec3_normalize(&axis, &axis);
+            vec3_cross(&up, &axis, &turn_axis);
+            float sine = vec3_length(&turn_axis), cosine = vec3_dot(&up, &axis);
+            geom.pose.orientation = {0, 0, 0, 1};
+            if (sine > 1e-7f) quat_from_axis_angle(turn_axis, std::atan2(sine, cosine), &geom.pose.orientation);
+            else if (cosine < 0.0f) geom.pose.orientation = {1, 0, 0, 0};
+        }
+
+        if (geom.type == GeomType::PLANE || geom.type == GeomType::CYLINDER || geom.type == GeomType::CAPSULE) {
+            // Turn our Y-axis shapes onto MJCF's Z axis
+            Quat y_to_z;
+            quat_from_axis_angle({1, 0, 0}, 0.5f * pi, &y_to_z);
+            quat_multiply(&geom.pose.orientation, &y_to_z, &geom.pose.orientation);
+        }
+        if (geom.type == GeomType::MESH) {
+            geom.mesh = mesh(read_string(element, "mesh"));
+            if (!geom.mesh) return fail(describe("mesh geom", geom.name) + " has no mesh");
+        } else if (geom.type != GeomType::PLANE && geom.size[0] <= 0.0f) {
+            return fail(describe(type + " geom", geom.name) + " has no size");
+        }
+
+        float r = geom.size[0], h = geom.size[1], volume = 0.0f;
+        switch (geom.type) {
+            case GeomType::PLANE: break;
+            case GeomType::BOX: volume = 8.0f * geom.size[0] * geom.size[1] * geom.size[2]; break;
+            case GeomType::SPHERE: volume = 4.0f / 3.0f * pi * r * r * r; break;
+            case GeomType::CYLINDER: volume = 2.0f * pi * r * r * h; break;
+            case GeomType::CAPSULE: volume = 2.0f * pi * r * r * h + 4.0f / 3.0f * pi * r * r * r; break;
+            case GeomType::MESH: volume = geom.mesh->get_solid_mass_properties().volume; break;
+        }
+        geom.mass = read_float(element, "mass", read_float(element, "density", 1000.0f) * volume);
+        geom.friction = read_float(element, "friction", 1.0f);
+
+        geom.color = {0.5f, 0.5f, 0.5f};
+        float rgba[4];
+        auto material = materials.find(read_string(element, "material"));
+        if (read_floats(element, "rgba", rgba, 4) >= 3) geom.color = {rgba[0], rgba[1], rgba[2]};
+        else if (material != materials.end()) geom.color = material->second;
+        return true;
+    }
+
+    bool read_actuators(const XmlElement& section) {
+        for (const auto& element : section.children) {
+            std::string name = read_string(element, "name");
+            if (element.tag != "velocity") {
+                warn(describe(element.tag + " actuator", name) + " is not supported and is skipped");
+                continue;
+            }
+            ActuatorSpec actuator;
+            actuator.name = name;
+            actuator.joint = read_string(element, "joint");
+            if (std::none_of(bodies.begin(), bodies.end(), [&](const BodySpec& body) {
+                    return std::any_of(body.hinges.begin(), body.hinges.end(), [&](const HingeSpec& hinge) { return hinge.name == actuator.joint; });
+                })) {
+                return fail(describe("actuator", name) + " drives the unknown " + describe("hinge joint", actuator.joint));
+            }
+            actuator.gear = read_float(element, "gear", 1.0f);
+            if (actuator.gear == 0.0f) return fail(describe("actuator", name) + " has a zero gear");
+            actuator.kv = read_float(element, "kv", 1.0f);
+            actuator.ctrl_range[0] = actuator.ctrl_range[1] = 0.0f;
+            bool has_range = read_floats(element, "ctrlrange", actuator.ctrl_range, 2) == 2;
+            actuator.ctrl_limited = read_bool(element, "ctrllimited", has_range) && has_range;
+            actuator.force_range[0] = actuator.force_range[1] = 0.0f;
+            has_range = read_floats(element, "forcerange", actuator.force_range, 2) == 2;
+            actuator.force_limited = read_bool(element, "forcelimited", has_range) && has_range;
+            actuator_specs.push_back(actuator);
+        }
+        return true;
+    }
+
+    void note_extent(const Pose& world, const GeomSpec& geom) {
+        extent = std::max(extent, vec3_length(&world.position) + geom_radius(geom));
+    }
+
+    // Adds the geoms of a body welded to the world, then places its children
+    void place_static(int index, const Pose& world, Scene& scene) {
+        const BodySpec& body = bodies[index];
+        for (const auto& geom : body.geoms) {
+            Pose pose = compose(world, geom.pose);
+            std::shared_ptr<Primitive> primitive = make_primitive(geom, 0.0f);
+            place(*primitive, pose);
+            scene.add_primitive(primitive);
+            if (!geom.name.empty()) model.geoms[geom.name] = primitive;
+            note_extent(pose, geom);
+        }
+        for (const auto& hinge : body.hinges) {
+            warn(describe("hinge joint", hinge.name) + " of " + describe("body", body.name) + " is not below a free body and is ignored");
+        }
+        add_cameras_and_lights(index, nullptr, world, world, scene);
+        for (int child : body.children) {
+            Pose child_world = compose(world, bodies[child].pose);
+            if (bodies[child].free) {
+                place_free(child, child_world, scene);
+            } else {
+                place_static(child, child_world, scene);
+            }
+        }
+    }
+
+    /**
+     * Turns a free body and its descendants into rigid bodies joined by hinges. Bodies welded to their
+     * parent join its object, and each body with a hinge starts an object of its own, joined to its
+     * parent's by a RevoluteJoint of the scene.
+     */
+    void place_free(int root, const Pose& root_world, Scene& scene) {
+        // The bodies below the root, with their poses relative to it, and the group of welded bodies each is in
+        std::vector<int> subtree = {root};
+        std::vector<Pose> relative(bodies.size(), identity_pose);
+        std::vector<int> group(bodies.size(), -1);
+        std::vector<int> group_heads = {root}; // The body each group starts at
+        group[root] = 0;
+        for (const auto& hinge : bodies[root].hinges) {
+            warn(describe("hinge joint", hinge.name) + " of " + describe("free body", bodies[root].name) + " is ignored");
+        }
+        for (size_t i = 0; i < subtree.size(); ++i) {
+            for (int child : bodies[subtree[i]].children) {
+                if (bodies[child].free) warn(describe("body", bodies[child].name) + " is free below another free body and is welded to it");
+                relative[child] = compose(relative[subtree[i]], bodies[child].pose);
+                if (bodies[child].hinges.empty()) {
+                    group[child] = group[subtree[i]];
+                } else {
+                    group[child] = (int)group_heads.size();
+                    group_heads.push_back(child);
+                }
+                subtree.push_back(child);
+            }
+        }
+
+        // A hinge needs geoms on both sides; without them its body is welded to its parent after all.
+        // Parents come before their children, so a group's parent is already resolved when it is reached.
+        std::vector<size_t> geom_counts(group_heads.size(), 0);
+        for (int index : subtree) geom_counts[group[index]] += bodies[index].geoms.size();
+        std::vector<int> merged_into(group_heads.size());
+        for (size_t g = 0; g < group_heads.size(); ++g) {
+            merged_into[g] = (int)g;
+            if (g == 0) continue;
+            const BodySpec& head = bodies[group_heads[g]];
+            int parent = merged_into[group[head.parent]];
+            for (size_t h = 1; h < head.hinges.size(); ++h) {
+                warn(describe("hinge joint", head.hinges[h].name) + " of " + describe("body", head.name) +
+                     " is ignored: only one hinge per body is supported");
+            }
+            if (geom_counts[g] == 0 || geom_counts[parent] == 0) {
+                warn(describe("hinge joint", head.hinges[0].name) + " of " + describe("body", head.name) +
+                     " does not join two bodies with geoms and is ignored");
+                merged_into[g] = parent;
+                geom_counts[parent] += geom_counts[g];
+            }
+        }
+        if (geom_counts[0] == 0) {
+            warn(describe("free body", bodies[root].name) + " has no geoms and is skipped");
+            return;
+        }
+
+        std::vector<std::shared_ptr<Primitive>> objects(group_heads.size());
+        std::vector<Pose> object_from_root(group_heads.size(), identity_pose); // Each object's frame in the root body's
+        for (size_t g = 0; g < group_heads.size(); ++g) {
+            if (merged_into[g] != (int)g) continue;
+            std::vector<const GeomSpec*> part_geoms;
+            std::vector<Pose> part_poses;
+            for (int index : subtree) {
+                if (merged_into[group[index]] != (int)g) continue;
+                for (const auto& geom : bodies[index].geoms) {
+                    part_geoms.push_back(&geom);
+                    part_poses.push_back(compose(relative[index], geom.pose));
+                }
+            }
+            objects[g] = place_group(part_geoms, part_poses, root_world, object_from_root[g], scene);
+            for (size_t i = 0; i < part_geoms.size(); ++i) note_extent(compose(root_world, part_poses[i]), *part_geoms[i]);
+        }
+
+        // The joints go in once both of their bodies are in the scene
+        for (size_t g = 1; g < group_heads.size(); ++g) {
+            if (merged_into[g] != (int)g) continue;
+            int head = group_heads[g];
+            const HingeSpec& hinge = bodies[head].hinges[0];
+            Pose body_world = compose(root_world, relative[head]);
+            Vec3 anchor = transform_point(body_world, hinge.position);
+            Vec3 axis = quat_rotate(&body_world.orientation, hinge.axis);
+            auto joint = std::make_unique<RevoluteJoint>(objects[merged_into[group[bodies[head].parent]]].get(),
+                                                         objects[g].get(), anchor, axis);
+            if (!hinge.name.empty()) hinge_joints.push_back({hinge.name, joint.get()});
+            scene.add_joint(std::move(joint));
+        }
+
+        for (int index : subtree) {
+            int g = merged_into[group[index]];
+            if (!bodies[index].name.empty()) model.bodies[bodies[index].name] = objects[g];
+            add_cameras_and_lights(index, objects[g], compose(inverse(object_from_root[g]), relative[index]),
+                                   compose(root_world, relative[index]), scene);
+        }
+    }
+
+    /**
+     * Adds the geoms of a group of welded bodies, posed in the frame of the free body they are below, as
+     * one object: the primitive of its only geom if that turns about its own center of mass, or else a
+     * composite of all of them with its origin at theirs, since bodies turn about their origin.
+     */
+    std::shared_ptr<Primitive> place_group(const std::vector<const GeomSpec*>& geoms, const std::vector<Pose>& poses,
+                                           const Pose& root_world, Pose& object_from_root, Scene& scene) {
+        std::vector<std::shared_ptr<Primitive>> primitives;
+        for (const GeomSpec* geom : geoms) primitives.push_back(make_primitive(*geom, geom->mass));
+
+        Vec3 own_center = primitives[0]->get_center_of_mass();
+        if (primitives.size() == 1 && vec3_length(&own_center) < 1e-6f) {
+            object_from_root = poses[0];
+            place(*primitives[0], compose(root_world, object_from_root));
+            scene.add_primitive(primitives[0]);
+            if (!geoms[0]->name.empty()) model.geoms[geoms[0]->name] = primitives[0];
+            return primitives[0];
+        }
+
+        Vec3 center = {0, 0, 0};
+        float total_mass = 0.0f;
+        for (size_t i = 0; i < primitives.size(); ++i) {
+            Vec3 part_center = transform_point(poses[i], primitives[i]->get_center_of_mass()), weighted;
+            vec3_scale(&part_center, geoms[i]->mass, &weighted);
+            vec3_add(&center, &weighted, &center);
+            total_mass += geoms[i]->mass;
+        }
+        if (total_mass > 0.0f) vec3_scale(&center, 1.0f / total_mass, &center);
+        object_from_root = {center, {0, 0, 0, 1}};
+
+        auto composite = std::make_shared<CompositeObject>(std::make_shared<Material>());
+        for (size_t i = 0; i < primitives.size(); ++i) {
+            Pose part_pose = compose(inverse(object_from_root), poses[i]);
+            Vec3 axis;
+            float angle;
+            quat_to_axis_angle(part_pose.orientation, &axis, &angle);
+            composite->add_part(primitives[i], part_pose.position, axis, angle);
+            if (!geoms[i]->name.empty()) model.geoms[geoms[i]->name] = primitives[i];
+        }
+        place(*composite, compose(root_world, object_from_root));
+        composite->update_child_transforms();
+        scene.add_composite_object(composite);
+        return composite;
+    }
+
+    /**
+     * Records the cameras of a body and adds its lights. The cameras follow 'parent', in whose frame
+     * the body is at 'body_in_parent', or are fixed in the world if it is null. Lights stay where the body starts.
+     */
+    void add_cameras_and_lights(int index, const std::shared_ptr<Primitive>& parent, const Pose& body_in_parent,
+                                const Pose& body_world, Scene& scene) {
+        const BodySpec& body = bodies[index];
+        for (const auto& camera : body.cameras) {
+            Pose pose = compose(body_in_parent, camera.pose);
+            model.cameras.push_back({camera.name, parent, pose.position, pose.orientation, camera.fov_y_rad, 0.0f, 0.0f});
+        }
+        for (const auto& light : body.lights) {
+            scene.add_light(std::make_unique<Light>(transform_point(body_world, light.position), light.color, 1.0f));
+        }
+    }
+
+    MjcfModel& model;
+    std::string path;
+    std::string directory;
+    Compiler compiler;
+    Vec3 gravity = {0.0f, 0.0f, -9.81f};
+    float timestep = 0.002f;
+    std::unordered_map<std::string, std::string> mesh_files;
+    std::unordered_map<std::string, std::shared_ptr<MeshAsset>> meshes;
+    std::unordered_map<std::string, Vec3> materials;
+    std::vector<BodySpec> bodies; // The world body first
+    std::vector<ActuatorSpec> actuator_specs;
+    std::vector<std::pair<std::string, RevoluteJoint*>> hinge_joints; // The named hinges the scene has joints for
+    float extent = 0.0f;
+};
+
+std::shared_ptr<MjcfModel> MjcfModel::load(const std::string& path, Scene& scene) {
+    std::shared_ptr<MjcfModel> model(new MjcfModel());
+    Builder builder(*model, path);
+    if (!builder.read()) {
+        return nullptr;
+    }
+    builder.build(scene);
+    return model;
+}
+
+std::shared_ptr<Primitive> MjcfModel::find_body(const std::string& name) const {
+    auto found = bodies.find(name);
+    return found == bodies.end() ? nullptr : found->second;
+}
+
+std::shared_ptr<Primitive> MjcfModel::find_geom(const std::string& name) const {
+    auto found = geoms.find(name);
+    return found == geoms.end() ? nullptr : found->second;
+}
+
+int MjcfModel::find_joint(const std::string& name) const {
+    auto found = joints.find(name);
+    return found == joints.end() ? -1 : found->second;
+}
+
+int MjcfModel::find_actuator(const std::string& name) const {
+    for (size_t i = 0; i < actuators.size(); ++i) {
+        if (actuators[i].name == name) return (int)i;
+    }
+    return -1;
+}
+
+void MjcfModel::controls_to_motor_speeds(const float* controls, float* speeds) const {
+    for (size_t i = 0; i < actuators.size(); ++i) {
+        const MjcfActuator& actuator = actuators[i];
+        float control = controls[i];
+        if (actuator.ctrl_limited) control = std::min(std::max(control, actuator.ctrl_min), actuator.ctrl_max);
+        speeds[actuator.joint_index] = control / actuator.gear;
+    }
+}
+
+void MjcfModel::apply_controls(Scene& scene, const float* controls) const {
+    std::vector<float> speeds(scene.get_revolute_joints().size());
+    for (size_t i = 0; i < speeds.size(); ++i) speeds[i] = scene.get_revolute_joints()[i]->get_motor_speed();
+    controls_to_motor_speeds(controls, speeds.data());
+    scene.set_motor_speeds(speeds.data());
+}
+
+std::vector<std::string> MjcfModel::get_camera_names() const {
+    std::vector<std::string> names;
+    for (const auto& camera : cameras) names.push_back(camera.name);
+    return names;
+}
+
+std::unique_ptr<Camera> MjcfModel::make_camera(const std::string& name, int width, int height) const {
+    auto spec = std::find_if(cameras.begin(), cameras.end(), [&](const CameraSpec& camera) { return camera.name == name; });
+    if (spec == cameras.end()) {
+        return nullptr;
+    }
+    auto camera = std::make_unique<Camera>(width, height);
+    camera->set_perspective(spec->fov_y_rad, spec->near_plane, spec->far_plane);
+    if (spec->parent) {
+        Mat4 translation, rotation, local_transform;
+        mat4_translate(spec->position, &translation);
+        quat_to_mat4(&spec->orientation, &rotation);
+        mat4_multiply(&translation, &rotation, &local_transform);
+        camera->attach_to(spec->parent.get(), local_transform);
+    } else {
+        Vec3 forward = quat_rotate(&spec->orientation, {0, 0, -1});
+        Vec3 up = quat_rotate(&spec->orientation, {0, 1, 0});
+        Vec3 target;
+        vec3_add(&spec->position, &forward, &target);
+        camera->set_look_at(spec->position, target, up);
+    }
+    return camera;
+}
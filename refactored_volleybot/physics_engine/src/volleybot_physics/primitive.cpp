@@ -1,67 +1,193 @@
 #include "volleybot_physics/primitive.h"
 #include "physics_core/kinematics.h" 
+#include "volleybot_physics/quickhull.h"
 
 // --- Primitive Base Class --- //
 
-Primitive::Primitive(std::shared_ptr<Material> mat) : material(mat) {
-    vec3_set(&position, 0, 0, 0);
-    vec3_set(&velocity, 0, 0, 0);
-    vec3_set(&acceleration, 0, 0, 0);
+Primitive::Primitive(std::shared_ptr<Material> mat)
+    : material(mat), type(PrimitiveType::COMPOSITE), store(nullptr), body_index(0),
+      detached(std::make_unique<BodyState>()) {
+    vec3_set(&detached->position, 0, 0, 0);
+    vec3_set(&detached->velocity, 0, 0, 0);
+    vec3_set(&detached->acceleration, 0, 0, 0);
+    vec3_set(&detached->angular_velocity, 0, 0, 0);
+    quat_identity(&detached->orientation);
+    detached->local_bounds = {{0, 0, 0}, {0, 0, 0}};
+    detached->aabb = {{0, 0, 0}, {0, 0, 0}};
+    detached->sleep_time = 0.0f;
+    detached->flags = 0;
 
-    vec3_set(&angular_velocity, 0, 0, 0);
     vec3_set(&center_of_mass, 0, 0, 0); // Default for single primitives
-    mat4_identity(&transform);
     mat4_zero(&inertia_tensor); // Initialize to zero
     mat4_zero(&inverse_inertia_tensor); // Initialize to zero
+    update_mass_properties();
 }
 
-void Primitive::update_physics(float dt, Vec3 gravity) {
-    // Apply gravity to the current acceleration
-    vec3_add(&acceleration, &gravity, &acceleration);
+Primitive::~Primitive() {
+    // Leave no dangling handle behind in the store
+    if (store) {
+        store->owners[body_index] = nullptr;
+    }
+}
+
+void Primitive::attach(BodyStore* target, uint8_t extra_flags) {
+    if (store) {
+        detach();
+    }
+    // Copied from a sleeping body, the state may say it sleeps, but it has no island in the new store
+    detached->flags = (detached->flags | extra_flags) & ~BODY_FLAG_SLEEPING;
+    detached->sleep_time = 0.0f;
+    body_index = target->add(*detached, this);
+    store = target;
+    detached.reset();
+}
+
+void Primitive::detach() {
+    if (!store) return;
+    detached = std::make_unique<BodyState>();
+    store->read(body_index, detached.get());
+    detached->flags &= ~BODY_FLAG_SLEEPING; // Nothing would wake it outside the store
+    store->owners[body_index] = nullptr;
+    store = nullptr;
+    body_index = 0;
+}
+
+void Primitive::set_solid_mass_properties(const MassProperties& solid) {
+    center_of_mass = solid.center_of_mass;
+    float density = solid.volume > 0.0f && material ? material->mass / solid.volume : 0.0f;
+    mat4_zero(&inertia_tensor);
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) inertia_tensor.m[i][j] = density * solid.inertia.m[i][j];
+    }
+    mat3_inverse(&inertia_tensor, &inverse_inertia_tensor);
+    update_mass_properties();
+}
+
+void Primitive::update_mass_properties() {
+    bool is_static = !material || material->mass <= 0.0f;
+    state_field(&BodyStore::inverse_masses, &BodyState::inverse_mass) = is_static ? 0.0f : 1.0f / material->mass;
+    state_field(&BodyStore::local_inverse_inertias, &BodyState::local_inverse_inertia) = inverse_inertia_tensor;
+    update_world_inverse_inertia();
+
+    uint8_t& flags = state_field(&BodyStore::flags, &BodyState::flags);
+    if (is_static) {
+        flags |= BODY_FLAG_STATIC;
+    } else {
+        flags &= ~BODY_FLAG_STATIC;
+    }
+}
+
+void Primitive::copy_body_from(const Primitive& other) {
+    if (store) return; // Only fresh, detached copies are filled in
+
+    center_of_mass = other.center_of_mass;
+    inertia_tensor = other.inertia_tensor;
+    inverse_inertia_tensor = other.inverse_inertia_tensor;
+    if (other.store) {
+        other.store->read(other.body_index, detached.get());
+    } else {
+        *detached = *other.detached;
+    }
+}
+
+Mat4 Primitive::get_transform() const {
+    Quat orientation = get_orientation();
+    Vec3 position = get_position();
+    Mat4 transform;
+    quat_to_mat4(&orientation, &transform);
+    transform.m[3][0] = position.x;
+    transform.m[3][1] = position.y;
+    transform.m[3][2] = position.z;
+    return transform;
+}
+
+Vec3 Primitive::get_world_center_of_mass() const {
+    Mat4 transform = get_transform();
+    return mat4_transform_point(&transform, center_of_mass);
+}
 
-    // Call the C core function to perform the Verlet integration
-    update_kinematics(&position, &velocity, &acceleration, dt);
+void Primitive::compute_aabb() {
+    update_aabbs(&state_field(&BodyStore::positions, &BodyState::position),
+                 &state_field(&BodyStore::orientations, &BodyState::orientation),
+                 &state_field(&BodyStore::local_bounds, &BodyState::local_bounds),
+                 &state_field(&BodyStore::aabbs, &BodyState::aabb), 1);
+}
 
-    // Reset acceleration for the next frame. Forces must be re-applied each frame.
-    vec3_set(&acceleration, 0, 0, 0);
+void Primitive::update_physics(float dt, Vec3 gravity) {
+    // Integrates just this body with the same kernel the Scene runs over its whole store
+    integrate_bodies(&state_field(&BodyStore::positions, &BodyState::position),
+                     &state_field(&BodyStore::velocities, &BodyState::velocity),
+                     &state_field(&BodyStore::accelerations, &BodyState::acceleration),
+                     &state_field(&BodyStore::flags, &BodyState::flags), 1, gravity, dt);
+    integrate_orientations(&state_field(&BodyStore::orientations, &BodyState::orientation),
+                           &state_field(&BodyStore::angular_velocities, &BodyState::angular_velocity),
+                           &state_field(&BodyStore::flags, &BodyState::flags), 1, dt);
+    update_world_inverse_inertia();
+}
 
-    // Update the object's transformation matrix from its new position
-    // Note: This doesn't account for rotation yet.
-    mat4_translate(position, &transform);
+void Primitive::update_world_inverse_inertia() {
+    update_inverse_inertias(&state_field(&BodyStore::orientations, &BodyState::orientation),
+                            &state_field(&BodyStore::local_inverse_inertias, &BodyState::local_inverse_inertia),
+                            &state_field(&BodyStore::inverse_inertias, &BodyState::inverse_inertia), 1);
 }
 
 void Primitive::set_position(const Vec3& pos) {
-    position = pos;
-    // Update the transform matrix whenever position changes
-    mat4_translate(position, &transform);
+    wake_up();
+    state_field(&BodyStore::positions, &BodyState::position) = pos;
 }
 
 void Primitive::set_velocity(const Vec3& vel) {
-    velocity = vel;
+    wake_up();
+    state_field(&BodyStore::velocities, &BodyState::velocity) = vel;
+}
+
+void Primitive::set_angular_velocity(const Vec3& ang_vel) {
+    wake_up();
+    state_field(&BodyStore::angular_velocities, &BodyState::angular_velocity) = ang_vel;
+}
+
+void Primitive::set_orientation(const Quat& orientation) {
+    wake_up();
+    quat_normalize(&orientation, &state_field(&BodyStore::orientations, &BodyState::orientation));
+    update_world_inverse_inertia();
 }
 
 void Primitive::apply_force(const Vec3& force) {
+    wake_up();
     // F = ma  =>  a = F/m
-    if (material && material->mass > 0.0f) {
-        Vec3 scaled_force;
-        vec3_scale(&force, 1.0f / material->mass, &scaled_force);
-        vec3_add(&acceleration, &scaled_force, &acceleration);
+    Vec3 scaled_force;
+    vec3_scale(&force, get_inverse_mass(), &scaled_force);
+    Vec3& acceleration = state_field(&BodyStore::accelerations, &BodyState::acceleration);
+    vec3_add(&acceleration, &scaled_force, &acceleration);
+}
+
+void Primitive::wake_up() {
+    if (store) store->wake(body_index);
+}
+
+void Primitive::set_bullet(bool bullet) {
+    uint8_t& flags = state_field(&BodyStore::flags, &BodyState::flags);
+    if (bullet) {
+        flags |= BODY_FLAG_BULLET;
+    } else {
+        flags &= ~BODY_FLAG_BULLET;
     }
 }
 
 void Primitive::apply_impulse(const Vec3& impulse, const Vec3& world_contact_point) {
-    if (this->material->mass <= 0.0f) return; // Static objects don't move
+    float inverse_mass = get_inverse_mass();
+    if (inverse_mass <= 0.0f) return; // Static objects don't move
+    wake_up();
 
     // 1. Update linear velocity
     Vec3 linear_velocity_change;
-    vec3_scale(&impulse, 1.0f / this->material->mass, &linear_velocity_change);
-    vec3_add(&this->velocity, &linear_velocity_change, &this->velocity);
+    vec3_scale(&impulse, inverse_mass, &linear_velocity_change);
+    Vec3& velocity = state_field(&BodyStore::velocities, &BodyState::velocity);
+    vec3_add(&velocity, &linear_velocity_change, &velocity);
 
     // 2. Update angular velocity
-    // First, find the world-space center of mass
-    Vec3 world_center_of_mass = mat4_transform_point(&this->transform, this->center_of_mass);
-
-    // Calculate r, the vector from the CoM to the contact point
+    // Calculate r, the vector from the world-space CoM to the contact point
+    Vec3 world_center_of_mass = get_world_center_of_mass();
     Vec3 r;
     vec3_sub(&world_contact_point, &world_center_of_mass, &r);
 
@@ -70,15 +196,16 @@ void Primitive::apply_impulse(const Vec3& impulse, const Vec3& world_contact_poi
     vec3_cross(&r, &impulse, &torque);
 
     // Calculate change in angular velocity: delta_omega = I_inv * T
-    Vec3 angular_velocity_change = mat4_transform_direction(&this->inverse_inertia_tensor, torque);
-    vec3_add(&this->angular_velocity, &angular_velocity_change, &this->angular_velocity);
+    apply_angular_impulse(torque);
 }
 
 void Primitive::apply_angular_impulse(const Vec3& impulse) {
-    if (this->material->mass <= 0.0f) return; // Static objects don't rotate from impulses
+    if (get_inverse_mass() <= 0.0f) return; // Static objects don't rotate from impulses
+    wake_up();
 
-    Vec3 angular_velocity_change = mat4_transform_direction(&this->inverse_inertia_tensor, impulse);
-    vec3_add(&this->angular_velocity, &angular_velocity_change, &this->angular_velocity);
+    Vec3 angular_velocity_change = mat4_transform_direction(&get_inverse_inertia_tensor(), impulse);
+    Vec3& angular_velocity = state_field(&BodyStore::angular_velocities, &BodyState::angular_velocity);
+    vec3_add(&angular_velocity, &angular_velocity_change, &angular_velocity);
 }
 
 Box::Box(const Vec3& extents, std::shared_ptr<Material> mat) 
@@ -94,11 +221,17 @@ Box::Box(const Vec3& extents, std::shared_ptr<Material> mat)
     inertia_tensor.m[1][1] = (1.0f / 12.0f) * mass * (W*W + D*D);
     inertia_tensor.m[2][2] = (1.0f / 12.0f) * mass * (W*W + H*H);
     mat3_inverse(&inertia_tensor, &inverse_inertia_tensor);
+    update_mass_properties();
+
+    Vec3 min_corner;
+    vec3_negate(&extents, &min_corner);
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = {min_corner, extents};
 }
 
-void Box::compute_aabb() {
-    vec3_sub(&position, &extents, &aabb.min);
-    vec3_add(&position, &extents, &aabb.max);
+std::shared_ptr<Primitive> Box::clone() const {
+    auto copy = std::make_shared<Box>(extents, material);
+    copy->copy_body_from(*this);
+    return copy;
 }
 
 // --- Sphere Derived Class --- //
@@ -112,19 +245,33 @@ Sphere::Sphere(float radius, std::shared_ptr<Material> mat)
     inertia_tensor.m[1][1] = I;
     inertia_tensor.m[2][2] = I;
     mat3_inverse(&inertia_tensor, &inverse_inertia_tensor);
+    update_mass_properties();
+
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = {{-radius, -radius, -radius}, {radius, radius, radius}};
 }
 
-void Sphere::compute_aabb() {
-    Vec3 r_vec = {radius, radius, radius};
-    vec3_sub(&position, &r_vec, &aabb.min);
-    vec3_add(&position, &r_vec, &aabb.max);
+std::shared_ptr<Primitive> Sphere::clone() const {
+    auto copy = std::make_shared<Sphere>(radius, material);
+    copy->copy_body_from(*this);
+    return copy;
 }
 
 // --- TriangleMesh Derived Class --- //
 
-TriangleMesh::TriangleMesh(std::shared_ptr<Material> mat)
-    : Primitive(mat) {
+TriangleMesh::TriangleMesh(std::vector<Vec3> vertices, std::vector<unsigned int> indices, std::shared_ptr<Material> mat)
+    : TriangleMesh(MeshAsset::build(std::move(vertices), std::move(indices)), mat) {}
+
+TriangleMesh::TriangleMesh(std::shared_ptr<MeshAsset> asset, std::shared_ptr<Material> mat)
+    : Primitive(mat), asset(std::move(asset)) {
     type = PrimitiveType::MESH;
+    set_solid_mass_properties(this->asset->get_solid_mass_properties());
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = this->asset->get_bounds();
+}
+
+std::shared_ptr<Primitive> TriangleMesh::clone() const {
+    auto copy = std::make_shared<TriangleMesh>(asset, material);
+    copy->copy_body_from(*this);
+    return copy;
 }
 
 // --- Cylinder Derived Class --- //
@@ -132,4 +279,119 @@ TriangleMesh::TriangleMesh(std::shared_ptr<Material> mat)
 Cylinder::Cylinder(float height, float radius, int sides, std::shared_ptr<Material> mat)
     : Primitive(mat), height(height), radius(radius), sides(sides) {
     type = PrimitiveType::CYLINDER;
+    // Calculate inertia tensor for a solid cylinder along Y
+    float mass = material->mass;
+    float I_side = (1.0f / 12.0f) * mass * (3.0f * radius * radius + height * height);
+    inertia_tensor.m[0][0] = I_side;
+    inertia_tensor.m[1][1] = 0.5f * mass * radius * radius;
+    inertia_tensor.m[2][2] = I_side;
+    mat3_inverse(&inertia_tensor, &inverse_inertia_tensor);
+    update_mass_properties();
+
+    float half_height = 0.5f * height;
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = {{-radius, -half_height, -radius}, {radius, half_height, radius}};
+}
+
+std::shared_ptr<Primitive> Cylinder::clone() const {
+    auto copy = std::make_shared<Cylinder>(height, radius, sides, material);
+    copy->copy_body_from(*this);
+    return copy;
+}
+
+// --- Capsule Derived Class --- //
+
+Capsule::Capsule(float height, float radius, std::shared_ptr<Material> mat)
+    : Primitive(mat), height(height), radius(radius) {
+    type = PrimitiveType::CAPSULE;
+    // The mass is split between the cylinder and the two caps (one sphere) by volume
+    float mass = material->mass;
+    float cylinder_volume = height * radius * radius;
+    float caps_volume = (4.0f / 3.0f) * radius * radius * radius;
+    float total_volume = cylinder_volume + caps_volume;
+    float cylinder_mass = total_volume > 0.0f ? mass * cylinder_volume / total_volume : 0.0f;
+    float caps_mass = mass - cylinder_mass;
+
+    // Each cap's center of mass sits 3/8 radius past its cylinder end, which the parallel axis theorem accounts for
+    float I_side = cylinder_mass * (height * height / 12.0f + radius * radius / 4.0f) +
+                   caps_mass * (0.4f * radius * radius + height * height / 4.0f + 0.375f * height * radius);
+    inertia_tensor.m[0][0] = I_side;
+    inertia_tensor.m[1][1] = cylinder_mass * 0.5f * radius * radius + caps_mass * 0.4f * radius * radius;
+    inertia_tensor.m[2][2] = I_side;
+    mat3_inverse(&inertia_tensor, &inverse_inertia_tensor);
+    update_mass_properties();
+
+    float half_length = 0.5f * height + radius;
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = {{-radius, -half_length, -radius}, {radius, half_length, radius}};
+}
+
+std::shared_ptr<Primitive> Capsule::clone() const {
+    auto copy = std::make_shared<Capsule>(height, radius, material);
+    copy->copy_body_from(*this);
+    return copy;
+}
+
+// --- ConvexHull Derived Class --- //
+
+ConvexHull::ConvexHull(const std::vector<Vec3>& points, std::shared_ptr<Material> mat) : Primitive(mat) {
+    type = PrimitiveType::CONVEX_HULL;
+    HullMesh hull;
+    bool solid = build_convex_hull(points.data(), points.size(), hull);
+    vertices = solid ? std::move(hull.vertices) : points;
+
+    AABB bounds = {{0, 0, 0}, {0, 0, 0}};
+    if (!vertices.empty()) {
+        bounds = {vertices[0], vertices[0]};
+        for (const Vec3& v : vertices) {
+            bounds.min = {fminf(bounds.min.x, v.x), fminf(bounds.min.y, v.y), fminf(bounds.min.z, v.z)};
+            bounds.max = {fmaxf(bounds.max.x, v.x), fmaxf(bounds.max.y, v.y), fmaxf(bounds.max.z, v.z)};
+        }
+    }
+
+    if (solid) {
+        set_solid_mass_properties(compute_mass_properties(vertices.data(), hull.indices.data(), hull.indices.size() / 3));
+    } else {
+        // Calculate inertia tensor for the solid box around the points
+        float mass = material->mass;
+        Vec3 size;
+        vec3_sub(&bounds.max, &bounds.min, &size);
+        inertia_tensor.m[0][0] = (1.0f / 12.0f) * mass * (size.y * size.y + size.z * size.z);
+        inertia_tensor.m[1][1] = (1.0f / 12.0f) * mass * (size.x * size.x + size.z * size.z);
+        inertia_tensor.m[2][2] = (1.0f / 12.0f) * mass * (size.x * size.x + size.y * size.y);
+        mat3_inverse(&inertia_tensor, &inverse_inertia_tensor);
+        update_mass_properties();
+    }
+
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = bounds;
+}
+
+ConvexHull::ConvexHull(const MeshAsset& asset, std::shared_ptr<Material> mat)
+    : ConvexHull(std::vector<Vec3>(asset.get_hull_points(), asset.get_hull_points() + asset.get_hull_point_count()), mat) {}
+
+std::shared_ptr<Primitive> ConvexHull::clone() const {
+    auto copy = std::make_shared<ConvexHull>(vertices, material);
+    copy->copy_body_from(*this);
+    return copy;
+}
+
+// --- Plane Derived Class --- //
+
+Plane::Plane(std::shared_ptr<Material> mat)
+    : Primitive(mat) {
+    type = PrimitiveType::PLANE;
+    state_field(&BodyStore::inverse_masses, &BodyState::inverse_mass) = 0.0f;
+    state_field(&BodyStore::flags, &BodyState::flags) |= BODY_FLAG_STATIC;
+
+    // Everything below the surface is solid, so the bounds reach as deep as they reach out
+    state_field(&BodyStore::local_bounds, &BodyState::local_bounds) = {{-half_size, -half_size, -half_size}, {half_size, 0.0f, half_size}};
+}
+
+std::shared_ptr<Primitive> Plane::clone() const {
+    auto copy = std::make_shared<Plane>(material);
+    copy->copy_body_from(*this);
+    return copy;
+}
+
+Vec3 Plane::get_normal() const {
+    Quat orientation = get_orientation();
+    return quat_rotate(&orientation, {0, 1, 0});
 }
@@ -0,0 +1,296 @@
+#include "volleybot_physics/quickhull.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace {
+
+// The hull is built in double precision, from float input
+struct Point {
+    double x, y, z;
+};
+
+Point sub(const Point& a, const Point& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Point cross(const Point& a, const Point& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+double dot(const Point& a, const Point& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+double length(const Point& a) { return std::sqrt(dot(a, a)); }
+
+struct Face {
+    int v[3];
+    Point normal;  // Unit length, outwards
+    double offset; // dot(normal, p) on the face's plane
+    std::vector<int> outside;  // Points in front of this face and no earlier one
+    bool alive;
+};
+
+// Directed edges are keyed by their two ends, so the face across edge (a, b) is the one owning (b, a)
+uint64_t edge_key(int a, int b) { return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b; }
+
+class HullBuilder {
+public:
+    HullBuilder(const Vec3* input, size_t count) : points(count) {
+        double scale = 0.0;
+        for (size_t i = 0; i < count; ++i) {
+            points[i] = {input[i].x, input[i].y, input[i].z};
+            scale = std::max(scale, std::fabs(points[i].x) + std::fabs(points[i].y) + std::fabs(points[i].z));
+        }
+        // The points are floats, so anything closer to a plane than a few float steps of the cloud's size is on it
+        tolerance = 4.0 * FLT_EPSILON * scale;
+        diameter = 2.0 * scale;
+    }
+
+    bool build(HullMesh& hull) {
+        if (!make_tetrahedron()) return false;
+        for (size_t f = 0; f < faces.size(); ++f) {
+            // New faces are appended as the hull grows, so this visits them too
+            while (faces[f].alive && !faces[f].outside.empty()) add_point(f);
+        }
+        output(hull);
+        return true;
+    }
+
+private:
+    double distance(const Face& face, int p) const { return dot(face.normal, points[p]) - face.offset; }
+
+    // Adds the face a, b, c, facing the side it winds counterclockwise on
+    int add_face(int a, int b, int c) {
+        Face face;
+        face.v[0] = a;
+        face.v[1] = b;
+        face.v[2] = c;
+        Point normal = cross(sub(points[b], points[a]), sub(points[c], points[a]));
+        double len = length(normal);
+        // A sliver too thin for a normal sees no points, so the hull grows around it
+        face.normal = len > 0.0 ? Point{normal.x / len, normal.y / len, normal.z / len} : Point{0.0, 0.0, 0.0};
+        face.offset = dot(face.normal, points[a]);
+        face.alive = true;
+        int index = (int)faces.size();
+        for (int k = 0; k < 3; ++k) edges[edge_key(face.v[k], face.v[(k + 1) % 3])] = index;
+        faces.push_back(std::move(face));
+        return index;
+    }
+
+    // Adds a face of the first tetrahedron, wound to face away from its inside
+    int add_face_facing_away(int a, int b, int c, const Point& inside) {
+        Point normal = cross(sub(points[b], points[a]), sub(points[c], points[a]));
+        return dot(normal, sub(inside, points[a])) > 0.0 ? add_face(a, c, b) : add_face(a, b, c);
+    }
+
+    // Gives each point to the first of the faces it lies in front of, or drops it as inside
+    void assign_outside(const std::vector<int>& candidates, const std::vector<int>& new_faces) {
+        for (int p : candidates) {
+            int best = -1;
+            double best_distance = tolerance;
+            for (int f : new_faces) {
+                double d = distance(faces[f], p);
+                if (d > best_distance) {
+                    best = f;
+                    best_distance = d;
+                }
+            }
+            if (best >= 0) faces[best].outside.push_back(p);
+        }
+    }
+
+    // A tetrahedron of extreme points: the two furthest apart of the axis extremes, the point furthest from their line, then the one furthest from their plane
+    bool make_tetrahedron() {
+        int n = (int)points.size();
+        if (n < 4) return false;
+        int extremes[6] = {0, 0, 0, 0, 0, 0};
+        for (int i = 1; i < n; ++i) {
+            const double* p = &points[i].x;
+            for (int axis = 0; axis < 3; ++axis) {
+                if (p[axis] < (&points[extremes[2 * axis]].x)[axis]) extremes[2 * axis] = i;
+                if (p[axis] > (&points[extremes[2 * axis + 1]].x)[axis]) extremes[2 * axis + 1] = i;
+            }
+        }
+        int a = 0, b = 0;
+        double best = -1.0;
+        for (int i = 0; i < 6; ++i) {
+            for (int j = i + 1; j < 6; ++j) {
+                double d = length(sub(points[extremes[i]], points[extremes[j]]));
+                if (d > best) {
+                    best = d;
+                    a = extremes[i];
+                    b = extremes[j];
+                }
+            }
+        }
+        if (best <= tolerance) return false;
+
+        Point line = sub(points[b], points[a]);
+        int c = -1;
+        best = tolerance * length(line);
+        for (int i = 0; i < n; ++i) {
+            double d = length(cross(line, sub(points[i], points[a])));
+            if (d > best) {
+                best = d;
+                c = i;
+            }
+        }
+        if (c < 0) return false;
+
+        Point normal = cross(line, sub(points[c], points[a]));
+        double normal_length = length(normal);
+        int d = -1;
+        best = tolerance;
+        for (int i = 0; i < n; ++i) {
+            double dist = std::fabs(dot(normal, sub(points[i], points[a]))) / normal_length;
+            if (dist > best) {
+                best = dist;
+                d = i;
+            }
+        }
+        if (d < 0) return false;
+
+        Point center = {(points[a].x + points[b].x + points[c].x + points[d].x) / 4,
+                        (points[a].y + points[b].y + points[c].y + points[d].y) / 4,
+                        (points[a].z + points[b].z + points[c].z + points[d].z) / 4};
+        std::vector<int> new_faces = {add_face_facing_away(a, b, c, center), add_face_facing_away(a, b, d, center),
+                                      add_face_facing_away(a, c, d, center), add_face_facing_away(b, c, d, center)};
+        std::vector<int> candidates;
+        for (int i = 0; i < n; ++i) {
+            if (i != a && i != b && i != c && i != d) candidates.push_back(i);
+        }
+        assign_outside(candidates, new_faces);
+        return true;
+    }
+
+    /**
+     * The faces the apex can see, which are connected, so they are found by walking across edges from 'start', and
+     * the edges around them. A face the apex is in front of by no more than the tolerance is kept, unless the new face
+     * over the edge between them would bend up from it enough to have a point of the cloud more than the tolerance in
+     * front: slivers with the apex close to the edge tilt far for a tiny height.
+     */
+    void find_visible(size_t start, int apex, bool exact, std::vector<int>& visible,
+                      std::vector<std::pair<int, int>>& horizon) const {
+        std::vector<signed char> state(faces.size(), 0);  // 1 visible, -1 kept, 0 not reached
+        visible.assign(1, (int)start);
+        state[start] = 1;
+        for (size_t i = 0; i < visible.size(); ++i) {
+            const Face& face = faces[visible[i]];
+            for (int k = 0; k < 3; ++k) {
+                int a = face.v[k], b = face.v[(k + 1) % 3];
+                auto found = edges.find(edge_key(b, a));
+                if (found == edges.end() || state[found->second] != 0) continue;
+                int across = found->second;
+                double d = distance(faces[across], apex);
+                bool seen = d > 0.0;
+                if (seen && !exact && d <= tolerance) {
+                    Point edge = sub(points[b], points[a]);
+                    double height = length(cross(edge, sub(points[apex], points[a]))) / length(edge);
+                    seen = d * diameter > tolerance * height;
+                }
+                state[across] = seen ? 1 : -1;
+                if (seen) visible.push_back(across);
+            }
+        }
+        horizon.clear();
+        for (int f : visible) {
+            const Face& face = faces[f];
+            for (int k = 0; k < 3; ++k) {
+                int a = face.v[k], b = face.v[(k + 1) % 3];
+                auto found = edges.find(edge_key(b, a));
+                if (found != edges.end() && state[found->second] != 1) horizon.push_back({a, b});
+            }
+        }
+    }
+
+    // True if the edges chain into a single closed loop, which the fan to the apex needs
+    static bool is_one_loop(const std::vector<std::pair<int, int>>& horizon) {
+        std::unordered_map<int, int> next;
+        for (const auto& edge : horizon) {
+            if (!next.emplace(edge.first, edge.second).second) return false;
+        }
+        size_t steps = 0;
+        int v = horizon.front().first;
+        do {
+            auto found = next.find(v);
+            if (found == next.end()) return false;
+            v = found->second;
+            ++steps;
+        } while (v != horizon.front().first && steps <= horizon.size());
+        return steps == horizon.size();
+    }
+
+    // True if a new face over a horizon edge would have another corner of the horizon, or the far corner of the face kept beside it, more than the tolerance in front
+    bool fan_bends_inwards(const std::vector<std::pair<int, int>>& horizon, int apex) const {
+        for (const auto& edge : horizon) {
+            int a = edge.first, b = edge.second;
+            const Face& across = faces[edges.at(edge_key(b, a))];
+            Point normal = cross(sub(points[b], points[a]), sub(points[apex], points[a]));
+            double limit = tolerance * length(normal);
+            if (dot(normal, sub(points[across.v[0] + across.v[1] + across.v[2] - a - b], points[a])) > limit) return true;
+            for (const auto& other : horizon) {
+                if (dot(normal, sub(points[other.first], points[a])) > limit) return true;
+            }
+        }
+        return false;
+    }
+
+    // Adds the furthest outside point of a face, replacing every face it can see with a fan from the horizon to it
+    void add_point(size_t start) {
+        const Face& first = faces[start];
+        int apex = first.outside[0];
+        for (int p : first.outside) {
+            if (distance(first, p) > distance(first, apex)) apex = p;
+        }
+
+        // A face the apex is within the tolerance of counts as behind it, as in assign_outside, so nearly coplanar
+        // faces are not torn up for it. Should that leave the horizon in more than one loop, or the fan of new faces
+        // bent inwards, the exact side decides.
+        std::vector<int> visible;
+        std::vector<std::pair<int, int>> horizon;
+        find_visible(start, apex, false, visible, horizon);
+        if (!is_one_loop(horizon) || fan_bends_inwards(horizon, apex)) find_visible(start, apex, true, visible, horizon);
+
+        std::vector<int> orphans;
+        for (int f : visible) {
+            Face& face = faces[f];
+            face.alive = false;
+            for (int k = 0; k < 3; ++k) edges.erase(edge_key(face.v[k], face.v[(k + 1) % 3]));
+            for (int p : face.outside) {
+                if (p != apex) orphans.push_back(p);
+            }
+            face.outside.clear();
+        }
+        std::vector<int> new_faces;
+        for (const auto& edge : horizon) {
+            // Wound like the visible face that had the edge, so the new face faces outwards too
+            new_faces.push_back(add_face(edge.first, edge.second, apex));
+        }
+        assign_outside(orphans, new_faces);
+    }
+
+    void output(HullMesh& hull) const {
+        std::vector<int> remap(points.size(), -1);
+        for (const Face& face : faces) {
+            if (!face.alive) continue;
+            for (int k = 0; k < 3; ++k) {
+                int v = face.v[k];
+                if (remap[v] < 0) {
+                    remap[v] = (int)hull.vertices.size();
+                    hull.vertices.push_back({(float)points[v].x, (float)points[v].y, (float)points[v].z});
+                }
+                hull.indices.push_back((unsigned int)remap[v]);
+            }
+        }
+    }
+
+    std::vector<Point> points;
+    std::vector<Face> faces;
+    std::unordered_map<uint64_t, int> edges;  // Directed edge to the face it belongs to
+    double tolerance;
+    double diameter;  // Bounds the distance between any two points
+};
+
+} // namespace
+
+bool build_convex_hull(const Vec3* points, size_t count, HullMesh& hull) {
+    hull.vertices.clear();
+    hull.indices.clear();
+    HullBuilder builder(points, count);
+    return builder.build(hull);
+}
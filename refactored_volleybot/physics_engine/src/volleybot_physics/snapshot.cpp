@@ -0,0 +1,161 @@
+#include "volleybot_physics/snapshot.h"
+#include <cstring>
+
+static const uint32_t snapshot_magic = 0x53534256; // "VBSS"
+static const uint32_t snapshot_version = 3;
+
+// A contact cache entry with its bodies as slots relative to the snapshot's first body
+struct SnapshotContact {
+    uint32_t body_a;
+    uint32_t body_b;
+    uint32_t feature_id;
+    CachedImpulse impulse;
+};
+
+// A convex cache entry, stored by slot like the contacts
+struct SnapshotConvexPair {
+    uint32_t body_a;
+    uint32_t body_b;
+    ConvexPairCache pair;
+};
+
+// Bytes of the bodies' fields. Every section is a multiple of 4 bytes long except the flags, which come last among them and are padded.
+static size_t body_section_size(uint32_t body_count) {
+    size_t flags_size = (body_count + 3) & ~(size_t)3;
+    return body_count * (4 * sizeof(Vec3) + sizeof(Quat) + sizeof(float) + sizeof(uint32_t)) + flags_size;
+}
+
+// Bytes of a snapshot with the given counts
+static size_t snapshot_size(uint32_t body_count, uint32_t joint_count, uint32_t contact_count, uint32_t convex_pair_count) {
+    return sizeof(SnapshotHeader) + body_section_size(body_count) +
+           joint_count * sizeof(float) +
+           contact_count * sizeof(SnapshotContact) +
+           convex_pair_count * sizeof(SnapshotConvexPair);
+}
+
+template <typename T>
+static uint8_t* write_array(uint8_t* cursor, const T* values, size_t count) {
+    std::memcpy(cursor, values, count * sizeof(T));
+    return cursor + count * sizeof(T);
+}
+
+template <typename T>
+static const uint8_t* read_array(const uint8_t* cursor, T* values, size_t count) {
+    std::memcpy(values, cursor, count * sizeof(T));
+    return cursor + count * sizeof(T);
+}
+
+void write_snapshot(const SnapshotTarget& source, std::vector<uint8_t>& out) {
+    const BodyStore& store = *source.store;
+    uint32_t first = source.first_body;
+    uint32_t n = source.body_count;
+    uint32_t joint_count = (uint32_t)source.joints->size();
+    uint32_t contact_count = (uint32_t)source.contacts->size();
+    uint32_t convex_pair_count = (uint32_t)source.convex_pairs->size();
+
+    out.resize(snapshot_size(n, joint_count, contact_count, convex_pair_count));
+    SnapshotHeader header = {snapshot_magic, snapshot_version, n, joint_count, contact_count, convex_pair_count};
+    uint8_t* cursor = write_array(out.data(), &header, 1);
+
+    cursor = write_array(cursor, store.positions.data() + first, n);
+    cursor = write_array(cursor, store.velocities.data() + first, n);
+    cursor = write_array(cursor, store.accelerations.data() + first, n);
+    cursor = write_array(cursor, store.angular_velocities.data() + first, n);
+    cursor = write_array(cursor, store.orientations.data() + first, n);
+    cursor = write_array(cursor, store.sleep_times.data() + first, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t link = store.sleep_links[first + i] - first;
+        cursor = write_array(cursor, &link, 1);
+    }
+    uint8_t* flags_end = write_array(cursor, store.flags.data() + first, n);
+    cursor += (n + 3) & ~(size_t)3;
+    std::memset(flags_end, 0, cursor - flags_end);
+
+    for (RevoluteJoint* joint : *source.joints) {
+        float speed = joint->get_motor_speed();
+        cursor = write_array(cursor, &speed, 1);
+    }
+
+    for (size_t i = 0; i < contact_count; ++i) {
+        const ContactKey& key = source.contacts->get_key(i);
+        SnapshotContact contact = {
+            key.a->get_body_index() - first,
+            key.b->get_body_index() - first,
+            key.feature_id,
+            source.contacts->get_impulse(i)
+        };
+        cursor = write_array(cursor, &contact, 1);
+    }
+
+    for (size_t i = 0; i < convex_pair_count; ++i) {
+        SnapshotConvexPair pair = {
+            source.convex_pairs->get_a(i)->get_body_index() - first,
+            source.convex_pairs->get_b(i)->get_body_index() - first,
+            source.convex_pairs->get_pair(i)
+        };
+        cursor = write_array(cursor, &pair, 1);
+    }
+}
+
+bool read_snapshot(const SnapshotTarget& target, const uint8_t* data, size_t size) {
+    SnapshotHeader header;
+    if (size < sizeof(SnapshotHeader)) return false;
+    const uint8_t* cursor = read_array(data, &header, 1);
+    if (header.magic != snapshot_magic || header.version != snapshot_version) return false;
+    if (header.body_count != target.body_count || header.joint_count != target.joints->size()) return false;
+    if (size != snapshot_size(header.body_count, header.joint_count, header.contact_count, header.convex_pair_count)) return false;
+
+    BodyStore& store = *target.store;
+    uint32_t first = target.first_body;
+    uint32_t n = header.body_count;
+
+    // The motor targets go first: changing one wakes its bodies, and the restored flags must have the last word
+    const uint8_t* bodies = cursor;
+    cursor += body_section_size(n);
+    for (RevoluteJoint* joint : *target.joints) {
+        float speed;
+        cursor = read_array(cursor, &speed, 1);
+        joint->set_motor_speed(speed);
+    }
+
+    bodies = read_array(bodies, store.positions.data() + first, n);
+    bodies = read_array(bodies, store.velocities.data() + first, n);
+    bodies = read_array(bodies, store.accelerations.data() + first, n);
+    bodies = read_array(bodies, store.angular_velocities.data() + first, n);
+    bodies = read_array(bodies, store.orientations.data() + first, n);
+    bodies = read_array(bodies, store.sleep_times.data() + first, n);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t link;
+        bodies = read_array(bodies, &link, 1);
+        // Like the contacts, a link outside the target's slots is not followed
+        store.sleep_links[first + i] = link < n ? first + link : first + i;
+    }
+    read_array(bodies, store.flags.data() + first, n);
+
+    // Map the contacts' slots back to this target's primitives
+    target.contacts->begin_update();
+    for (uint32_t i = 0; i < header.contact_count; ++i) {
+        SnapshotContact contact;
+        cursor = read_array(cursor, &contact, 1);
+        if (contact.body_a >= n || contact.body_b >= n) continue;
+        const Primitive* a = store.owners[first + contact.body_a];
+        const Primitive* b = store.owners[first + contact.body_b];
+        target.contacts->add({a, b, contact.feature_id}, contact.impulse);
+    }
+    target.contacts->end_update();
+
+    target.convex_pairs->clear();
+    for (uint32_t i = 0; i < header.convex_pair_count; ++i) {
+        SnapshotConvexPair pair;
+        cursor = read_array(cursor, &pair, 1);
+        if (pair.body_a >= n || pair.body_b >= n) continue;
+        target.convex_pairs->add(store.owners[first + pair.body_a], store.owners[first + pair.body_b], pair.pair);
+    }
+    target.convex_pairs->end_update();
+
+    // The solver's world-space inertias follow from the restored orientations, and the bounds are
+    // kept in line with the restored poses until the next step recomputes them
+    store.update_aabbs(first, first + n);
+    store.update_inverse_inertias(first, first + n);
+    return true;
+}
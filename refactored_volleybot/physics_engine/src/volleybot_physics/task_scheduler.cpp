@@ -0,0 +1,191 @@
+#include "volleybot_physics/task_scheduler.h"
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Which scheduler the current thread works for, and its queue there
+static thread_local const TaskScheduler* current_scheduler = nullptr;
+static thread_local size_t current_index = 0;
+
+static int default_thread_count() {
+    const char* forced = std::getenv("VOLLEYBOT_NUM_THREADS");
+    if (forced && std::atoi(forced) > 0) {
+        return std::atoi(forced);
+    }
+    unsigned hardware = std::thread::hardware_concurrency();
+    return hardware > 0 ? (int)hardware : 1;
+}
+
+// Pins a thread to the n-th core in the process's affinity mask, wrapping around
+static void pin_to_core(std::thread& thread, size_t n) {
+#if defined(__linux__)
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return;
+    int core_count = CPU_COUNT(&allowed);
+    if (core_count == 0) return;
+
+    size_t target = n % (size_t)core_count;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (!CPU_ISSET(cpu, &allowed)) continue;
+        if (target-- == 0) {
+            cpu_set_t single;
+            CPU_ZERO(&single);
+            CPU_SET(cpu, &single);
+            pthread_setaffinity_np(thread.native_handle(), sizeof(single), &single);
+            return;
+        }
+    }
+#else
+    (void)thread;
+    (void)n;
+#endif
+}
+
+TaskScheduler::TaskScheduler(int num_threads, bool pin_threads)
+    : queued_tasks(0), stopping(false), pin_threads(pin_threads) {
+    if (num_threads <= 0) {
+        num_threads = default_thread_count();
+    }
+
+    // Queue 0 belongs to the threads that call into the pool, the others to the workers
+    for (int i = 0; i < num_threads; ++i) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (int i = 1; i < num_threads; ++i) {
+        workers.emplace_back(&TaskScheduler::worker_loop, this, (size_t)i);
+        if (pin_threads) {
+            // The caller keeps core 0 of the mask to itself
+            pin_to_core(workers.back(), (size_t)i);
+        }
+    }
+}
+
+TaskScheduler::~TaskScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping = true;
+    }
+    wake_workers.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void TaskScheduler::worker_loop(size_t index) {
+    current_scheduler = this;
+    current_index = index;
+
+    while (true) {
+        Task task;
+        if (pop_local(index, &task) || steal(index, &task)) {
+            run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        wake_workers.wait(lock, [this] { return stopping.load() || queued_tasks.load() > 0; });
+        if (stopping) return;
+    }
+}
+
+size_t TaskScheduler::current_queue() const {
+    return current_scheduler == this ? current_index : 0;
+}
+
+bool TaskScheduler::pop_local(size_t index, Task* out_task) {
+    TaskQueue& queue = *queues[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) return false;
+    // Newest first: its data is most likely still in this core's cache
+    *out_task = queue.tasks.back();
+    queue.tasks.pop_back();
+    --queued_tasks;
+    return true;
+}
+
+bool TaskScheduler::steal(size_t thief, Task* out_task) {
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        TaskQueue& queue = *queues[(thief + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        // Oldest first: the largest remaining piece of the victim's work
+        *out_task = queue.tasks.front();
+        queue.tasks.pop_front();
+        --queued_tasks;
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::run(const Task& task) {
+    (*task.body)(task.begin, task.end);
+    task.pending->fetch_sub(1, std::memory_order_release);
+}
+
+void TaskScheduler::parallel_for(size_t count, size_t grain_size, const std::function<void(size_t, size_t)>& body) {
+    if (count == 0) return;
+    grain_size = std::max<size_t>(grain_size, 1);
+    if (count <= grain_size || queues.size() == 1) {
+        body(0, count);
+        return;
+    }
+
+    // A few chunks per thread leaves room for stealing to even out the load
+    size_t chunk_size = std::max(grain_size, (count + 4 * queues.size() - 1) / (4 * queues.size()));
+    size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+    std::atomic<size_t> pending(chunk_count);
+
+    // Queue every chunk but the first, which this thread starts on right away
+    size_t self = current_queue();
+    {
+        TaskQueue& queue = *queues[self];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (size_t chunk = chunk_count - 1; chunk > 0; --chunk) {
+            size_t begin = chunk * chunk_size;
+            queue.tasks.push_back({&body, begin, std::min(begin + chunk_size, count), &pending});
+        }
+        queued_tasks += chunk_count - 1;
+    }
+    {
+        // Taking the lock orders the wakeup after a worker's check of queued_tasks
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+    }
+    wake_workers.notify_all();
+
+    run({&body, 0, std::min(chunk_size, count), &pending});
+
+    // Help out until every chunk is done. This may run tasks of other loops, which keeps nesting deadlock-free.
+    while (pending.load(std::memory_order_acquire) > 0) {
+        Task task;
+        if (pop_local(self, &task) || steal(self, &task)) {
+            run(task);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+static std::unique_ptr<TaskScheduler>& global_scheduler() {
+    static std::unique_ptr<TaskScheduler> scheduler;
+    return scheduler;
+}
+
+TaskScheduler& TaskScheduler::global() {
+    static std::once_flag created;
+    std::call_once(created, [] {
+        if (!global_scheduler()) {
+            global_scheduler() = std::make_unique<TaskScheduler>();
+        }
+    });
+    return *global_scheduler();
+}
+
+void TaskScheduler::configure_global(int num_threads, bool pin_threads) {
+    // Join the old workers first, so the two pools never oversubscribe the machine
+    global_scheduler().reset();
+    global_scheduler() = std::make_unique<TaskScheduler>(num_threads, pin_threads);
+}
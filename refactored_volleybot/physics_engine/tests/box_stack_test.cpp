@@ -0,0 +1,58 @@
+// Five boxes stacked straight up on a ground box must stay where they were put and fall asleep.
+// The stack used to tip over: contacts bounced off each other's warm starts, and pushing the boxes
+// out of the ground only moved them, so any tilt they picked up was never taken back.
+#include "volleybot_physics/scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+static bool stays_put(bool sleeping) {
+    Scene scene;
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+
+    auto ground_material = std::make_shared<Material>();
+    ground_material->mass = 0.0f;
+    auto ground = std::make_shared<Box>(Vec3{10.0f, 0.5f, 10.0f}, ground_material);
+    ground->set_position({0.0f, -0.5f, 0.0f});
+    scene.add_primitive(ground);
+
+    const int box_count = 5;
+    std::vector<std::shared_ptr<Box>> boxes;
+    for (int i = 0; i < box_count; ++i) {
+        auto material = std::make_shared<Material>();
+        material->mass = 1.0f;
+        auto box = std::make_shared<Box>(Vec3{0.5f, 0.5f, 0.5f}, material);
+        box->set_position({0.0f, 0.5f + (float)i, 0.0f});
+        scene.add_primitive(box);
+        boxes.push_back(box);
+    }
+
+    for (int i = 0; i < 600; ++i) scene.step(1.0f / 60.0f);
+
+    // Each box may sink into the one below by a little more than the contact slop, but not slide off it
+    float drift = 0.0f, sag = 0.0f, speed = 0.0f;
+    bool asleep = true;
+    for (int i = 0; i < box_count; ++i) {
+        Vec3 position = boxes[i]->get_position();
+        Vec3 velocity = boxes[i]->get_velocity();
+        drift = std::max(drift, std::sqrt(position.x * position.x + position.z * position.z));
+        sag = std::max(sag, 0.5f + (float)i - position.y);
+        speed = std::max(speed, vec3_length(&velocity));
+        asleep = asleep && boxes[i]->is_sleeping();
+    }
+    bool ok = drift < 0.05f && sag < 0.02f * box_count && speed < 0.05f && (asleep || !sleeping);
+    std::printf("%s: sleeping %s, drifted %.4f, sank %.4f, speed %.4f, %s\n", ok ? "ok" : "FAILED",
+                sleeping ? "on" : "off", drift, sag, speed, asleep ? "asleep" : "awake");
+    return ok;
+}
+
+int main() {
+    bool ok = stays_put(true);
+    ok = stays_put(false) && ok;
+    return ok ? 0 : 1;
+}
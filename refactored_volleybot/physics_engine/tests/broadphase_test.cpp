@@ -0,0 +1,178 @@
+// Every broadphase must report the same pairs as testing every pair of AABBs, while the bodies
+// move and with a ground and net too big for the spatial hash's cells. A floor moved by hand must also still hold a ball with every broadphase: the AABB tree
+// used to build its static tree once and never refit it, so a ball over the floor's new place fell through.
+#include "volleybot_physics/scene.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <set>
+#include <utility>
+#include <vector>
+
+static const char* broadphase_names[] = {"sweep and prune", "AABB tree", "spatial hash"};
+
+// Every pair of overlapping AABBs where at least one body can move
+static std::set<std::pair<uint32_t, uint32_t>> all_pairs(const BodyStore& bodies, const std::vector<uint32_t>& proxies) {
+    std::set<std::pair<uint32_t, uint32_t>> pairs;
+    for (size_t i = 0; i < proxies.size(); ++i) {
+        for (size_t j = i + 1; j < proxies.size(); ++j) {
+            uint32_t a = std::min(proxies[i], proxies[j]), b = std::max(proxies[i], proxies[j]);
+            if (is_static_body(bodies, a) && is_static_body(bodies, b)) continue;
+            if (aabb_overlap(bodies.aabbs[a], bodies.aabbs[b])) pairs.insert({a, b});
+        }
+    }
+    return pairs;
+}
+
+// Runs the broadphase and compares its pairs with all_pairs. Each pair must come once, with a < b.
+static bool same_pairs(Broadphase& broadphase, const BodyStore& bodies, const std::vector<uint32_t>& proxies,
+                       size_t& expected_count) {
+    std::vector<BroadphasePair> found;
+    broadphase.find_pairs(bodies, proxies, found);
+    std::set<std::pair<uint32_t, uint32_t>> expected = all_pairs(bodies, proxies), reported;
+    bool ok = true;
+    for (const BroadphasePair& pair : found) {
+        ok = ok && pair.a < pair.b && reported.insert({pair.a, pair.b}).second;
+    }
+    expected_count = expected.size();
+    return ok && reported == expected;
+}
+
+// A fixed sequence in [-0.5, 0.5)
+struct Lcg {
+    uint32_t state = 12345;
+    float next() {
+        state = state * 1664525u + 1013904223u;
+        return (float)(state >> 8) / 16777216.0f - 0.5f;
+    }
+};
+
+// Boxes of mixed sizes scattered over a court, a quarter of them static
+static void scatter_bodies(BodyStore& bodies, std::vector<uint32_t>& proxies, Lcg& random, int count) {
+    for (int i = 0; i < count; ++i) {
+        BodyState state = {};
+        state.orientation = {0.0f, 0.0f, 0.0f, 1.0f};
+        Vec3 center = {18.0f * random.next(), 1.0f + 2.0f * random.next(), 9.0f * random.next()};
+        Vec3 half = {0.2f + 0.4f * (random.next() + 0.5f), 0.2f + 0.4f * (random.next() + 0.5f), 0.2f + 0.4f * (random.next() + 0.5f)};
+        state.position = center;
+        state.aabb = {center - half, center + half};
+        state.inverse_mass = i % 4 == 0 ? 0.0f : 1.0f;
+        state.flags = i % 4 == 0 ? BODY_FLAG_STATIC : 0;
+        proxies.push_back(bodies.add(state, nullptr));
+    }
+}
+
+// Moves every dynamic body a little, as one step of a simulation would
+static void drift_bodies(BodyStore& bodies, const std::vector<uint32_t>& proxies, Lcg& random, float distance) {
+    for (uint32_t body : proxies) {
+        if (is_static_body(bodies, body)) continue;
+        Vec3 move = {distance * random.next(), distance * random.next(), distance * random.next()};
+        bodies.positions[body] = bodies.positions[body] + move;
+        bodies.aabbs[body].min = bodies.aabbs[body].min + move;
+        bodies.aabbs[body].max = bodies.aabbs[body].max + move;
+    }
+}
+
+// 200 bodies drifting over 100 steps. Sweep and prune re-sorts the previous order each step and the
+// AABB tree refits its leaves, so both must keep up with bodies crossing each other.
+static bool pairs_match_while_moving(BroadphaseType type) {
+    BodyStore bodies;
+    std::vector<uint32_t> proxies;
+    Lcg random;
+    scatter_bodies(bodies, proxies, random, 200);
+    std::unique_ptr<Broadphase> broadphase = create_broadphase(type);
+    bool ok = true;
+    size_t pair_count = 0, total = 0;
+    int first_wrong = -1;
+    for (int step = 0; step < 100 && ok; ++step) {
+        size_t expected_count = 0;
+        ok = same_pairs(*broadphase, bodies, proxies, expected_count);
+        if (!ok) first_wrong = step;
+        total += expected_count;
+        pair_count = expected_count;
+        drift_bodies(bodies, proxies, random, 0.2f);
+    }
+    std::printf("%s: %s, %zu pairs in the last step, %zu in all", ok ? "ok" : "FAILED", broadphase_names[(int)type],
+                pair_count, total);
+    if (!ok) std::printf(", wrong from step %d", first_wrong);
+    std::printf("\n");
+    return ok;
+}
+
+// A court with a ground and a net far bigger than the grid's cells, which the spatial hash keeps in its
+// overflow list, and bodies added between calls. Each pair must still be reported once.
+static bool pairs_match_with_ground_and_net(BroadphaseType type) {
+    BodyStore bodies;
+    std::vector<uint32_t> proxies;
+    Lcg random;
+    for (AABB bounds : {AABB{{-10.0f, -1.0f, -5.0f}, {10.0f, 0.0f, 5.0f}}, AABB{{-0.05f, 0.0f, -5.0f}, {0.05f, 2.5f, 5.0f}}}) {
+        BodyState state = {};
+        state.orientation = {0.0f, 0.0f, 0.0f, 1.0f};
+        state.aabb = bounds;
+        state.flags = BODY_FLAG_STATIC;
+        proxies.push_back(bodies.add(state, nullptr));
+    }
+    scatter_bodies(bodies, proxies, random, 100);
+    std::unique_ptr<Broadphase> broadphase = create_broadphase(type);
+    bool ok = true;
+    size_t pair_count = 0;
+    for (int step = 0; step < 50 && ok; ++step) {
+        if (step == 25) scatter_bodies(bodies, proxies, random, 50);
+        ok = same_pairs(*broadphase, bodies, proxies, pair_count);
+        drift_bodies(bodies, proxies, random, 0.2f);
+    }
+    size_t overflow = 0;
+    if (type == BroadphaseType::SPATIAL_HASH) {
+        overflow = static_cast<SpatialHashGrid&>(*broadphase).get_overflow_count();
+        ok = ok && overflow > 0;
+    }
+    std::printf("%s: %s with a ground and net, %zu pairs in the last step, %zu bodies in overflow\n", ok ? "ok" : "FAILED",
+                broadphase_names[(int)type], pair_count, overflow);
+    return ok;
+}
+
+static bool moved_floor_holds_ball(BroadphaseType type, bool sleeping) {
+    Scene scene;
+    scene.set_broadphase_type(type);
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+
+    auto floor_material = std::make_shared<Material>();
+    floor_material->mass = 0.0f;
+    auto floor = std::make_shared<Box>(Vec3{2.0f, 0.5f, 2.0f}, floor_material);
+    floor->set_position({0.0f, -0.5f, 0.0f});
+    scene.add_primitive(floor);
+
+    // The ball starts over empty space, 10 m beside the floor
+    auto ball_material = std::make_shared<Material>();
+    ball_material->mass = 1.0f;
+    auto ball = std::make_shared<Sphere>(0.25f, ball_material);
+    ball->set_position({10.0f, 0.5f, 0.0f});
+    scene.add_primitive(ball);
+
+    scene.step(1.0f / 60.0f);
+    floor->set_position({10.0f, -0.5f, 0.0f});
+    for (int i = 0; i < 300; ++i) scene.step(1.0f / 60.0f);
+
+    float height = ball->get_position().y;
+    bool ok = std::fabs(height - 0.25f) < 0.02f;
+    std::printf("%s: %s, sleeping %s, ball at y=%.4f on the moved floor\n", ok ? "ok" : "FAILED",
+                broadphase_names[(int)type], sleeping ? "on" : "off", height);
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    for (BroadphaseType type : {BroadphaseType::SWEEP_AND_PRUNE, BroadphaseType::AABB_TREE, BroadphaseType::SPATIAL_HASH}) {
+        ok = pairs_match_while_moving(type) && ok;
+        ok = pairs_match_with_ground_and_net(type) && ok;
+        ok = moved_floor_holds_ball(type, true) && ok;
+        ok = moved_floor_holds_ball(type, false) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,78 @@
+// The contact cache must hand back the impulses stored for each contact the step before, and the solver
+// must start from them: with a single velocity iteration a stack of boxes only stands if the impulses
+// that held it up the last step are applied again, and falls over without them.
+#include "volleybot_physics/scene.h"
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <vector>
+
+// Entries added out of order are found by pair and feature, and only last update's entries are kept
+static bool cache_finds_stored_impulses() {
+    auto material = std::make_shared<Material>();
+    Sphere first(0.5f, material), second(0.5f, material), third(0.5f, material);
+    ContactCache cache;
+    cache.begin_update();
+    cache.add({&second, &third, 3}, {3.0f, {0.3f, -0.3f}});
+    cache.add({&first, &second, 1}, {1.0f, {0.1f, -0.1f}});
+    cache.add({&first, &second, 0}, {2.0f, {0.2f, -0.2f}});
+    cache.end_update();
+
+    CachedImpulse impulse;
+    bool ok = cache.size() == 3;
+    ok = ok && cache.find({&first, &second, 0}, &impulse) && impulse.normal == 2.0f && impulse.tangent[0] == 0.2f &&
+         impulse.tangent[1] == -0.2f;
+    ok = ok && cache.find({&first, &second, 1}, &impulse) && impulse.normal == 1.0f;
+    ok = ok && cache.find({&second, &third, 3}, &impulse) && impulse.normal == 3.0f;
+    ok = ok && !cache.find({&first, &second, 2}, &impulse) && !cache.find({&first, &third, 0}, &impulse);
+
+    cache.begin_update();
+    cache.add({&first, &second, 1}, {4.0f, {0.0f, 0.0f}});
+    cache.end_update();
+    ok = ok && cache.size() == 1 && cache.find({&first, &second, 1}, &impulse) && impulse.normal == 4.0f;
+    ok = ok && !cache.find({&first, &second, 0}, &impulse) && !cache.find({&second, &third, 3}, &impulse);
+
+    std::printf("%s: contact cache finds the impulses of the last update\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+// Three unit boxes on a plane, solved with one velocity iteration a step
+static bool warm_started_stack_stands(bool sleeping) {
+    Scene scene;
+    scene.set_solver_iterations(1);
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+
+    auto ground_material = std::make_shared<Material>();
+    ground_material->mass = 0.0f;
+    scene.add_primitive(std::make_shared<Plane>(ground_material));
+    std::vector<std::shared_ptr<Box>> stack;
+    for (int i = 0; i < 3; ++i) {
+        auto material = std::make_shared<Material>();
+        material->mass = 1.0f;
+        auto box = std::make_shared<Box>(Vec3{0.5f, 0.5f, 0.5f}, material);
+        box->set_position({0.0f, 0.5f + i, 0.0f});
+        scene.add_primitive(box);
+        stack.push_back(box);
+    }
+
+    for (int i = 0; i < 240; ++i) scene.step(1.0f / 60.0f);
+
+    Vec3 top = stack.back()->get_position();
+    float drift = std::sqrt(top.x * top.x + top.z * top.z);
+    bool ok = top.y > 2.4f && drift < 0.25f;
+    std::printf("%s: stack with one iteration, sleeping %s, top box at y=%.4f, %.4f off center\n", ok ? "ok" : "FAILED",
+                sleeping ? "on" : "off", top.y, drift);
+    return ok;
+}
+
+int main() {
+    bool ok = cache_finds_stored_impulses();
+    for (bool sleeping : {true, false}) {
+        ok = warm_started_stack_stands(sleeping) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,191 @@
+// A cooked mesh must load back as it was written, and a cooked file with an index or a BVH node that
+// points outside its arrays must be refused rather than mapped, since the queries index with them unchecked.
+// An STL cube, which stores every triangle's corners on their own, must weld back into a closed mesh of 8 vertices.
+#include "volleybot_physics/mesh_asset.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// A bumpy square of 2 * steps * steps triangles, enough for a BVH of several levels
+static std::shared_ptr<MeshAsset> bumpy_square(int steps) {
+    std::vector<Vec3> vertices;
+    std::vector<unsigned int> indices;
+    for (int i = 0; i <= steps; ++i) {
+        for (int j = 0; j <= steps; ++j) {
+            vertices.push_back({(float)i, 0.1f * (float)((i * 7 + j * 3) % 5), (float)j});
+        }
+    }
+    for (int i = 0; i < steps; ++i) {
+        for (int j = 0; j < steps; ++j) {
+            unsigned int corner = (unsigned int)(i * (steps + 1) + j);
+            indices.insert(indices.end(), {corner, corner + 1, corner + (unsigned int)steps + 2});
+            indices.insert(indices.end(), {corner, corner + (unsigned int)steps + 2, corner + (unsigned int)steps + 1});
+        }
+    }
+    return MeshAsset::build(std::move(vertices), std::move(indices));
+}
+
+static std::vector<uint8_t> read_file(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void write_file(const std::string& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+}
+
+// Where an array of the asset sits in its cooked file, found by its contents
+template <typename T>
+static size_t find_section(const std::vector<uint8_t>& bytes, const T* values, size_t count) {
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(values);
+    auto found = std::search(bytes.begin(), bytes.end(), begin, begin + count * sizeof(T));
+    return (size_t)(found - bytes.begin());
+}
+
+template <typename T>
+static void poke(std::vector<uint8_t>& bytes, size_t offset, T value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+static bool cooked_mesh_loads_back(const std::shared_ptr<MeshAsset>& asset, const std::string& path) {
+    std::shared_ptr<MeshAsset> loaded = MeshAsset::load_cooked(path);
+    bool ok = loaded && loaded->get_vertex_count() == asset->get_vertex_count() &&
+              loaded->get_triangle_count() == asset->get_triangle_count() &&
+              loaded->get_node_count() == asset->get_node_count() &&
+              loaded->get_hull_point_count() == asset->get_hull_point_count() &&
+              std::memcmp(loaded->get_indices(), asset->get_indices(), 3 * asset->get_triangle_count() * sizeof(unsigned int)) == 0 &&
+              std::memcmp(loaded->get_bvh_nodes(), asset->get_bvh_nodes(), asset->get_node_count() * sizeof(BvhNode)) == 0;
+    std::printf("%s: cooked mesh of %zu triangles and %zu BVH nodes loads back\n", ok ? "ok" : "FAILED",
+                asset->get_triangle_count(), asset->get_node_count());
+    return ok;
+}
+
+// The triangles of a cube of half size 1, wound outwards, plus one sliver whose corners are closer than the
+// welding distance. 'jitter' moves each stored corner by up to that much, as rounding in an exporter would.
+static std::vector<Vec3> stl_cube_corners(float jitter) {
+    static const unsigned int faces[12][3] = {{0, 2, 3}, {0, 3, 1}, {4, 5, 7}, {4, 7, 6}, {0, 1, 5}, {0, 5, 4},
+                                              {2, 6, 7}, {2, 7, 3}, {0, 4, 6}, {0, 6, 2}, {1, 3, 7}, {1, 7, 5}};
+    uint32_t state = 12345;
+    auto next = [&]() {
+        state = state * 1664525u + 1013904223u;
+        return jitter * ((float)(state >> 8) / 16777216.0f - 0.5f);
+    };
+    std::vector<Vec3> corners;
+    for (const auto& face : faces) {
+        for (unsigned int corner : face) {
+            corners.push_back({(corner & 1 ? 1.0f : -1.0f) + next(), (corner & 2 ? 1.0f : -1.0f) + next(),
+                               (corner & 4 ? 1.0f : -1.0f) + next()});
+        }
+    }
+    corners.insert(corners.end(), {{1.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 1.0f + 1e-6f}, {1.0f + 1e-6f, 1.0f, 1.0f}});
+    return corners;
+}
+
+static void write_binary_stl(const std::string& path, const std::vector<Vec3>& corners) {
+    std::vector<uint8_t> bytes(84 + 50 * (corners.size() / 3), 0);
+    poke(bytes, 80, (uint32_t)(corners.size() / 3));
+    for (size_t t = 0; t < corners.size() / 3; ++t) {
+        std::memcpy(bytes.data() + 84 + 50 * t + 12, &corners[3 * t], 3 * sizeof(Vec3));
+    }
+    write_file(path, bytes);
+}
+
+static void write_ascii_stl(const std::string& path, const std::vector<Vec3>& corners) {
+    std::ofstream file(path, std::ios::trunc);
+    file.precision(9);
+    file << "solid cube\n";
+    for (size_t t = 0; t < corners.size() / 3; ++t) {
+        file << "  facet normal 0 0 0\n    outer loop\n";
+        for (int k = 0; k < 3; ++k) {
+            const Vec3& p = corners[3 * t + k];
+            file << "      vertex " << p.x << " " << p.y << " " << p.z << "\n";
+        }
+        file << "    endloop\n  endfacet\n";
+    }
+    file << "endsolid cube\n";
+}
+
+// The 39 stored corners weld into the cube's 8, and the sliver that welding collapses is dropped
+static bool stl_cube_welds(const std::string& path, bool binary) {
+    std::vector<Vec3> corners = stl_cube_corners(1e-6f);
+    if (binary) {
+        write_binary_stl(path, corners);
+    } else {
+        write_ascii_stl(path, corners);
+    }
+    std::shared_ptr<MeshAsset> cube = MeshAsset::load_stl(path);
+    std::remove(path.c_str());
+    bool ok = cube && cube->get_vertex_count() == 8 && cube->get_triangle_count() == 12 && cube->is_closed() &&
+              std::fabs(cube->get_mass_properties().volume - 8.0f) < 1e-4f;
+    std::printf("%s: %s STL cube of %zu corners welds into %zu vertices and %zu triangles, %s, volume %.5f\n",
+                ok ? "ok" : "FAILED", binary ? "binary" : "ASCII", corners.size(), cube ? cube->get_vertex_count() : 0,
+                cube ? cube->get_triangle_count() : 0, cube && cube->is_closed() ? "closed" : "open",
+                cube ? cube->get_mass_properties().volume : 0.0f);
+    return ok;
+}
+
+int main() {
+    std::shared_ptr<MeshAsset> asset = bumpy_square(8);
+    std::string directory = std::filesystem::temp_directory_path().string();
+    std::string path = directory + "/volleybot_mesh_asset_test.vbmesh";
+    if (!asset || !asset->write_cooked(path)) {
+        std::printf("FAILED: cannot cook a mesh to %s\n", path.c_str());
+        return 1;
+    }
+    bool ok = cooked_mesh_loads_back(asset, path);
+
+    const std::vector<uint8_t> cooked = read_file(path);
+    size_t indices = find_section(cooked, asset->get_indices(), 3 * asset->get_triangle_count());
+    size_t hull_indices = find_section(cooked, asset->get_hull_indices(), 3 * asset->get_hull_triangle_count());
+    size_t nodes = find_section(cooked, asset->get_bvh_nodes(), asset->get_node_count());
+    const BvhNode* tree = asset->get_bvh_nodes();
+    size_t leaf = 0;
+    while (tree[leaf].count == 0) ++leaf;
+    if (indices >= cooked.size() || hull_indices >= cooked.size() || nodes >= cooked.size() || tree[0].count != 0) {
+        std::printf("FAILED: cannot find the arrays to damage in the cooked file\n");
+        return 1;
+    }
+    uint32_t vertex_count = (uint32_t)asset->get_vertex_count();
+    uint32_t triangle_count = (uint32_t)asset->get_triangle_count();
+    uint32_t node_count = (uint32_t)asset->get_node_count();
+
+    struct Damage {
+        const char* name;
+        std::function<void(std::vector<uint8_t>&)> apply;
+    };
+    const Damage damages[] = {
+        {"a vertex index past the vertices", [&](std::vector<uint8_t>& b) { poke(b, indices + 4 * sizeof(unsigned int), vertex_count); }},
+        {"a hull index past the hull points", [&](std::vector<uint8_t>& b) { poke(b, hull_indices, (uint32_t)asset->get_hull_point_count()); }},
+        {"a leaf past the triangles", [&](std::vector<uint8_t>& b) { poke(b, nodes + leaf * sizeof(BvhNode) + offsetof(BvhNode, offset), triangle_count); }},
+        {"an inner node past the nodes", [&](std::vector<uint8_t>& b) { poke(b, nodes + offsetof(BvhNode, offset), node_count); }},
+        {"an inner node pointing back at itself", [&](std::vector<uint8_t>& b) { poke(b, nodes + offsetof(BvhNode, offset), 0u); }},
+        {"a file cut short", [&](std::vector<uint8_t>& b) { b.resize(b.size() - 16); }},
+    };
+    int index = 0;
+    for (const Damage& damage : damages) {
+        std::vector<uint8_t> bytes = cooked;
+        damage.apply(bytes);
+        // A new path for each, so none is taken from the loaded meshes of an earlier one
+        std::string damaged_path = directory + "/volleybot_mesh_asset_test_" + std::to_string(index++) + ".vbmesh";
+        write_file(damaged_path, bytes);
+        bool refused = MeshAsset::load_cooked(damaged_path) == nullptr;
+        std::printf("%s: cooked mesh with %s is %s\n", refused ? "ok" : "FAILED", damage.name, refused ? "refused" : "loaded");
+        ok = refused && ok;
+        std::remove(damaged_path.c_str());
+    }
+    std::remove(path.c_str());
+
+    ok = stl_cube_welds(directory + "/volleybot_mesh_asset_test_binary.stl", true) && ok;
+    ok = stl_cube_welds(directory + "/volleybot_mesh_asset_test_ascii.stl", false) && ok;
+    return ok ? 0 : 1;
+}
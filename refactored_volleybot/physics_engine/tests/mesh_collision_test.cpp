@@ -0,0 +1,95 @@
+// Shapes dropped on a triangle mesh floor must come to rest on top of it, and a mesh with mass
+// dropped on a plane must rest on the plane. Convex hulls and planes used to pass through meshes.
+#include "volleybot_physics/scene.h"
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// A cube around the origin, its faces wound outwards
+static void cube_mesh(float half, std::vector<Vec3>& vertices, std::vector<unsigned int>& indices) {
+    for (int corner = 0; corner < 8; ++corner) {
+        vertices.push_back({corner & 1 ? half : -half, corner & 2 ? half : -half, corner & 4 ? half : -half});
+    }
+    const unsigned int faces[12][3] = {{0, 2, 3}, {0, 3, 1}, {4, 5, 7}, {4, 7, 6}, {0, 1, 5}, {0, 5, 4},
+                                       {2, 6, 7}, {2, 7, 3}, {0, 4, 6}, {0, 6, 2}, {1, 3, 7}, {1, 7, 5}};
+    for (const auto& face : faces) indices.insert(indices.end(), face, face + 3);
+}
+
+static std::shared_ptr<Material> make_material(float mass) {
+    auto material = std::make_shared<Material>();
+    material->mass = mass;
+    return material;
+}
+
+// Resting a contact slop deep at most, without sliding away from where it was dropped
+static bool rests_at(const char* name, const std::shared_ptr<Primitive>& body, Vec3 expected, bool sleeping) {
+    Vec3 position = body->get_position();
+    Vec3 velocity = body->get_velocity();
+    Vec3 offset = position - expected;
+    bool ok = vec3_length(&offset) < 0.03f && vec3_length(&velocity) < 0.05f;
+    std::printf("%s: %s, sleeping %s, at y=%.4f of %.4f, off by %.4f, speed %.4f\n", ok ? "ok" : "FAILED", name,
+                sleeping ? "on" : "off", position.y, expected.y, vec3_length(&offset), vec3_length(&velocity));
+    return ok;
+}
+
+static bool shapes_rest_on_mesh(bool sleeping) {
+    Scene scene;
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+
+    // A flat floor of two triangles, far wider than the shapes
+    std::vector<Vec3> floor_vertices = {{-10, 0, -10}, {10, 0, -10}, {10, 0, 10}, {-10, 0, 10}};
+    std::vector<unsigned int> floor_indices = {0, 2, 1, 0, 3, 2};
+    auto floor = std::make_shared<TriangleMesh>(floor_vertices, floor_indices, make_material(0.0f));
+    scene.add_primitive(floor);
+
+    auto sphere = std::make_shared<Sphere>(0.25f, make_material(1.0f));
+    sphere->set_position({-3.0f, 1.0f, 0.0f});
+    auto box = std::make_shared<Box>(Vec3{0.25f, 0.25f, 0.25f}, make_material(1.0f));
+    box->set_position({0.0f, 1.0f, 0.0f});
+    std::vector<Vec3> cube_points;
+    std::vector<unsigned int> cube_indices;
+    cube_mesh(0.25f, cube_points, cube_indices);
+    auto hull = std::make_shared<ConvexHull>(cube_points, make_material(1.0f));
+    hull->set_position({3.0f, 1.0f, 0.0f});
+    for (const auto& body : std::vector<std::shared_ptr<Primitive>>{sphere, box, hull}) scene.add_primitive(body);
+
+    for (int i = 0; i < 300; ++i) scene.step(1.0f / 60.0f);
+
+    bool ok = rests_at("sphere on mesh", sphere, {-3.0f, 0.25f, 0.0f}, sleeping);
+    ok = rests_at("box on mesh", box, {0.0f, 0.25f, 0.0f}, sleeping) && ok;
+    ok = rests_at("convex hull on mesh", hull, {3.0f, 0.25f, 0.0f}, sleeping) && ok;
+    return ok;
+}
+
+static bool mesh_rests_on_plane(bool sleeping) {
+    Scene scene;
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+
+    scene.add_primitive(std::make_shared<Plane>(make_material(0.0f)));
+    std::vector<Vec3> vertices;
+    std::vector<unsigned int> indices;
+    cube_mesh(0.25f, vertices, indices);
+    auto cube = std::make_shared<TriangleMesh>(vertices, indices, make_material(1.0f));
+    cube->set_position({0.0f, 1.0f, 0.0f});
+    scene.add_primitive(cube);
+
+    for (int i = 0; i < 300; ++i) scene.step(1.0f / 60.0f);
+    return rests_at("mesh on plane", cube, {0.0f, 0.25f, 0.0f}, sleeping);
+}
+
+int main() {
+    bool ok = true;
+    for (bool sleeping : {true, false}) {
+        ok = shapes_rest_on_mesh(sleeping) && ok;
+        ok = mesh_rests_on_plane(sleeping) && ok;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,67 @@
+// The volleyball court's robot must come to rest on the floor, and drive off when its wheel motors
+// turn. Its wheels used to be welded to it as composite parts, so the motors did nothing.
+#include "volleybot_physics/scene.h"
+#include "volleybot_physics/mjcf_model.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+static const char* robot_bodies[] = {"robot_frame", "left_wheel", "right_wheel", "rear_wheel"};
+
+static bool settles_and_drives(const char* path, bool sleeping) {
+    Scene scene;
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+    std::shared_ptr<MjcfModel> model = MjcfModel::load(path, scene);
+    if (!model) {
+        std::printf("FAILED: cannot load %s\n", path);
+        return false;
+    }
+    for (const char* name : robot_bodies) {
+        if (!model->find_body(name)) {
+            std::printf("FAILED: no body %s\n", name);
+            return false;
+        }
+    }
+    std::shared_ptr<Primitive> frame = model->find_body("robot_frame");
+
+    // One second to fall the few millimeters it starts above the floor and settle
+    float dt = model->get_timestep();
+    for (int i = 0; i < 500; ++i) scene.step(dt);
+    float lowest = frame->get_aabb().min.z;
+    for (const char* name : robot_bodies) lowest = std::min(lowest, model->find_body(name)->get_aabb().min.z);
+    Vec3 velocity = frame->get_velocity();
+    float speed = vec3_length(&velocity);
+    bool rests = lowest > -0.002f && speed < 0.01f;
+    std::printf("%s: sleeping %s, lowest point at z=%.4f, speed %.4f\n", rests ? "ok" : "FAILED", sleeping ? "on" : "off",
+                lowest, speed);
+
+    // A fifth of full speed on both wheels, as MuJoCo's velocity actuators take it
+    float controls[2] = {0.2f, 0.2f};
+    model->apply_controls(scene, controls);
+    Vec3 start = frame->get_position();
+    for (int i = 0; i < 500; ++i) scene.step(dt);
+    Vec3 end = frame->get_position(), moved;
+    vec3_sub(&end, &start, &moved);
+    float target = controls[0] / model->get_actuators()[0].gear;
+    float left_speed = scene.get_joint_speeds()[model->find_joint("joint_left_wheel")];
+    float right_speed = scene.get_joint_speeds()[model->find_joint("joint_right_wheel")];
+    bool drives = std::fabs(left_speed - target) < 0.1f * std::fabs(target) &&
+                  std::fabs(right_speed - target) < 0.1f * std::fabs(target) && vec3_length(&moved) > 0.05f;
+    std::printf("%s: sleeping %s, wheels at %.2f and %.2f rad/s of %.2f, moved %.4f\n", drives ? "ok" : "FAILED",
+                sleeping ? "on" : "off", left_speed, right_speed, target, vec3_length(&moved));
+    return rests && drives;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::printf("usage: %s court.xml\n", argv[0]);
+        return 1;
+    }
+    bool ok = settles_and_drives(argv[1], true);
+    ok = settles_and_drives(argv[1], false) && ok;
+    return ok ? 0 : 1;
+}
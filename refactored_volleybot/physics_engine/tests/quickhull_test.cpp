@@ -0,0 +1,91 @@
+// The hulls of a cube's and a cylinder's surface point clouds must be closed and convex, with only their
+// corners as vertices. Walking to the horizon used to take every face the new point was in front of, however
+// little, where points within the tolerance of a face are taken as on it.
+#include "volleybot_physics/quickhull.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Every edge is shared by one face each way, every point is behind every face, and a closed triangulated
+// hull over V corners has 2V - 4 faces. 'corners' is the number of vertices expected, if known.
+static bool check_hull(const char* name, const std::vector<Vec3>& points, size_t corners) {
+    HullMesh hull;
+    if (!build_convex_hull(points.data(), points.size(), hull)) {
+        std::printf("FAILED: %s, no hull\n", name);
+        return false;
+    }
+    size_t face_count = hull.indices.size() / 3;
+    std::map<std::pair<unsigned int, unsigned int>, int> edges;
+    float worst = 0.0f;
+    for (size_t f = 0; f < face_count; ++f) {
+        const unsigned int* v = &hull.indices[3 * f];
+        for (int k = 0; k < 3; ++k) ++edges[{v[k], v[(k + 1) % 3]}];
+        Vec3 e0, e1, normal;
+        vec3_sub(&hull.vertices[v[1]], &hull.vertices[v[0]], &e0);
+        vec3_sub(&hull.vertices[v[2]], &hull.vertices[v[0]], &e1);
+        vec3_cross(&e0, &e1, &normal);
+        vec3_normalize(&normal, &normal);
+        for (const Vec3& point : points) {
+            Vec3 offset;
+            vec3_sub(&point, &hull.vertices[v[0]], &offset);
+            float dist = vec3_dot(&offset, &normal);
+            if (dist > worst) worst = dist;
+        }
+    }
+    bool closed = true;
+    for (const auto& edge : edges) {
+        auto reverse = edges.find({edge.first.second, edge.first.first});
+        closed = closed && edge.second == 1 && reverse != edges.end() && reverse->second == 1;
+    }
+    bool ok = closed && worst < 1e-5f && face_count == 2 * hull.vertices.size() - 4 &&
+              (corners == 0 || hull.vertices.size() == corners);
+    std::printf("%s: %s, %zu corners, %zu faces, %s, furthest point %.2e in front of a face\n", ok ? "ok" : "FAILED", name,
+                hull.vertices.size(), face_count, closed ? "closed" : "open", worst);
+    return ok;
+}
+
+// Points on a lattice over the surface of a cube of half size 1, which has 8 corners. 'jitter' moves each
+// point by up to that much, from a fixed sequence, so the faces are only nearly flat.
+static std::vector<Vec3> cube_surface(int steps, float jitter) {
+    uint32_t state = 12345;
+    auto next = [&]() {
+        state = state * 1664525u + 1013904223u;
+        return jitter * ((float)(state >> 8) / 16777216.0f - 0.5f);
+    };
+    std::vector<Vec3> points;
+    for (int i = 0; i <= steps; ++i) {
+        for (int j = 0; j <= steps; ++j) {
+            for (int k = 0; k <= steps; ++k) {
+                if (i != 0 && i != steps && j != 0 && j != steps && k != 0 && k != steps) continue;
+                float x = -1.0f + 2.0f * i / steps, y = -1.0f + 2.0f * j / steps, z = -1.0f + 2.0f * k / steps;
+                points.push_back({x + next(), y + next(), z + next()});
+            }
+        }
+    }
+    return points;
+}
+
+// Points around a cylinder's rims and over its caps, of which only the rims' are corners
+static std::vector<Vec3> cylinder_surface(int sides) {
+    std::vector<Vec3> points;
+    for (float y : {-1.0f, 1.0f}) {
+        for (int side = 0; side < sides; ++side) {
+            float angle = 6.2831853f * side / sides;
+            for (float scale : {1.0f, 0.75f, 0.5f, 0.25f}) {
+                points.push_back({0.5f * scale * std::cos(angle), y, 0.5f * scale * std::sin(angle)});
+            }
+        }
+    }
+    return points;
+}
+
+int main() {
+    bool ok = check_hull("cube", cube_surface(6, 0.0f), 8);
+    ok = check_hull("cylinder", cylinder_surface(32), 64) && ok;
+    // The jittered points stick out of the faces by up to a few float steps, so more of them can be corners
+    ok = check_hull("jittered cube", cube_surface(8, 2e-6f), 0) && ok;
+    return ok ? 0 : 1;
+}
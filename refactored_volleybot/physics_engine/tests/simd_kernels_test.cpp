@@ -0,0 +1,223 @@
+// Every instruction set level of the batch kernels must give the scalar kernels' results on the same inputs,
+// up to the rounding that fused multiply-adds change. The counts are not multiples of any block size, so the
+// partial blocks at the ends are checked as well.
+#include "physics_core/cpu_dispatch.h"
+#include "physics_core/kinematics.h"
+#include "physics_core/mat4.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+static const size_t body_count = 37;
+static const size_t pair_count = 53;
+static const size_t contact_count = 41;
+static const int solver_iterations = 4;
+
+// A fixed sequence in [-0.5, 0.5)
+struct Lcg {
+    uint32_t state = 12345;
+    float next() {
+        state = state * 1664525u + 1013904223u;
+        return (float)(state >> 8) / 16777216.0f - 0.5f;
+    }
+    Vec3 vec3(float scale) { return {scale * next(), scale * next(), scale * next()}; }
+    Quat rotation() {
+        Quat q = {next(), next(), next(), next()}, result;
+        quat_normalize(&q, &result);
+        return result;
+    }
+};
+
+// The inputs of every kernel, which each run overwrites with its outputs
+struct KernelData {
+    // Bodies, for integration and the inertia and AABB updates
+    std::vector<Vec3> positions, velocities, accelerations, angular_velocities;
+    std::vector<Quat> orientations;
+    std::vector<uint8_t> flags;
+    std::vector<Mat4> local_inverse_inertias, world_inverse_inertias;
+    std::vector<AABB> local_bounds, world_bounds;
+    // Shape pairs
+    std::vector<Vec3> centers_a, centers_b, extents;
+    std::vector<float> radii_a, radii_b;
+    std::vector<Quat> box_orientations;
+    std::vector<CollisionInfo> sphere_hits, box_hits;
+    // Contacts between the bodies
+    std::vector<SolverContact> contacts, pushes;
+    std::vector<float> inverse_masses;
+    std::vector<Vec3> correction_velocities, correction_angular_velocities;
+};
+
+static KernelData make_inputs() {
+    Lcg random;
+    KernelData data;
+    for (size_t i = 0; i < body_count; ++i) {
+        data.positions.push_back(random.vec3(10.0f));
+        data.velocities.push_back(random.vec3(4.0f));
+        data.accelerations.push_back(random.vec3(2.0f));
+        data.angular_velocities.push_back(random.vec3(6.0f));
+        data.orientations.push_back(random.rotation());
+        // Static, sleeping and composite parts are left where they are
+        data.flags.push_back(i % 7 == 0 ? BODY_FLAG_STATIC : (i % 11 == 3 ? BODY_FLAG_SLEEPING : (i % 13 == 5 ? BODY_FLAG_CHILD : 0)));
+        data.inverse_masses.push_back(i % 7 == 0 ? 0.0f : 0.5f + random.next());
+        Mat4 inertia;
+        mat4_identity(&inertia);
+        for (int k = 0; k < 3; ++k) inertia.m[k][k] = 1.0f + random.next();
+        inertia.m[3][3] = 0.0f;
+        data.local_inverse_inertias.push_back(inertia);
+        Vec3 half = random.vec3(1.0f), center = random.vec3(0.2f);
+        half = {std::fabs(half.x) + 0.1f, std::fabs(half.y) + 0.1f, std::fabs(half.z) + 0.1f};
+        data.local_bounds.push_back({{center.x - half.x, center.y - half.y, center.z - half.z},
+                                     {center.x + half.x, center.y + half.y, center.z + half.z}});
+        data.correction_velocities.push_back(random.vec3(0.5f));
+        data.correction_angular_velocities.push_back(random.vec3(0.5f));
+    }
+    data.world_inverse_inertias.resize(body_count);
+    data.world_bounds.resize(body_count);
+
+    // Pairs close enough that about half of them touch, and one sphere at a box's center
+    for (size_t i = 0; i < pair_count; ++i) {
+        data.centers_a.push_back(random.vec3(2.0f));
+        data.centers_b.push_back(i == 7 ? data.centers_a.back() : random.vec3(2.0f));
+        data.radii_a.push_back(0.3f + random.next() + 0.5f);
+        data.radii_b.push_back(0.3f + random.next() + 0.5f);
+        data.box_orientations.push_back(random.rotation());
+        Vec3 half = random.vec3(1.0f);
+        data.extents.push_back({std::fabs(half.x) + 0.1f, std::fabs(half.y) + 0.1f, std::fabs(half.z) + 0.1f});
+    }
+    data.sphere_hits.resize(pair_count);
+    data.box_hits.resize(pair_count);
+
+    // Contacts along random directions, their Jacobians from the bodies' world inertias
+    std::vector<Mat4> inertias(body_count);
+    for (size_t i = 0; i < body_count; ++i) {
+        Mat4 rotation, inverse_rotation, scaled;
+        quat_to_mat4(&data.orientations[i], &rotation);
+        for (int row = 0; row < 4; ++row) {
+            for (int column = 0; column < 4; ++column) inverse_rotation.m[row][column] = rotation.m[column][row];
+        }
+        mat4_multiply(&rotation, &data.local_inverse_inertias[i], &scaled);
+        mat4_multiply(&scaled, &inverse_rotation, &inertias[i]);
+    }
+    for (size_t i = 0; i < contact_count; ++i) {
+        SolverContact contact = {};
+        contact.body_a = (uint32_t)(i % body_count);
+        contact.body_b = (uint32_t)((i * 5 + 3) % body_count);
+        if (contact.body_b == contact.body_a) contact.body_b = (contact.body_a + 1) % body_count;
+        Vec3 normal = random.vec3(1.0f), tangent, bitangent, up = {0.0f, 1.0f, 0.0f};
+        vec3_normalize(&normal, &normal);
+        vec3_cross(&normal, &up, &tangent);
+        vec3_normalize(&tangent, &tangent);
+        vec3_cross(&normal, &tangent, &bitangent);
+        Vec3 r_a = random.vec3(1.0f), r_b = random.vec3(1.0f);
+        const Vec3* directions[3] = {&normal, &tangent, &bitangent};
+        for (int row = 0; row < 3; ++row) {
+            contact_row_prepare(&contact.rows[row], vec4_load3(directions[row]), vec4_load3(&r_a), vec4_load3(&r_b),
+                                data.inverse_masses[contact.body_a], &inertias[contact.body_a],
+                                data.inverse_masses[contact.body_b], &inertias[contact.body_b]);
+        }
+        contact.friction = 0.5f + random.next();
+        contact.velocity_bias = random.next() + 0.5f;
+        contact.position_bias = random.next() + 0.5f;
+        contact.accumulated_impulse = i % 3 == 0 ? random.next() + 0.5f : 0.0f;
+        data.contacts.push_back(contact);
+    }
+    data.pushes = data.contacts;
+    return data;
+}
+
+static void run_kernels(const PhysicsKernels* kernels, KernelData& data) {
+    kernels->integrate_bodies(data.positions.data(), data.velocities.data(), data.accelerations.data(), data.flags.data(),
+                              body_count, {0.0f, -9.81f, 0.0f}, 1.0f / 60.0f);
+    kernels->integrate_orientations(data.orientations.data(), data.angular_velocities.data(), data.flags.data(),
+                                    body_count, 1.0f / 60.0f);
+    kernels->update_inverse_inertias(data.orientations.data(), data.local_inverse_inertias.data(),
+                                     data.world_inverse_inertias.data(), body_count);
+    kernels->update_aabbs(data.positions.data(), data.orientations.data(), data.local_bounds.data(),
+                          data.world_bounds.data(), body_count);
+    kernels->test_spheres_vs_spheres(data.centers_a.data(), data.radii_a.data(), data.centers_b.data(),
+                                     data.radii_b.data(), pair_count, data.sphere_hits.data());
+    kernels->test_spheres_vs_boxes(data.centers_a.data(), data.radii_a.data(), data.centers_b.data(),
+                                   data.box_orientations.data(), data.extents.data(), pair_count, data.box_hits.data());
+    for (int i = 0; i < solver_iterations; ++i) {
+        kernels->solve_contacts(data.contacts.data(), contact_count, data.velocities.data(),
+                                data.angular_velocities.data(), data.inverse_masses.data());
+        kernels->solve_contact_positions(data.pushes.data(), contact_count, data.correction_velocities.data(),
+                                         data.correction_angular_velocities.data(), data.inverse_masses.data());
+    }
+}
+
+// Compares 'count' floats starting at each pointer and keeps the largest relative difference
+static void compare(const float* expected, const float* actual, size_t count, float& worst) {
+    for (size_t i = 0; i < count; ++i) {
+        float difference = std::fabs(expected[i] - actual[i]) / std::fmax(1.0f, std::fabs(expected[i]));
+        if (!(difference <= worst)) worst = difference; // NaN sticks
+    }
+}
+
+template <typename T>
+static void compare(const std::vector<T>& expected, const std::vector<T>& actual, float& worst) {
+    compare(reinterpret_cast<const float*>(expected.data()), reinterpret_cast<const float*>(actual.data()),
+            expected.size() * sizeof(T) / sizeof(float), worst);
+}
+
+// The solver's outputs, without the padding of the Vec4 rows
+static void compare(const std::vector<SolverContact>& expected, const std::vector<SolverContact>& actual, float& worst) {
+    for (size_t i = 0; i < expected.size(); ++i) {
+        compare(&expected[i].accumulated_impulse, &actual[i].accumulated_impulse, 1, worst);
+        compare(expected[i].accumulated_friction, actual[i].accumulated_friction, 2, worst);
+        compare(&expected[i].accumulated_push, &actual[i].accumulated_push, 1, worst);
+    }
+}
+
+static bool compare(const std::vector<CollisionInfo>& expected, const std::vector<CollisionInfo>& actual, float& worst) {
+    bool same_hits = true;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        same_hits = same_hits && expected[i].has_collided == actual[i].has_collided;
+        compare(&expected[i].normal.x, &actual[i].normal.x, 3, worst);
+        compare(&expected[i].depth, &actual[i].depth, 1, worst);
+    }
+    return same_hits;
+}
+
+int main() {
+    SimdLevel initial = simd_get_level();
+    const KernelData inputs = make_inputs();
+    simd_set_level(SIMD_LEVEL_SCALAR);
+    KernelData expected = inputs;
+    run_kernels(physics_kernels(), expected);
+
+    bool ok = true;
+    for (int requested = SIMD_LEVEL_SSE4; requested <= SIMD_LEVEL_AVX512; ++requested) {
+        SimdLevel level = simd_set_level((SimdLevel)requested);
+        if (level != requested) {
+            std::printf("skipped: %s, not supported here\n", simd_level_name((SimdLevel)requested));
+            continue;
+        }
+        KernelData actual = inputs;
+        run_kernels(physics_kernels(), actual);
+
+        float bodies = 0.0f, shapes = 0.0f, solver = 0.0f;
+        compare(expected.positions, actual.positions, bodies);
+        compare(expected.accelerations, actual.accelerations, bodies);
+        compare(expected.orientations, actual.orientations, bodies);
+        compare(expected.world_inverse_inertias, actual.world_inverse_inertias, bodies);
+        compare(expected.world_bounds, actual.world_bounds, bodies);
+        bool same_hits = compare(expected.sphere_hits, actual.sphere_hits, shapes);
+        same_hits = compare(expected.box_hits, actual.box_hits, shapes) && same_hits;
+        // The velocities are integrated and then solved
+        compare(expected.velocities, actual.velocities, solver);
+        compare(expected.angular_velocities, actual.angular_velocities, solver);
+        compare(expected.correction_velocities, actual.correction_velocities, solver);
+        compare(expected.correction_angular_velocities, actual.correction_angular_velocities, solver);
+        compare(expected.contacts, actual.contacts, solver);
+        compare(expected.pushes, actual.pushes, solver);
+
+        bool level_ok = same_hits && bodies < 1e-5f && shapes < 1e-5f && solver < 1e-4f;
+        std::printf("%s: %s, largest difference from scalar %.2e in the bodies, %.2e in the shape tests%s, %.2e in the solver\n",
+                    level_ok ? "ok" : "FAILED", simd_level_name(level), bodies, shapes, same_hits ? "" : " (hits differ)", solver);
+        ok = level_ok && ok;
+    }
+    simd_set_level(initial);
+    return ok ? 0 : 1;
+}
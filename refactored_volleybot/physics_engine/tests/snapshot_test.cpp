@@ -0,0 +1,114 @@
+// Restoring a snapshot must put a scene back exactly: stepping on from it gives the same bits as the
+// first time, in the scene it was saved from and in another one built the same way, and saving again
+// gives the same bytes. The contact and convex caches are part of it, or the warm starts would differ.
+// Another scene's caches are sorted by its own primitives' addresses, so only its steps are compared.
+#include "volleybot_physics/scene.h"
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+static std::shared_ptr<Material> make_material(float mass) {
+    auto material = std::make_shared<Material>();
+    material->mass = mass;
+    return material;
+}
+
+// Boxes, spheres and convex hulls thrown onto a floor and into each other, so that some are
+// sliding, tumbling, resting or asleep at any time
+static void build_scene(Scene& scene, bool sleeping) {
+    if (!sleeping) {
+        SleepSettings settings;
+        settings.time = 0.0f;
+        scene.set_sleep_settings(settings);
+    }
+    scene.add_primitive(std::make_shared<Plane>(make_material(0.0f)));
+    std::vector<Vec3> tetrahedron = {{0.3f, 0.0f, 0.0f}, {-0.2f, 0.0f, 0.25f}, {-0.2f, 0.0f, -0.25f}, {0.0f, 0.4f, 0.0f}};
+    for (int i = 0; i < 12; ++i) {
+        std::shared_ptr<Primitive> body;
+        if (i % 3 == 0) {
+            body = std::make_shared<Box>(Vec3{0.25f, 0.2f, 0.3f}, make_material(1.0f));
+        } else if (i % 3 == 1) {
+            body = std::make_shared<Sphere>(0.2f, make_material(0.5f));
+        } else {
+            body = std::make_shared<ConvexHull>(tetrahedron, make_material(0.8f));
+        }
+        body->set_position({0.3f * (i % 4) - 0.45f, 0.5f + 0.45f * i, 0.2f * (i % 3) - 0.2f});
+        body->set_velocity({0.5f * (i % 2) - 0.25f, 0.0f, 0.1f * (i % 5)});
+        scene.add_primitive(body);
+    }
+}
+
+// The bits of every body's state after each of 'steps' steps
+static std::vector<uint8_t> record(Scene& scene, int steps) {
+    std::vector<uint8_t> trace;
+    for (int i = 0; i < steps; ++i) {
+        scene.step(1.0f / 60.0f);
+        const BodyStore& bodies = scene.get_body_store();
+        for (size_t b = 0; b < bodies.positions.size(); ++b) {
+            const uint8_t* fields[] = {(const uint8_t*)&bodies.positions[b], (const uint8_t*)&bodies.velocities[b],
+                                       (const uint8_t*)&bodies.angular_velocities[b], (const uint8_t*)&bodies.orientations[b]};
+            const size_t sizes[] = {sizeof(Vec3), sizeof(Vec3), sizeof(Vec3), sizeof(Quat)};
+            for (int f = 0; f < 4; ++f) trace.insert(trace.end(), fields[f], fields[f] + sizes[f]);
+            trace.push_back(bodies.flags[b]);
+        }
+    }
+    return trace;
+}
+
+static bool round_trip_is_exact(bool sleeping) {
+    Scene scene, copy;
+    build_scene(scene, sleeping);
+    build_scene(copy, sleeping);
+
+    // Save in the middle of the pile landing, with plenty of contacts in the caches
+    record(scene, 45);
+    std::vector<uint8_t> saved, saved_again;
+    scene.save_snapshot(saved);
+    std::vector<uint8_t> first = record(scene, 120);
+
+    bool restored = scene.restore_snapshot(saved.data(), saved.size());
+    scene.save_snapshot(saved_again);
+    std::vector<uint8_t> second = record(scene, 120);
+
+    // The copy has never stepped, so its caches start empty
+    bool copied = copy.restore_snapshot(saved.data(), saved.size());
+    std::vector<uint8_t> third = record(copy, 120);
+
+    bool same_bytes = saved_again == saved;
+    bool same_steps = second == first && third == first;
+    bool ok = restored && copied && same_bytes && same_steps;
+    std::printf("%s: snapshot of %zu bytes, sleeping %s, %s saved again, %s steps after restoring\n", ok ? "ok" : "FAILED",
+                saved.size(), sleeping ? "on" : "off", same_bytes ? "same bytes" : "different bytes",
+                same_steps ? "same" : "different");
+    return ok;
+}
+
+// Snapshots of another scene or of nothing at all are refused, and leave the scene as it was
+static bool mismatched_snapshot_is_refused() {
+    Scene scene, smaller;
+    build_scene(scene, true);
+    smaller.add_primitive(std::make_shared<Plane>(make_material(0.0f)));
+    std::vector<uint8_t> before, wrong, after;
+    scene.save_snapshot(before);
+    smaller.save_snapshot(wrong);
+
+    bool refused = !scene.restore_snapshot(wrong.data(), wrong.size());
+    refused = !scene.restore_snapshot(before.data(), before.size() - 1) && refused;
+    std::vector<uint8_t> garbage(before.size(), 0xab);
+    refused = !scene.restore_snapshot(garbage.data(), garbage.size()) && refused;
+    scene.save_snapshot(after);
+    bool ok = refused && after == before;
+    std::printf("%s: snapshots of other scenes, cut short or of garbage are refused\n", ok ? "ok" : "FAILED");
+    return ok;
+}
+
+int main() {
+    bool ok = true;
+    for (bool sleeping : {true, false}) {
+        ok = round_trip_is_exact(sleeping) && ok;
+    }
+    ok = mismatched_snapshot_is_refused() && ok;
+    return ok ? 0 : 1;
+}